@@ -11,13 +11,24 @@
 #include <IpTNLP.hpp>
 #include <IpRegOptions.hpp>
 #include <IpOptionsList.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <utility>
+#include <vector>
 #include <sqphot/Stats.hpp>
+#include <sqphot/TraceWriter.hpp>
 #include <sqphot/Types.hpp>
+#include <sqphot/Formulation.hpp>
 #include <sqphot/Options.hpp>
 #include <sqphot/QPhandler.hpp>
 //#include <sqphot/LPhandler.hpp>
 #include <sqphot/Utils.hpp>
 #include <sqphot/SQPTNLP.hpp>
+#include <sqphot/HessianApproximation.hpp>
+#include <sqphot/KKTSolver.hpp>
 #include <sqphot/Vector.hpp>
 #include <sqphot/Matrix.hpp>
 
@@ -85,10 +96,16 @@ public:
     /**
      * @brief ReOptimize a problem by hotstarting from the old optimal solution
      *
-     * TO BE IMPLEMENTED
+     * The new nlp must have the same dimensions and the same Jacobian/Hessian
+     * sparsity structure as the one given to @initialization; only the data
+     * (bounds, parameters) may differ. The QP handlers, the sparse matrix
+     * structures and the working set of the QP solvers are kept, and the new solve
+     * starts from the last accepted iterate, its multipliers, the last
+     * trust-region radius and the last penalty parameter.
+     *
+     * @param nlp: the nlp reader that read data of the function to be minimized;
      */
-
-    virtual void ReOptimize(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {}
+    virtual void ReOptimize(Ipopt::SmartPtr<Ipopt::TNLP> nlp);
 
 
     /** @name Set the corresponding option to the user-defined value */
@@ -117,6 +134,10 @@ public:
         return stats_;
     }
 
+    inline shared_ptr<Options> get_options() const {
+        return options_;
+    }
+
     inline double get_norm_p() const {
         return norm_p_k_;
     }
@@ -173,6 +194,12 @@ private:
                      shared_ptr<const Vector> x_l = nullptr,
                      shared_ptr<const Vector> x_u = nullptr);
 
+    /**
+     * @brief the infeasibility measure of the penalty function of formulation_, at
+     * the point x whose constraint values are c
+     */
+    double infea_measure(shared_ptr<const Vector> c, shared_ptr<const Vector> x);
+
     /**
      * @brief This function calculates the infeasibility measure for  current
      * iterate x_k
@@ -238,6 +265,40 @@ private:
      */
     void update_penalty_parameter();
 
+    /**
+     * @brief Increase rho_trial by the factor increase_parm and re-solve the QP
+     * while keep_increasing() holds and rho_trial < rho_max, updating
+     * infea_measure_model_ after every solve.
+     *
+     * If the option penalty_parallel_trials is larger than one, the QPs of that
+     * many successive values of rho_trial are solved concurrently, and the serial
+     * rule is then replayed on their solutions, so that the same rho_trial is
+     * chosen. The QP of the chosen value is moved into myQP_ by
+     * QPhandler::swap_state.
+     */
+    void increase_penalty(double &rho_trial,
+                          const std::function<bool()> &keep_increasing);
+
+    /**
+     * @brief load the QP data of the current iterate into trial_QPs_, with the
+     * penalty parameter rho. It is done once per call of increase_penalty, since
+     * the rounds of candidates only change the penalty terms of g, and the QPs
+     * whose state is swapped with that of myQP_ hold the same data.
+     */
+    void load_penalty_trials(double rho);
+
+    /**
+     * @brief solve the QPs with the penalty parameters rho_candidates concurrently,
+     * the first one with myQP_, the others with trial_QPs_, after updating the
+     * penalty terms of g in each of them.
+     *
+     * @param errors is set to the exception thrown by the solve of each QP, or
+     * nullptr if it is solved; they are rethrown by the caller only for the QPs
+     * the serial rule would have solved
+     */
+    void solve_penalty_trials(const std::vector<double> &rho_candidates,
+                              std::vector<std::exception_ptr> &errors);
+
 
     /**@name Get the search direction from the LP/QP handler*/
     //@{
@@ -280,6 +341,54 @@ private:
 
     void setupLP();
 
+    /**
+     * @brief set up the LP subproblem and start solving it in another thread.
+     *
+     * The LP only depends on the data of the current iterate, not on the QP
+     * solution, so it is solved while the QP is; update_penalty_parameter then
+     * takes its solution with finish_LP. An LP it does not need is left running,
+     * and is only waited for by drop_LP.
+     */
+    void start_LP();
+
+    /**
+     * @brief wait for an LP started by start_LP which is not taken by finish_LP,
+     * when the next one is started, at the end of Optimize, or by ReOptimize.
+     * Its iterations and time are not added to stats_, and LP_NOT_OPTIMAL is
+     * ignored.
+     */
+    void drop_LP();
+
+    /**
+     * @brief wait for the LP started by start_LP, add its iterations and time to
+     * stats_, and rethrow the exception it threw, if any
+     */
+    void finish_LP();
+
+    /**
+     * @brief the decrease of the SL1QP model at the Cauchy point, the minimizer of
+     * the model along the steepest descent direction of the model at p = 0,
+     * projected onto the trust region (and, unless the bounds are penalized, onto
+     * the bounds of x)
+     *
+     * Along this path the model is a piecewise quadratic function of the step
+     * length, whose pieces are separated by the lengths at which a constraint
+     * becomes satisfied or violated, so the Cauchy point is found exactly by
+     * sorting these breakpoints.
+     */
+    double cauchy_decrease();
+
+    /** @brief cauchy_decrease for the formulation F*/
+    template <Formulation F>
+    double cauchy_decrease();
+
+    /**
+     * @brief let the QP solver stop the next QP once its objective is
+     * options_->qp_inexact_decrease times the Cauchy decrease below its value at
+     * p = 0, unless the Cauchy decrease is small, which happens near a solution
+     */
+    void set_QP_objective_target();
+
     /**
      * @brief This function extracts the Lagragian multipliers for constraints
      * in NLP and copies it to the class member multiplier_cons_.
@@ -294,6 +403,60 @@ private:
 
     void get_multipliers();
 
+    /**
+     * @brief estimate the multipliers at x_k_ by least squares, and use them
+     * instead of multiplier_cons_ and multiplier_vars_ if their KKT error is
+     * smaller.
+     *
+     * The active set is that of the constraints and bounds within
+     * options_->active_set_tol of one of their bounds. With F the variables not
+     * at a bound and A the active constraints, the estimates lambda_A minimize
+     * ||grad_f_F - J_AF^T lambda_A||_2, from the augmented system
+     *
+     *      [ I      J_AF^T ] [   r    ]   [ grad_f_F ]
+     *      [ J_AF  -reg I  ] [lambda_A] = [    0     ],
+     *
+     * and the multipliers of the active bounds are the components of
+     * grad_f_ - J^T lambda left for them. The estimates are computed once per
+     * iterate.
+     *
+     * @return true if the estimates are used
+     */
+    bool least_squares_multipliers();
+
+    /**
+     * @brief the violations of dual feasibility, complementarity and
+     * stationarity of the multipliers y_cons and y_vars at x_k_, in one pass over
+     * the constraints and one over the bounds, split in blocks over
+     * options_->num_threads threads for large problems
+     *
+     * @param W_constr, W_bounds if not NULL, the constraints and bounds within
+     * options_->active_set_tol of their bounds are marked active there
+     */
+    void multiplier_violations(shared_ptr<const Vector> y_cons,
+                               shared_ptr<const Vector> y_vars,
+                               double &dual_violation, double &compl_violation,
+                               double &stationarity_violation,
+                               ActiveType* W_constr = NULL,
+                               ActiveType* W_bounds = NULL);
+
+    /**
+     * @brief compute the gradient of the Lagrangian, grad_f_-jacobian_^T
+     * multiplier_cons_, at the current function information
+     */
+    void get_lagrangian_gradient(shared_ptr<Vector> result);
+
+    /**
+     * @brief update the quasi-Newton approximation of the Hessian, used instead of
+     * nlp_->Eval_Hessian if the option hessian_approximation is set.
+     *
+     * @param s_k the step from the previous iterate to x_k_
+     * @param grad_lag_old the gradient of the Lagrangian at the previous iterate,
+     * with the current multipliers
+     */
+    void update_hessian_approximation(shared_ptr<const Vector> s_k,
+                                      shared_ptr<const Vector> grad_lag_old);
+
     /**
      * @brief alloocate memory for class members.
      * This function initializes all the shared pointer which will be used in the
@@ -321,9 +484,40 @@ private:
      */
     void classify_constraints_types();
 
+    /**
+     * @brief tell the QP handlers which entries of the Jacobian may change, so that
+     * the linear constraints are not copied to the QP solvers at every iteration
+     */
+    void set_QP_nonlinear_Jacobian_entries();
+
+    /**
+     * @brief decide, after the exact Hessian of a new NLP is evaluated at x_0,
+     * whether it is constant: it is if options_->hessian_constant is set or the
+     * NLP declares itself linear, and it is checked at the next iterates if only
+     * the constraints are declared linear
+     */
+    void reset_hessian_constant();
+
+    /**
+     * @brief compare the exact Hessian just evaluated with the previous one, and
+     * take it to be constant after options_->hessian_constant_checks equal ones;
+     * the first difference stops the checks, since a constant Hessian never differs
+     * @return true if the values changed
+     */
+    bool check_hessian_constant();
+
+    /** @brief let the QP handlers keep the Hessian they have, if it is constant*/
+    void set_QP_hessian_constant();
+
 
 
     void print_final_stats();
+
+    /**
+     * @brief push the record of the iteration just finished to trace_, with the
+     * QP iterations and phase times counted since the previous record
+     */
+    void trace_iteration();
     //@}
 
 
@@ -332,7 +526,8 @@ private:
     ///////////////////////////////////////////////////////////
 private:
 
-    clock_t iter_time_;
+    std::chrono::steady_clock::time_point iter_start_; /**< wall-clock time at
+                                                          *the start of the iteration*/
     ConstraintType* bound_cons_type_;/**< the variables type, it can be either
                                                *bounded, bounded above,bounded below, or
                                                *unbounded*/
@@ -342,6 +537,7 @@ private:
     Exitflag exitflag_ = UNKNOWN;
     int nCon_; /**< number of constraints*/
     int nVar_; /**< number of variables*/
+    Formulation formulation_; /**< resolved from options_->formulation*/
     Ipopt::SmartPtr<Ipopt::Journalist> jnlst_;
     Ipopt::SmartPtr<Ipopt::OptionsList> roptions2_;
     Ipopt::SmartPtr<Ipopt::RegisteredOptions> roptions;
@@ -364,9 +560,20 @@ private:
     shared_ptr<QPhandler> myLP_;
     shared_ptr<Options> options_;/**< the default options used for now. */
     shared_ptr<QPhandler> myQP_;
+    std::vector<shared_ptr<QPhandler>> trial_QPs_;/**< the additional QPs solved
+                                                *by increase_penalty, empty unless
+                                                *penalty_parallel_trials > 1*/
     shared_ptr<SQPTNLP> nlp_;
     shared_ptr<SpTripletMat> hessian_;/**< the SparseMatrix object for hessain
                                                 *of  f(x)-sum_{i=1}^m lambda_i c_i(x)*/
+    shared_ptr<HessianApproximation> hessian_approx_;/**< quasi-Newton
+                                                *approximation of hessian_, NULL if
+                                                *the exact hessian is used*/
+    bool is_hessian_constant_;/**< hessian_ is not evaluated again*/
+    int hessian_equal_count_;/**< number of evaluations in a row equal to the
+                                *previous one, -1 once they are not checked*/
+    std::vector<double> hessian_last_;/**< the previous values of hessian_, kept
+                                        *while they are checked*/
     shared_ptr<SpTripletMat> jacobian_;/** <the SparseMatrix object for Jacobian
                                                  *from c(x)*/
     shared_ptr<Stats> stats_;
@@ -377,6 +584,23 @@ private:
     shared_ptr<Vector> grad_f_;/**< gradient evaluated at x_k*/
     shared_ptr<Vector> multiplier_cons_;/**< multiplier for constraints*/
     shared_ptr<Vector> multiplier_vars_;/**< multipliers for variables*/
+    shared_ptr<Vector> JTy_;/**< workspace of multiplier_violations*/
+    /** the least-squares multiplier estimates, used if
+     * options_->multiplier_least_squares*/
+    //@{
+    shared_ptr<KKTSolver> multiplier_solver_;
+    std::vector<int> multiplier_index_;/**< the row of each variable not at a
+                                         *bound and each active constraint in the
+                                         *system of multiplier_solver_, or -1*/
+    std::vector<int> multiplier_jacobian_entries_;/**< the entries of jacobian_
+                                                    *in multiplier_jacobian_*/
+    shared_ptr<SpTripletMat> multiplier_jacobian_;/**< J_AF*/
+    std::vector<double> multiplier_rhs_;
+    shared_ptr<Vector> multiplier_cons_ls_;
+    shared_ptr<Vector> multiplier_vars_ls_;
+    bool is_multiplier_ls_current_;/**< the estimates are those at x_k_*/
+    bool has_multiplier_ls_;/**< the estimates could be computed at x_k_*/
+    //@}
     shared_ptr<Vector> p_k_; /* search direction at x_k*/
     shared_ptr<Vector> x_k_; /**< current iterate point*/
     shared_ptr<Vector> x_l_; /* the lower bounds for variables*/
@@ -384,6 +608,24 @@ private:
                                           *x_trial = x_k+p_k*/
 
     shared_ptr<Vector> x_u_; /* the upper bounds for variables*/
+    /** workspace of cauchy_decrease*/
+    //@{
+    shared_ptr<Vector> cauchy_d_;/**< the direction of the Cauchy point*/
+    shared_ptr<Vector> cauchy_Hd_;
+    shared_ptr<Vector> cauchy_Jd_;
+    std::vector<std::pair<double, double>> cauchy_breakpoints_;/**< the step
+                                                *lengths at which the slope of the
+                                                *penalty term increases, and by how
+                                                *much*/
+    //@}
+    shared_ptr<Stats> LP_stats_;/**< the stats of the LP started by start_LP*/
+    bool is_LP_current_;/**< LP_solve_ is the LP of the current iteration*/
+    shared_ptr<TraceWriter> trace_;/**< the trace of the iterations, NULL if
+                                     *options_->trace_file is empty*/
+    Stats trace_stats_;/**< stats_ at the previous record of trace_*/
+    std::future<void> LP_solve_;/**< the LP started by start_LP; it is declared
+                                  *last so that it is waited for before any other
+                                  *member is destroyed*/
 
 };//END_OF_ALG_CLASS
 
@@ -0,0 +1,92 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#ifndef SQPHOTSTART_DENSELDL_HPP_
+#define SQPHOTSTART_DENSELDL_HPP_
+
+#include <vector>
+
+namespace SQPhotstart {
+
+/**
+ * @brief The factorization P K P^T = L D L^T of a dense symmetric indefinite
+ * matrix K, with L unit lower triangular and D block diagonal with 1x1 and 2x2
+ * blocks, by the partial pivoting of Bunch and Kaufman.
+ *
+ * It is meant for the small KKT systems [H A^T; A 0], whose zero block rules out
+ * a Cholesky factorization. The factors are stored as by LAPACK's dsytf2 in the
+ * lower triangle of one n x n array, and the interchanges are applied by solve
+ * as they were made, so that the rows of L before a pivot are never swapped.
+ */
+class DenseLDL {
+public:
+    DenseLDL();
+
+    /**
+     * @brief factorize K
+     *
+     * @param n the dimension of K
+     * @param K stored by rows, only its lower triangle is read
+     * @return false if K is singular, with a pivot of at most pivot_tol times the
+     * largest entry of K; the factors are then not usable
+     */
+    bool factorize(int n, const double* K, double pivot_tol = 1.0e-12);
+
+    /** @brief overwrite rhs, of length n, with K^{-1} rhs*/
+    void solve(double* rhs) const;
+
+    /** @name the inertia of K, from the last successful factorize*/
+    //@{
+    inline int num_positive() const {
+        return num_positive_;
+    }
+
+    inline int num_negative() const {
+        return num_negative_;
+    }
+    //@}
+
+    inline int dimension() const {
+        return n_;
+    }
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Copy Constructor */
+    DenseLDL(const DenseLDL &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const DenseLDL &);
+
+    inline double &L(int i, int j) {
+        return LD_[i * n_ + j];
+    }
+
+    inline double L(int i, int j) const {
+        return LD_[i * n_ + j];
+    }
+
+    /** @brief swap the rows and columns i < k of the lower triangle from row i on*/
+    void symmetric_swap(int i, int k);
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    int n_;
+    int num_positive_;
+    int num_negative_;
+    std::vector<double> LD_;  /**< L below the diagonal and D on and next to it*/
+    std::vector<int> pivot_;  /**< the row swapped with row k at step k, or for a
+                                *2x2 block in rows k,k+1, -1 minus the row swapped
+                                *with row k+1, in both entries*/
+};
+
+}
+
+#endif //SQPHOTSTART_DENSELDL_HPP_
@@ -0,0 +1,236 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:    2019-10
+ */
+#ifndef __SQPHOTSTART_DENSEQPINTERFACE_HPP__
+#define __SQPHOTSTART_DENSEQPINTERFACE_HPP__
+
+#include <sqphot/QPsolverInterface.hpp>
+#include <sqphot/DenseQPSolver.hpp>
+
+namespace SQPhotstart {
+
+/**
+ * @brief This is a derived class of QPsolverInterface.
+ *
+ * It solves the QP with the built-in DenseQPSolver, on dense copies of H and A.
+ * For the small subproblems it is meant for, this is cheaper than setting up the
+ * sparse data structures of qpOASES or QORE. The bounds are laid out as for
+ * qpOASES, with lb and ub on the variables and lbA and ubA on Ax, and each solve
+ * starts from the working set of the previous one.
+ */
+class DenseQPInterface :
+    public QPSolverInterface {
+
+    ///////////////////////////////////////////////////////////
+    //                      PUBLIC METHODS                   //
+    ///////////////////////////////////////////////////////////
+public:
+
+    /**
+     * @brief Constructor which also allocates the dense matrices
+     * @param nlp_info the struct that stores simple nlp dimension info
+     * @param qptype  is the problem to be solved QP or LP?
+     */
+    DenseQPInterface(NLPInfo nlp_info, QPType qptype,
+                     shared_ptr<const Options> options,
+                     Ipopt::SmartPtr<Ipopt::Journalist> jnlst);
+
+    /** @brief Constructor for a QP given by its data, for testing*/
+    DenseQPInterface(shared_ptr<SpHbMat> H,
+                     shared_ptr<SpHbMat> A,
+                     shared_ptr<Vector> g,
+                     shared_ptr<Vector> lb,
+                     shared_ptr<Vector> ub,
+                     shared_ptr<Vector> lbA,
+                     shared_ptr<Vector> ubA,
+                     shared_ptr<Options> options = nullptr);
+
+    /** Default Destructor */
+    ~DenseQPInterface() override;
+
+    void optimizeQP(shared_ptr<Stats> stats = nullptr) override;
+
+    void optimizeLP(shared_ptr<Stats> stats = nullptr) override;
+
+    /**
+     * @brief start the next solve from the given working set and x; the dual guess
+     * is not needed by the primal active-set method
+     */
+    void set_warm_start(const ActiveType* W_constr, const ActiveType* W_bounds,
+                        const double* x, const double* y_bounds,
+                        const double* y_constr) override;
+
+    /** @brief the primal active-set iterates are feasible and decrease the
+     * objective, so the target is passed on to the solver*/
+    void set_objective_target(double target) override {
+        objective_target_ = target;
+    }
+
+    /** @name Getters*/
+    //@{
+    double* get_optimal_solution() override {
+        return x_qp_->values();
+    }
+
+    double* get_multipliers_bounds() override {
+        return y_qp_->values() + bound_multipliers_offset_;
+    }
+
+    double* get_multipliers_constr() override {
+        return y_qp_->values() + nVar_QP_;
+    }
+
+    void get_working_set(ActiveType* W_constr, ActiveType* W_bounds) override;
+
+    double get_obj_value() override {
+        return solver_->objective();
+    }
+
+    Exitflag get_status() override {
+        return solver_->status();
+    }
+
+    OptimalityStatus get_optimality_status() override {
+        return qpOptimalStatus_;
+    }
+    //@}
+
+    /** @name Setters */
+    //@{
+    void set_lb(int location, double value) override;
+
+    void set_lb(shared_ptr<const Vector> rhs) override;
+
+    void set_lb(int location, int length, const double* values) override;
+
+    void set_ub(int location, double value) override;
+
+    void set_ub(shared_ptr<const Vector> rhs) override;
+
+    void set_ub(int location, int length, const double* values) override;
+
+    void set_lbA(int location, double value) override;
+
+    void set_lbA(shared_ptr<const Vector> rhs) override;
+
+    void set_lbA(int location, int length, const double* values) override;
+
+    void set_ubA(int location, double value) override;
+
+    void set_ubA(shared_ptr<const Vector> rhs) override;
+
+    void set_ubA(int location, int length, const double* values) override;
+
+    void set_g(int location, double value) override;
+
+    void set_g(shared_ptr<const Vector> rhs) override;
+
+    void set_H(shared_ptr<const SpTripletMat> rhs) override;
+
+    void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) override;
+
+    void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+               const std::vector<int>& entries) override;
+    //@}
+
+    void WriteQPSnapshot(const string filename) override;
+
+    void reset_constraints() override;
+
+    //@{
+    const shared_ptr<Vector>& getLb() const override {
+        return lb_;
+    };
+
+    const shared_ptr<Vector>& getUb() const override {
+        return ub_;
+    };
+
+    const shared_ptr<Vector>& getLbA() const override {
+        return lbA_;
+    };
+
+    const shared_ptr<Vector>& getUbA() const override {
+        return ubA_;
+    };
+
+    const shared_ptr<Vector>& getG() const override {
+        return g_;
+    };
+
+    shared_ptr<const SpHbMat> getH() const override {
+        return H_;
+    };
+
+    shared_ptr<const SpHbMat> getA() const override {
+        return A_;
+    };
+    //@}
+
+    bool test_optimality(ActiveType* W_c = NULL, ActiveType* W_b = NULL) override;
+
+    ///////////////////////////////////////////////////////////
+    //                      PRIVATE METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** default constructor*/
+    DenseQPInterface();
+
+    /** Copy Constructor */
+    DenseQPInterface(const DenseQPInterface &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const DenseQPInterface &);
+
+    /**
+     * @brief solve the QP, or the LP if qptype is LP, and start again from an empty
+     * working set if the solver stops before it is solved
+     */
+    void solve(QPType qptype, shared_ptr<Stats> stats);
+
+    /**
+     * @brief Allocate the workspace of test_optimality, so that it does not
+     * allocate memory after each solve
+     */
+    void allocate_workspace();
+
+    ///////////////////////////////////////////////////////////
+    //                      PRIVATE MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    Ipopt::SmartPtr<Ipopt::Journalist> jnlst_;
+    int nConstr_QP_;  /**< number of constraints for QP*/
+    int nVar_QP_;  /**< number of variables for QP*/
+    int bound_multipliers_offset_; /**< of the multipliers of the bounds on x in
+                                     *y_qp_, see FormulationPolicy*/
+    OptimalityStatus qpOptimalStatus_;
+    shared_ptr<const Options> options_;
+    shared_ptr<DenseQPSolver> solver_;
+    double objective_target_; /**< passed to the next QP solve, then reset*/
+    std::vector<double> H_dense_; /**< H stored by rows*/
+    std::vector<double> A_dense_; /**< A stored by rows, with its identity blocks*/
+    /** workspace, sized once by allocate_workspace*/
+    //@{
+    std::vector<double> Ax_work_;
+    std::vector<ActiveType> W_c_work_;
+    std::vector<ActiveType> W_b_work_;
+    //@}
+    shared_ptr<Vector> g_;   /**< the grad used for QPsubproblem*/
+    shared_ptr<Vector> lbA_; /**< lower bounds of Ax */
+    shared_ptr<Vector> lb_;  /**< lower bounds of x */
+    shared_ptr<Vector> ubA_; /**< upper bounds of Ax */
+    shared_ptr<Vector> ub_;  /**< upper bounds of x */
+    shared_ptr<Vector> x_qp_; /** the qp solution */
+    shared_ptr<Vector> y_qp_; /** the multipliers of the bounds, then of the
+                                *constraints */
+    shared_ptr<SpHbMat> H_;/**< the Matrix object stores the QP data H in
+                             * Harwell-Boeing Sparse Matrix format*/
+    shared_ptr<SpHbMat> A_;/**< the Matrix object stores the QP data A in
+                             * Harwell-Boeing Sparse Matrix format, with
+                             * implicit identity blocks*/
+};
+}
+#endif
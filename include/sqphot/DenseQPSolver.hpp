@@ -0,0 +1,283 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#ifndef SQPHOTSTART_DENSEQPSOLVER_HPP_
+#define SQPHOTSTART_DENSEQPSOLVER_HPP_
+
+#include <vector>
+#include <sqphot/Types.hpp>
+#include <sqphot/Utils.hpp>
+
+namespace SQPhotstart {
+
+/**
+ * @brief A primal active-set solver for small QPs stored as dense matrices,
+ *
+ *  minimize 1/2 x^T H x + g^T x
+ *  subject  lbA <= Ax <= ubA,
+ *            lb <=  x <= ub,
+ *
+ * where H may be indefinite, in which case a local minimizer is found, or NULL
+ * for an LP.
+ *
+ * The matrix C of the normals of the working set (e_j for a bound, the row a_i of
+ * A for a constraint) is kept in a TQ factorization
+ *
+ *      C Q = [0 T],
+ *
+ * with Q orthogonal and T upper triangular, so that the first nZ columns of Q are
+ * a basis Z of the null space of C, and the reduced Hessian Z^T H Z is kept in a
+ * Cholesky factorization R^T R. A change of the working set updates Q, T and R by
+ * Givens rotations, in O(n^2) operations. Q is stored by columns and the other
+ * matrices by rows, so that the rotations and the products with Z sweep
+ * contiguous memory.
+ *
+ * A feasible point is found first by minimizing the sum of the infeasibilities
+ * (phase 1). The QP is then solved with the inertia-controlling strategy of Gill,
+ * Murray, Saunders and Wright: Z^T H Z is allowed at most one nonpositive
+ * eigenvalue, and only right after a constraint is deleted; the iterate then moves
+ * along a direction of nonpositive curvature until a constraint blocks it. If the
+ * working set the solver starts from gives a reduced Hessian with more nonpositive
+ * eigenvalues, the free variables are temporarily fixed at their values, and
+ * released one at a time by the iterations.
+ *
+ * The working set of a solve is kept, and the next solve starts from it and from
+ * the previous solution, after both are made consistent with the new bounds.
+ */
+class DenseQPSolver {
+public:
+    DenseQPSolver(int nVar, int nConstr);
+
+    /**
+     * @brief solve the QP with the given data, starting from the working set of the
+     * previous solve if there was one
+     *
+     * @param H the Hessian, nVar x nVar and stored by rows, or NULL for an LP
+     * @param A the constraint matrix, nConstr x nVar and stored by rows
+     * @param max_iter the maximum number of changes to the working set
+     * @param objective_target for a QP, stop as soon as a feasible iterate has an
+     * objective of at most this value. The iterates of the second phase are
+     * feasible and their objective decreases, so such an iterate is a step which
+     * achieves the decrease, though not the minimizer.
+     *
+     * @return QP_OPTIMAL, QP_SUFFICIENT_DECREASE, QPERROR_INFEASIBLE,
+     * QPERROR_UNBOUNDED or QPERROR_EXCEED_MAX_ITER
+     */
+    Exitflag solve(const double* H, const double* A, const double* g,
+                   const double* lb, const double* ub, const double* lbA,
+                   const double* ubA, int max_iter, double objective_target = -INF);
+
+    /** @brief start the next solve from scratch*/
+    void reset();
+
+    /**
+     * @brief start the next solve from the given working set and point instead of
+     * those of the previous solve
+     *
+     * As for a previous working set, the bounds and constraints which are no longer
+     * finite, or whose normals depend on the others, are left out.
+     */
+    void set_working_set(const ActiveType* W_constr, const ActiveType* W_bounds,
+                         const double* x);
+
+    /**
+     * @brief copy the working set of the last solve; the bounds which are only
+     * fixed temporarily are reported as inactive
+     */
+    void get_working_set(ActiveType* W_constr, ActiveType* W_bounds) const;
+
+    /** Extract class member information*/
+    //@{
+    inline const double* x() const {
+        return x_.data();
+    }
+
+    /** the multipliers of the bounds, followed by those of the constraints, with
+     * g + Hx = y_bounds + A^T y_constr; after an early stop, they are the least
+     * squares multipliers of the working set*/
+    inline const double* y() const {
+        return y_.data();
+    }
+
+    inline double objective() const {
+        return objective_;
+    }
+
+    /** the number of changes to the working set in the last solve*/
+    inline int iterations() const {
+        return iter_;
+    }
+
+    inline Exitflag status() const {
+        return status_;
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Default constructor*/
+    DenseQPSolver();
+
+    /** Copy Constructor */
+    DenseQPSolver(const DenseQPSolver &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const DenseQPSolver &);
+
+    /** the state of a bound (ids 0,...,nVar-1) or constraint (ids nVar,...)*/
+    enum ConstraintStatus {
+        FREE = 0,
+        AT_LOWER,
+        AT_UPPER,
+        AT_EQUALITY,
+        TEMPORARILY_FIXED /**< a bound fixed at the current value of its variable*/
+    };
+
+    inline double lower(int id) const {
+        return id < nVar_ ? lb_[id] : lbA_[id - nVar_];
+    }
+
+    inline double upper(int id) const {
+        return id < nVar_ ? ub_[id] : ubA_[id - nVar_];
+    }
+
+    /** the value of the bounded variable or constraint at x_*/
+    inline double value(int id) const {
+        return id < nVar_ ? x_[id] : Ax_[id - nVar_];
+    }
+
+    /** the value the bound or constraint takes in the working set*/
+    double working_value(int id) const;
+
+    /** the inner product of the normal of a bound or constraint with v*/
+    double normal_dot(int id, const double* v) const;
+
+    /**
+     * @brief put the working set of the previous solve, or an empty one, in the
+     * factorization, and move x_ onto it
+     */
+    void start_working_set();
+
+    /**
+     * @brief add a bound or constraint to the working set
+     *
+     * @return false if its normal depends on those in the working set
+     */
+    bool add_constraint(int id, ConstraintStatus status);
+
+    /** @brief remove the constraint in row r of T from the working set*/
+    void delete_constraint(int r);
+
+    /**
+     * @brief add the column of Z created by delete_constraint to R, or mark it
+     * as a direction of nonpositive curvature
+     */
+    void extend_reduced_hessian();
+
+    /**
+     * @brief factorize Z^T H Z again, with symmetric pivoting so that at most the
+     * last column of Z has nonpositive curvature
+     *
+     * @return false if more than one direction has nonpositive curvature
+     */
+    bool factorize_reduced_hessian();
+
+    /** @brief fix free variables temporarily until the working set is a vertex*/
+    void fix_free_variables();
+
+    /** @brief solve T^T lambda = Y^T v for the multipliers of the working set*/
+    void compute_multipliers(const double* v);
+
+    /**
+     * @brief the row of T of the constraint whose multiplier has the wrong sign
+     * by more than tol (the largest one scaled by the norm of the constraint,
+     * temporarily fixed bounds first), or -1 if there is none
+     */
+    int constraint_to_delete(double tol) const;
+
+    /**
+     * @brief the largest step in [0, step_max] along p_ which keeps the satisfied
+     * bounds and constraints satisfied. In phase 1, the step also stops when a
+     * violated constraint becomes satisfied.
+     *
+     * @param blocking is set to the id of the blocking bound or constraint, or -1
+     */
+    double ratio_test(double step_max, bool phase1, int &blocking,
+                      ConstraintStatus &blocking_status);
+
+    /** @brief x_ += step * p_, and update Ax_ and the gradient*/
+    void take_step(double step);
+
+    /** @brief gradient_ = g + Hx*/
+    void compute_gradient();
+
+    /**
+     * @brief minimize the sum of infeasibilities, or the LP objective if phase1 is
+     * false, by steepest descent in the null space of the working set
+     */
+    Exitflag run_first_order(bool phase1);
+
+    /** @brief minimize the QP objective from a feasible point*/
+    Exitflag run_second_order();
+
+    /** @brief set y_ and objective_ from the multipliers of the working set*/
+    void finish();
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    int nVar_;
+    int nConstr_;
+    int nZ_;              /**< the dimension of the null space of the working set*/
+    int iter_;
+    int max_iter_;
+    bool has_solution_;   /**< if the working set of the last solve can be reused*/
+    bool has_R_;          /**< if R is kept for the current working set*/
+    bool is_singular_;    /**< if the last column of Z has nonpositive curvature*/
+    double curvature_;    /**< which is then this one*/
+    double H_scale_;      /**< the largest entry of H*/
+    double objective_target_; /**< the objective at which run_second_order stops*/
+    Exitflag status_;
+    double objective_;
+
+    /** the data of the QP being solved*/
+    //@{
+    const double* H_;
+    const double* A_;
+    const double* g_;
+    const double* lb_;
+    const double* ub_;
+    const double* lbA_;
+    const double* ubA_;
+    //@}
+
+    std::vector<double> Qt_;  /**< Q^T, nVar x nVar, so row k is the column k of Q*/
+    std::vector<double> T_;   /**< nVar x nVar, T is in rows and columns nZ_,...*/
+    std::vector<double> R_;   /**< nVar x nVar, R is in rows and columns 0,...,nZ_-1*/
+    std::vector<int> working_;/**< the id of the constraint in each row of T*/
+    std::vector<int> status_of_; /**< ConstraintStatus of every bound and constraint*/
+    std::vector<double> fixed_value_; /**< the values of TEMPORARILY_FIXED bounds*/
+    std::vector<double> A_norm_;  /**< the norms of the rows of A*/
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> Ax_;
+    std::vector<double> gradient_; /**< g + Hx, or the gradient of the sum of
+                                     *infeasibilities in phase 1*/
+    std::vector<double> lambda_;   /**< the multipliers of the rows of T*/
+    std::vector<double> p_;        /**< the search direction*/
+    std::vector<double> Ap_;
+    std::vector<double> work_;     /**< workspace of length nVar*/
+    std::vector<double> work2_;    /**< workspace of length nVar*/
+    std::vector<double> M_;        /**< workspace for Z^T H Z*/
+    std::vector<int> permutation_; /**< the pivots of the factorization of Z^T H Z*/
+};
+
+}
+
+#endif //SQPHOTSTART_DENSEQPSOLVER_HPP_
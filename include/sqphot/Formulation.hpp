@@ -0,0 +1,151 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#ifndef SQPHOTSTART_FORMULATION_HPP_
+#define SQPHOTSTART_FORMULATION_HPP_
+
+#include <algorithm>
+#include <sqphot/Types.hpp>
+
+namespace SQPhotstart {
+
+/**
+ * @brief The layout of the SL1QP subproblem for each Formulation.
+ *
+ * The QP variables are [p u_1 u_2] for BOX_BOUNDS and [p u_1 u_2 v_1 v_2] for
+ * ELASTIC_BOUNDS, and the rows are J_k p + u_1 - u_2, followed for ELASTIC_BOUNDS
+ * by p + v_1 - v_2. The code which depends on the layout is written once, as a
+ * template on the formulation, and is compiled for both of them, so that its loops
+ * do not test the formulation.
+ */
+template <Formulation F>
+struct FormulationPolicy;
+
+
+template <>
+struct FormulationPolicy<BOX_BOUNDS> {
+    /** the bounds on x enter the penalty function*/
+    static const bool penalizes_bounds = false;
+
+    static int nVar_QP(const NLPInfo &nlp_info) {
+        return nlp_info.nVar + 2 * nlp_info.nCon;
+    }
+
+    static int nConstr_QP(const NLPInfo &nlp_info) {
+        return nlp_info.nCon;
+    }
+
+    /** the position of the multipliers of the bounds on x in those of the QP,
+     * where the multipliers of the bounds come first*/
+    static int bound_multipliers_offset(const NLPInfo &nlp_info) {
+        return 0;
+    }
+
+    /** the number of identity blocks in A, besides the Jacobian*/
+    static int num_identity_blocks() {
+        return 2;
+    }
+
+    /** fill the identity blocks of A, whose arrays have num_identity_blocks()
+     * entries*/
+    static void identity_blocks(const NLPInfo &nlp_info, IdentityInfo &I_info) {
+        I_info.length = 2;
+        I_info.irow[0] = I_info.irow[1] = 1;
+        I_info.jcol[0] = nlp_info.nVar + 1;
+        I_info.jcol[1] = nlp_info.nVar + nlp_info.nCon + 1;
+        I_info.size[0] = I_info.size[1] = nlp_info.nCon;
+        I_info.value[0] = 1.0;
+        I_info.value[1] = -1.0;
+    }
+
+    /**
+     * @brief the bounds on the step p,
+     *   lb = max(x_l-x_k, -delta),  ub = min(x_u-x_k, delta)
+     */
+    static inline void step_bounds(int nVar, double delta, const double* x_l,
+                                   const double* x_u, const double* x_k,
+                                   double* lb, double* ub) {
+        for (int i = 0; i < nVar; i++) {
+            lb[i] = std::max(x_l[i] - x_k[i], -delta);
+            ub[i] = std::min(x_u[i] - x_k[i], delta);
+        }
+    }
+};
+
+
+template <>
+struct FormulationPolicy<ELASTIC_BOUNDS> {
+    static const bool penalizes_bounds = true;
+
+    static int nVar_QP(const NLPInfo &nlp_info) {
+        return 3 * nlp_info.nVar + 2 * nlp_info.nCon;
+    }
+
+    static int nConstr_QP(const NLPInfo &nlp_info) {
+        return nlp_info.nCon + nlp_info.nVar;
+    }
+
+    /** the multipliers of the rows p + v_1 - v_2, after those of the bounds and of
+     * the rows of J_k*/
+    static int bound_multipliers_offset(const NLPInfo &nlp_info) {
+        return nVar_QP(nlp_info) + nlp_info.nCon;
+    }
+
+    static int num_identity_blocks() {
+        return 5;
+    }
+
+    static void identity_blocks(const NLPInfo &nlp_info, IdentityInfo &I_info) {
+        I_info.length = 5;
+        I_info.irow[0] = I_info.irow[1] = 1;
+        I_info.irow[2] = I_info.irow[3] = I_info.irow[4] = nlp_info.nCon + 1;
+        I_info.jcol[0] = nlp_info.nVar + 1;
+        I_info.jcol[1] = nlp_info.nVar + nlp_info.nCon + 1;
+        I_info.jcol[2] = 1;
+        I_info.jcol[3] = nlp_info.nVar + nlp_info.nCon * 2 + 1;
+        I_info.jcol[4] = nlp_info.nVar * 2 + nlp_info.nCon * 2 + 1;
+        I_info.size[0] = I_info.size[1] = nlp_info.nCon;
+        I_info.size[2] = I_info.size[3] = I_info.size[4] = nlp_info.nVar;
+        I_info.value[0] = I_info.value[2] = I_info.value[3] = 1.0;
+        I_info.value[1] = I_info.value[4] = -1.0;
+    }
+
+    /** the bounds on x are rows of A, only the trust region bounds the step*/
+    static inline void step_bounds(int nVar, double delta, const double* x_l,
+                                   const double* x_u, const double* x_k,
+                                   double* lb, double* ub) {
+        for (int i = 0; i < nVar; i++) {
+            lb[i] = -delta;
+            ub[i] = delta;
+        }
+    }
+};
+
+
+/** @name the layout of a formulation chosen at run time*/
+//@{
+inline int formulation_nVar_QP(Formulation formulation, const NLPInfo &nlp_info) {
+    return formulation == ELASTIC_BOUNDS ?
+           FormulationPolicy<ELASTIC_BOUNDS>::nVar_QP(nlp_info) :
+           FormulationPolicy<BOX_BOUNDS>::nVar_QP(nlp_info);
+}
+
+inline int formulation_nConstr_QP(Formulation formulation, const NLPInfo &nlp_info) {
+    return formulation == ELASTIC_BOUNDS ?
+           FormulationPolicy<ELASTIC_BOUNDS>::nConstr_QP(nlp_info) :
+           FormulationPolicy<BOX_BOUNDS>::nConstr_QP(nlp_info);
+}
+
+inline int formulation_bound_multipliers_offset(Formulation formulation,
+        const NLPInfo &nlp_info) {
+    return formulation == ELASTIC_BOUNDS ?
+           FormulationPolicy<ELASTIC_BOUNDS>::bound_multipliers_offset(nlp_info) :
+           FormulationPolicy<BOX_BOUNDS>::bound_multipliers_offset(nlp_info);
+}
+//@}
+
+}//SQPHOTSTART
+#endif
@@ -151,9 +151,7 @@ public:
     /**                  Data Writer                          **/
     /**-------------------------------------------------------**/
 
-    void WriteQPDataToFile(Ipopt::EJournalLevel level,
-                           Ipopt::EJournalCategory category,
-                           const string filename) override {};
+    void WriteQPSnapshot(const string filename) override {};
 
 
 private:
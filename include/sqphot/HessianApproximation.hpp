@@ -0,0 +1,156 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#ifndef SQPHOTSTART_HESSIANAPPROXIMATION_HPP_
+#define SQPHOTSTART_HESSIANAPPROXIMATION_HPP_
+
+#include <memory>
+#include <vector>
+#include <IpException.hpp>
+#include <sqphot/Types.hpp>
+#include <sqphot/Vector.hpp>
+#include <sqphot/SpTripletMat.hpp>
+
+namespace SQPhotstart {
+
+DECLARE_STD_EXCEPTION(HESSIAN_APPROXIMATION_TOO_LARGE);
+
+/**
+ * the largest number of variables for which B_k is approximated. The QP solvers
+ * take B_k as its dense lower triangle, whose nVar*(nVar+1)/2 entries are written
+ * at every iteration, which does not scale to more variables.
+ */
+const int HESSIAN_APPROXIMATION_MAX_NVAR = 5000;
+
+/**
+ * @brief Quasi-Newton approximation B_k of the Hessian of the Lagrangian, which is
+ * used in place of the exact Hessian when the option hessian_approximation is not
+ * EXACT_HESSIAN.
+ *
+ * It is updated from the pairs
+ *      s_k = x_{k+1} - x_k,
+ *      y_k = grad L(x_{k+1},lambda_{k+1}) - grad L(x_k,lambda_{k+1}),
+ * so the nlp is never asked for its second derivatives. Two types are available:
+ *
+ *  DAMPED_BFGS         a dense BFGS update with Powell's damping, which keeps B_k
+ *                      positive definite. It stores B_k explicitly and is meant for
+ *                      small problems.
+ *  LIMITED_MEMORY_SR1  B_k = sigma*I + sum_i v_i v_i^T/d_i, built from the last
+ *                      memory_size pairs only. It may be indefinite, which is fine
+ *                      for the trust-region subproblems.
+ *
+ * Since the QP solvers take an explicit matrix, B_k is handed over as the dense
+ * lower triangle of a symmetric SpTripletMat, so both types are limited to
+ * HESSIAN_APPROXIMATION_MAX_NVAR variables.
+ */
+class HessianApproximation {
+public:
+    /** constructor/destructor */
+    //@{
+    HessianApproximation(int nVar, HessianApproximationType type, int memory_size);
+
+    ~HessianApproximation();
+    //@}
+
+    /**
+     * @brief the number of entries in the lower triangle of an nVar x nVar matrix,
+     * i.e., the number of nonzeros of the triplet matrix B_k is written to.
+     *
+     * It throws HESSIAN_APPROXIMATION_TOO_LARGE if nVar is larger than
+     * HESSIAN_APPROXIMATION_MAX_NVAR, or if the count does not fit in an int.
+     */
+    static int nnz(int nVar);
+
+    /**
+     * @brief set the structure of hessian to the dense lower triangle, row by row.
+     * hessian should have nnz(nVar) entries.
+     */
+    void set_structure(std::shared_ptr<SpTripletMat> hessian) const;
+
+    /**
+     * @brief copy the values of B_k to hessian, whose structure has been set by
+     * @set_structure
+     */
+    void get_values(std::shared_ptr<SpTripletMat> hessian) const;
+
+    /**
+     * @brief update B_k by the pair (s,y)
+     *
+     * @return false if the pair was skipped because it does not carry any
+     * curvature information
+     */
+    bool update(std::shared_ptr<const Vector> s, std::shared_ptr<const Vector> y);
+
+    /** @brief reset B_k to the identity and forget all the pairs */
+    void reset();
+
+    /** Extract class member information*/
+    //@{
+    inline HessianApproximationType type() const {
+        return type_;
+    }
+
+    inline int num_updates() const {
+        return num_updates_;
+    }
+
+    inline int num_skipped() const {
+        return num_skipped_;
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Default constructor*/
+    HessianApproximation();
+
+    /** Copy Constructor */
+    HessianApproximation(const HessianApproximation &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const HessianApproximation &);
+
+    bool update_damped_bfgs(const double* s, const double* y);
+
+    bool update_limited_memory_sr1(const double* s, const double* y);
+
+    /**
+     * @brief recompute sigma_ and the SR1 corrections v_i, d_i from the stored
+     * pairs, oldest first
+     * @return if the most recent pair produced a correction
+     */
+    bool rebuild_limited_memory_sr1();
+
+    /**
+     * @brief result = B*p for the limited-memory matrix made of sigma_ and the
+     * corrections computed so far
+     */
+    void times_limited_memory(const double* p, double* result) const;
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    int nVar_;
+    HessianApproximationType type_;
+    int memory_size_;
+    int num_updates_;  /**< number of pairs used to update B_k */
+    int num_skipped_;  /**< number of pairs skipped */
+    bool is_scaled_;   /**< if the initial identity has been scaled by y^Ty/s^Ty*/
+    double* B_;        /**< B_k stored row by row (DAMPED_BFGS only) */
+    double* Bs_;       /**< workspace of length nVar_ */
+    double sigma_;     /**< B_0 = sigma_*I (LIMITED_MEMORY_SR1 only) */
+    std::vector<std::shared_ptr<Vector>> s_;  /**< stored pairs, oldest first*/
+    std::vector<std::shared_ptr<Vector>> y_;
+    std::vector<std::shared_ptr<Vector>> v_;  /**< SR1 corrections v_i */
+    std::vector<double> d_;                   /**< and their scalings d_i = v_i^Ts_i*/
+};
+
+}
+
+#endif //SQPHOTSTART_HESSIANAPPROXIMATION_HPP_
@@ -0,0 +1,167 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#ifndef SQPHOTSTART_KKTSOLVER_HPP_
+#define SQPHOTSTART_KKTSOLVER_HPP_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <IpException.hpp>
+#include <IpIpoptApplication.hpp>
+#include <IpSymLinearSolver.hpp>
+#include <IpSymTMatrix.hpp>
+#include <IpDenseVector.hpp>
+#include <sqphot/Types.hpp>
+#include <sqphot/SpTripletMat.hpp>
+#include <sqphot/DenseLDL.hpp>
+
+namespace SQPhotstart {
+
+DECLARE_STD_EXCEPTION(KKT_SOLVER_ERROR);
+
+/**
+ * @brief Factorizes and solves the symmetric indefinite systems
+ *
+ *      K = [H + delta_x I     A^T     ]
+ *          [    A        -delta_c I  ],
+ *
+ * with H (nVar x nVar) and A (nConstr x nVar) given as SpTripletMat, and A
+ * possibly with identity blocks as in the QP subproblems.
+ *
+ * The lower triangle of K is kept as triplets, in the order of the entries of H, A
+ * and the identity blocks, followed by the diagonal. set_structure fixes the
+ * pattern, and the symbolic factorization is done once for it; set_values copies
+ * new values, and the next factorize or solve factorizes K numerically again.
+ *
+ * The systems with at most dense_max_size rows are factorized by DenseLDL, and the
+ * others by the sparse solver of Ipopt chosen by linear_solver (MA27 or MUMPS),
+ * through its SymLinearSolver, with the options of an IpoptApplication.
+ */
+class KKTSolver {
+public:
+    /**
+     * @param linear_solver  the sparse solver, or DENSE_LDL for DenseLDL at all
+     * sizes
+     * @param dense_max_size the largest system factorized by DenseLDL
+     */
+    KKTSolver(LinearSolver linear_solver, int dense_max_size);
+
+    /**
+     * @brief set the sparsity pattern of K
+     *
+     * @param H symmetric with one triangle stored, or NULL for H = 0
+     * @param A the rows of A, or its first columns if there are identity blocks
+     * @param I_info the identity blocks of A, or NULL
+     */
+    void set_structure(int nVar, int nConstr, std::shared_ptr<const SpTripletMat> H,
+                       std::shared_ptr<const SpTripletMat> A,
+                       const IdentityInfo* I_info = NULL);
+
+    /**
+     * @brief set the values of K, for matrices with the pattern given to
+     * set_structure
+     */
+    void set_values(std::shared_ptr<const SpTripletMat> H,
+                    std::shared_ptr<const SpTripletMat> A,
+                    const IdentityInfo* I_info = NULL, double delta_x = 0.0,
+                    double delta_c = 0.0);
+
+    /**
+     * @brief factorize K, unless it has not changed since the last factorization
+     *
+     * @return false if K is singular
+     */
+    bool factorize();
+
+    /**
+     * @brief overwrite rhs with K^{-1} rhs, for nrhs right-hand sides of length
+     * nVar + nConstr stored one after the other; K is factorized first if needed
+     *
+     * @return false if K is singular
+     */
+    bool solve(double* rhs, int nrhs = 1);
+
+    /** @name the inertia of K, from its last factorization*/
+    //@{
+    /** false if the sparse solver does not compute the inertia*/
+    bool provides_inertia() const;
+
+    int num_negative() const;
+    //@}
+
+    inline int dimension() const {
+        return nVar_ + nConstr_;
+    }
+
+    /** @return true if K is factorized by DenseLDL*/
+    inline bool is_dense() const {
+        return is_dense_;
+    }
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Default constructor*/
+    KKTSolver();
+
+    /** Copy Constructor */
+    KKTSolver(const KKTSolver &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const KKTSolver &);
+
+    /** @brief add an entry of K to the pattern, in the lower triangle*/
+    inline void add_entry(int row, int col) {
+        irow_.push_back(std::max(row, col));
+        jcol_.push_back(std::min(row, col));
+    }
+
+    /** @brief create the SymLinearSolver of Ipopt and the matrix of the pattern*/
+    void create_sparse_solver();
+
+    /**
+     * @brief solve with the SymLinearSolver of Ipopt, which factorizes K again if
+     * its values have changed
+     */
+    bool sparse_solve(double* rhs, int nrhs);
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    LinearSolver linear_solver_;
+    int dense_max_size_;
+    int nVar_;
+    int nConstr_;
+    bool is_dense_;
+    bool is_factorized_;  /**< if the factorization is that of the current values*/
+    bool is_singular_;
+    std::vector<int> irow_;  /**< the pattern of the lower triangle of K, 1-based*/
+    std::vector<int> jcol_;
+    std::vector<double> values_;
+
+    /** the dense factorization*/
+    //@{
+    std::vector<double> K_dense_;
+    DenseLDL ldl_;
+    //@}
+
+    /** the sparse factorization, created for each pattern*/
+    //@{
+    Ipopt::SmartPtr<Ipopt::IpoptApplication> app_; /**< its options and journalist
+                                                     *are those of the solver*/
+    Ipopt::SmartPtr<Ipopt::SymLinearSolver> sparse_solver_;
+    Ipopt::SmartPtr<Ipopt::SymTMatrixSpace> K_space_;
+    Ipopt::SmartPtr<Ipopt::SymTMatrix> K_;
+    Ipopt::SmartPtr<Ipopt::DenseVectorSpace> vector_space_;
+    //@}
+};
+
+}
+
+#endif //SQPHOTSTART_KKTSOLVER_HPP_
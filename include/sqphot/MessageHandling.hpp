@@ -23,4 +23,10 @@
 #define QP_NOT_OPTIMAL_MSG "The QP problem is not solved to optimality!\n"
 #define LP_NOT_OPTIMAL_MSG "The LP problem is not solved to optimality!\n"
 #define SMALL_TRUST_REGION_MSG "The trust region is smaller than the user-defined minimum value\n"
+#define INVALID_QP_SNAPSHOT_MSG "The QP snapshot "
+#define INVALID_TRACE_FILE_MSG "The trace file "
+#define INVALID_FORMULATION_MSG "ELASTIC_BOUNDS is not supported by GUROBI and CPLEX\n"
+#define HESSIAN_APPROXIMATION_TOO_LARGE_MSG "The Hessian approximation is limited to HESSIAN_APPROXIMATION_MAX_NVAR variables, use EXACT_HESSIAN\n"
+#define INVALID_QP_SOLVER_MSG "The QP solver is not one of the available solvers\n"
+#define KKT_SOLVER_ERROR_MSG "The linear solver of Ipopt failed to factorize the KKT system\n"
 #endif
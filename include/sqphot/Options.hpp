@@ -32,11 +32,22 @@ public:
     int iter_max;
     int printLevel;
     double time_max; //in seconds
+    std::string trace_file; /**< file to write one record per iteration to, see
+                              *TraceWriter; empty for no trace. It has to be set
+                              *before Algorithm::initialization*/
+    bool trace_binary; /**< write the trace in the binary format of TraceWriter
+                         *instead of JSON lines*/
 
     /**solver choice*/
     //@{
     Solver QPsolverChoice;
     Solver LPsolverChoice;
+    Formulation formulation; /**< the layout of the QP subproblems, BOX_BOUNDS
+                               *by default. ELASTIC_BOUNDS is for NLPs whose
+                               *starting point violates bounds which cannot be
+                               *satisfied by shifting it, and is not supported by
+                               *GUROBI and CPLEX. It has to be set before
+                               *Algorithm::initialization*/
 
     //@}
 
@@ -61,6 +72,13 @@ public:
     double opt_prim_fea_tol;
     double opt_second_tol;
     double opt_stat_tol;
+    bool multiplier_least_squares; /**< estimate the multipliers at each accepted
+                                     *iterate by least squares on the constraints
+                                     *and bounds active there, and use them instead
+                                     *of those of the QP when their KKT error is
+                                     *smaller*/
+    double multiplier_least_squares_reg; /**< the regularization of dependent
+                                           *active constraints in the estimates*/
     //@}
 
     /**QPsolver options */
@@ -69,8 +87,57 @@ public:
     int lp_maxiter;
     int qpPrintLevel;
     int qp_maxiter;
+    int dense_qp_max_size; /**< if QPsolverChoice is AUTO_SOLVER, the QPs and
+                             *LPs with at most this many variables, and whose
+                             *Jacobian has at least the density
+                             *dense_qp_min_density, are solved by the built-in
+                             *dense solver, and the others by QORE*/
+    double dense_qp_min_density;
+    bool qp_warm_start; /**< start the QP of a new iterate from the working set and
+                          *multipliers of the QP which gave the accepted step*/
+    bool qp_inexact; /**< let the QP solver stop once the QP reaches
+                       *qp_inexact_decrease times the Cauchy decrease of the model,
+                       *while that decrease is large; only the dense solver can
+                       *stop early*/
+    double qp_inexact_decrease;
+    double qp_inexact_tol; /**< the QPs are solved to optimality once the Cauchy
+                             *decrease is at most qp_inexact_tol times
+                             *max(1,|f(x_k)|+rho*||c(x_k)||_1)*/
+    int qp_working_set_stable; /**< once the QPs have had the same working set this
+                                 *many times in a row, the next QP is first solved
+                                 *on that working set by one KKT system, and by the
+                                 *QP solver only if the solution is not optimal;
+                                 *0, the default, disables it*/
+    int qp_working_set_max_size; /**< the largest KKT system, in free variables
+                                   *and working constraints, solved that way*/
+    LinearSolver kkt_linear_solver; /**< the sparse factorization of the KKT
+                                      *systems with more than kkt_dense_max_size
+                                      *rows, DENSE_LDL for a dense one for all of
+                                      *them*/
+    int kkt_dense_max_size; /**< the largest KKT system factorized by DenseLDL*/
     //@}
 
+    /** Hessian approximation parameters, these have to be set before
+     * Algorithm::initialization */
+    //@{
+    HessianApproximationType hessian_approximation; /**< the approximations take
+                                                      *at most
+                                                      *HESSIAN_APPROXIMATION_MAX_NVAR
+                                                      *variables*/
+    int limited_memory_size; /**< number of pairs kept by LIMITED_MEMORY_SR1*/
+    bool hessian_constant; /**< the NLP is a QP, with a quadratic objective and
+                             *linear constraints, so the exact Hessian is
+                             *evaluated once*/
+    int hessian_constant_checks; /**< if the constraints are declared linear, the
+                                   *exact Hessian is taken to be constant once it
+                                   *has the same values at this many accepted
+                                   *iterates in a row after x_0; 0 disables it*/
+    //@}
+
+    /** number of threads used by the sparse matrix-vector products, it has to be set
+     * before Algorithm::initialization*/
+    int num_threads;
+
     /** penalty update parameters*/
     //@{
 
@@ -87,6 +154,12 @@ public:
     double rho;
     double rho_max;
     int penalty_iter_max;
+    bool penalty_concurrent_LP; /**< solve the LP of the penalty update alongside
+                                  *the QP whenever x_k is infeasible*/
+    int penalty_parallel_trials; /**< number of increased penalty parameters whose
+                                   *QPs are solved concurrently, 1 tries them one
+                                   *at a time. It has to be set before
+                                   *Algorithm::initialization*/
     //@}
     Ipopt::EJournalLevel debug_print_level = Ipopt::J_ALL;
     Ipopt::EJournalLevel print_level = Ipopt::J_ITERSUMMARY;
@@ -56,6 +56,14 @@ public:
 
     void optimizeLP(shared_ptr<Stats> stats = nullptr) override;
 
+    /**
+     * @brief hand the guess to the next call of QPOptimize, which starts from the
+     * working set of the nonzero multipliers
+     */
+    void set_warm_start(const ActiveType* W_constr, const ActiveType* W_bounds,
+                        const double* x, const double* y_bounds,
+                        const double* y_constr) override;
+
     bool test_optimality(ActiveType* W_c = NULL, ActiveType* W_b =NULL) override;
 
     /**@name Getters */
@@ -81,11 +89,7 @@ public:
      * @brief get the pointer to the multipliers to the bounds constraints.
      */
     inline double* get_multipliers_bounds()override {
-#if NEW_FORMULATION
-        return y_qp_->values()+nVar_QP_+(3*nConstr_QP_-nVar_QP_);//3*nConstr_QP-nVar_QP = nlp_info.nCon
-#else
-        return y_qp_->values();
-#endif
+        return y_qp_->values() + bound_multipliers_offset_;
     };
 
     /**
@@ -140,40 +144,61 @@ public:
     /** @name Setters */
     //@{
     void set_g(int location, double value) override {
+        data_change_flags_.Update_g = true;
         value = value < INF ? value : INF;
         g_->setValueAt(location, value);
     };
 
     void set_lb(int location, double value) override {
+        data_change_flags_.Update_bounds = true;
         value = value > -INF ? value : -INF;
         lb_->setValueAt(location, value);
     };
 
     void set_ub(int location, double value) override {
+        data_change_flags_.Update_bounds = true;
         value = value < INF ? value : INF;
         ub_->setValueAt(location, value);
     };
 
 
+    void set_lb(int location, int length, const double* values) override {
+        data_change_flags_.Update_bounds = true;
+        double* lb = lb_->values() + location;
+        for (int i = 0; i < length; i++)
+            lb[i] = values[i] > -INF ? values[i] : -INF;
+    };
+
+    void set_ub(int location, int length, const double* values) override {
+        data_change_flags_.Update_bounds = true;
+        double* ub = ub_->values() + location;
+        for (int i = 0; i < length; i++)
+            ub[i] = values[i] < INF ? values[i] : INF;
+    };
+
     void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) override;
 
+    void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+               const std::vector<int>& entries) override;
+
     void set_H(shared_ptr<const SpTripletMat> rhs) override;
 
     //@}
-    void WriteQPDataToFile(Ipopt::EJournalLevel level,
-                           Ipopt::EJournalCategory category,
-                           const string filename) override ;
+    void WriteQPSnapshot(const string filename) override;
 
     //@{
     void set_g(shared_ptr<const Vector> rhs) override {
+        data_change_flags_.Update_g = true;
         g_->copy_vector(rhs);
     };
 
     void set_lb(shared_ptr<const Vector> rhs) override {
+        data_change_flags_.Update_bounds = true;
         lb_->copy_vector(rhs);
     };
 
     void set_ub(shared_ptr<const Vector> rhs) override {
+        data_change_flags_.Update_bounds = true;
         ub_->copy_vector(rhs);
     };
 
@@ -183,6 +208,7 @@ public:
     void set_ubA(shared_ptr<const Vector> rhs) override {};
 
     void reset_constraints() override {
+        data_change_flags_.Update_bounds = true;
         lb_->set_zeros();
         ub_->set_zeros();
     };
@@ -211,6 +237,12 @@ private:
      * @brief Handle errors based on current status
      */
     void handle_error(QPType qptype, shared_ptr<Stats> stats=nullptr);
+
+    /**
+     * @brief reset all the data change flags to false, called once the data
+     * have been passed to QORE
+     */
+    void reset_flags();
     /**
      * @brief Allocate memory for the class members
      * @param nlp_index_info  the struct that stores simple nlp dimension info
@@ -218,6 +250,12 @@ private:
      */
     void allocate_memory(NLPInfo nlp_info, QPType qptype);
 
+    /**
+     * @brief Allocate the workspace of test_optimality, get_obj_value and
+     * set_warm_start, so that they do not allocate memory after each solve
+     */
+    void allocate_workspace();
+
 
 
     ///////////////////////////////////////////////////////////
@@ -229,15 +267,34 @@ private:
     bool firstQPsolved_ = false;
     int nConstr_QP_;
     int nVar_QP_;
-    bool matrix_change_flag_ = false;
+    int bound_multipliers_offset_; /**< of the multipliers of the bounds on x in
+                                     *y_qp_, see FormulationPolicy*/
+    Formulation formulation_;
+    UpdateFlags data_change_flags_;/**< which QP data have been changed since the
+                                      *last solve */
     OptimalityStatus qpOptimalStatus_;
-    shared_ptr<SpHbMat> A_;
+    shared_ptr<const Options> options_;
+    shared_ptr<SpHbMat> A_; /**< [J I -I] with implicit identity blocks*/
+    shared_ptr<SpHbMat> A_expanded_; /**< A_ with explicit identity blocks, which is
+                                       * handed to QORE */
     shared_ptr<SpHbMat> H_;
     shared_ptr<Vector> g_;
     shared_ptr<Vector> lb_;
     shared_ptr<Vector> ub_;
     shared_ptr<Vector> x_qp_;
     shared_ptr<Vector> y_qp_;
+    /** workspace, sized once by allocate_workspace*/
+    //@{
+    shared_ptr<Vector> Ax_work_;
+    shared_ptr<Vector> Hx_work_;
+    shared_ptr<Vector> stationary_gap_work_;
+    std::vector<ActiveType> W_c_work_;
+    std::vector<ActiveType> W_b_work_;
+    //@}
+    bool has_warm_start_ = false; /**< if the next solve starts from the guess
+                                    *below, given by set_warm_start*/
+    shared_ptr<Vector> x_guess_; /**< x followed by Ax, as QORE takes it*/
+    shared_ptr<Vector> y_guess_; /**< zero for the inactive bounds and constraints*/
 
     int qpiter_[1];
     Ipopt::SmartPtr<Ipopt::Journalist> jnlst_;
@@ -0,0 +1,261 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#ifndef SQPHOTSTART_QPSNAPSHOT_HPP_
+#define SQPHOTSTART_QPSNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <IpException.hpp>
+#include <sqphot/Types.hpp>
+#include <sqphot/Options.hpp>
+#include <sqphot/SpHbMat.hpp>
+
+namespace SQPhotstart {
+
+DECLARE_STD_EXCEPTION(INVALID_QP_SNAPSHOT);
+
+/**
+ * @brief A binary snapshot of the QP handed to a QP solver, written when the
+ * solver fails so that the QP can be replayed offline with any backend
+ * (see test/replay_QPsnapshot.cpp).
+ *
+ * The file is a fixed-size header followed by the payload, every section aligned
+ * to 8 bytes and stored in the native byte order:
+ *
+ *  header          dimensions, QPType, the solver and its exit flag, the solver
+ *                  options, the orientation of A and H, and the size and FNV-1a
+ *                  checksum of the payload
+ *  A               pointer, index and values of its compressed lines, as stored
+ *                  by the solver interface (CSC for qpOASES, CSR for QORE)
+ *  H               the same, for the QPs only
+ *  g, lb, ub       of length nVar
+ *  lbA, ubA        of length nConstr
+ *  working set     ActiveType of the bounds, then of the constraints (optional)
+ *
+ * The arrays are written directly from the SpHbMat and Vector buffers, without
+ * any intermediate copy, and a snapshot is loaded by mapping the file into memory,
+ * so that its accessors point into the mapping.
+ */
+class QPSnapshot {
+public:
+    /**
+     * @brief write a snapshot of a QP to filename
+     *
+     * @param H the Hessian in Harwell-Boeing format, nullptr for an LP
+     * @param A the constraint matrix in Harwell-Boeing format, with explicit
+     * identity blocks
+     * @param W_bounds, W_constr the working set of the bounds and the constraints,
+     * or NULL if it is not available
+     */
+    static void write(const std::string &filename, QPType qptype, Solver solver,
+                      Exitflag status, std::shared_ptr<const Options> options,
+                      std::shared_ptr<const SpHbMat> H,
+                      std::shared_ptr<const SpHbMat> A, const double* g,
+                      const double* lb, const double* ub, const double* lbA,
+                      const double* ubA, const ActiveType* W_bounds = NULL,
+                      const ActiveType* W_constr = NULL);
+
+    /**
+     * @brief map the snapshot stored in filename into memory, after checking its
+     * header and checksum
+     */
+    explicit QPSnapshot(const std::string &filename);
+
+    ~QPSnapshot();
+
+    /**
+     * @brief build a copy of A or H in the given orientation, for the solver
+     * interfaces, which own their matrices. H is empty for an LP.
+     */
+    //@{
+    std::shared_ptr<SpHbMat> get_A(bool isCompressedRow) const;
+
+    std::shared_ptr<SpHbMat> get_H(bool isCompressedRow) const;
+    //@}
+
+    /** @brief the options the snapshot was solved with, on top of the defaults*/
+    std::shared_ptr<Options> get_options() const;
+
+    /** Extract class member information*/
+    //@{
+    inline int nVar() const {
+        return header_.nVar;
+    }
+
+    inline int nConstr() const {
+        return header_.nConstr;
+    }
+
+    inline QPType qptype() const {
+        return static_cast<QPType>(header_.qptype);
+    }
+
+    inline Solver solver() const {
+        return static_cast<Solver>(header_.solver);
+    }
+
+    inline Exitflag status() const {
+        return static_cast<Exitflag>(header_.status);
+    }
+
+    inline bool has_working_set() const {
+        return header_.has_working_set != 0;
+    }
+
+    inline int nnz_A() const {
+        return header_.nnz_A;
+    }
+
+    inline int nnz_H() const {
+        return header_.nnz_H;
+    }
+
+    inline bool A_isCompressedRow() const {
+        return header_.A_is_compressed_row != 0;
+    }
+
+    inline bool H_isCompressedRow() const {
+        return header_.H_is_compressed_row != 0;
+    }
+
+    inline const int* A_pointer() const {
+        return array<int>(layout_.A_pointer);
+    }
+
+    inline const int* A_index() const {
+        return array<int>(layout_.A_index);
+    }
+
+    inline const double* A_values() const {
+        return array<double>(layout_.A_values);
+    }
+
+    inline const int* H_pointer() const {
+        return array<int>(layout_.H_pointer);
+    }
+
+    inline const int* H_index() const {
+        return array<int>(layout_.H_index);
+    }
+
+    inline const double* H_values() const {
+        return array<double>(layout_.H_values);
+    }
+
+    inline const double* g() const {
+        return array<double>(layout_.g);
+    }
+
+    inline const double* lb() const {
+        return array<double>(layout_.lb);
+    }
+
+    inline const double* ub() const {
+        return array<double>(layout_.ub);
+    }
+
+    inline const double* lbA() const {
+        return array<double>(layout_.lbA);
+    }
+
+    inline const double* ubA() const {
+        return array<double>(layout_.ubA);
+    }
+
+    inline const ActiveType* W_bounds() const {
+        return has_working_set() ? array<ActiveType>(layout_.working_set) : NULL;
+    }
+
+    inline const ActiveType* W_constr() const {
+        return has_working_set() ? W_bounds() + header_.nVar : NULL;
+    }
+    //@}
+
+    /** the header of the file; all the integers are written as int32_t*/
+    struct Header {
+        char magic[8];
+        int32_t version;
+        int32_t byte_order;
+        int32_t qptype;
+        int32_t solver;
+        int32_t status;
+        int32_t nVar;
+        int32_t nConstr;
+        int32_t nnz_A;
+        int32_t nnz_H;
+        int32_t A_is_compressed_row;
+        int32_t H_is_compressed_row;
+        int32_t has_H;
+        int32_t has_working_set;
+        int32_t qp_maxiter;
+        int32_t lp_maxiter;
+        int32_t qpPrintLevel;
+        uint64_t payload_size;
+        uint64_t checksum;
+    };
+
+    /** the offsets of the sections from the beginning of the file*/
+    struct Layout {
+        size_t A_pointer;
+        size_t A_index;
+        size_t A_values;
+        size_t H_pointer;
+        size_t H_index;
+        size_t H_values;
+        size_t g;
+        size_t lb;
+        size_t ub;
+        size_t lbA;
+        size_t ubA;
+        size_t working_set;
+        size_t file_size;
+    };
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Default constructor*/
+    QPSnapshot();
+
+    /** Copy Constructor */
+    QPSnapshot(const QPSnapshot &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const QPSnapshot &);
+
+    /** @brief check the mapped file, and read its header and layout*/
+    void validate(const std::string &filename);
+
+    /**
+     * @brief build a matrix in the given orientation from the compressed lines
+     * stored in the snapshot
+     */
+    static std::shared_ptr<SpHbMat> to_SpHbMat(int RowNum, int ColNum, int nnz,
+            bool stored_as_compressed_row, const int* pointer, const int* index,
+            const double* values, bool isCompressedRow);
+
+    template<typename T>
+    inline const T* array(size_t offset) const {
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    const char* data_;  /**< the mapped file */
+    size_t size_;       /**< and its size */
+    Header header_;
+    Layout layout_;
+};
+
+}
+
+#endif //SQPHOTSTART_QPSNAPSHOT_HPP_
@@ -11,11 +11,16 @@
 #include <sqphot/qpOASESInterface.hpp>
 #include <sqphot/GurobiInterface.hpp>
 #include <sqphot/QOREInterface.hpp>
+#include <sqphot/DenseQPInterface.hpp>
 #include <sqphot/CplexInterface.hpp>
+#include <sqphot/WorkingSetSolver.hpp>
 
 namespace SQPhotstart {
 /** Forward Declaration */
 
+DECLARE_STD_EXCEPTION(INVALID_FORMULATION);
+DECLARE_STD_EXCEPTION(INVALID_QP_SOLVER);
+
 /**
  *
  * This is a class for setting up and solving the SQP
@@ -58,14 +63,55 @@ public:
     /**
      * @brief solve the QP subproblem according to the bounds setup before,
      * assuming the first QP subproblem has been solved.
+     *
+     * Once Options::qp_working_set_stable QPs in a row have had the same working
+     * set, the QP is first solved on that working set by WorkingSetSolver, which
+     * near convergence gives the solution without the QP solver; the QP solver is
+     * only called if that solution is not optimal.
      * */
 
     void solveQP(shared_ptr<SQPhotstart::Stats> stats, shared_ptr<Options> options);
 
 
     void solveLP(shared_ptr<SQPhotstart::Stats> stats) {
+        PhaseTimer timer(stats.get(), PHASE_LP_SOLVE);
         solverInterface_->optimizeLP(stats);
     }
+
+    /**
+     * @brief hand the working set, solution and multipliers of the last QP solved
+     * to the QP solver, as the starting point of the next solve
+     *
+     * This is meant for the QP of the next iterate, after a step is accepted, whose
+     * working set changes little from that of the last QP, and not at all near
+     * convergence.
+     */
+    void warm_start_next_QP();
+
+    /**
+     * @brief let the next solveQP stop once the QP objective is at most target,
+     * if the QP solver can stop early; see QPSolverInterface::set_objective_target
+     */
+    void set_objective_target(double target);
+
+    /** @return true if the last QP was stopped early, at the objective target*/
+    bool is_inexact();
+
+    /**
+     * @brief the entries of the Jacobian which may change between iterates, see
+     * SQPTNLP::nonlinear_Jacobian_entries.
+     *
+     * The next set_A or update_A passes the whole Jacobian to the QP solver, and
+     * the ones after it only these entries.
+     */
+    void set_A_nonlinear_entries(const std::vector<int>& entries);
+
+    /**
+     * @brief declare whether the Hessian stays the same from now on. If so, the
+     * next set_H or update_H passes it to the QP solver and the ones after it
+     * are skipped, so that the solver keeps its factorization of H.
+     */
+    void set_H_constant(bool is_constant);
     /** @name Getters */
     //@{
     /**
@@ -117,6 +163,21 @@ public:
      */
     Exitflag get_status();
 
+    /**
+     * @brief the solver of the QPs, with AUTO_SOLVER resolved
+     */
+    inline Solver get_solver() const {
+        return QPsolverChoice_;
+    }
+
+    /**
+     * @brief exchange the QP solver, with its data and solution, and the working
+     * set history with other, which has to be built with the same NLPInfo, QPType
+     * and options. Each handler keeps its journalist, so that the one of the main
+     * QP keeps printing whichever QP it ends up with.
+     */
+    void swap_state(QPhandler &other);
+
 
 
     //@}
@@ -234,7 +295,8 @@ public:
 //@}
 
     /**
-     * @brief Write QP data to a file
+     * @brief Write the current QP to a binary QPSnapshot, which can be replayed by
+     * test/replay_QPsnapshot
      */
     void WriteQPData(const string filename);
 
@@ -286,6 +348,37 @@ private:
     void operator=(const QPhandler&);
     //@}
 
+    /** @brief allocate and fill I_info_A_ for the formulation F*/
+    template <Formulation F>
+    void set_identity_blocks();
+
+    /**
+     * @brief set the bounds of the QP in the layout of the formulation F; the
+     * bounds of the slack variables are only set if is_update is false
+     */
+    template <Formulation F>
+    void set_QP_bounds(double delta, shared_ptr<const Vector> x_l,
+                       shared_ptr<const Vector> x_u, shared_ptr<const Vector> x_k,
+                       shared_ptr<const Vector> c_l, shared_ptr<const Vector> c_u,
+                       shared_ptr<const Vector> c_k, bool is_update);
+
+    /**
+     * @brief write l-k and u-k to the first length entries of lb_work_ and
+     * ub_work_
+     */
+    void shift_bounds(const double* l, const double* u, const double* k, int length);
+
+    /**
+     * @brief solve the QP on the working set W_b_, W_c_ of the previous QPs
+     *
+     * @return true if the solution is optimal, it is then returned by the getters
+     * instead of that of the QP solver
+     */
+    bool solve_on_working_set();
+
+    /** @brief count the QPs in a row which have had the working set W_b_, W_c_*/
+    void count_working_set();
+
 
 
 
@@ -310,12 +403,29 @@ protected:
 
 private:
     Solver QPsolverChoice_;
+    Formulation formulation_; /**< resolved from Options::formulation*/
     //bounds that can be represented as vectors
     const NLPInfo nlp_info_;
     int nConstr_QP_;
     int nVar_QP_;
     ActiveType* W_c_;//working set for constraints;
     ActiveType* W_b_;//working set for bounds;
+    std::vector<ActiveType> W_c_last_;//working set of the QP before
+    std::vector<ActiveType> W_b_last_;
+    int same_working_set_count_;//QPs in a row with the working set W_b_, W_c_
+    int working_set_stable_;//from Options::qp_working_set_stable
+    shared_ptr<WorkingSetSolver> working_set_solver_;//NULL for an LP, or if disabled
+    bool is_working_set_solution_;//was the last QP solved by working_set_solver_?
+    int bound_multipliers_offset_;//see FormulationPolicy
+    shared_ptr<const SpTripletMat> hessian_;//the last H and J handed to the QP solver
+    shared_ptr<const SpTripletMat> jacobian_;
+    double* lb_work_;//workspace for the lower bounds handed to the QP solver
+    double* ub_work_;//workspace for the upper bounds handed to the QP solver
+    std::vector<int> A_nonlinear_entries_;
+    bool has_linear_A_entries_;//are some entries of A left out of A_nonlinear_entries_?
+    bool is_linear_A_set_;//has the QP solver the values of the other entries?
+    bool is_H_constant_;
+    bool is_constant_H_set_;//has the QP solver the constant Hessian?
 
     Ipopt::SmartPtr<Ipopt::Journalist> jnlst_;
     OptimalityStatus qpOptimalStatus_;
@@ -12,6 +12,7 @@
 #include <sqphot/Vector.hpp>
 #include <sqphot/Utils.hpp>
 #include <sqphot/SpHbMat.hpp>
+#include <sqphot/Formulation.hpp>
 
 #include <qpOASES.hpp>
 #include <sqphot/Stats.hpp>
@@ -84,6 +85,38 @@ public:
     virtual void
     optimizeLP(shared_ptr<Stats> stats) = 0;
 
+    /**
+     * @brief Start the next solve from a predicted working set and primal and dual
+     * guesses, such as those of the QP solved at the previous iterate.
+     *
+     * @param W_constr the predicted working set of the constraints, of length
+     * nCon_QP_, as returned by get_working_set
+     * @param W_bounds the predicted working set of the bounds, of length nVar_QP_
+     * @param x        a guess of the first nVar_QP_ entries of the solution
+     * @param y_bounds a guess of the multipliers of the bounds, with the signs of
+     * get_multipliers_bounds
+     * @param y_constr a guess of the multipliers of the constraints, with the signs
+     * of get_multipliers_constr
+     *
+     * The data are copied, and only used by the next call of optimizeQP or
+     * optimizeLP. By default they are ignored, and the solver starts from its own
+     * state.
+     */
+    virtual void set_warm_start(const ActiveType* W_constr, const ActiveType* W_bounds,
+                                const double* x, const double* y_bounds,
+                                const double* y_constr) {}
+
+    /**
+     * @brief Let the next call of optimizeQP stop at the first feasible iterate whose
+     * objective is at most target, with the status QP_SUFFICIENT_DECREASE.
+     *
+     * The solution and multipliers are then those of that iterate. By default the
+     * target is ignored, and the QP is solved to optimality, which is what the
+     * solvers whose iterates are not feasible, or whose objective does not
+     * decrease monotonically, have to do.
+     */
+    virtual void set_objective_target(double target) {}
+
 
     /**-------------------------------------------------------**/
     /**                    Getters                            **/
@@ -152,6 +185,35 @@ public:
     virtual void set_g(int location, double value) = 0;
     //@}
 
+    /**
+     * @name Setters for a contiguous block of entries, from location to
+     * location+length-1, by an array of values
+     *
+     * The default implementations fall back to the setters by location and value;
+     * overload them to copy the whole block at once.
+     */
+    //@{
+    virtual void set_lb(int location, int length, const double* values) {
+        for (int i = 0; i < length; i++)
+            set_lb(location + i, values[i]);
+    }
+
+    virtual void set_ub(int location, int length, const double* values) {
+        for (int i = 0; i < length; i++)
+            set_ub(location + i, values[i]);
+    }
+
+    virtual void set_lbA(int location, int length, const double* values) {
+        for (int i = 0; i < length; i++)
+            set_lbA(location + i, values[i]);
+    }
+
+    virtual void set_ubA(int location, int length, const double* values) {
+        for (int i = 0; i < length; i++)
+            set_ubA(location + i, values[i]);
+    }
+    //@}
+
     /**@name Setters for dense vector, by vector value*/
     //@{
     virtual void set_ub(shared_ptr<const Vector> rhs) = 0;
@@ -171,6 +233,15 @@ public:
     virtual void set_H(shared_ptr<const SpTripletMat> rhs) = 0;
 
     virtual void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) = 0;
+
+    /**
+     * @brief update only the given entries of the Jacobian, whose other entries
+     * have the values of the last set_A
+     */
+    virtual void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+                       const std::vector<int>& entries) {
+        set_A(rhs, I_info);
+    }
     //@}
 
     virtual void reset_constraints() =0;
@@ -179,9 +250,11 @@ public:
     /**                  Data Writer                          **/
     /**-------------------------------------------------------**/
 
-    virtual void WriteQPDataToFile(Ipopt::EJournalLevel level,
-                                   Ipopt::EJournalCategory category,
-                                   const string filename) = 0;
+    /**
+     * @brief write the current QP data, the solver options and, if the solver can
+     * provide it, the working set to a binary QPSnapshot
+     */
+    virtual void WriteQPSnapshot(const string filename) = 0;
 
 protected:
 
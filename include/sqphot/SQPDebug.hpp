@@ -11,7 +11,6 @@
 #define __SQPDEBUG_HPP__
 
 #define DEBUG true
-#define NEW_FORMULATION false
 
 #ifdef DEBUG
 #define COMPARE_QP_SOLVER false
@@ -23,12 +22,7 @@
 #define CHECK_NLP_READER false
 #define PRINT_QP_DATA false
 #define GET_QP_INTERFACE_MEMBERS false
-#define PRINT_OUT_QP_WITH_ERROR true
-#if PRINT_OUT_QP_WITH_ERROR
-#define PRINT_DATA_FOR_QPOASES false
-#define PRINT_DATA_FOR_QORE true
-#define PRINT_QP_IN_CPP false
-#endif
+#define PRINT_OUT_QP_WITH_ERROR true //write a QPSnapshot of the failed QPs
 #endif
 
 #endif /* __SQPDEBUG_HPP */
@@ -8,10 +8,12 @@
 #define SQPHOTSTART_SQPTNLP_HPP
 
 #include <memory>
+#include <vector>
 #include <sqphot/Utils.hpp>
 #include <IpTNLP.hpp>
 #include <sqphot/Vector.hpp>
 #include <sqphot/SpTripletMat.hpp>
+#include <sqphot/Stats.hpp>
 
 namespace SQPhotstart {
 /**
@@ -20,13 +22,17 @@ namespace SQPhotstart {
  * This class enables user to read data from NLP class object with more friendly
  * names and the use of Matrix and Vector objects for data.
  *
+ * It keeps track of the last point passed to the NLP, so that the NLP is called
+ * with new_x = false whenever the point has not changed, and it caches the
+ * objective and constraint values evaluated at that point.
  */
 class SQPTNLP {
 
 public:
 
-    /** @brief constructor that copies nlp to _nlp as a local data reader*/
-    SQPTNLP(Ipopt::SmartPtr<Ipopt::TNLP> nlp);
+    /** @brief constructor that copies nlp to _nlp as a local data reader
+     * @param stats if given, the evaluation counters will be recorded there*/
+    SQPTNLP(Ipopt::SmartPtr<Ipopt::TNLP> nlp, shared_ptr<Stats> stats = nullptr);
 
     /** Default destructor*/
     virtual ~SQPTNLP();
@@ -103,6 +109,70 @@ public:
     shift_starting_point(shared_ptr<Vector> x, shared_ptr<const Vector> x_l,
                          shared_ptr<const Vector> x_u);
 
+    /**
+     * @brief forget the last evaluated point, so that the next evaluation will be
+     * passed to the NLP with new_x = true
+     */
+    void reset_cache();
+
+    /**
+     * @brief replace the NLP to be read by another one with the same dimensions
+     * and the same sparsity structure of the Jacobian and the Hessian.
+     * @return false if nlp does not use FORTRAN_STYLE indices, or if its
+     * dimensions or the index arrays of its Jacobian or Hessian do not match the
+     * current ones
+     */
+    bool reset_nlp(Ipopt::SmartPtr<Ipopt::TNLP> nlp);
+
+    /**
+     * @brief the entries of the Jacobian, in the order of Eval_Jacobian, in the
+     * rows of the constraints which the NLP does not declare linear through
+     * TNLP::get_constraints_linearity. The other entries never change, so the QP
+     * matrices only need these to be updated.
+     *
+     * It is set by Get_Strucutre_Jacobian, and again by reset_nlp, and it holds
+     * every entry if the NLP gives no linearity information.
+     */
+    const std::vector<int>& nonlinear_Jacobian_entries() const {
+        return nonlinear_jac_entries_;
+    }
+
+    /**
+     * @brief true if every constraint is declared linear, so that the Hessian of
+     * the Lagrangian does not depend on the multipliers
+     */
+    bool are_constraints_linear() const {
+        return are_constraints_linear_;
+    }
+
+    /**
+     * @brief true if the constraints are linear and every variable is declared
+     * linear through TNLP::get_variables_linearity, so that the Hessian is zero
+     */
+    bool is_linear_program() const {
+        return is_linear_program_;
+    }
+
+private:
+    /**
+     * @brief read the linearity of the constraints and the variables from the
+     * NLP, and set nonlinear_jac_entries_ from it
+     */
+    void classify_linearity();
+
+    /**
+     * @brief true if the Jacobian and the Hessian of nlp have the same index
+     * arrays, in the same order, as those of the current NLP
+     */
+    bool has_same_structure(Ipopt::SmartPtr<Ipopt::TNLP> nlp);
+
+    /**
+     * @brief check if x differs from the last point passed to the NLP. If so, the
+     * point is recorded and the cached values are invalidated.
+     * @return the new_x flag to be passed to the NLP
+     */
+    bool update_x(shared_ptr<const Vector> x);
+
 public:
     NLPInfo nlp_info_; /**< the struct record the number of variables, number of
                                constraints, number of nonzeoro entry of Hessian and that of Jacobian
@@ -110,6 +180,19 @@ public:
     Ipopt::SmartPtr<Ipopt::TNLP> nlp_;/**< a local nlp reader */
 
 private:
+    shared_ptr<Stats> stats_; /**< evaluation counters, can be NULL */
+    shared_ptr<Vector> x_last_; /**< the last point passed to the NLP */
+    shared_ptr<Vector> c_cached_; /**< constraint values at x_last_ */
+    double f_cached_; /**< objective value at x_last_ */
+    bool has_x_last_;
+    bool is_f_cached_;
+    bool is_c_cached_;
+    std::vector<int> jac_rows_; /**< the row of each entry of the Jacobian*/
+    std::vector<int> nonlinear_jac_entries_;
+    bool are_constraints_linear_;
+    bool is_linear_program_;
+
+
     /** Default constructor*/
     SQPTNLP();
 
@@ -58,12 +58,38 @@ public:
     //@}
 
 //@{
+    /**
+     * @brief setup the structure of [rhs, identity blocks], with the identity blocks
+     * stored explicitly as matrix entries
+     */
     void setStructure(std::shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info);
 
 
     void setStructure(std::shared_ptr<const SpTripletMat> rhs);
 //@}
 
+    /**
+     * @brief attach the identity blocks described by I_info to the matrix without
+     * storing them entry by entry. times, transposed_times, the norms and the
+     * dense/print helpers handle them analytically, so that memory and mat-vec cost
+     * only depend on the entries set by setStructure(rhs).
+     *
+     * It has to be called before setStructure(rhs), and the matrix has to be
+     * allocated with the number of nonzeros of rhs only.
+     */
+    void set_identity_blocks(IdentityInfo I_info);
+
+    /**
+     * @brief the matrix with the implicit identity blocks expanded to explicit
+     * entries, for the QP solvers which need the whole matrix in Harwell-Boeing
+     * format.
+     *
+     * The structure is built on the first call and cached; later calls only copy
+     * the values changed by setMatVal, in O(EntryNum_). The returned object stays
+     * the same, so the pointers to its arrays can be handed to a solver once.
+     */
+    std::shared_ptr<SpHbMat> expanded();
+
 
 //@{
     inline void setMatValAt(int i, double value) {
@@ -108,6 +134,17 @@ public:
 
     virtual void setMatVal(std::shared_ptr<const SpTripletMat> rhs);
 
+    /**
+     * @brief set only the values of the given entries of rhs, for a matrix which
+     * is not symmetric and whose other entries have not changed since the last
+     * setMatVal
+     *
+     * The cached transpose and expanded matrix are updated in place, so the cost is
+     * O(entries.size()).
+     */
+    void setMatVal(std::shared_ptr<const SpTripletMat> rhs,
+                   const std::vector<int>& entries);
+
 
 
     void get_dense_matrix(double* dense_matrix,bool row_oriented = true) const ;
@@ -138,43 +175,24 @@ public:
                           std::shared_ptr<Vector> result) const;
 
     void transposed_times(const double* p, double* result) const {
-        for(int i = 0; i<ColNum_; i++)
-            result[i] = 0.0;
+        times_impl(p, result, true);
+    }
 
-        if(isCompressedRow_) {
-            int row;
-            for(int i = 1; i <RowNum_+1; i++) {
-                if(RowIndex_[i]>0) {
-                    row = i-1;
-                    break;
-                }
-            }
-            for(int i = 0; i<EntryNum_; i++) {
-                while(i==RowIndex_[row+1]) {
-                    row++;
-                }
-                result[ColIndex_[i]] +=MatVal_[i]*p[row];
-            }
-        }
-        else {
-            int col;
-            //find the col corresponding to the first nonzero entry
-            for(int i = 1; i<ColNum_+1; i++) {
-                if(ColIndex_[i]>0) {
-                    col = i-1;
-                    break;
-                }
-            }
-            for(int i = 0; i<EntryNum_; i++) {
-                //go to the next col
-                while(i == ColIndex_[col+1]) {
-                    col++;
-                }
-                result[col] += MatVal_[i]*p[RowIndex_[i]];
-            }
-        }
+    /**
+     * @brief set the number of threads times and transposed_times may use. Products
+     * with too few entries per thread still run serially.
+     *
+     * With more than one thread, the transpose is cached, so that both products
+     * are split by the rows of their result and need no synchronization. Its
+     * values are refreshed by setMatVal, so the values should not be changed
+     * through setMatValAt or MatVal() in the meantime.
+     */
+    void set_num_threads(int num_threads);
 
+    inline int num_threads() const {
+        return num_threads_;
     }
+
     /**
      * @brief make a deep copy of a matrix information
      */
@@ -201,6 +219,15 @@ public:
     }
 
 
+    /** the number of entries in the implicit identity blocks*/
+    inline int IdentityEntryNum() const {
+        int result = 0;
+        for (int size : I_size_)
+            result += size;
+        return result;
+    }
+
+
     inline int ColNum() const {
 
         return ColNum_;
@@ -319,15 +346,9 @@ public:
         return isCompressedRow_;
     }
 
-    /**
-     *@brief write data to a file
-     * Only works when DEBUG is enabled.
-     */
-    void write_to_file(const char* name,
-                       Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
-                       Ipopt::EJournalLevel level,
-                       Ipopt::EJournalCategory category,
-                       Solver solver);
+    inline bool isCompressedRow() const {
+        return isCompressedRow_;
+    }
 
 
 ///////////////////////////////////////////////////////////
@@ -355,6 +376,47 @@ private:
     void set_zero();
 
 
+    /**
+     * @brief result = M*p, or M^T*p if transposed. Both dispatch to a gather over
+     * the compressed lines, through the cached transpose if the lines run the
+     * other way, and are split among the threads by the number of entries.
+     */
+    void times_impl(const double* p, double* result, bool transposed) const;
+
+    /** @brief build the cached transpose, see set_num_threads*/
+    void build_transpose_structure();
+
+    /** @brief copy the values set by setMatVal to the cached transpose*/
+    void update_transpose_values();
+
+
+    /**
+     * @brief result += I*p for the implicit identity blocks, or I^T*p if transposed
+     */
+    void add_identity_times(const double* p, double* result, bool transposed) const {
+        for (int b = 0; b < (int) I_size_.size(); b++) {
+            for (int j = 0; j < I_size_[b]; j++) {
+                if (transposed)
+                    result[I_jcol_[b] + j] += I_value_[b] * p[I_irow_[b] + j];
+                else
+                    result[I_irow_[b] + j] += I_value_[b] * p[I_jcol_[b] + j];
+            }
+        }
+    }
+
+    /** @brief add the implicit identity blocks to a dense matrix */
+    void add_identity_to_dense(double* dense_matrix, bool row_oriented) const;
+
+
+    /**
+     * @brief fill the compressed row/column structure, values and order_ from
+     * EntryNum_ (0-based) triplet entries by counting sort, in
+     * O(EntryNum_+RowNum_+ColNum_).
+     */
+    void build_compressed_structure(const int* row, const int* col,
+                                    const double* val);
+
+
     template <typename T>
     static void print_tuple(vector<tuple<int,int,T>> tuple) {
         for(int i = 0; i<tuple.size(); i++) {
@@ -410,6 +472,30 @@ private:
     int * ColIndex_;
     int *RowIndex_;
 
+    /** the implicit identity blocks, with 0-based row and column of their first
+     * entries*/
+    //@{
+    std::vector<int> I_irow_;
+    std::vector<int> I_jcol_;
+    std::vector<int> I_size_;
+    std::vector<double> I_value_;
+    //@}
+    std::shared_ptr<SpHbMat> expanded_; /**< cache of the expanded matrix*/
+    std::vector<int> expanded_position_; /**< the position in expanded_ of each
+                                           *  stored entry*/
+    bool expanded_is_current_; /**< if the values of expanded_ are up to date*/
+
+    int num_threads_ = 1; /**< the number of threads used by the mat-vec products*/
+    /** the transpose: the compressed lines in the other direction, with the
+     * position in MatVal_ of each of their entries*/
+    //@{
+    std::vector<int> transpose_pointer_;
+    std::vector<int> transpose_index_;
+    std::vector<int> transpose_position_;
+    std::vector<int> transpose_slot_; /**< the inverse of transpose_position_*/
+    std::vector<double> transpose_values_;
+    //@}
+
 
     /**
      * @brief setup the structure of the sparse matrix for QPsolvrs
@@ -251,6 +251,18 @@ public:
         ColIndex_[i] = value;
     }
 
+    /**
+     * @brief set the number of threads times and transposed_times may use. Products
+     * with too few entries per thread still run serially.
+     */
+    inline void set_num_threads(int num_threads) {
+        num_threads_ = num_threads > 0 ? num_threads : 1;
+    }
+
+    inline int num_threads() const {
+        return num_threads_;
+    }
+
     void set_zero() {
         for(int i = 0; i<EntryNum_; i++) {
             order_[i] = 0;
@@ -283,6 +295,15 @@ private:
     void operator=(const SpTripletMat &);
 
 
+    /**
+     * @brief result = M*p, or M^T*p if transposed, with the entries split among
+     * num_threads threads. Every thread accumulates into its own copy of result,
+     * and the copies are summed up afterwards, again in parallel.
+     */
+    void parallel_times(const double* p, double* result, int result_dim,
+                        bool transposed, int num_threads) const;
+
+
 ///////////////////////////////////////////////////////////
 //                     PRIVATE  MEMBERS                  //
 ///////////////////////////////////////////////////////////
@@ -298,6 +319,7 @@ private:
     int* ColIndex_;/**< the column number of a matrix entry */
     int* RowIndex_;/**< the row number of a matrix entry */
     int* order_;    /**< the corresponding original position of a matrix entry */
+    int num_threads_ = 1; /**< the number of threads used by the mat-vec products*/
 
 };
 
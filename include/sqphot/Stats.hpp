@@ -6,7 +6,36 @@
 */
 #ifndef SQPHOTSTART_STATS_HPP
 #define SQPHOTSTART_STATS_HPP
+
+#include <chrono>
+#include <sqphot/Types.hpp>
+
 namespace SQPhotstart {
+
+/**
+ * @brief Wall-clock time spent in one phase of the algorithm, in seconds
+ */
+struct PhaseTime {
+    PhaseTime() : count(0), total(0.0), min(0.0), max(0.0) {}
+
+    inline void add(double seconds) {
+        if (count == 0 || seconds < min) min = seconds;
+        if (count == 0 || seconds > max) max = seconds;
+        total += seconds;
+        count++;
+    }
+
+    inline double mean() const {
+        return count == 0 ? 0.0 : total / count;
+    }
+
+    int count;    /**< number of times the phase was entered */
+    double total;
+    double min;
+    double max;
+};
+
+
 class Stats {
 public:
     /* Default constructor*/
@@ -18,7 +47,17 @@ public:
         penalty_change_Fail = 0;
         penalty_change_Succ = 0;
         soc_iter = 0;
+        qp_working_set = 0;
+        multiplier_ls = 0;
         total_time = 0.0;
+        f_eval = 0;
+        c_eval = 0;
+        grad_eval = 0;
+        jac_eval = 0;
+        hess_eval = 0;
+        f_eval_cached = 0;
+        c_eval_cached = 0;
+        new_x_reused = 0;
     };
 
     /* Destructor*/
@@ -99,9 +138,99 @@ public:
     };
 
 
+    /* add 1 to the number of QPs solved on the working set of the previous ones*/
+    inline void qp_working_set_addone() {
+        qp_working_set++;
+    };
+
+
+    /* add 1 to the number of least-squares multiplier estimates used*/
+    inline void multiplier_ls_addone() {
+        multiplier_ls++;
+    };
+
+
+    /* add 1 to the number of requests for a function value, cached or not*/
+    inline void f_eval_addone(bool cached) {
+        f_eval++;
+        if (cached) f_eval_cached++;
+    };
+
+    /* add 1 to the number of requests for constraint values, cached or not*/
+    inline void c_eval_addone(bool cached) {
+        c_eval++;
+        if (cached) c_eval_cached++;
+    };
+
+    /* add 1 to the value of class member grad_eval*/
+    inline void grad_eval_addone() {
+        grad_eval++;
+    };
+
+    /* add 1 to the value of class member jac_eval*/
+    inline void jac_eval_addone() {
+        jac_eval++;
+    };
+
+    /* add 1 to the value of class member hess_eval*/
+    inline void hess_eval_addone() {
+        hess_eval++;
+    };
+
+    /* add 1 to the value of class member new_x_reused*/
+    inline void new_x_reused_addone() {
+        new_x_reused++;
+    };
+
+    /* the total number of evaluation requests from the algorithm*/
+    inline int eval_total() const {
+        return f_eval + c_eval + grad_eval + jac_eval + hess_eval;
+    };
+
+    /* the fraction of evaluation requests which were either answered from the
+     * cache or passed to the NLP with new_x = false*/
+    inline double eval_cache_hit_rate() const {
+        if (eval_total() == 0)
+            return 0.0;
+        return (double) (f_eval_cached + c_eval_cached + new_x_reused) / eval_total();
+    };
+
+
+    /* record one pass through phase, which took the given number of seconds*/
+    inline void phase_time_add(TimedPhase phase, double seconds) {
+        phase_time[phase].add(seconds);
+    };
+
+    inline const PhaseTime& get_phase_time(TimedPhase phase) const {
+        return phase_time[phase];
+    };
+
+    /* name of phase used in the final statistics*/
+    static const char* phase_name(TimedPhase phase) {
+        switch (phase) {
+        case PHASE_QP_SETUP:
+            return "QP Setup";
+        case PHASE_QP_SOLVE:
+            return "QP Solve";
+        case PHASE_LP_SOLVE:
+            return "LP Solve";
+        case PHASE_NLP_EVAL:
+            return "NLP Evaluations";
+        case PHASE_OPTIMALITY_CHECK:
+            return "Optimality Check";
+        case PHASE_SOC:
+            return "Second-Order Correction";
+        case PHASE_LOGGING:
+            return "Logging";
+        default:
+            return "Unknown";
+        }
+    };
+
+
     /* Member Variables */
 public:
-    double total_time;
+    double total_time; /**< wall-clock seconds, measured with steady_clock */
     int qp_iter;
     int iter;
     int qp_break_down;
@@ -109,6 +238,52 @@ public:
     int penalty_change_Fail;
     int penalty_change_Succ;
     int soc_iter;
+    int qp_working_set; /**< QPs solved by WorkingSetSolver instead of the QP
+                          *solver */
+    int multiplier_ls; /**< least-squares multiplier estimates used instead of
+                         *those of the QP */
+    int f_eval;        /**< number of objective requests */
+    int c_eval;        /**< number of constraint requests */
+    int grad_eval;     /**< number of gradient requests */
+    int jac_eval;      /**< number of Jacobian requests */
+    int hess_eval;     /**< number of Hessian requests */
+    int f_eval_cached; /**< objective requests answered from the cache */
+    int c_eval_cached; /**< constraint requests answered from the cache */
+    int new_x_reused;  /**< callbacks made to the NLP with new_x = false */
+    PhaseTime phase_time[N_TIMED_PHASES]; /**< wall-clock time of each phase */
+};
+
+
+/**
+ * @brief Times a scope with steady_clock and adds the elapsed time to a phase
+ * of stats on destruction. Nothing is recorded if stats is NULL.
+ *
+ * The phases can be nested (e.g. the QP solves and NLP evaluations made inside
+ * a second-order correction step are also counted in their own phases).
+ */
+class PhaseTimer {
+public:
+    PhaseTimer(Stats* stats, TimedPhase phase) :
+        stats_(stats),
+        phase_(phase),
+        start_(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer() {
+        if (stats_ != nullptr) {
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start_;
+            stats_->phase_time_add(phase_, elapsed.count());
+        }
+    }
+
+private:
+    PhaseTimer(const PhaseTimer &);
+
+    void operator=(const PhaseTimer &);
+
+    Stats* stats_;
+    TimedPhase phase_;
+    std::chrono::steady_clock::time_point start_;
 };
 
 }//END_NAMESPACE_SQPHOTSTART
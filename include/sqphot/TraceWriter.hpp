@@ -0,0 +1,130 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#ifndef SQPHOTSTART_TRACEWRITER_HPP_
+#define SQPHOTSTART_TRACEWRITER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <IpException.hpp>
+#include <sqphot/Types.hpp>
+
+namespace SQPhotstart {
+
+DECLARE_STD_EXCEPTION(INVALID_TRACE_FILE);
+
+/**
+ * @brief The record of one iteration of the SQP algorithm written to the trace.
+ *
+ * Its layout is fixed, so that the binary trace is an array of these records.
+ */
+struct IterationRecord {
+    int32_t iter;
+    int32_t qp_iter;  /**< QP and LP iterations of this iteration*/
+    int32_t accepted; /**< 1 if the trial point was accepted, 0 otherwise*/
+    int32_t padding;
+    double f;         /**< objective at x_k*/
+    double infea_measure;
+    double rho;
+    double delta;     /**< the trust-region radius of the step*/
+    double norm_p;    /**< the infinity norm of the step*/
+    double qp_kkt_error;
+    double phase_time[N_TIMED_PHASES]; /**< wall-clock seconds spent in each phase
+                                         *during this iteration*/
+};
+
+
+/**
+ * @brief Writes one IterationRecord per iteration to a file, from a background
+ * thread.
+ *
+ * The solver thread only copies the record into a single-producer
+ * single-consumer ring buffer, which takes a few nanoseconds and never blocks:
+ * if the writer falls behind and the buffer is full, the record is dropped and
+ * counted. The writer thread drains the buffer and formats the records, either
+ *
+ *  JSON lines      one object per line, with the phase times keyed by
+ *                  Stats::phase_name
+ *  binary          a header (magic "SQPTRACE", version, record size and
+ *                  N_TIMED_PHASES, as four uint32_t after the magic) followed by
+ *                  the raw records, in the native byte order
+ *
+ * The records still in the buffer are written, and the file is closed, by the
+ * destructor.
+ */
+class TraceWriter {
+public:
+    /**
+     * @param filename the file to write the trace to, it is truncated
+     * @param binary   write the binary format instead of JSON lines
+     * @param capacity the number of records the ring buffer holds, rounded up to a
+     * power of two
+     */
+    TraceWriter(const std::string &filename, bool binary, int capacity = 1024);
+
+    /** stop the writer thread once it has written the buffered records*/
+    ~TraceWriter();
+
+    /**
+     * @brief queue a record for writing; it is dropped if the buffer is full.
+     * Only one thread may push records.
+     */
+    inline void push(const IterationRecord &record) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            dropped_++;
+            return;
+        }
+        buffer_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /** @return the number of records dropped so far, for the pushing thread*/
+    std::size_t dropped() const {
+        return dropped_;
+    }
+
+    static const char* magic() {
+        return "SQPTRACE";
+    }
+
+    static const uint32_t version = 1;
+
+private:
+    /** Copy Constructor */
+    TraceWriter(const TraceWriter &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const TraceWriter &);
+
+    /** the loop of the writer thread*/
+    void run();
+
+    /** write the records queued so far and flush the file*/
+    void drain();
+
+    void write_json(const IterationRecord &record);
+
+    std::FILE* file_;
+    bool binary_;
+    std::vector<IterationRecord> buffer_;
+    std::size_t mask_;      /**< the capacity of buffer_ minus one*/
+    std::size_t dropped_;   /**< only accessed by the pushing thread*/
+    /** on separate cache lines, since each is written by one of the threads*/
+    //@{
+    alignas(64) std::atomic<std::size_t> head_; /**< the number of records pushed*/
+    alignas(64) std::atomic<std::size_t> tail_; /**< the number of records written*/
+    //@}
+    std::atomic<bool> stop_;
+    std::thread writer_;    /**< declared last, so it is started last*/
+};
+
+}//SQPHOTSTART
+#endif
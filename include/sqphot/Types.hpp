@@ -42,6 +42,35 @@ typedef struct {
 } IdentityInfo;
 
 
+/** the phases of an SQP solve whose wall-clock time is recorded in Stats*/
+enum TimedPhase {
+    PHASE_QP_SETUP = 0,
+    PHASE_QP_SOLVE,
+    PHASE_LP_SOLVE,
+    PHASE_NLP_EVAL,
+    PHASE_OPTIMALITY_CHECK,
+    PHASE_SOC,
+    PHASE_LOGGING,
+    N_TIMED_PHASES
+};
+
+
+/** how the Hessian of the Lagrangian in the QP subproblems is obtained*/
+enum HessianApproximationType {
+    EXACT_HESSIAN = 0, /** evaluated by the nlp*/
+    DAMPED_BFGS = 1, /** dense damped BFGS approximation, for small problems*/
+    LIMITED_MEMORY_SR1 = 2 /** limited-memory SR1 approximation, handed to the QP
+                             * dense, see HESSIAN_APPROXIMATION_MAX_NVAR*/
+};
+
+
+/** how the bounds on x enter the SL1QP subproblems, see FormulationPolicy*/
+enum Formulation {
+    BOX_BOUNDS = 0, /** as bounds on the step, which x_0 is shifted to satisfy*/
+    ELASTIC_BOUNDS = 1 /** as penalized rows, like the constraints*/
+};
+
+
 enum QPType {
     LP = 1,/** solving a linear program*/
     QP = 2/**solving a regular qp subproblem **/
@@ -68,6 +97,8 @@ enum Exitflag {
     QPERROR_PERFORMINGHOMOTOPY = 28,
     QPERROR_HOMOTOPYQPSOLVED = 29,
     QPERROR_UNKNOWN = 30,
+    QP_SUFFICIENT_DECREASE = 31, //QP solver stopped early, at a feasible point which
+                                 //reaches the requested objective value
     AUXINPUT_NOT_OPTIMAL = 99,//The input point in auxInput is not optimal when hotstart is enabled.
     UNKNOWN = -99//unknown error
 };
@@ -93,9 +124,19 @@ enum Solver {
     QORE,
     GUROBI,
     CPLEX,
+    DENSE, /** the built-in dense active-set solver, for small QPs*/
+    AUTO_SOLVER, /**< DENSE for the QPs within Options::dense_qp_max_size and
+                   *Options::dense_qp_min_density, QORE for the others*/
     SOLVER_UNDEFINED
 };
 
+/** the factorizations of the symmetric indefinite systems of KKTSolver*/
+enum LinearSolver {
+    DENSE_LDL, /**< the built-in dense LDL^T factorization, DenseLDL*/
+    MA27,      /**< the sparse solvers linked with Ipopt*/
+    MUMPS
+};
+
 
 typedef struct {
     int  nCon;
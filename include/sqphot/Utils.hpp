@@ -17,6 +17,7 @@
 #include <iterator>
 #include <memory>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -54,6 +55,43 @@ bool is_int_array_equal(const int* a, const int* b, int length);
 bool is_double_array_equal(const double* a, const double* b, int length);
 
 
+/** the minimum number of matrix entries a thread gets in a parallel mat-vec;
+ * below that, starting the thread costs more than it saves*/
+const int MIN_ENTRIES_PER_THREAD = 20000;
+
+/**
+ * @brief the number of threads to split a loop over num_entries matrix entries,
+ * at most max_threads and such that every thread gets MIN_ENTRIES_PER_THREAD
+ */
+inline int num_threads_for(int num_entries, int max_threads) {
+    return std::max(1, std::min(max_threads, num_entries / MIN_ENTRIES_PER_THREAD));
+}
+
+/**
+ * @brief the first index of the t-th of num_threads nearly equal chunks of [0,length)
+ */
+inline int chunk_begin(int length, int t, int num_threads) {
+    return (int) ((long long) length * t / num_threads);
+}
+
+/**
+ * @brief call body(t) for t = 0,...,num_threads-1 concurrently and wait for all of
+ * them. body(0) runs in the calling thread, every other one in its own std::thread.
+ */
+template<typename Body>
+void parallel_for(int num_threads, const Body &body) {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (int t = 1; t < num_threads; t++)
+        threads.emplace_back([&body, t]() {
+            body(t);
+        });
+    body(0);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+
 //debug tool print things out
 template<typename T>
 inline void print_(char* name, T* vec, int length) {
@@ -175,11 +175,6 @@ public:
 //            size_ = rhs.size_;
 //            values_ = rhs.values_;
 //        }
-    void write_to_file(const char* name,
-                       Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
-                       Ipopt::EJournalLevel level,
-                       Ipopt::EJournalCategory category,
-                       Solver qpsolver);
 
 
     bool isAllocated() {
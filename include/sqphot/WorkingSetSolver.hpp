@@ -0,0 +1,167 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#ifndef SQPHOTSTART_WORKINGSETSOLVER_HPP_
+#define SQPHOTSTART_WORKINGSETSOLVER_HPP_
+
+#include <memory>
+#include <vector>
+#include <sqphot/Types.hpp>
+#include <sqphot/SpTripletMat.hpp>
+#include <sqphot/KKTSolver.hpp>
+
+namespace SQPhotstart {
+
+/**
+ * @brief Solves the QP
+ *
+ *  minimize 1/2 x^T H x + g^T x
+ *  subject  lbA <= Ax <= ubA,
+ *            lb <=  x <= ub,
+ *
+ * for a given working set, by one Newton step on its KKT conditions instead of an
+ * active-set method.
+ *
+ * The bounds in the working set fix their variables, and the constraints in it hold
+ * as equalities, so that x and the multipliers y_W of the working constraints solve
+ * the reduced KKT system
+ *
+ *      [H_FF  A_WF^T] [ x_F ]   [ -g_F - H_FX x_X ]
+ *      [A_WF   0    ] [-y_W ] = [  b_W - A_WX x_X ],
+ *
+ * where F are the free variables and X the fixed ones. The solution is the one of
+ * the QP if the multipliers have the signs of their side of the working set and the
+ * other bounds and constraints are satisfied, and, so that it is a minimizer, if the
+ * reduced system has the inertia (|F|, |W|, 0). Otherwise solve fails, and the QP is
+ * left to the active-set solver.
+ *
+ * The system is factorized by KKTSolver. Its pattern only changes with the working
+ * set, so near convergence each solve is a numerical factorization of the same
+ * pattern. Only working sets with at most max_size free variables and working
+ * constraints are tried.
+ */
+class WorkingSetSolver {
+public:
+    /**
+     * @param nVar     the number of variables of the QP
+     * @param nConstr  the number of rows of A
+     * @param max_size the largest reduced KKT system which is factorized
+     * @param linear_solver, dense_max_size see KKTSolver
+     */
+    WorkingSetSolver(int nVar, int nConstr, int max_size,
+                     LinearSolver linear_solver = DENSE_LDL, int dense_max_size = 0);
+
+    /**
+     * @brief solve the QP on the working set W_constr, W_bounds
+     *
+     * @param H the Hessian of the first H->RowNum() variables, symmetric with one
+     * triangle stored; the rest of the Hessian is zero
+     * @param J the first J->ColNum() columns of the first J->RowNum() rows of A
+     * @param I_info the identity blocks of A, besides J
+     * @param tol the largest KKT error of the solution, the sum of the violations
+     * of the bounds, constraints, signs of the multipliers and stationarity, as
+     * for the QP solvers
+     *
+     * @return true if the solution of the reduced KKT system solves the QP
+     */
+    bool solve(std::shared_ptr<const SpTripletMat> H,
+               std::shared_ptr<const SpTripletMat> J, const IdentityInfo &I_info,
+               const double* g, const double* lb, const double* ub,
+               const double* lbA, const double* ubA, const ActiveType* W_constr,
+               const ActiveType* W_bounds, double tol = 1.0e-6);
+
+    /** Extract class member information*/
+    //@{
+    inline double* x() {
+        return x_.data();
+    }
+
+    /** the multipliers of the bounds, followed by those of the constraints, with
+     * g + Hx = y_bounds + A^T y_constr, as for DenseQPSolver*/
+    inline double* y() {
+        return y_.data();
+    }
+
+    inline double objective() const {
+        return objective_;
+    }
+
+    /** the violations of the KKT conditions at the last solution, with a zero
+     * complementarity violation by construction*/
+    inline const OptimalityStatus &optimality_status() const {
+        return optimality_status_;
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  METHODS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    /** Default constructor*/
+    WorkingSetSolver();
+
+    /** Copy Constructor */
+    WorkingSetSolver(const WorkingSetSolver &);
+
+    /** Overloaded Equals Operator */
+    void operator=(const WorkingSetSolver &);
+
+    /**
+     * @brief set the pattern of the reduced KKT system, that of H_FF and A_WF,
+     * for the working set numbered in index_
+     */
+    void set_structure(std::shared_ptr<const SpTripletMat> H,
+                       std::shared_ptr<const SpTripletMat> J,
+                       const IdentityInfo &I_info, int nFree, int nWorking);
+
+    /** @brief copy the values of H_FF and A_WF*/
+    void set_values(std::shared_ptr<const SpTripletMat> H,
+                    std::shared_ptr<const SpTripletMat> J, const IdentityInfo &I_info);
+
+    /** @brief result = H v over all the variables*/
+    void H_times(const SpTripletMat &H, const double* v, double* result) const;
+
+    /** @brief result = A v, or A^T v if transposed*/
+    void A_times(const SpTripletMat &J, const IdentityInfo &I_info, const double* v,
+                 double* result, bool transposed) const;
+
+    ///////////////////////////////////////////////////////////
+    //                     PRIVATE  MEMBERS                  //
+    ///////////////////////////////////////////////////////////
+private:
+    int nVar_;
+    int nConstr_;
+    int max_size_;
+    double objective_;
+    OptimalityStatus optimality_status_;
+    KKTSolver kkt_;
+    std::vector<int> index_;  /**< the row of the reduced system of each free
+                                *variable and working constraint, or -1*/
+    /** the working set, H and J the pattern of the reduced system is for*/
+    //@{
+    bool has_structure_;
+    std::vector<ActiveType> W_constr_;
+    std::vector<ActiveType> W_bounds_;
+    const SpTripletMat* H_source_;
+    const SpTripletMat* J_source_;
+    //@}
+    std::shared_ptr<SpTripletMat> H_FF_;
+    std::shared_ptr<SpTripletMat> A_WF_;
+    std::vector<int> H_entries_;  /**< the entries of H in H_FF_*/
+    std::vector<int> J_entries_;  /**< the entries of J in A_WF_, followed there by
+                                    *those of the identity blocks*/
+    std::vector<int> I_blocks_;   /**< the block of each of these*/
+    std::vector<double> rhs_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> Hx_;
+    std::vector<double> Ax_;
+    std::vector<double> ATy_;
+};
+
+}
+
+#endif //SQPHOTSTART_WORKINGSETSOLVER_HPP_
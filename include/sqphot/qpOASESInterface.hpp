@@ -67,6 +67,15 @@ public:
 
     void optimizeLP(shared_ptr<Stats> stats = nullptr) override;
 
+    /**
+     * @brief hand the predicted working set to the next solve, which hotstarts from
+     * it instead of the working set of the last solve, or initializes from it and
+     * from x and y if the matrices have changed their status
+     */
+    void set_warm_start(const ActiveType* W_constr, const ActiveType* W_bounds,
+                        const double* x, const double* y_bounds,
+                        const double* y_constr) override;
+
     /** @name Getters*/
 //@{
     /**
@@ -116,24 +125,36 @@ public:
     void set_lb(shared_ptr<const Vector> rhs) override;
 
 
+    void set_lb(int location, int length, const double* values) override;
+
+
     void set_ub(int location, double value) override;
 
 
     void set_ub(shared_ptr<const Vector> rhs) override;
 
 
+    void set_ub(int location, int length, const double* values) override;
+
+
     void set_lbA(int location, double value) override;
 
 
     void set_lbA(shared_ptr<const Vector> rhs) override;
 
 
+    void set_lbA(int location, int length, const double* values) override;
+
+
     void set_ubA(int location, double value) override;
 
 
     void set_ubA(shared_ptr<const Vector> rhs) override;
 
 
+    void set_ubA(int location, int length, const double* values) override;
+
+
     void set_g(int location, double value) override;
 
 
@@ -144,11 +165,12 @@ public:
 
     void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) override;
 
+    void set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+               const std::vector<int>& entries) override;
+
     //@}
 
-    void WriteQPDataToFile(Ipopt::EJournalLevel level,
-                           Ipopt::EJournalCategory category,
-                           const string filename) override ;
+    void WriteQPSnapshot(const string filename) override;
 
 
     void reset_constraints() override;
@@ -211,6 +233,12 @@ private:
      */
     void allocate_memory(NLPInfo nlp_info, QPType qptype);
 
+    /**
+     * @brief Allocate the workspace of test_optimality, get_working_set and
+     * set_warm_start, so that they do not allocate memory after each solve
+     */
+    void allocate_workspace();
+
 
     void set_solver_options();
 
@@ -239,6 +267,8 @@ private:
     bool firstQPsolved_ = false; /**< if the first QP has been solved? */
     int nConstr_QP_;  /**< number of constraints for QP*/
     int nVar_QP_;  /**< number of variables for QP*/
+    int bound_multipliers_offset_; /**< of the multipliers of the bounds on x in
+                                     *y_qp_, see FormulationPolicy*/
     OptimalityStatus qpOptimalStatus_;
     shared_ptr<const Options> options_;
     shared_ptr<qpOASES::SymSparseMat> H_qpOASES_;/**< the Matrix object that qpOASES
@@ -258,10 +288,30 @@ private:
     shared_ptr<Vector> ub_;  /**< upper bounds of x */
     shared_ptr<Vector> x_qp_; /** the qp solution */
     shared_ptr<Vector> y_qp_; /** the multiplier corresponding to the optimal solution */
+    /** workspace, sized once by allocate_workspace*/
+    //@{
+    shared_ptr<Vector> Ax_work_;
+    shared_ptr<Vector> Hx_work_;
+    shared_ptr<Vector> stationary_gap_work_;
+    std::vector<int> W_solver_work_; /**< the working set as qpOASES reports it, the
+                                       *bounds followed by the constraints*/
+    std::vector<ActiveType> W_c_work_;
+    std::vector<ActiveType> W_b_work_;
+    //@}
+    bool has_warm_start_ = false; /**< if the next solve starts from the guess
+                                    *below, given by set_warm_start*/
+    qpOASES::Bounds guessed_bounds_;
+    qpOASES::Constraints guessed_constraints_;
+    shared_ptr<Vector> x_guess_;
+    shared_ptr<Vector> y_guess_; /**< the multipliers of the bounds, then of the
+                                   *constraints */
     shared_ptr<SpHbMat> H_;/**< the Matrix object stores the QP data H in
                                           * Harwell-Boeing Sparse Matrix format*/
     shared_ptr<SpHbMat> A_;/**< the Matrix object stores the QP data A in
-                                          * Harwell-Boeing Sparse Matrix format*/
+                                          * Harwell-Boeing Sparse Matrix format, with
+                                          * implicit identity blocks*/
+    shared_ptr<SpHbMat> A_expanded_;/**< A_ with explicit identity blocks, whose
+                                          * arrays A_qpOASES_ points to*/
 
 };
 }
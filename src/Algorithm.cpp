@@ -24,9 +24,16 @@ Algorithm::Algorithm() :
     qp_obj_(0),
     actual_reduction_(0),
     infea_measure_(0.0),
-    infea_measure_model_(0.0) {
+    infea_measure_model_(0.0),
+    is_hessian_constant_(false),
+    hessian_equal_count_(-1),
+    is_multiplier_ls_current_(false),
+    has_multiplier_ls_(false),
+    is_LP_current_(false) {
     jnlst_ = new Ipopt::Journalist();
     roptions2_ = new Ipopt::OptionsList();
+    //TODO: use roptions instead of this one
+    options_ = make_shared<Options>();
 }
 
 
@@ -53,20 +60,45 @@ Algorithm::~Algorithm() {
  * @param nlp: the nlp reader that read data of the function to be minimized;
  */
 void Algorithm::Optimize() {
+    if (options_->printLevel < 2) {
+        //the iterations only go to the file_output journal; a console journal
+        //opened by print_final_stats at the end of a previous solve is silenced
+        //until the final statistics
+        Ipopt::SmartPtr<Ipopt::Journal> stdout_jrnl = jnlst_->GetJournal("console");
+        if (IsValid(stdout_jrnl))
+            stdout_jrnl->SetAllPrintLevels(Ipopt::J_NONE);
+    }
+    trace_stats_ = *stats_;
     while (stats_->iter < options_->iter_max && exitflag_ == UNKNOWN) {
-        iter_time_ = clock();
+        iter_start_ = std::chrono::steady_clock::now();
         setupQP();
+        is_LP_current_ = false;
+        //the LP of the penalty update is only needed if x_k is infeasible
+        if (options_->penalty_update && options_->penalty_concurrent_LP &&
+                infea_measure_ > options_->penalty_update_tol)
+            start_LP();
         //for debugging
         //@{
         //    hessian_->print_full("hessian");
         //    jacobian_->print_full("jacobian");
         //@}
+        //only the dense solver can stop at the objective target
+        if (options_->qp_inexact && myQP_->get_solver() == DENSE) {
+            PhaseTimer timer(stats_.get(), PHASE_QP_SETUP);
+            set_QP_objective_target();
+        }
         try {
             myQP_->solveQP(stats_,
                            options_);//solve the QP subproblem and update the stats_
+            //the penalty update needs the infeasibility of the QP model at its
+            //minimizer, so an early stop with linearized infeasibility is finished
+            //from where it stopped
+            if (myQP_->is_inexact() && options_->penalty_update &&
+                    myQP_->get_infea_measure_model() > options_->penalty_update_tol)
+                myQP_->solveQP(stats_, options_);
         }
         catch (QP_NOT_OPTIMAL) {
-            myQP_->WriteQPData(problem_name_+"qpdata.log");
+            myQP_->WriteQPData(problem_name_+".qpsnap");
             exitflag_ = myQP_->get_status();
             break;
         }
@@ -96,24 +128,10 @@ void Algorithm::Optimize() {
 
         //check if the current iterates is optimal and decide to
         //exit the loop or not
-        if (options_->printLevel >= 2) {
-            if (stats_->iter % 10 == 0) {
-                jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_HEADER);
-                jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, DOUBLE_LONG_DIVIDER);
-            }
-            jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_OUTPUT);
-        }
-        else {
-            jnlst_->DeleteAllJournals();
-            Ipopt::SmartPtr<Ipopt::Journal> logout_jrnl = jnlst_->GetJournal("file_output");
-            if(IsNull(logout_jrnl)) {
-                jnlst_->AddFileJournal("file_output", problem_name_+"_output.log",
-                                       Ipopt::J_ITERSUMMARY);
-
-            }
-            if (IsValid(logout_jrnl)) {
-                logout_jrnl->SetPrintLevel(Ipopt::J_STATISTICS, Ipopt::J_NONE);
-            }
+        {
+            PhaseTimer timer(stats_.get(), PHASE_LOGGING);
+            if (trace_ != nullptr)
+                trace_iteration();
             if (stats_->iter % 10 == 0) {
                 jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_HEADER);
                 jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, DOUBLE_LONG_DIVIDER);
@@ -135,15 +153,19 @@ void Algorithm::Optimize() {
             break;
         }
 
-        iter_time_ = clock()-iter_time_;
-        stats_->total_time += iter_time_;
-        if(((float) stats_->total_time/CLOCKS_PER_SEC)>options_->time_max) {
+        std::chrono::duration<double> iter_time =
+            std::chrono::steady_clock::now() - iter_start_;
+        stats_->total_time += iter_time.count();
+        if(stats_->total_time>options_->time_max) {
             exitflag_ = EXCEED_TIME_LIMITS;
             break;
         }
 
     }
 
+    //an LP the penalty update did not need is not left running after the solve
+    drop_LP();
+
     //check if the current iterates get_status before exiting
     if (stats_->iter == options_->iter_max)
         exitflag_ = EXCEED_MAX_ITER;
@@ -158,6 +180,78 @@ void Algorithm::Optimize() {
 }
 
 
+/**
+ * @brief ReOptimize a problem by hotstarting from the old optimal solution
+ *
+ * Only the data which may have changed is re-read from the nlp: the bounds, and
+ * the function and derivative values at the last accepted iterate. The
+ * structure analysis done by @allocate_memory and by the first QP setup is not
+ * repeated, and the QP solvers hotstart from their last working set.
+ *
+ * @param nlp: the nlp reader that read data of the function to be minimized;
+ */
+void Algorithm::ReOptimize(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
+
+    assert(nlp_ != nullptr);  // initialization has to be called first
+    //an LP left by the previous solve is not for the new iterates
+    drop_LP();
+    if (!nlp_->reset_nlp(nlp)) {
+        exitflag_ = INVALID_NLP;
+        print_final_stats();
+        return;
+    }
+
+    //a failed solve is not a good starting point, restart the trust-region
+    //and the penalty parameter from the user-defined values
+    if (exitflag_ != OPTIMAL) {
+        delta_ = options_->delta;
+        rho_ = options_->rho;
+    }
+    exitflag_ = UNKNOWN;
+    *stats_ = Stats();
+    norm_p_k_ = 0.0;
+    //the bounds, and so the active set, may have changed
+    is_multiplier_ls_current_ = false;
+
+    /*-----------------------------------------------------*/
+    /*         Get the nlp information                     */
+    /*-----------------------------------------------------*/
+    nlp_->Get_bounds_info(x_l_, x_u_, c_l_, c_u_);
+
+    //start from the last accepted iterate, shifted to satisfy the new bounds
+    if (formulation_ == BOX_BOUNDS)
+        nlp_->shift_starting_point(x_k_, x_l_, x_u_);
+    nlp_->Eval_f(x_k_, obj_value_);
+    nlp_->Eval_gradient(x_k_, grad_f_);
+    nlp_->Eval_constraints(x_k_, c_k_);
+    //a quasi-Newton approximation is kept from the previous solve
+    if (hessian_approx_ == nullptr)
+        nlp_->Eval_Hessian(x_k_, multiplier_cons_, hessian_);
+    reset_hessian_constant();
+    nlp_->Eval_Jacobian(x_k_, jacobian_);
+    classify_constraints_types();
+    set_QP_nonlinear_Jacobian_entries();
+
+    infea_measure_ = infea_measure(c_k_, x_k_);
+
+    //since stats_->iter is 0 again, setupQP will push all the data into the QP
+    //solvers, which only updates the values of the matrices already set up.
+    QPinfoFlag_.Update_A = false;
+    QPinfoFlag_.Update_H = false;
+    QPinfoFlag_.Update_bounds = false;
+    QPinfoFlag_.Update_delta = false;
+    QPinfoFlag_.Update_penalty = false;
+    QPinfoFlag_.Update_g = false;
+
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, DOUBLE_LONG_DIVIDER);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_HEADER);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, DOUBLE_LONG_DIVIDER);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_OUTPUT);
+
+    Optimize();
+}
+
+
 /**
  * @brief This is the function that checks if the current point is optimal, and
  * decides if to exit the loop or not
@@ -169,64 +263,15 @@ void Algorithm::Optimize() {
  */
 void Algorithm::check_optimality() {
     //FIXME: not sure if it is better to use the new multiplier or the old one
+    PhaseTimer timer(stats_.get(), PHASE_OPTIMALITY_CHECK);
 
     double primal_violation = 0;
     double dual_violation =0;
     double compl_violation = 0;
     double statioanrity_violation = 0;
 
-    int i;
     get_multipliers();
 
-    if(multiplier_vars_== nullptr)
-        /**-------------------------------------------------------**/
-        /**               Check the KKT conditions                **/
-        /**-------------------------------------------------------**/
-
-        /**-------------------------------------------------------**/
-        /**                    Identify Active Set                **/
-        /**-------------------------------------------------------**/
-        for (i = 0; i < nCon_; i++) {
-            if (cons_type_[i] == BOUNDED_ABOVE) {
-                if (abs(c_u_->values(i) - c_k_->values(i)) <
-                        options_->active_set_tol)
-                    W_constr_[i] = ACTIVE_ABOVE;
-            } else if (cons_type_[i] == BOUNDED_BELOW) {
-                if (abs(c_k_->values(i) - c_l_->values(i)) <
-                        options_->active_set_tol) {
-                    W_constr_[i] = ACTIVE_BELOW;
-                }
-            } else if (cons_type_[i] == EQUAL) {
-                if ((abs(c_u_->values(i) - c_k_->values(i)) <
-                        options_->active_set_tol) &&
-                        (abs(c_k_->values(i) - c_l_->values(i)) <
-                         options_->active_set_tol))
-                    W_constr_[i] = ACTIVE_BOTH_SIDE;
-            } else {
-                W_constr_[i] = INACTIVE;
-            }
-        }
-
-
-    for (i = 0; i < nVar_; i++) {
-        if (bound_cons_type_[i] == BOUNDED_ABOVE) {
-            if (abs(x_u_->values(i) - x_k_->values(i)) <
-                    options_->active_set_tol)
-                W_bounds_[i] = ACTIVE_ABOVE;
-        } else if (bound_cons_type_[i] == BOUNDED_BELOW) {
-            if (abs(x_k_->values(i) - x_l_->values(i)) <
-                    options_->active_set_tol)
-                W_bounds_[i] = ACTIVE_BELOW;
-        } else if (bound_cons_type_[i] == EQUAL) {
-            if ((abs(x_u_->values(i) - x_k_->values(i)) <
-                    options_->active_set_tol) &&
-                    (abs(x_k_->values(i) - x_l_->values(i)) <
-                     options_->active_set_tol))
-                W_bounds_[i] = ACTIVE_BOTH_SIDE;
-        } else {
-            W_bounds_[i] = INACTIVE;
-        }
-    }
     /**-------------------------------------------------------**/
     /**                    Primal Feasibility                 **/
     /**-------------------------------------------------------**/
@@ -234,104 +279,14 @@ void Algorithm::check_optimality() {
     primal_violation += infea_measure_;
 
     /**-------------------------------------------------------**/
-    /**                    Dual Feasibility                   **/
-    /**-------------------------------------------------------**/
-
-    //    multiplier_vars_->print("multiplier_vars");
-    //    multiplier_cons_->print("multiplier_cons");
-    //    x_k_->print("x_k");
-    //    x_l_->print("x_l");
-    //    x_u_->print("x_u");
-    //
-    //    c_k_->print("c_k");
-    //    c_l_->print("c_l");
-    //    c_u_->print("c_u");
-    i = 0;
-    opt_status_.dual_feasibility = true;
-    while (i < nVar_) {
-        if (bound_cons_type_[i] == BOUNDED_ABOVE) {
-            dual_violation += max(multiplier_vars_->values(i), 0.0);
-        } else if (bound_cons_type_[i] == BOUNDED_BELOW) {
-            dual_violation += -min(multiplier_vars_->values(i), 0.0);
-        }
-        i++;
-
-    }
-
-    i = 0;
-    while (i < nCon_) {
-        if (cons_type_[i] == BOUNDED_ABOVE) {
-            dual_violation += max(multiplier_cons_->values(i),0.0);
-        } else if (cons_type_[i] == BOUNDED_BELOW) {
-            dual_violation += -min(multiplier_cons_->values(i),0.0);
-        }
-        i++;
-    }
-
-    /**-------------------------------------------------------**/
-    /**                    Complemtarity                      **/
+    /**   Dual Feasibility, Complemtarity, Stationarity and   **/
+    /**                  Identify Active Set                  **/
     /**-------------------------------------------------------**/
-    //@{
-
-    i = 0;
-    while (i < nCon_ ) {
-        if (cons_type_[i] == BOUNDED_ABOVE) {
-            compl_violation+=abs(multiplier_cons_->values(i) *
-                                 (c_u_->values(i) - c_k_->values(i)));
-        }
-        else if (cons_type_[i] == BOUNDED_BELOW) {
-            compl_violation+=abs(multiplier_cons_->values(i) *
-                                 (c_k_->values(i) - c_l_->values(i)));
-        }
-        else if (cons_type_[i] == UNBOUNDED) {
-            compl_violation+= abs(multiplier_cons_->values(i));
-        }
-        i++;
-    }
-
-    i = 0;
-    while (i < nVar_ ) {
-        if (bound_cons_type_[i] == BOUNDED_ABOVE) {
-            compl_violation+=abs(multiplier_vars_->values(i) *
-                                 (x_u_->values(i) - x_k_->values(i)));
-        }
-        else if (bound_cons_type_[i] == BOUNDED_BELOW) {
-            compl_violation+=abs(multiplier_vars_->values(i) *
-                                 (x_k_->values(i) - x_l_->values(i)));
-        }
-        else if (bound_cons_type_[i] == UNBOUNDED) {
-            compl_violation+= abs(multiplier_vars_->values(i));
-        }
-        i++;
-    }
-    //@{
-    //    c_l_->print("c_l");
-    //    c_u_->print("c_u");
-    //    std::cout<<compl_violation<<std::endl;
-    //    multiplier_vars_->print("multiplier_vars");
-    //    multiplier_cons_->print("multiplier_constr");
-    //@}
-
-    //@}
-    /**-------------------------------------------------------**/
-    /**                    Stationarity                       **/
-    /**-------------------------------------------------------**/
-    //@{
-    shared_ptr<Vector> difference = make_shared<Vector>(nVar_);
-    // the difference of g-J^T y -\lambda
-    //
-//    grad_f_->print("grad_f_");
-//
-//    jacobian_->print_full("jacobian");
-//
-//    multiplier_cons_->print("multiplier_cons_");
-//    multiplier_vars_->print("multiplier_vars_");
-    jacobian_->transposed_times(multiplier_cons_, difference);
-    difference->add_vector(multiplier_vars_->values());
-    difference->subtract_vector(grad_f_->values());
-
-    statioanrity_violation = difference->getOneNorm();
-    //@}
+    if (options_->multiplier_least_squares && least_squares_multipliers())
+        stats_->multiplier_ls_addone();
+    multiplier_violations(multiplier_cons_, multiplier_vars_, dual_violation,
+                          compl_violation, statioanrity_violation, W_constr_,
+                          W_bounds_);
 
 
     /**-------------------------------------------------------**/
@@ -391,6 +346,11 @@ void Algorithm::check_optimality() {
         jnlst_->Printf(Ipopt::J_ALL, Ipopt::J_DBG, SINGLE_DIVIDER);
         jacobian_->print_full("jacobian", jnlst_, Ipopt::J_MOREDETAILED, Ipopt::J_DBG);
         hessian_->print_full("hessian", jnlst_, Ipopt::J_MOREDETAILED, Ipopt::J_DBG);
+        //J^T y + y_vars - g, from the J^T y left in JTy_ by multiplier_violations
+        shared_ptr<Vector> difference = make_shared<Vector>(nVar_);
+        difference->copy_vector(JTy_);
+        difference->add_vector(multiplier_vars_->values());
+        difference->subtract_vector(grad_f_->values());
         difference->print("stationarity gap", jnlst_, Ipopt::J_MOREDETAILED, Ipopt::J_DBG);
         jnlst_->Printf(Ipopt::J_ALL, Ipopt::J_DBG, SINGLE_DIVIDER);
         jnlst_->Printf(Ipopt::J_ALL, Ipopt::J_DBG, "Feasibility      ");
@@ -421,11 +381,7 @@ void Algorithm::get_trial_point_info() {
     nlp_->Eval_f(x_trial_, obj_value_trial_);
     nlp_->Eval_constraints(x_trial_, c_trial_);
 
-#if NEW_FORMULATION
-    infea_measure_trial_ = cal_infea(c_trial_,c_l_,c_u_, x_trial_,x_l_, x_u_);
-#else
-    infea_measure_trial_=cal_infea(c_trial_, c_l_, c_u_); //calculate the infeasibility measure for x_k
-#endif
+    infea_measure_trial_ = infea_measure(c_trial_, x_trial_);
 }
 
 
@@ -454,23 +410,26 @@ void Algorithm::initialization(Ipopt::SmartPtr<Ipopt::TNLP> nlp,
     nlp_->Get_starting_point(x_k_, multiplier_cons_);
 
     //shift starting point to satisfy the bound constraint
-#if not NEW_FORMULATION
-    nlp_->shift_starting_point(x_k_, x_l_, x_u_);
-#endif
+    if (formulation_ == BOX_BOUNDS)
+        nlp_->shift_starting_point(x_k_, x_l_, x_u_);
     nlp_->Eval_f(x_k_, obj_value_);
     nlp_->Eval_gradient(x_k_, grad_f_);
     nlp_->Eval_constraints(x_k_, c_k_);
-    nlp_->Get_Structure_Hessian(x_k_, multiplier_cons_, hessian_);
-    nlp_->Eval_Hessian(x_k_, multiplier_cons_, hessian_);
+    if (hessian_approx_ != nullptr) {
+        hessian_approx_->set_structure(hessian_);
+        hessian_approx_->get_values(hessian_);
+    }
+    else {
+        nlp_->Get_Structure_Hessian(x_k_, multiplier_cons_, hessian_);
+        nlp_->Eval_Hessian(x_k_, multiplier_cons_, hessian_);
+    }
+    reset_hessian_constant();
     nlp_->Get_Strucutre_Jacobian(x_k_, jacobian_);
     nlp_->Eval_Jacobian(x_k_, jacobian_);
     classify_constraints_types();
+    set_QP_nonlinear_Jacobian_entries();
 
-#if NEW_FORMULATION
-    infea_measure_=cal_infea(c_k_, c_l_, c_u_, x_k_, x_l_, x_u_); //calculate the infeasibility measure for x_k
-#else
-    infea_measure_=cal_infea(c_k_, c_l_, c_u_); //calculate the infeasibility measure for x_k
-#endif
+    infea_measure_ = infea_measure(c_k_, x_k_); //calculate the infeasibility measure for x_k
 
     /*-----------------------------------------------------*/
     /*             JOURNAL INIT & OUTPUT                   */
@@ -506,6 +465,14 @@ void Algorithm::initialization(Ipopt::SmartPtr<Ipopt::TNLP> nlp,
         jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, STANDARD_OUTPUT);
     }
 
+    //warned once, the objective target is only computed for DENSE
+    if (options_->qp_inexact && myQP_->get_solver() != DENSE)
+        jnlst_->Printf(Ipopt::J_WARNING, Ipopt::J_MAIN,
+                       "qp_inexact has no effect, the QP solver is not DENSE\n");
+
+    if (!options_->trace_file.empty())
+        trace_ = make_shared<TraceWriter>(options_->trace_file, options_->trace_binary);
+
     //#if DEBUG
     //    Ipopt::SmartPtr<Ipopt::Journal> debug_jrnl =
     //        jnlst_->AddFileJournal("Debug", problem_name_+"debug.log",
@@ -528,10 +495,12 @@ void Algorithm::initialization(Ipopt::SmartPtr<Ipopt::TNLP> nlp,
  */
 void Algorithm::allocate_memory(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
 
-    clock_t t = clock();
-    nlp_ = make_shared<SQPTNLP>(nlp);
+    auto start = std::chrono::steady_clock::now();
+    stats_ = make_shared<Stats>();
+    nlp_ = make_shared<SQPTNLP>(nlp, stats_);
     nVar_ = nlp_->nlp_info_.nVar;
     nCon_ = nlp_->nlp_info_.nCon;
+    formulation_ = options_->formulation;
     cons_type_ = new ConstraintType[nCon_];
     bound_cons_type_ = new ConstraintType[nVar_];
     W_bounds_ = new ActiveType[nVar_];
@@ -549,19 +518,40 @@ void Algorithm::allocate_memory(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
     c_l_ = make_shared<Vector>(nCon_);
     c_u_ = make_shared<Vector>(nCon_);
     grad_f_ = make_shared<Vector>(nVar_);
+    cauchy_d_ = make_shared<Vector>(nVar_);
+    cauchy_Hd_ = make_shared<Vector>(nVar_);
+    cauchy_Jd_ = make_shared<Vector>(nCon_);
+    cauchy_breakpoints_.reserve(2 * (nCon_ + nVar_));
 
     jacobian_ = make_shared<SpTripletMat>(nlp_->nlp_info_.nnz_jac_g, nCon_, nVar_,
                                           false);
-    hessian_ = make_shared<SpTripletMat>(nlp_->nlp_info_.nnz_h_lag, nVar_, nVar_,
-                                         true);
-    //TODO: use roptions instead of this one
-    options_ = make_shared<Options>();
-    stats_ = make_shared<Stats>();
+    //the QP solvers see the dense lower triangle of the Hessian approximation
+    NLPInfo qp_info = nlp_->nlp_info_;
+    if (options_->hessian_approximation != EXACT_HESSIAN) {
+        hessian_approx_ = make_shared<HessianApproximation>(nVar_,
+                          options_->hessian_approximation,
+                          options_->limited_memory_size);
+        qp_info.nnz_h_lag = HessianApproximation::nnz(nVar_);
+    }
+    hessian_ = make_shared<SpTripletMat>(qp_info.nnz_h_lag, nVar_, nVar_, true);
+    jacobian_->set_num_threads(options_->num_threads);
+    hessian_->set_num_threads(options_->num_threads);
 
-    myQP_ = make_shared<QPhandler>(nlp_->nlp_info_,QP, jnlst_, options_);
-    myLP_ = make_shared<QPhandler>(nlp_->nlp_info_,LP, jnlst_, options_);
+    multiplier_solver_ = nullptr;
+    is_multiplier_ls_current_ = false;
+    JTy_ = make_shared<Vector>(nVar_);
 
-    stats_->total_time = clock() - t;
+    myQP_ = make_shared<QPhandler>(qp_info,QP, jnlst_, options_);
+    myLP_ = make_shared<QPhandler>(qp_info,LP, jnlst_, options_);
+    trial_QPs_.clear();
+    //the trial QPs are solved concurrently with myQP_, and a Journalist is not
+    //thread-safe; each one gets its own, which has no journals and prints nothing
+    for (int i = 1; i < options_->penalty_parallel_trials; i++)
+        trial_QPs_.push_back(make_shared<QPhandler>(qp_info, QP,
+                             new Ipopt::Journalist(), options_));
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats_->total_time = elapsed.count();
 
 
 }
@@ -602,6 +592,15 @@ double Algorithm::cal_infea(shared_ptr<const Vector> c_k,
 }
 
 
+double Algorithm::infea_measure(shared_ptr<const Vector> c, shared_ptr<const Vector> x) {
+    //the bounds on x are only penalized by the elastic formulation, the other one
+    //keeps the iterates within them
+    if (formulation_ == ELASTIC_BOUNDS)
+        return cal_infea(c, c_l_, c_u_, x, x_l_, x_u_);
+    return cal_infea(c, c_l_, c_u_);
+}
+
+
 /**
  * @brief This function extracts the search direction for NLP from the QP subproblem
  * solved, and copies it to the class member _p_k
@@ -617,10 +616,11 @@ void Algorithm::get_search_direction() {
  */
 
 void Algorithm::get_multipliers() {
-    if (options_->QPsolverChoice == QORE||options_->QPsolverChoice==QPOASES) {
+    Solver solver = myQP_->get_solver();
+    if (solver == QORE || solver == QPOASES || solver == DENSE) {
         multiplier_cons_->copy_vector(myQP_->get_multipliers_constr());
         multiplier_vars_->copy_vector(myQP_->get_multipliers_bounds());
-    } else if(options_->QPsolverChoice ==GUROBI||options_->QPsolverChoice==CPLEX) {
+    } else if (solver == GUROBI || solver == CPLEX) {
         multiplier_cons_->copy_vector(myQP_->get_multipliers_constr());
         shared_ptr<Vector> tmp_vec_nVar = make_shared<Vector>(nVar_);
         jacobian_->transposed_times(multiplier_cons_,tmp_vec_nVar);
@@ -631,6 +631,265 @@ void Algorithm::get_multipliers() {
 }
 
 
+void Algorithm::get_lagrangian_gradient(shared_ptr<Vector> result) {
+    jacobian_->transposed_times(multiplier_cons_, result);
+    result->subtract_vector_to(grad_f_->values());
+}
+
+
+/** @brief is a constraint or bound of the given type within tol of one of its bounds*/
+static bool is_near_bound(ConstraintType type, double value, double lower,
+                          double upper, double tol) {
+    switch (type) {
+    case EQUAL:
+        return true;
+    case BOUNDED_ABOVE:
+        return abs(upper - value) < tol;
+    case BOUNDED_BELOW:
+        return abs(value - lower) < tol;
+    case BOUNDED:
+        return abs(upper - value) < tol || abs(value - lower) < tol;
+    default:
+        return false;
+    }
+}
+
+
+bool Algorithm::least_squares_multipliers() {
+    if (!is_multiplier_ls_current_) {
+        is_multiplier_ls_current_ = true;
+        has_multiplier_ls_ = false;
+        if (multiplier_solver_ == nullptr) {
+            multiplier_solver_ = make_shared<KKTSolver>(options_->kkt_linear_solver,
+                                 options_->kkt_dense_max_size);
+            multiplier_index_.clear();
+            multiplier_cons_ls_ = make_shared<Vector>(nCon_);
+            multiplier_vars_ls_ = make_shared<Vector>(nVar_);
+        }
+
+        /**-------------------------------------------------------**/
+        /**   number the free variables and active constraints    **/
+        /**-------------------------------------------------------**/
+        std::vector<int> index(nVar_ + nCon_);
+        int nFree = 0;
+        for (int j = 0; j < nVar_; j++)
+            index[j] = is_near_bound(bound_cons_type_[j], x_k_->values(j),
+                                     x_l_->values(j), x_u_->values(j),
+                                     options_->active_set_tol) ? -1 : nFree++;
+        int n = nFree;
+        for (int i = 0; i < nCon_; i++)
+            index[nVar_ + i] = is_near_bound(cons_type_[i], c_k_->values(i),
+                                             c_l_->values(i), c_u_->values(i),
+                                             options_->active_set_tol) ? n++ : -1;
+        int nActive = n - nFree;
+        if (n == 0)
+            return false;
+
+        /**-------------------------------------------------------**/
+        /**     the augmented system, whose pattern only changes  **/
+        /**                  with the active set                  **/
+        /**-------------------------------------------------------**/
+        if (index != multiplier_index_) {
+            multiplier_index_.swap(index);
+            multiplier_jacobian_entries_.clear();
+            for (int k = 0; k < jacobian_->EntryNum(); k++)
+                if (multiplier_index_[nVar_ + jacobian_->RowIndex(k) - 1] >= 0 &&
+                        multiplier_index_[jacobian_->ColIndex(k) - 1] >= 0)
+                    multiplier_jacobian_entries_.push_back(k);
+            multiplier_jacobian_ = make_shared<SpTripletMat>(
+                                       (int) multiplier_jacobian_entries_.size(),
+                                       nActive, nFree);
+            for (size_t e = 0; e < multiplier_jacobian_entries_.size(); e++) {
+                int k = multiplier_jacobian_entries_[e];
+                multiplier_jacobian_->setRowIndex(e, multiplier_index_[nVar_ +
+                                                  jacobian_->RowIndex(k) - 1] - nFree + 1);
+                multiplier_jacobian_->setColIndex(e, multiplier_index_[
+                                                      jacobian_->ColIndex(k) - 1] + 1);
+            }
+            multiplier_solver_->set_structure(nFree, nActive, nullptr,
+                                              multiplier_jacobian_);
+        }
+        for (size_t e = 0; e < multiplier_jacobian_entries_.size(); e++)
+            multiplier_jacobian_->setMatValAt(e, jacobian_->MatVal(
+                                                  multiplier_jacobian_entries_[e]));
+        multiplier_solver_->set_values(nullptr, multiplier_jacobian_, NULL, 1.0,
+                                       options_->multiplier_least_squares_reg);
+
+        multiplier_rhs_.assign(n, 0.0);
+        for (int j = 0; j < nVar_; j++)
+            if (multiplier_index_[j] >= 0)
+                multiplier_rhs_[multiplier_index_[j]] = grad_f_->values(j);
+        //without estimates, the multipliers of the QP are kept
+        try {
+            if (!multiplier_solver_->solve(multiplier_rhs_.data()))
+                return false;
+        }
+        catch (KKT_SOLVER_ERROR) {
+            return false;
+        }
+
+        multiplier_cons_ls_->set_zeros();
+        for (int i = 0; i < nCon_; i++)
+            if (multiplier_index_[nVar_ + i] >= 0)
+                multiplier_cons_ls_->setValueAt(i,
+                                                multiplier_rhs_[multiplier_index_[nVar_ + i]]);
+        //the bounds at x_k take the rest of grad_f - J^T lambda
+        jacobian_->transposed_times(multiplier_cons_ls_, multiplier_vars_ls_);
+        for (int j = 0; j < nVar_; j++)
+            multiplier_vars_ls_->setValueAt(j, multiplier_index_[j] >= 0 ? 0.0 :
+                                            grad_f_->values(j) -
+                                            multiplier_vars_ls_->values(j));
+        has_multiplier_ls_ = true;
+    }
+    if (!has_multiplier_ls_)
+        return false;
+
+    double dual_violation, compl_violation, stationarity_violation;
+    multiplier_violations(multiplier_cons_, multiplier_vars_, dual_violation,
+                          compl_violation, stationarity_violation);
+    double KKT_error = dual_violation + compl_violation + stationarity_violation;
+    multiplier_violations(multiplier_cons_ls_, multiplier_vars_ls_, dual_violation,
+                          compl_violation, stationarity_violation);
+    if (dual_violation + compl_violation + stationarity_violation >= KKT_error)
+        return false;
+    multiplier_cons_->copy_vector(multiplier_cons_ls_);
+    multiplier_vars_->copy_vector(multiplier_vars_ls_);
+    return true;
+}
+
+
+/**
+ * @brief the constraints or the bounds in the structure-of-arrays layout of the
+ * residual kernel, with value[i] in [lower[i], upper[i]] and multiplier y[i]. For
+ * the bounds, the stationarity residual JTy[i] + y[i] - g[i] is also summed.
+ */
+struct KKTRows {
+    const ConstraintType* type;
+    const double* value;
+    const double* lower;
+    const double* upper;
+    const double* y;
+    const double* JTy;  /**< NULL for the constraints*/
+    const double* g;
+    ActiveType* W;      /**< the active set, NULL if it is not identified*/
+};
+
+
+struct KKTResiduals {
+    double dual = 0.0;
+    double complementarity = 0.0;
+    double stationarity = 0.0;
+};
+
+
+/** the rows in a block of the residual kernel; the partial sums of the blocks are
+ * added in order, so that the residuals do not depend on the number of threads*/
+const int KKT_RESIDUAL_BLOCK = 4096;
+
+
+/** @brief add the residuals of rows [begin, end) to r, in a single pass*/
+static void kkt_residuals(const KKTRows &rows, int begin, int end, double tol,
+                          KKTResiduals &r) {
+    for (int i = begin; i < end; i++) {
+        double y = rows.y[i];
+        double to_upper = rows.upper[i] - rows.value[i];
+        double to_lower = rows.value[i] - rows.lower[i];
+        switch (rows.type[i]) {
+        case BOUNDED_ABOVE:
+            r.dual += max(y, 0.0);
+            r.complementarity += abs(y * to_upper);
+            if (rows.W != NULL && abs(to_upper) < tol)
+                rows.W[i] = ACTIVE_ABOVE;
+            break;
+        case BOUNDED_BELOW:
+            r.dual += -min(y, 0.0);
+            r.complementarity += abs(y * to_lower);
+            if (rows.W != NULL && abs(to_lower) < tol)
+                rows.W[i] = ACTIVE_BELOW;
+            break;
+        case EQUAL:
+            if (rows.W != NULL && abs(to_upper) < tol && abs(to_lower) < tol)
+                rows.W[i] = ACTIVE_BOTH_SIDE;
+            break;
+        case UNBOUNDED:
+            r.complementarity += abs(y);
+            if (rows.W != NULL)
+                rows.W[i] = INACTIVE;
+            break;
+        default:
+            if (rows.W != NULL)
+                rows.W[i] = INACTIVE;
+        }
+        if (rows.JTy != NULL)
+            r.stationarity += abs(rows.JTy[i] + y - rows.g[i]);
+    }
+}
+
+
+/** @brief the residuals of all the length rows, over up to max_threads threads*/
+static KKTResiduals kkt_residuals(const KKTRows &rows, int length, double tol,
+                                  int max_threads) {
+    int num_blocks = (length + KKT_RESIDUAL_BLOCK - 1) / KKT_RESIDUAL_BLOCK;
+    std::vector<KKTResiduals> partial(num_blocks);
+    int num_threads = min(num_threads_for(length, max_threads), max(num_blocks, 1));
+    parallel_for(num_threads, [&](int t) {
+        int end = chunk_begin(num_blocks, t + 1, num_threads);
+        for (int b = chunk_begin(num_blocks, t, num_threads); b < end; b++)
+            kkt_residuals(rows, b * KKT_RESIDUAL_BLOCK,
+                          min(length, (b + 1) * KKT_RESIDUAL_BLOCK), tol, partial[b]);
+    });
+    KKTResiduals result;
+    for (const KKTResiduals &r : partial) {
+        result.dual += r.dual;
+        result.complementarity += r.complementarity;
+        result.stationarity += r.stationarity;
+    }
+    return result;
+}
+
+
+void Algorithm::multiplier_violations(shared_ptr<const Vector> y_cons,
+                                      shared_ptr<const Vector> y_vars,
+                                      double &dual_violation, double &compl_violation,
+                                      double &stationarity_violation,
+                                      ActiveType* W_constr, ActiveType* W_bounds) {
+    //the stationarity residual is J^T y_cons + y_vars - grad_f
+    jacobian_->transposed_times(y_cons, JTy_);
+
+    KKTRows bounds = {bound_cons_type_, x_k_->values(), x_l_->values(),
+                      x_u_->values(), y_vars->values(), JTy_->values(),
+                      grad_f_->values(), W_bounds
+                     };
+    KKTRows constraints = {cons_type_, c_k_->values(), c_l_->values(),
+                           c_u_->values(), y_cons->values(), NULL, NULL, W_constr
+                          };
+    KKTResiduals r_bounds = kkt_residuals(bounds, nVar_, options_->active_set_tol,
+                                          options_->num_threads);
+    KKTResiduals r_constraints = kkt_residuals(constraints, nCon_,
+                                 options_->active_set_tol, options_->num_threads);
+
+    dual_violation = r_bounds.dual + r_constraints.dual;
+    compl_violation = r_bounds.complementarity + r_constraints.complementarity;
+    stationarity_violation = r_bounds.stationarity;
+}
+
+
+/**
+ * @brief update the quasi-Newton approximation of the Hessian by the pair
+ *      s_k = x_k-x_{k-1},
+ *      y_k = grad L(x_k,lambda_k)-grad L(x_{k-1},lambda_k),
+ * and copy it to hessian_.
+ */
+void Algorithm::update_hessian_approximation(shared_ptr<const Vector> s_k,
+        shared_ptr<const Vector> grad_lag_old) {
+    shared_ptr<Vector> y_k = make_shared<Vector>(nVar_);
+    get_lagrangian_gradient(y_k);
+    y_k->subtract_vector(grad_lag_old->values());
+    hessian_approx_->update(s_k, y_k);
+    hessian_approx_->get_values(hessian_);
+}
+
+
 DECLARE_STD_EXCEPTION(QP_UNCHANGED);
 
 /**
@@ -643,6 +902,7 @@ DECLARE_STD_EXCEPTION(QP_UNCHANGED);
 
 
 void Algorithm::setupQP() {
+    PhaseTimer timer(stats_.get(), PHASE_QP_SETUP);
     if (stats_->iter == 0) {
         myQP_->set_A(jacobian_);
         myQP_->set_H(hessian_);
@@ -704,6 +964,152 @@ void Algorithm::setupLP() {
 }
 
 
+void Algorithm::start_LP() {
+    //myLP_ is set up again, so an LP still running is waited for first
+    drop_LP();
+    setupLP();
+    LP_stats_ = make_shared<Stats>();
+    LP_solve_ = std::async(std::launch::async, [this]() {
+        myLP_->solveLP(LP_stats_);
+    });
+    is_LP_current_ = true;
+}
+
+
+void Algorithm::drop_LP() {
+    if (!LP_solve_.valid())
+        return;
+    try {
+        LP_solve_.get();
+    }
+    catch (LP_NOT_OPTIMAL) {
+        //the penalty update did not take this LP, so its failure does not matter
+    }
+    is_LP_current_ = false;
+}
+
+
+void Algorithm::finish_LP() {
+    LP_solve_.wait();
+    stats_->qp_iter_addValue(LP_stats_->qp_iter);
+    const PhaseTime &LP_time = LP_stats_->get_phase_time(PHASE_LP_SOLVE);
+    if (LP_time.count > 0)
+        stats_->phase_time_add(PHASE_LP_SOLVE, LP_time.total);
+    //rethrows LP_NOT_OPTIMAL
+    LP_solve_.get();
+}
+
+
+double Algorithm::cauchy_decrease() {
+    if (formulation_ == ELASTIC_BOUNDS)
+        return cauchy_decrease<ELASTIC_BOUNDS>();
+    return cauchy_decrease<BOX_BOUNDS>();
+}
+
+
+template <Formulation F>
+double Algorithm::cauchy_decrease() {
+    double* d = cauchy_d_->values();
+    double* Jd = cauchy_Jd_->values();
+    const double* c = c_k_->values();
+    const double* x = x_k_->values();
+
+    //the steepest descent direction of the model at p = 0, where it is
+    //differentiable, -(g + rho J^T sigma) with sigma_i the sign of the violation
+    //of constraint i
+    for (int i = 0; i < nCon_; i++)
+        Jd[i] = c[i] < c_l_->values(i) ? -1.0 : c[i] > c_u_->values(i) ? 1.0 : 0.0;
+    jacobian_->transposed_times(cauchy_Jd_, cauchy_d_);
+    for (int j = 0; j < nVar_; j++) {
+        d[j] = -grad_f_->values(j) - rho_ * d[j];
+        if (FormulationPolicy<F>::penalizes_bounds) {
+            if (x[j] < x_l_->values(j))
+                d[j] += rho_;
+            else if (x[j] > x_u_->values(j))
+                d[j] -= rho_;
+        }
+    }
+
+    //scaled to the trust region, and projected onto it, so that the path t*d,
+    //0 <= t <= 1, stays in the QP bounds
+    double d_norm = cauchy_d_->getInfNorm();
+    if (d_norm == 0.0)
+        return 0.0;
+    for (int j = 0; j < nVar_; j++) {
+        double lower = -delta_;
+        double upper = delta_;
+        if (!FormulationPolicy<F>::penalizes_bounds) {
+            lower = std::min(std::max(lower, x_l_->values(j) - x[j]), 0.0);
+            upper = std::max(std::min(upper, x_u_->values(j) - x[j]), 0.0);
+        }
+        d[j] = std::min(std::max(d[j] * delta_ / d_norm, lower), upper);
+    }
+    hessian_->times(cauchy_d_, cauchy_Hd_);
+    jacobian_->times(cauchy_d_, cauchy_Jd_);
+    double gd = grad_f_->times(cauchy_d_);
+    double dHd = cauchy_d_->times(cauchy_Hd_);
+
+    //the penalty term sum_i dist(r_i + t s_i, [l_i, u_i]) has the slope slope at
+    //t = 0+, which increases by |s_i| whenever r_i + t s_i crosses l_i or u_i
+    double slope = 0.0;
+    cauchy_breakpoints_.clear();
+    auto add_penalty_term = [&](double r, double s, double l, double u) {
+        if (s == 0.0)
+            return;
+        if (r < l || (r == l && s < 0.0))
+            slope -= s;
+        else if (r > u || (r == u && s > 0.0))
+            slope += s;
+        if (l > -INF && (l - r) / s > 0.0 && (l - r) / s < 1.0)
+            cauchy_breakpoints_.push_back(std::make_pair((l - r) / s, std::fabs(s)));
+        if (u < INF && (u - r) / s > 0.0 && (u - r) / s < 1.0)
+            cauchy_breakpoints_.push_back(std::make_pair((u - r) / s, std::fabs(s)));
+    };
+    for (int i = 0; i < nCon_; i++)
+        add_penalty_term(c[i], Jd[i], c_l_->values(i), c_u_->values(i));
+    if (FormulationPolicy<F>::penalizes_bounds) {
+        for (int j = 0; j < nVar_; j++)
+            add_penalty_term(x[j], d[j], x_l_->values(j), x_u_->values(j));
+    }
+    std::sort(cauchy_breakpoints_.begin(), cauchy_breakpoints_.end());
+
+    //on each piece [t_a, t_b], the change of the model is
+    //gd t + dHd t^2 / 2 + rho (penalty_a + slope (t - t_a)),
+    //whose minimum is at t_b or at its stationary point
+    double best = 0.0;
+    double t_a = 0.0;
+    double penalty_a = 0.0;
+    for (size_t k = 0; k <= cauchy_breakpoints_.size(); k++) {
+        double t_b = k < cauchy_breakpoints_.size() ? cauchy_breakpoints_[k].first : 1.0;
+        auto model_change = [&](double t) {
+            return gd * t + 0.5 * dHd * t * t + rho_ * (penalty_a + slope * (t - t_a));
+        };
+        best = std::min(best, model_change(t_b));
+        if (dHd > 0.0) {
+            double t_min = -(gd + rho_ * slope) / dHd;
+            if (t_min > t_a && t_min < t_b)
+                best = std::min(best, model_change(t_min));
+        }
+        if (k < cauchy_breakpoints_.size()) {
+            penalty_a += slope * (t_b - t_a);
+            slope += cauchy_breakpoints_[k].second;
+            t_a = t_b;
+        }
+    }
+    return -best;
+}
+
+
+void Algorithm::set_QP_objective_target() {
+    double decrease = cauchy_decrease();
+    double scale = std::max(1.0, fabs(obj_value_) + rho_ * infea_measure_);
+    //the QP objective at p = 0 is rho*infea_measure_, as in pred_reduction_
+    if (decrease > options_->qp_inexact_tol * scale)
+        myQP_->set_objective_target(rho_ * infea_measure_ -
+                                    options_->qp_inexact_decrease * decrease);
+}
+
+
 /**
  *
  * @brief This function performs the ratio test to determine if we should accept
@@ -769,7 +1175,7 @@ void Algorithm::ratio_test() {
             && actual_reduction_ >= -options_->tol)
 #else
     if (pred_reduction_ < -1.0e-8) {
-        //    myQP_->WriteQPData(problem_name_+"qpdata.log");
+        //    myQP_->WriteQPData(problem_name_+".qpsnap");
         exitflag_ = PRED_REDUCTION_NEGATIVE;
         return;
     }
@@ -781,18 +1187,43 @@ void Algorithm::ratio_test() {
         infea_measure_ = infea_measure_trial_;
 
         obj_value_ = obj_value_trial_;
+        shared_ptr<Vector> s_k;
+        if (hessian_approx_ != nullptr) {
+            s_k = make_shared<Vector>(nVar_, x_trial_->values());
+            s_k->subtract_vector(x_k_->values());
+        }
         x_k_->copy_vector(x_trial_->values());
         c_k_->copy_vector(c_trial_->values());
         //update function information by reading from nlp_ object
         get_multipliers();
+        shared_ptr<Vector> grad_lag_old;
+        if (hessian_approx_ != nullptr) {
+            grad_lag_old = make_shared<Vector>(nVar_);
+            get_lagrangian_gradient(grad_lag_old);
+        }
         nlp_->Eval_gradient(x_k_, grad_f_);
         nlp_->Eval_Jacobian(x_k_, jacobian_);
-        nlp_->Eval_Hessian(x_k_, multiplier_cons_, hessian_);
+        is_multiplier_ls_current_ = false;
+        if (hessian_approx_ != nullptr) {
+            update_hessian_approximation(s_k, grad_lag_old);
+            QPinfoFlag_.Update_H = true;
+        }
+        else if (!is_hessian_constant_) {
+            //the multipliers of the QP may be those of a second-order correction
+            //or of a previous penalty parameter
+            if (options_->multiplier_least_squares)
+                least_squares_multipliers();
+            nlp_->Eval_Hessian(x_k_, multiplier_cons_, hessian_);
+            QPinfoFlag_.Update_H = check_hessian_constant();
+        }
 
         QPinfoFlag_.Update_A = true;
-        QPinfoFlag_.Update_H = true;
         QPinfoFlag_.Update_bounds = true;
         QPinfoFlag_.Update_g = true;
+        //the last QP solved gave the accepted step, the QP at x_k is expected to
+        //have nearly the same working set
+        if (options_->qp_warm_start)
+            myQP_->warm_start_next_QP();
 
         isaccept_ = true;    //no need to calculate the SOC direction
     } else {
@@ -879,6 +1310,61 @@ void Algorithm::classify_constraints_types() {
 }
 
 
+void Algorithm::set_QP_nonlinear_Jacobian_entries() {
+    const std::vector<int>& entries = nlp_->nonlinear_Jacobian_entries();
+    myQP_->set_A_nonlinear_entries(entries);
+    myLP_->set_A_nonlinear_entries(entries);
+    for (auto &qp : trial_QPs_)
+        qp->set_A_nonlinear_entries(entries);
+}
+
+
+void Algorithm::reset_hessian_constant() {
+    is_hessian_constant_ = hessian_approx_ == nullptr &&
+                           (options_->hessian_constant || nlp_->is_linear_program());
+    //the Hessian of the Lagrangian depends on the multipliers unless the
+    //constraints are linear
+    bool is_checked = hessian_approx_ == nullptr && !is_hessian_constant_ &&
+                      options_->hessian_constant_checks > 0 &&
+                      nlp_->are_constraints_linear();
+    hessian_equal_count_ = is_checked ? 0 : -1;
+    if (is_checked)
+        hessian_last_.assign(hessian_->MatVal(), hessian_->MatVal() + hessian_->EntryNum());
+    else
+        hessian_last_.clear();
+    set_QP_hessian_constant();
+}
+
+
+bool Algorithm::check_hessian_constant() {
+    if (hessian_equal_count_ < 0)
+        return true;
+    const double* values = hessian_->MatVal();
+    if (!std::equal(hessian_last_.begin(), hessian_last_.end(), values)) {
+        hessian_equal_count_ = -1;
+        hessian_last_.clear();
+        return true;
+    }
+    if (++hessian_equal_count_ >= options_->hessian_constant_checks) {
+        jnlst_->Printf(Ipopt::J_DETAILED, Ipopt::J_MAIN,
+                       "The Hessian is taken to be constant from iteration %i.\n",
+                       stats_->iter);
+        is_hessian_constant_ = true;
+        hessian_equal_count_ = -1;
+        hessian_last_.clear();
+        set_QP_hessian_constant();
+    }
+    return false;
+}
+
+
+void Algorithm::set_QP_hessian_constant() {
+    myQP_->set_H_constant(is_hessian_constant_);
+    for (auto &qp : trial_QPs_)
+        qp->set_H_constant(is_hessian_constant_);
+}
+
+
 /**
  * @brief update the penalty parameter for the algorithm.
  *
@@ -893,10 +1379,11 @@ void Algorithm::update_penalty_parameter() {
         if (infea_measure_model_ > options_->penalty_update_tol) {
             double infea_measure_model_tmp = infea_measure_model_;//temporarily store the value
             double rho_trial = rho_;//the temporary trial value for rho
-            setupLP();
 
             try {
-                myLP_->solveLP(stats_);
+                if (!is_LP_current_)
+                    start_LP();
+                finish_LP();
             }
             catch (LP_NOT_OPTIMAL) {
                 exitflag_ = myLP_->get_status();
@@ -911,65 +1398,20 @@ void Algorithm::update_penalty_parameter() {
                 // infeasibility measure of QP model with such penalty parameter
                 // becomes zero
 
-                while (infea_measure_model_ > options_->penalty_update_tol) {
-                    if (rho_trial >= options_->rho_max) {
-                        break;
-                    }//TODO:safeguarded procedure...put here for now
-
-                    rho_trial = min(options_->rho_max,
-                                    rho_trial*options_->increase_parm);  //increase rho
-
-                    stats_->penalty_change_trial_addone();
-
-                    myQP_->update_penalty(rho_trial);
-
-                    try {
-                        myQP_->solveQP(stats_, options_);
-                    }
-                    catch (QP_NOT_OPTIMAL) {
-                        exitflag_ = myQP_->get_status();
-                        break;
-                    }
-
-                    //recalculate the infeasibility measure of the model by
-                    // calculating the one norm of the slack variables
-
-                    infea_measure_model_ = myQP_->get_infea_measure_model();
-
-                }
+                //TODO:safeguarded procedure...put here for now
+                increase_penalty(rho_trial, [this]() {
+                    return infea_measure_model_ > options_->penalty_update_tol;
+                });
             } else {
-                while ((infea_measure_ - infea_measure_model_) <
-                        options_->eps1 * (infea_measure_ - infea_measure_infty) &&
-                        (stats_->penalty_change_trial <
-                         options_->penalty_iter_max)) {
-
-
-                    if (rho_trial >= options_->rho_max) {
-                        break;
-                    }
-
-                    //try to increase the penalty parameter to a number such that
-                    // the incurred reduction for the QP model is to a ratio to the
-                    // maximum possible reduction for current linear model.
-                    rho_trial = min(options_->rho_max, rho_trial*options_->increase_parm);
-
-                    stats_->penalty_change_trial_addone();
-
-                    myQP_->update_penalty(rho_trial);
-
-                    try {
-                        myQP_->solveQP(stats_, options_);
-                    }
-                    catch (QP_NOT_OPTIMAL) {
-                        exitflag_ = myQP_->get_status();
-                        break;
-                    }
-
-                    //recalculate the infeasibility measure of the model by
-                    // calculating the one norm of the slack variables
-
-                    infea_measure_model_ = myQP_->get_infea_measure_model();
-                }
+                //try to increase the penalty parameter to a number such that
+                // the incurred reduction for the QP model is to a ratio to the
+                // maximum possible reduction for current linear model.
+                increase_penalty(rho_trial, [this, infea_measure_infty]() {
+                    return (infea_measure_ - infea_measure_model_) <
+                           options_->eps1 * (infea_measure_ - infea_measure_infty) &&
+                           (stats_->penalty_change_trial <
+                            options_->penalty_iter_max);
+                });
             }
             //if any change occurs
             if (rho_trial > rho_) {
@@ -1028,6 +1470,115 @@ void Algorithm::update_penalty_parameter() {
 }
 
 
+void Algorithm::increase_penalty(double &rho_trial,
+                                 const std::function<bool()> &keep_increasing) {
+    if (trial_QPs_.empty()) {
+        while (keep_increasing() && rho_trial < options_->rho_max) {
+            rho_trial = min(options_->rho_max,
+                            rho_trial*options_->increase_parm);  //increase rho
+
+            stats_->penalty_change_trial_addone();
+
+            myQP_->update_penalty(rho_trial);
+
+            try {
+                myQP_->solveQP(stats_, options_);
+            }
+            catch (QP_NOT_OPTIMAL) {
+                exitflag_ = myQP_->get_status();
+                break;
+            }
+
+            //recalculate the infeasibility measure of the model by
+            // calculating the one norm of the slack variables
+
+            infea_measure_model_ = myQP_->get_infea_measure_model();
+        }
+        return;
+    }
+
+    load_penalty_trials(rho_trial);
+    std::vector<double> rho_candidates;
+    std::vector<std::exception_ptr> errors;
+    bool is_stopped = false;
+    while (!is_stopped && keep_increasing() && rho_trial < options_->rho_max) {
+        //the values the serial rule would try next, up to rho_max
+        rho_candidates.clear();
+        double rho = rho_trial;
+        while (rho_candidates.size() <= trial_QPs_.size() && rho < options_->rho_max) {
+            rho = min(options_->rho_max, rho*options_->increase_parm);
+            rho_candidates.push_back(rho);
+        }
+        solve_penalty_trials(rho_candidates, errors);
+
+        //replay the serial rule on the solutions, in increasing order of rho
+        int chosen = 0;
+        for (int i = 0; i < (int) rho_candidates.size(); i++) {
+            if (i > 0 && !keep_increasing())
+                break;
+            chosen = i;
+            rho_trial = rho_candidates[i];
+            stats_->penalty_change_trial_addone();
+            shared_ptr<QPhandler> qp = i == 0 ? myQP_ : trial_QPs_[i - 1];
+            if (errors[i]) {
+                try {
+                    std::rethrow_exception(errors[i]);
+                }
+                catch (QP_NOT_OPTIMAL) {
+                    exitflag_ = qp->get_status();
+                    is_stopped = true;
+                    break;
+                }
+            }
+            infea_measure_model_ = qp->get_infea_measure_model();
+        }
+        //myQP_ keeps its journalist, only the QP solved with rho_trial moves
+        if (chosen > 0)
+            myQP_->swap_state(*trial_QPs_[chosen - 1]);
+    }
+}
+
+
+void Algorithm::load_penalty_trials(double rho) {
+    //only the QP data of the current iterate, which is the same for all of them;
+    //the penalty terms of g are set for each candidate by solve_penalty_trials
+    parallel_for((int) trial_QPs_.size(), [&](int t) {
+        shared_ptr<QPhandler> qp = trial_QPs_[t];
+        qp->set_A(jacobian_);
+        qp->set_H(hessian_);
+        qp->set_bounds(delta_, x_l_, x_u_, x_k_, c_l_, c_u_, c_k_);
+        qp->set_g(grad_f_, rho);
+    });
+}
+
+
+void Algorithm::solve_penalty_trials(const std::vector<double> &rho_candidates,
+                                     std::vector<std::exception_ptr> &errors) {
+    int num_trials = (int) rho_candidates.size();
+    errors.assign(num_trials, nullptr);
+    //the QP solves share no data but the NLP information, which is only read; each
+    //one counts its iterations in its own stats, and the wall-clock time of the
+    //whole batch is recorded once
+    std::vector<shared_ptr<Stats>> trial_stats(num_trials);
+    {
+        PhaseTimer timer(stats_.get(), PHASE_QP_SOLVE);
+        parallel_for(num_trials, [&](int t) {
+            trial_stats[t] = make_shared<Stats>();
+            try {
+                shared_ptr<QPhandler> qp = t == 0 ? myQP_ : trial_QPs_[t - 1];
+                qp->update_penalty(rho_candidates[t]);
+                qp->solveQP(trial_stats[t], options_);
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (int t = 0; t < num_trials; t++)
+        stats_->qp_iter_addValue(trial_stats[t]->qp_iter);
+}
+
+
 /**
  * @brief Use the Ipopt Reference Options and set it to default values.
  */
@@ -1144,6 +1695,7 @@ void Algorithm::setDefaultOption() {
 void Algorithm::second_order_correction() {
     //FIXME: check correctness
     if ((!isaccept_) && options_->second_order_correction) {
+        PhaseTimer timer(stats_.get(), PHASE_SOC);
         isaccept_ = false;
 
 #if DEBUG
@@ -1188,7 +1740,7 @@ void Algorithm::second_order_correction() {
             myQP_->solveQP(stats_, options_);
         }
         catch (QP_NOT_OPTIMAL) {
-            myQP_->WriteQPData(problem_name_+"qpdata.log");
+            myQP_->WriteQPData(problem_name_+".qpsnap");
             exitflag_ = myQP_->get_status();
             THROW_EXCEPTION(QP_NOT_OPTIMAL,QP_NOT_OPTIMAL_MSG);
         }
@@ -1221,6 +1773,26 @@ double Algorithm::get_obj_QP() {
 }
 
 
+void Algorithm::trace_iteration() {
+    IterationRecord record;
+    record.iter = stats_->iter;
+    record.qp_iter = stats_->qp_iter - trace_stats_.qp_iter;
+    record.accepted = isaccept_ ? 1 : 0;
+    record.padding = 0;
+    record.f = obj_value_;
+    record.infea_measure = infea_measure_;
+    record.rho = rho_;
+    record.delta = delta_;
+    record.norm_p = norm_p_k_;
+    record.qp_kkt_error = myQP_->get_QpOptimalStatus().KKT_error;
+    for (int i = 0; i < N_TIMED_PHASES; i++)
+        record.phase_time[i] = stats_->phase_time[i].total -
+                               trace_stats_.phase_time[i].total;
+    trace_->push(record);
+    trace_stats_ = *stats_;
+}
+
+
 void Algorithm::print_final_stats() {
     if(options_ ->printLevel>0) {
         Ipopt::SmartPtr<Ipopt::Journal> stdout_jrnl = jnlst_->GetJournal("console");
@@ -1345,6 +1917,11 @@ void Algorithm::print_final_stats() {
                        "Exitflag:                                                   %23s\n",
                        "STEP_LARGER_THAN_TRUST_REGION");
         break;
+    case QP_SUFFICIENT_DECREASE:
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "Exitflag:                                                   %23s\n",
+                       "QP_SUFFICIENT_DECREASE");
+        break;
     case QPERROR_UNKNOWN:
         jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                        "Exitflag:                                                   %23s\n",
@@ -1370,12 +1947,31 @@ void Algorithm::print_final_stats() {
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                    "QP Solver Iterations:                                       %23i\n",
                    stats_->qp_iter);
+    if (options_->qp_working_set_stable > 0)
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "QPs Solved on the Working Set:                              %23i\n",
+                       stats_->qp_working_set);
+    if (options_->multiplier_least_squares)
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "Least-Squares Multiplier Estimates Used:                    %23i\n",
+                       stats_->multiplier_ls);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                   "Function Evaluations (f/c/grad/jac/hess):  %8i%8i%8i%8i%8i\n",
+                   stats_->f_eval, stats_->c_eval, stats_->grad_eval,
+                   stats_->jac_eval, stats_->hess_eval);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                   "Evaluation Cache Hit Rate:                                  %23.16e\n",
+                   stats_->eval_cache_hit_rate());
+    if (hessian_approx_ != nullptr)
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "Quasi-Newton Updates (used/skipped):                        %11i%12i\n",
+                       hessian_approx_->num_updates(), hessian_approx_->num_skipped());
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                    "Final Objectives:                                           %23.16e\n",
                    obj_value_);
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                    "Total Times:                                                %23.16e\n",
-                   (float)stats_->total_time/CLOCKS_PER_SEC);
+                   stats_->total_time);
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                    "Primal Feasibility Violation                                %23.16e\n",
                    opt_status_.primal_violation);
@@ -1395,6 +1991,24 @@ void Algorithm::print_final_stats() {
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
                    "||c_k||                                                     %23.16e\n",
                    infea_measure_);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, SINGLE_DIVIDER);
+    jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                   "Wall-Clock Time (s)            count        total         mean"
+                   "          min          max\n");
+    for (int i = 0; i < N_TIMED_PHASES; i++) {
+        const PhaseTime& phase_time = stats_->get_phase_time((TimedPhase) i);
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "%-24s %11i %12.4e %12.4e %12.4e %12.4e\n",
+                       Stats::phase_name((TimedPhase) i), phase_time.count,
+                       phase_time.total, phase_time.mean(), phase_time.min,
+                       phase_time.max);
+    }
+    if (trace_ != nullptr && trace_->dropped() > 0) {
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, SINGLE_DIVIDER);
+        jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN,
+                       "Trace Records Dropped                                       %23zu\n",
+                       trace_->dropped());
+    }
 
     jnlst_->Printf(Ipopt::J_ITERSUMMARY, Ipopt::J_MAIN, DOUBLE_LONG_DIVIDER);
 
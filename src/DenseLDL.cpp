@@ -0,0 +1,175 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#include <sqphot/DenseLDL.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace SQPhotstart {
+
+using namespace std;
+
+DenseLDL::DenseLDL() :
+    n_(0),
+    num_positive_(0),
+    num_negative_(0) {
+}
+
+
+void DenseLDL::symmetric_swap(int i, int k) {
+    for (int j = k + 1; j < n_; j++)
+        swap(L(j, i), L(j, k));
+    for (int j = i + 1; j < k; j++)
+        swap(L(j, i), L(k, j));
+    swap(L(i, i), L(k, k));
+}
+
+
+bool DenseLDL::factorize(int n, const double* K, double pivot_tol) {
+    //the growth of the entries of L is bounded for this alpha
+    const double alpha = (1.0 + sqrt(17.0)) / 8.0;
+    n_ = n;
+    num_positive_ = num_negative_ = 0;
+    LD_.resize(n * n);
+    pivot_.resize(n);
+    double K_max = 0.0;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j <= i; j++) {
+            L(i, j) = K[i * n + j];
+            K_max = max(K_max, fabs(L(i, j)));
+        }
+    double tol = pivot_tol * max(K_max, 1.0);
+
+    int k = 0;
+    while (k < n) {
+        int step = 1;
+        int kp = k;
+        double a_kk = fabs(L(k, k));
+        //the largest entry below the diagonal in column k
+        int imax = k;
+        double colmax = 0.0;
+        for (int i = k + 1; i < n; i++)
+            if (fabs(L(i, k)) > colmax) {
+                colmax = fabs(L(i, k));
+                imax = i;
+            }
+        if (max(a_kk, colmax) <= tol)
+            return false;
+
+        if (a_kk < alpha * colmax) {
+            //the largest entry off the diagonal in row and column imax
+            double rowmax = 0.0;
+            for (int j = k; j < imax; j++)
+                rowmax = max(rowmax, fabs(L(imax, j)));
+            for (int i = imax + 1; i < n; i++)
+                rowmax = max(rowmax, fabs(L(i, imax)));
+            if (a_kk * rowmax < alpha * colmax * colmax)
+                kp = imax;
+            if (kp == imax && fabs(L(imax, imax)) < alpha * rowmax)
+                step = 2;
+        }
+
+        int kk = k + step - 1;
+        if (kp != kk) {
+            symmetric_swap(kk, kp);
+            if (step == 2)
+                swap(L(kk, k), L(kp, k));
+        }
+
+        if (step == 1) {
+            double d = L(k, k);
+            if (fabs(d) <= tol)
+                return false;
+            d > 0 ? num_positive_++ : num_negative_++;
+            for (int j = k + 1; j < n; j++) {
+                double l_jk = L(j, k) / d;
+                for (int i = j; i < n; i++)
+                    L(i, j) -= L(i, k) * l_jk;
+            }
+            for (int i = k + 1; i < n; i++)
+                L(i, k) /= d;
+            pivot_[k] = kp;
+        }
+        else {
+            double d11 = L(k, k);
+            double d21 = L(k + 1, k);
+            double d22 = L(k + 1, k + 1);
+            double det = d11 * d22 - d21 * d21;
+            if (fabs(det) <= pivot_tol * d21 * d21)
+                return false;
+            if (det < 0) {
+                num_positive_++;
+                num_negative_++;
+            }
+            else if (d11 + d22 > 0)
+                num_positive_ += 2;
+            else
+                num_negative_ += 2;
+            //the columns k,k+1 of L are [w_k w_k+1] = [a_k a_k+1] D^{-1}
+            for (int j = k + 2; j < n; j++) {
+                double w_k = (d22 * L(j, k) - d21 * L(j, k + 1)) / det;
+                double w_k1 = (d11 * L(j, k + 1) - d21 * L(j, k)) / det;
+                for (int i = j; i < n; i++)
+                    L(i, j) -= L(i, k) * w_k + L(i, k + 1) * w_k1;
+                L(j, k) = w_k;
+                L(j, k + 1) = w_k1;
+            }
+            pivot_[k] = pivot_[k + 1] = -1 - kp;
+        }
+        k += step;
+    }
+    return true;
+}
+
+
+void DenseLDL::solve(double* rhs) const {
+    int n = n_;
+    //solve L D z = P rhs
+    int k = 0;
+    while (k < n) {
+        if (pivot_[k] >= 0) {
+            swap(rhs[k], rhs[pivot_[k]]);
+            for (int i = k + 1; i < n; i++)
+                rhs[i] -= L(i, k) * rhs[k];
+            rhs[k] /= L(k, k);
+            k++;
+        }
+        else {
+            swap(rhs[k + 1], rhs[-1 - pivot_[k]]);
+            for (int i = k + 2; i < n; i++)
+                rhs[i] -= L(i, k) * rhs[k] + L(i, k + 1) * rhs[k + 1];
+            double d11 = L(k, k);
+            double d21 = L(k + 1, k);
+            double d22 = L(k + 1, k + 1);
+            double det = d11 * d22 - d21 * d21;
+            double r_k = rhs[k];
+            double r_k1 = rhs[k + 1];
+            rhs[k] = (d22 * r_k - d21 * r_k1) / det;
+            rhs[k + 1] = (d11 * r_k1 - d21 * r_k) / det;
+            k += 2;
+        }
+    }
+    //solve L^T P x = z, undoing the interchanges in the reverse order
+    k = n - 1;
+    while (k >= 0) {
+        if (pivot_[k] >= 0) {
+            for (int i = k + 1; i < n; i++)
+                rhs[k] -= L(i, k) * rhs[i];
+            swap(rhs[k], rhs[pivot_[k]]);
+            k--;
+        }
+        else {
+            for (int i = k + 1; i < n; i++) {
+                rhs[k] -= L(i, k) * rhs[i];
+                rhs[k - 1] -= L(i, k - 1) * rhs[i];
+            }
+            swap(rhs[k], rhs[-1 - pivot_[k]]);
+            k -= 2;
+        }
+    }
+}
+
+}
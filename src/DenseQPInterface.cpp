@@ -0,0 +1,347 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:    2019-10
+ */
+#include <sqphot/DenseQPInterface.hpp>
+#include <sqphot/QPSnapshot.hpp>
+
+
+namespace SQPhotstart {
+
+
+DenseQPInterface::DenseQPInterface(NLPInfo nlp_info, QPType qptype,
+                                   shared_ptr<const Options> options,
+                                   Ipopt::SmartPtr<Ipopt::Journalist> jnlst):
+    jnlst_(jnlst),
+    options_(options),
+    objective_target_(-INF) {
+
+    Formulation formulation = options->formulation;
+    nConstr_QP_ = formulation_nConstr_QP(formulation, nlp_info);
+    nVar_QP_ = formulation_nVar_QP(formulation, nlp_info);
+    bound_multipliers_offset_ = formulation_bound_multipliers_offset(formulation,
+                                nlp_info);
+    lbA_ = make_shared<Vector>(nConstr_QP_);
+    ubA_ = make_shared<Vector>(nConstr_QP_);
+    lb_ = make_shared<Vector>(nVar_QP_);
+    ub_ = make_shared<Vector>(nVar_QP_);
+    g_ = make_shared<Vector>(nVar_QP_);
+    x_qp_ = make_shared<Vector>(nVar_QP_);
+    y_qp_ = make_shared<Vector>(nConstr_QP_+nVar_QP_);
+    //the identity blocks of A are kept implicitly, only the Jacobian is stored
+    A_ = make_shared<SpHbMat>(nlp_info.nnz_jac_g, nConstr_QP_, nVar_QP_, false);
+    A_dense_.resize(nConstr_QP_ * nVar_QP_);
+    if (qptype != LP) {
+        H_ = make_shared<SpHbMat>(nVar_QP_, nVar_QP_, false);
+        H_dense_.resize(nVar_QP_ * nVar_QP_);
+    }
+    solver_ = make_shared<DenseQPSolver>(nVar_QP_, nConstr_QP_);
+    allocate_workspace();
+}
+
+
+DenseQPInterface::DenseQPInterface(shared_ptr<SpHbMat> H,
+                                   shared_ptr<SpHbMat> A,
+                                   shared_ptr<Vector> g,
+                                   shared_ptr<Vector> lb,
+                                   shared_ptr<Vector> ub,
+                                   shared_ptr<Vector> lbA,
+                                   shared_ptr<Vector> ubA,
+                                   shared_ptr<Options> options):
+    nConstr_QP_(A->RowNum()),
+    nVar_QP_(A->ColNum()),
+    bound_multipliers_offset_(0),
+    objective_target_(-INF),
+    g_(g),
+    lbA_(lbA),
+    lb_(lb),
+    ubA_(ubA),
+    ub_(ub),
+    H_(H),
+    A_(A) {
+    options_ = options != nullptr ? options : make_shared<Options>();
+    x_qp_ = make_shared<Vector>(nVar_QP_);
+    y_qp_ = make_shared<Vector>(nConstr_QP_+nVar_QP_);
+    A_dense_.resize(nConstr_QP_ * nVar_QP_, 0.0);
+    A_->get_dense_matrix(A_dense_.data());
+    if (H_ != nullptr) {
+        H_dense_.resize(nVar_QP_ * nVar_QP_, 0.0);
+        H_->get_dense_matrix(H_dense_.data());
+    }
+    solver_ = make_shared<DenseQPSolver>(nVar_QP_, nConstr_QP_);
+    allocate_workspace();
+}
+
+
+/**Default destructor*/
+DenseQPInterface::~DenseQPInterface() = default;
+
+
+void DenseQPInterface::allocate_workspace() {
+    Ax_work_.resize(nConstr_QP_);
+    W_c_work_.resize(nConstr_QP_);
+    W_b_work_.resize(nVar_QP_);
+}
+
+
+void DenseQPInterface::optimizeQP(shared_ptr<Stats> stats) {
+    solve(QP, stats);
+}
+
+
+void DenseQPInterface::optimizeLP(shared_ptr<Stats> stats) {
+    solve(LP, stats);
+}
+
+
+void DenseQPInterface::solve(QPType qptype, shared_ptr<Stats> stats) {
+    //every change of the working set is counted as an iteration, and a solve from
+    //an empty working set may need one for each bound and constraint
+    int max_iter = std::max(qptype == LP ? options_->lp_maxiter : options_->qp_maxiter,
+                            5 * (nVar_QP_ + nConstr_QP_));
+    const double* H = qptype == LP || H_dense_.empty() ? NULL : H_dense_.data();
+    double objective_target = qptype == LP ? -INF : objective_target_;
+    objective_target_ = -INF;
+
+    Exitflag status = solver_->solve(H, A_dense_.data(), g_->values(), lb_->values(),
+                                     ub_->values(), lbA_->values(), ubA_->values(),
+                                     max_iter, objective_target);
+    int iter = solver_->iterations();
+    if (status == QPERROR_EXCEED_MAX_ITER || status == QPERROR_INTERNAL_ERROR) {
+        //the working set of the previous solve may be a poor start
+        solver_->reset();
+        status = solver_->solve(H, A_dense_.data(), g_->values(), lb_->values(),
+                                ub_->values(), lbA_->values(), ubA_->values(),
+                                max_iter, objective_target);
+        iter += solver_->iterations();
+    }
+
+    if (stats != nullptr)
+        stats->qp_iter_addValue(iter);
+    x_qp_->copy_vector(solver_->x());
+    y_qp_->copy_vector(solver_->y());
+
+    if (status != QP_OPTIMAL && status != QP_SUFFICIENT_DECREASE) {
+        if (qptype == LP) {
+            THROW_EXCEPTION(LP_NOT_OPTIMAL, LP_NOT_OPTIMAL_MSG);
+        }
+        else {
+            THROW_EXCEPTION(QP_NOT_OPTIMAL, QP_NOT_OPTIMAL_MSG);
+        }
+    }
+}
+
+
+void DenseQPInterface::set_warm_start(const ActiveType* W_constr,
+                                      const ActiveType* W_bounds, const double* x,
+                                      const double* y_bounds, const double* y_constr) {
+    solver_->set_working_set(W_constr, W_bounds, x);
+}
+
+
+void DenseQPInterface::get_working_set(ActiveType* W_constr, ActiveType* W_bounds) {
+    solver_->get_working_set(W_constr, W_bounds);
+}
+
+
+void DenseQPInterface::set_lb(int location, double value) {
+    lb_->setValueAt(location, value);
+}
+
+
+void DenseQPInterface::set_ub(int location, double value) {
+    ub_->setValueAt(location, value);
+}
+
+
+void DenseQPInterface::set_lbA(int location, double value) {
+    lbA_->setValueAt(location, value);
+}
+
+
+void DenseQPInterface::set_ubA(int location, double value) {
+    ubA_->setValueAt(location, value);
+}
+
+
+void DenseQPInterface::set_g(int location, double value) {
+    g_->setValueAt(location, value);
+}
+
+
+void DenseQPInterface::set_lb(shared_ptr<const Vector> rhs) {
+    lb_->copy_vector(rhs->values());
+}
+
+
+void DenseQPInterface::set_ub(shared_ptr<const Vector> rhs) {
+    ub_->copy_vector(rhs->values());
+}
+
+
+void DenseQPInterface::set_lbA(shared_ptr<const Vector> rhs) {
+    lbA_->copy_vector(rhs->values());
+}
+
+
+void DenseQPInterface::set_ubA(shared_ptr<const Vector> rhs) {
+    ubA_->copy_vector(rhs->values());
+}
+
+
+void DenseQPInterface::set_g(shared_ptr<const Vector> rhs) {
+    g_->copy_vector(rhs->values());
+}
+
+
+void DenseQPInterface::set_lb(int location, int length, const double* values) {
+    std::copy(values, values + length, lb_->values() + location);
+}
+
+
+void DenseQPInterface::set_ub(int location, int length, const double* values) {
+    std::copy(values, values + length, ub_->values() + location);
+}
+
+
+void DenseQPInterface::set_lbA(int location, int length, const double* values) {
+    std::copy(values, values + length, lbA_->values() + location);
+}
+
+
+void DenseQPInterface::set_ubA(int location, int length, const double* values) {
+    std::copy(values, values + length, ubA_->values() + location);
+}
+
+
+void DenseQPInterface::set_H(shared_ptr<const SpTripletMat> rhs) {
+    if (!H_->isinitialized())
+        H_->setStructure(rhs);
+    else
+        H_->setMatVal(rhs);
+    std::fill(H_dense_.begin(), H_dense_.end(), 0.0);
+    H_->get_dense_matrix(H_dense_.data());
+}
+
+
+void DenseQPInterface::set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) {
+    if (!A_->isinitialized()) {
+        A_->set_identity_blocks(I_info);
+        A_->setStructure(rhs);
+    }
+    else
+        A_->setMatVal(rhs);
+    std::fill(A_dense_.begin(), A_dense_.end(), 0.0);
+    A_->get_dense_matrix(A_dense_.data());
+}
+
+
+void DenseQPInterface::set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+                             const std::vector<int>& entries) {
+    if (!A_->isinitialized()) {
+        set_A(rhs, I_info);
+        return;
+    }
+    A_->setMatVal(rhs, entries);
+    for (int i : entries)
+        A_dense_[(rhs->RowIndex(i) - 1) * nVar_QP_ + rhs->ColIndex(i) - 1] =
+            rhs->MatVal(i);
+}
+
+
+void DenseQPInterface::reset_constraints() {
+    lb_->set_zeros();
+    ub_->set_zeros();
+    lbA_->set_zeros();
+    ubA_->set_zeros();
+}
+
+
+bool DenseQPInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
+    if (W_c == NULL && W_b == NULL) {
+        W_c = W_c_work_.data();
+        W_b = W_b_work_.data();
+    }
+    get_working_set(W_c, W_b);
+
+    const double* x = x_qp_->values();
+    const double* y = y_qp_->values();
+    double primal_violation = 0.0;
+    double dual_violation = 0.0;
+    double compl_violation = 0.0;
+
+    /**-------------------------------------------------------**/
+    /**     primal feasibility, dual feasibility and          **/
+    /**     complementarity, for the bounds then for Ax       **/
+    /**-------------------------------------------------------**/
+    std::vector<double> &Ax = Ax_work_;
+    std::fill(Ax.begin(), Ax.end(), 0.0);
+    for (int i = 0; i < nConstr_QP_; i++)
+        for (int j = 0; j < nVar_QP_; j++)
+            Ax[i] += A_dense_[i * nVar_QP_ + j] * x[j];
+    for (int k = 0; k < nVar_QP_ + nConstr_QP_; k++) {
+        bool is_bound = k < nVar_QP_;
+        double value = is_bound ? x[k] : Ax[k - nVar_QP_];
+        double lower = is_bound ? lb_->values(k) : lbA_->values(k - nVar_QP_);
+        double upper = is_bound ? ub_->values(k) : ubA_->values(k - nVar_QP_);
+        primal_violation += max(0.0, lower - value) - min(0.0, upper - value);
+        switch (is_bound ? W_b[k] : W_c[k - nVar_QP_]) {
+        case INACTIVE://the multiplier should be 0
+            dual_violation += fabs(y[k]);
+            compl_violation += fabs(y[k]);
+            break;
+        case ACTIVE_BELOW://the multiplier should be positive
+            dual_violation += -min(0.0, y[k]);
+            compl_violation += fabs(y[k] * (value - lower));
+            break;
+        case ACTIVE_ABOVE://the multiplier should be negative
+            dual_violation += max(0.0, y[k]);
+            compl_violation += fabs(y[k] * (upper - value));
+            break;
+        case ACTIVE_BOTH_SIDE:
+            break;
+        default:
+            THROW_EXCEPTION(INVALID_WORKING_SET, INVALID_WORKING_SET_MSG);
+        }
+    }
+
+    /**-------------------------------------------------------**/
+    /**                   stationarity                        **/
+    /**-------------------------------------------------------**/
+    //g+Hx-y_b-A'y_c
+    double stationarity_violation = 0.0;
+    for (int j = 0; j < nVar_QP_; j++) {
+        double gap = g_->values(j) - y[j];
+        if (!H_dense_.empty())
+            for (int l = 0; l < nVar_QP_; l++)
+                gap += H_dense_[j * nVar_QP_ + l] * x[l];
+        for (int i = 0; i < nConstr_QP_; i++)
+            gap -= A_dense_[i * nVar_QP_ + j] * y[nVar_QP_ + i];
+        stationarity_violation += fabs(gap);
+    }
+
+    qpOptimalStatus_.compl_violation = compl_violation;
+    qpOptimalStatus_.stationarity_violation = stationarity_violation;
+    qpOptimalStatus_.dual_violation = dual_violation;
+    qpOptimalStatus_.primal_violation = primal_violation;
+    qpOptimalStatus_.KKT_error =
+        compl_violation + stationarity_violation + dual_violation + primal_violation;
+
+    return qpOptimalStatus_.KKT_error <= 1.0e-6;
+}
+
+
+void DenseQPInterface::WriteQPSnapshot(const string filename) {
+    vector<ActiveType> W_bounds(nVar_QP_);
+    vector<ActiveType> W_constr(nConstr_QP_);
+    get_working_set(W_constr.data(), W_bounds.data());
+
+    QPSnapshot::write(filename, H_ != nullptr ? QP : LP, DENSE, get_status(),
+                      options_, H_, A_->expanded(), g_->values(), lb_->values(),
+                      ub_->values(), lbA_->values(), ubA_->values(),
+                      W_bounds.data(), W_constr.data());
+}
+
+}//SQPHOTSTART
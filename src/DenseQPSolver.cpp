@@ -0,0 +1,797 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#include <algorithm>
+#include <cmath>
+#include <sqphot/DenseQPSolver.hpp>
+#include <sqphot/Utils.hpp>
+
+namespace SQPhotstart {
+
+/** tolerances of the active-set iterations, relative to the quantities they are
+ * compared with*/
+//@{
+static const double FEASIBILITY_TOL = 1.0e-9;
+static const double STATIONARITY_TOL = 1.0e-10;
+static const double DEPENDENCY_TOL = 1.0e-10;
+static const double CURVATURE_TOL = 1.0e-10;
+//@}
+
+
+static inline double dot(int length, const double* a, const double* b) {
+    double result = 0.0;
+    for (int i = 0; i < length; i++)
+        result += a[i] * b[i];
+    return result;
+}
+
+
+static inline double inf_norm(int length, const double* a) {
+    double result = 0.0;
+    for (int i = 0; i < length; i++)
+        result = std::max(result, std::fabs(a[i]));
+    return result;
+}
+
+
+/** @brief (a, b) = (c a - s b, s a + c b) entrywise*/
+static inline void rotate(int length, double* a, double* b, double c, double s) {
+    for (int i = 0; i < length; i++) {
+        double ai = a[i];
+        a[i] = c * ai - s * b[i];
+        b[i] = s * ai + c * b[i];
+    }
+}
+
+
+DenseQPSolver::DenseQPSolver(int nVar, int nConstr) :
+    nVar_(nVar),
+    nConstr_(nConstr),
+    nZ_(nVar),
+    iter_(0),
+    max_iter_(0),
+    has_solution_(false),
+    has_R_(false),
+    is_singular_(false),
+    curvature_(0.0),
+    H_scale_(0.0),
+    objective_target_(-INF),
+    status_(UNKNOWN),
+    objective_(0.0),
+    H_(NULL),
+    A_(NULL),
+    g_(NULL),
+    lb_(NULL),
+    ub_(NULL),
+    lbA_(NULL),
+    ubA_(NULL),
+    Qt_(nVar * nVar),
+    T_(nVar * nVar),
+    R_(nVar * nVar),
+    working_(nVar),
+    status_of_(nVar + nConstr, FREE),
+    fixed_value_(nVar),
+    A_norm_(nConstr),
+    x_(nVar, 0.0),
+    y_(nVar + nConstr, 0.0),
+    Ax_(nConstr, 0.0),
+    gradient_(nVar),
+    lambda_(nVar),
+    p_(nVar),
+    Ap_(nConstr),
+    work_(nVar),
+    work2_(nVar),
+    M_(nVar * nVar),
+    permutation_(nVar) {
+}
+
+
+Exitflag DenseQPSolver::solve(const double* H, const double* A, const double* g,
+                              const double* lb, const double* ub, const double* lbA,
+                              const double* ubA, int max_iter,
+                              double objective_target) {
+    H_ = H;
+    A_ = A;
+    g_ = g;
+    lb_ = lb;
+    ub_ = ub;
+    lbA_ = lbA;
+    ubA_ = ubA;
+    max_iter_ = max_iter;
+    objective_target_ = objective_target;
+    iter_ = 0;
+
+    H_scale_ = H_ == NULL ? 0.0 : inf_norm(nVar_ * nVar_, H_);
+    for (int i = 0; i < nConstr_; i++)
+        A_norm_[i] = std::sqrt(dot(nVar_, A_ + i * nVar_, A_ + i * nVar_));
+
+    start_working_set();
+    status_ = run_first_order(true);
+    if (status_ == QP_OPTIMAL)
+        status_ = H_ == NULL ? run_first_order(false) : run_second_order();
+    has_solution_ = status_ == QP_OPTIMAL || status_ == QP_SUFFICIENT_DECREASE;
+    finish();
+    return status_;
+}
+
+
+void DenseQPSolver::reset() {
+    has_solution_ = false;
+}
+
+
+void DenseQPSolver::set_working_set(const ActiveType* W_constr,
+                                    const ActiveType* W_bounds, const double* x) {
+    //start_working_set only reads whether a bound or constraint is in the working
+    //set, and chooses the side closest to x
+    for (int id = 0; id < nVar_ + nConstr_; id++) {
+        ActiveType type = id < nVar_ ? W_bounds[id] : W_constr[id - nVar_];
+        status_of_[id] = type == ACTIVE_BELOW ? AT_LOWER :
+                         type == ACTIVE_ABOVE ? AT_UPPER :
+                         type == ACTIVE_BOTH_SIDE ? AT_EQUALITY : FREE;
+    }
+    std::copy(x, x + nVar_, x_.begin());
+    has_solution_ = true;
+}
+
+
+void DenseQPSolver::get_working_set(ActiveType* W_constr, ActiveType* W_bounds) const {
+    for (int id = 0; id < nVar_ + nConstr_; id++) {
+        ActiveType type;
+        switch (status_of_[id]) {
+        case AT_LOWER:
+            type = ACTIVE_BELOW;
+            break;
+        case AT_UPPER:
+            type = ACTIVE_ABOVE;
+            break;
+        case AT_EQUALITY:
+            type = ACTIVE_BOTH_SIDE;
+            break;
+        default:
+            type = INACTIVE;
+        }
+        if (id < nVar_)
+            W_bounds[id] = type;
+        else
+            W_constr[id - nVar_] = type;
+    }
+}
+
+
+double DenseQPSolver::working_value(int id) const {
+    switch (status_of_[id]) {
+    case AT_UPPER:
+        return upper(id);
+    case TEMPORARILY_FIXED:
+        return fixed_value_[id];
+    default:
+        return lower(id);
+    }
+}
+
+
+double DenseQPSolver::normal_dot(int id, const double* v) const {
+    return id < nVar_ ? v[id] : dot(nVar_, A_ + (id - nVar_) * nVar_, v);
+}
+
+
+void DenseQPSolver::start_working_set() {
+    int n = nVar_;
+    std::fill(Qt_.begin(), Qt_.end(), 0.0);
+    for (int k = 0; k < n; k++)
+        Qt_[k * n + k] = 1.0;
+    nZ_ = n;
+    has_R_ = false;
+    is_singular_ = false;
+
+    if (!has_solution_)
+        std::fill(x_.begin(), x_.end(), 0.0);
+    for (int j = 0; j < n; j++)
+        x_[j] = std::min(std::max(x_[j], lb_[j]), ub_[j]);
+
+    //keep the bounds and constraints of the previous working set which are still
+    //finite, on the side closest to x_
+    bool has_constraints = false;
+    for (int id = 0; id < n + nConstr_; id++) {
+        //the bounds come first and may move x_
+        if (id == n)
+            for (int i = 0; i < nConstr_; i++)
+                Ax_[i] = dot(n, A_ + i * n, x_.data());
+        int previous = status_of_[id];
+        status_of_[id] = FREE;
+        if (!has_solution_ || previous == FREE || previous == TEMPORARILY_FIXED)
+            continue;
+        double lo = lower(id), up = upper(id), v = value(id);
+        ConstraintStatus status;
+        if (lo > -INF && (up >= INF || v - lo <= up - v))
+            status = AT_LOWER;
+        else if (up < INF)
+            status = AT_UPPER;
+        else
+            continue;
+        if (add_constraint(id, status)) {
+            if (id < n)
+                x_[id] = working_value(id);
+            else
+                has_constraints = true;
+        }
+    }
+
+    if (has_constraints) {
+        //move onto the constraints in the working set along the columns of Y,
+        //solving T w = b - Cx
+        double* w = work_.data();
+        for (int r = n - 1; r >= nZ_; r--) {
+            double residual = working_value(working_[r]) -
+                              normal_dot(working_[r], x_.data());
+            for (int j = r + 1; j < n; j++)
+                residual -= T_[r * n + j] * w[j];
+            w[r] = residual / T_[r * n + r];
+        }
+        for (int r = nZ_; r < n; r++)
+            for (int j = 0; j < n; j++)
+                x_[j] += w[r] * Qt_[r * n + j];
+
+        bool is_bound_feasible = true;
+        for (int j = 0; j < n; j++) {
+            if (status_of_[j] != FREE)
+                x_[j] = working_value(j);
+            else if (x_[j] < lb_[j] - FEASIBILITY_TOL * std::max(1.0, std::fabs(lb_[j]))
+                     || x_[j] > ub_[j] + FEASIBILITY_TOL * std::max(1.0, std::fabs(ub_[j])))
+                is_bound_feasible = false;
+        }
+
+        if (!is_bound_feasible) {
+            //keep only the bounds, and leave the constraints to phase 1
+            std::fill(Qt_.begin(), Qt_.end(), 0.0);
+            for (int k = 0; k < n; k++)
+                Qt_[k * n + k] = 1.0;
+            nZ_ = n;
+            for (int id = 0; id < n + nConstr_; id++) {
+                int previous = status_of_[id];
+                status_of_[id] = FREE;
+                if (id < n && previous != FREE)
+                    add_constraint(id, (ConstraintStatus) previous);
+            }
+            for (int j = 0; j < n; j++)
+                x_[j] = status_of_[j] != FREE ? working_value(j) :
+                        std::min(std::max(x_[j], lb_[j]), ub_[j]);
+        }
+    }
+
+    for (int i = 0; i < nConstr_; i++)
+        Ax_[i] = dot(n, A_ + i * n, x_.data());
+}
+
+
+bool DenseQPSolver::add_constraint(int id, ConstraintStatus status) {
+    int n = nVar_;
+    if (nZ_ == 0)
+        return false;
+
+    //w = c^T Q
+    double* w = work2_.data();
+    if (id < n) {
+        for (int k = 0; k < n; k++)
+            w[k] = Qt_[k * n + id];
+    }
+    else {
+        const double* a = A_ + (id - n) * n;
+        for (int k = 0; k < n; k++)
+            w[k] = dot(n, a, Qt_.data() + k * n);
+    }
+    double norm = id < n ? 1.0 : A_norm_[id - n];
+    if (std::sqrt(dot(nZ_, w, w)) <= DEPENDENCY_TOL * norm)
+        return false;
+
+    //rotate the columns of Z so that w is zero in all but the last one, which then
+    //moves to Y
+    bool update_R = has_R_ && !is_singular_;
+    for (int k = 0; k < nZ_ - 1; k++) {
+        if (w[k] == 0.0)
+            continue;
+        double r = std::hypot(w[k], w[k + 1]);
+        double c = w[k + 1] / r, s = w[k] / r;
+        w[k] = 0.0;
+        w[k + 1] = r;
+        rotate(n, &Qt_[k * n], &Qt_[(k + 1) * n], c, s);
+        if (update_R) {
+            //the same rotation of the columns of R, then one of its rows to make
+            //it upper triangular again
+            for (int i = 0; i <= k + 1; i++) {
+                double rik = R_[i * n + k];
+                R_[i * n + k] = c * rik - s * R_[i * n + k + 1];
+                R_[i * n + k + 1] = s * rik + c * R_[i * n + k + 1];
+            }
+            double a = R_[k * n + k], b = R_[(k + 1) * n + k];
+            double rr = std::hypot(a, b);
+            if (rr > 0.0)
+                rotate(nZ_ - k, &R_[k * n + k], &R_[(k + 1) * n + k], a / rr, -b / rr);
+            R_[(k + 1) * n + k] = 0.0;
+        }
+    }
+
+    nZ_--;
+    for (int j = nZ_; j < n; j++)
+        T_[nZ_ * n + j] = w[j];
+    working_[nZ_] = id;
+    if (status != TEMPORARILY_FIXED && lower(id) == upper(id))
+        status = AT_EQUALITY;
+    if (status == TEMPORARILY_FIXED)
+        fixed_value_[id] = x_[id];
+    status_of_[id] = status;
+    return true;
+}
+
+
+void DenseQPSolver::delete_constraint(int r) {
+    int n = nVar_;
+    int id = working_[r];
+
+    //rotate the columns of Y to zero the diagonal of the rows of T above r, so that
+    //they can move down by one row
+    for (int k = r - 1; k >= nZ_; k--) {
+        double a = T_[k * n + k], b = T_[k * n + k + 1];
+        double rr = std::hypot(a, b);
+        double c = b / rr, s = a / rr;
+        for (int i = nZ_; i <= k; i++) {
+            double tik = T_[i * n + k];
+            T_[i * n + k] = c * tik - s * T_[i * n + k + 1];
+            T_[i * n + k + 1] = s * tik + c * T_[i * n + k + 1];
+        }
+        T_[k * n + k] = 0.0;
+        rotate(n, &Qt_[k * n], &Qt_[(k + 1) * n], c, s);
+    }
+    for (int k = r - 1; k >= nZ_; k--) {
+        std::copy(T_.begin() + k * n + k + 1, T_.begin() + (k + 1) * n,
+                  T_.begin() + (k + 1) * n + k + 1);
+        working_[k + 1] = working_[k];
+    }
+
+    status_of_[id] = FREE;
+    nZ_++;
+    if (has_R_)
+        extend_reduced_hessian();
+}
+
+
+void DenseQPSolver::extend_reduced_hessian() {
+    int n = nVar_;
+    int k = nZ_ - 1;
+    const double* z = &Qt_[k * n];
+    double* h = work_.data();
+    for (int i = 0; i < n; i++)
+        h[i] = dot(n, H_ + i * n, z);
+
+    //solve R^T r = Z^T H z for the new column of R
+    for (int i = 0; i < k; i++) {
+        double value = dot(n, &Qt_[i * n], h);
+        for (int l = 0; l < i; l++)
+            value -= R_[l * n + i] * R_[l * n + k];
+        R_[i * n + k] = value / R_[i * n + i];
+    }
+    double d = dot(n, z, h);
+    for (int i = 0; i < k; i++)
+        d -= R_[i * n + k] * R_[i * n + k];
+
+    if (d > CURVATURE_TOL * H_scale_) {
+        R_[k * n + k] = std::sqrt(d);
+        is_singular_ = false;
+    }
+    else {
+        R_[k * n + k] = 0.0;
+        curvature_ = d;
+        is_singular_ = true;
+    }
+}
+
+
+bool DenseQPSolver::factorize_reduced_hessian() {
+    int n = nVar_;
+    int nZ = nZ_;
+    has_R_ = false;
+    is_singular_ = false;
+
+    //S = Z^T H Z in M_, with the stride n
+    double* S = M_.data();
+    double* h = work_.data();
+    for (int j = 0; j < nZ; j++) {
+        for (int i = 0; i < n; i++)
+            h[i] = dot(n, H_ + i * n, &Qt_[j * n]);
+        for (int i = 0; i <= j; i++)
+            S[i * n + j] = S[j * n + i] = dot(n, &Qt_[i * n], h);
+    }
+
+    //Cholesky factorization with symmetric pivoting on the largest diagonal
+    for (int j = 0; j < nZ; j++)
+        permutation_[j] = j;
+    double tol = CURVATURE_TOL * H_scale_;
+    int rank = 0;
+    for (int j = 0; j < nZ; j++) {
+        int pivot = j;
+        for (int l = j + 1; l < nZ; l++)
+            if (S[l * n + l] > S[pivot * n + pivot])
+                pivot = l;
+        if (S[pivot * n + pivot] <= tol)
+            break;
+        if (pivot != j) {
+            for (int l = 0; l < nZ; l++)
+                std::swap(S[j * n + l], S[pivot * n + l]);
+            for (int l = 0; l < nZ; l++)
+                std::swap(S[l * n + j], S[l * n + pivot]);
+            for (int l = 0; l < j; l++)
+                std::swap(R_[l * n + j], R_[l * n + pivot]);
+            std::swap(permutation_[j], permutation_[pivot]);
+        }
+        double diagonal = std::sqrt(S[j * n + j]);
+        R_[j * n + j] = diagonal;
+        for (int l = j + 1; l < nZ; l++)
+            R_[j * n + l] = S[j * n + l] / diagonal;
+        for (int l = j + 1; l < nZ; l++)
+            for (int m = j + 1; m < nZ; m++)
+                S[l * n + m] -= R_[j * n + l] * R_[j * n + m];
+        rank++;
+    }
+    if (rank < nZ - 1)
+        return false;
+    if (rank == nZ - 1) {
+        curvature_ = S[rank * n + rank];
+        R_[rank * n + rank] = 0.0;
+        is_singular_ = true;
+    }
+
+    //order the columns of Z as the pivots
+    std::copy(Qt_.begin(), Qt_.begin() + nZ * n, M_.begin());
+    for (int j = 0; j < nZ; j++)
+        std::copy(M_.begin() + permutation_[j] * n,
+                  M_.begin() + (permutation_[j] + 1) * n, Qt_.begin() + j * n);
+    has_R_ = true;
+    return true;
+}
+
+
+void DenseQPSolver::fix_free_variables() {
+    has_R_ = false;
+    for (int j = 0; j < nVar_ && nZ_ > 0; j++)
+        if (status_of_[j] == FREE)
+            add_constraint(j, TEMPORARILY_FIXED);
+    has_R_ = true;
+    is_singular_ = false;
+}
+
+
+void DenseQPSolver::compute_multipliers(const double* v) {
+    int n = nVar_;
+    for (int r = nZ_; r < n; r++) {
+        double value = dot(n, &Qt_[r * n], v);
+        for (int i = nZ_; i < r; i++)
+            value -= T_[i * n + r] * lambda_[i];
+        lambda_[r] = value / T_[r * n + r];
+    }
+}
+
+
+int DenseQPSolver::constraint_to_delete(double tol) const {
+    int chosen = -1;
+    bool chosen_is_fixed = false;
+    double largest = 0.0;
+    for (int r = nZ_; r < nVar_; r++) {
+        int id = working_[r];
+        double lambda = lambda_[r] * (id < nVar_ ? 1.0 : A_norm_[id - nVar_]);
+        double violation;
+        switch (status_of_[id]) {
+        case AT_LOWER:
+            violation = -lambda;
+            break;
+        case AT_UPPER:
+            violation = lambda;
+            break;
+        case TEMPORARILY_FIXED:
+            violation = std::fabs(lambda);
+            break;
+        default:
+            continue;
+        }
+        if (violation <= tol)
+            continue;
+        bool is_fixed = status_of_[id] == TEMPORARILY_FIXED;
+        if (chosen < 0 || (is_fixed && !chosen_is_fixed) ||
+                (is_fixed == chosen_is_fixed && violation > largest)) {
+            chosen = r;
+            chosen_is_fixed = is_fixed;
+            largest = violation;
+        }
+    }
+    return chosen;
+}
+
+
+double DenseQPSolver::ratio_test(double step_max, bool phase1, int &blocking,
+                                 ConstraintStatus &blocking_status) {
+    //a constraint with |c^T p| above this is independent of the working set
+    double p_norm = std::sqrt(dot(nVar_, p_.data(), p_.data()));
+    double step = step_max;
+    double pivot = 0.0;
+    blocking = -1;
+    for (int id = 0; id < nVar_ + nConstr_; id++) {
+        if (status_of_[id] != FREE)
+            continue;
+        double norm = id < nVar_ ? 1.0 : A_norm_[id - nVar_];
+        double cp = id < nVar_ ? p_[id] : Ap_[id - nVar_];
+        if (std::fabs(cp) <= DEPENDENCY_TOL * p_norm * norm)
+            continue;
+        double lo = lower(id), up = upper(id), v = value(id);
+        bool is_below = v < lo - FEASIBILITY_TOL * std::max(1.0, std::fabs(lo));
+        bool is_above = v > up + FEASIBILITY_TOL * std::max(1.0, std::fabs(up));
+        double candidate;
+        ConstraintStatus status;
+        if (cp < 0.0) {
+            if (phase1 && is_above) {
+                candidate = (up - v) / cp;
+                status = AT_UPPER;
+            }
+            else if (lo > -INF && !is_below) {
+                candidate = (lo - v) / cp;
+                status = AT_LOWER;
+            }
+            else
+                continue;
+        }
+        else {
+            if (phase1 && is_below) {
+                candidate = (lo - v) / cp;
+                status = AT_LOWER;
+            }
+            else if (up < INF && !is_above) {
+                candidate = (up - v) / cp;
+                status = AT_UPPER;
+            }
+            else
+                continue;
+        }
+        candidate = std::max(candidate, 0.0);
+        //on ties, prefer the constraint most orthogonal to the working set
+        if (candidate < step || (candidate == step && blocking >= 0 &&
+                                 std::fabs(cp) / norm > pivot)) {
+            step = candidate;
+            pivot = std::fabs(cp) / norm;
+            blocking = id;
+            blocking_status = status;
+        }
+    }
+    return step;
+}
+
+
+void DenseQPSolver::take_step(double step) {
+    for (int j = 0; j < nVar_; j++)
+        x_[j] += step * p_[j];
+    for (int i = 0; i < nConstr_; i++)
+        Ax_[i] = dot(nVar_, A_ + i * nVar_, x_.data());
+}
+
+
+void DenseQPSolver::compute_gradient() {
+    for (int i = 0; i < nVar_; i++)
+        gradient_[i] = g_[i] + (H_ == NULL ? 0.0 : dot(nVar_, H_ + i * nVar_, x_.data()));
+}
+
+
+Exitflag DenseQPSolver::run_first_order(bool phase1) {
+    int n = nVar_;
+    while (true) {
+        if (phase1) {
+            //the gradient of the sum of infeasibilities
+            std::fill(gradient_.begin(), gradient_.end(), 0.0);
+            bool is_feasible = true;
+            for (int i = 0; i < nConstr_; i++) {
+                if (status_of_[n + i] != FREE)
+                    continue;
+                double sign;
+                if (Ax_[i] < lbA_[i] - FEASIBILITY_TOL * std::max(1.0, std::fabs(lbA_[i])))
+                    sign = -1.0;
+                else if (Ax_[i] > ubA_[i] + FEASIBILITY_TOL * std::max(1.0, std::fabs(ubA_[i])))
+                    sign = 1.0;
+                else
+                    continue;
+                is_feasible = false;
+                for (int j = 0; j < n; j++)
+                    gradient_[j] += sign * A_[i * n + j];
+            }
+            if (is_feasible)
+                return QP_OPTIMAL;
+        }
+        else
+            compute_gradient();
+
+        //steepest descent in the null space, p = -Z Z^T gradient
+        double* Zg = work_.data();
+        for (int k = 0; k < nZ_; k++)
+            Zg[k] = dot(n, &Qt_[k * n], gradient_.data());
+        double tol = STATIONARITY_TOL * std::max(1.0, inf_norm(n, gradient_.data()));
+        if (inf_norm(nZ_, Zg) <= tol) {
+            compute_multipliers(gradient_.data());
+            int r = constraint_to_delete(tol);
+            if (r < 0)
+                return phase1 ? QPERROR_INFEASIBLE : QP_OPTIMAL;
+            if (++iter_ > max_iter_)
+                return QPERROR_EXCEED_MAX_ITER;
+            delete_constraint(r);
+            continue;
+        }
+        std::fill(p_.begin(), p_.end(), 0.0);
+        for (int k = 0; k < nZ_; k++)
+            for (int j = 0; j < n; j++)
+                p_[j] -= Zg[k] * Qt_[k * n + j];
+        for (int i = 0; i < nConstr_; i++)
+            Ap_[i] = dot(n, A_ + i * n, p_.data());
+
+        int blocking;
+        ConstraintStatus status;
+        double step = ratio_test(INF, phase1, blocking, status);
+        if (blocking < 0)
+            return phase1 ? QPERROR_INTERNAL_ERROR : QPERROR_UNBOUNDED;
+        take_step(step);
+        if (++iter_ > max_iter_)
+            return QPERROR_EXCEED_MAX_ITER;
+        if (!add_constraint(blocking, status))
+            return QPERROR_INTERNAL_ERROR;
+        if (blocking < n)
+            x_[blocking] = working_value(blocking);
+    }
+}
+
+
+Exitflag DenseQPSolver::run_second_order() {
+    int n = nVar_;
+    if (!factorize_reduced_hessian())
+        fix_free_variables();
+
+    while (true) {
+        compute_gradient();
+        double* Zg = work2_.data();
+        for (int k = 0; k < nZ_; k++)
+            Zg[k] = dot(n, &Qt_[k * n], gradient_.data());
+        double tol = STATIONARITY_TOL * std::max(1.0, inf_norm(n, gradient_.data()));
+        if (objective_target_ > -INF) {
+            double objective = 0.0;
+            for (int j = 0; j < n; j++)
+                objective += 0.5 * x_[j] * (gradient_[j] + g_[j]);
+            if (objective <= objective_target_) {
+                compute_multipliers(gradient_.data());
+                return QP_SUFFICIENT_DECREASE;
+            }
+        }
+
+        //the step in the null space, u, and its largest length
+        double* u = work_.data();
+        double step_max;
+        if (!is_singular_) {
+            if (inf_norm(nZ_, Zg) <= tol) {
+                compute_multipliers(gradient_.data());
+                int r = constraint_to_delete(tol);
+                if (r < 0)
+                    return QP_OPTIMAL;
+                if (++iter_ > max_iter_)
+                    return QPERROR_EXCEED_MAX_ITER;
+                delete_constraint(r);
+                continue;
+            }
+            //the Newton step R^T R u = -Z^T gradient
+            for (int i = 0; i < nZ_; i++) {
+                double value = -Zg[i];
+                for (int l = 0; l < i; l++)
+                    value -= R_[l * n + i] * u[l];
+                u[i] = value / R_[i * n + i];
+            }
+            for (int i = nZ_ - 1; i >= 0; i--) {
+                double value = u[i];
+                for (int l = i + 1; l < nZ_; l++)
+                    value -= R_[i * n + l] * u[l];
+                u[i] = value / R_[i * n + i];
+            }
+            step_max = 1.0;
+        }
+        else {
+            //the direction of nonpositive curvature, R11 u1 = -r, u2 = 1
+            int k = nZ_ - 1;
+            u[k] = 1.0;
+            for (int i = k - 1; i >= 0; i--) {
+                double value = -R_[i * n + k];
+                for (int l = i + 1; l < k; l++)
+                    value -= R_[i * n + l] * u[l];
+                u[i] = value / R_[i * n + i];
+            }
+            step_max = INF;
+        }
+        std::fill(p_.begin(), p_.end(), 0.0);
+        for (int k = 0; k < nZ_; k++)
+            for (int j = 0; j < n; j++)
+                p_[j] += u[k] * Qt_[k * n + j];
+
+        double slope = 0.0;
+        if (is_singular_) {
+            slope = dot(n, gradient_.data(), p_.data());
+            if (slope > 0.0) {
+                for (int j = 0; j < n; j++)
+                    p_[j] = -p_[j];
+                slope = -slope;
+            }
+            double p_norm = std::sqrt(dot(n, p_.data(), p_.data()));
+            if (curvature_ > 0.0) {
+                if (-slope <= tol * p_norm) {
+                    //stationary along a direction of tiny positive curvature
+                    R_[(nZ_ - 1) * n + nZ_ - 1] = std::sqrt(curvature_);
+                    is_singular_ = false;
+                    continue;
+                }
+                step_max = -slope / curvature_;
+            }
+        }
+        for (int i = 0; i < nConstr_; i++)
+            Ap_[i] = dot(n, A_ + i * n, p_.data());
+
+        int blocking;
+        ConstraintStatus status;
+        double step = ratio_test(step_max, false, blocking, status);
+        if (blocking < 0 && step >= INF) {
+            double p_norm = std::sqrt(dot(n, p_.data(), p_.data()));
+            if (-slope > tol * p_norm || curvature_ < -CURVATURE_TOL * H_scale_)
+                return QPERROR_UNBOUNDED;
+            //the objective is constant along p, fix the variable which changes most
+            int fixed = -1;
+            for (int j = 0; j < n; j++)
+                if (status_of_[j] == FREE &&
+                        (fixed < 0 || std::fabs(p_[j]) > std::fabs(p_[fixed])))
+                    fixed = j;
+            if (++iter_ > max_iter_)
+                return QPERROR_EXCEED_MAX_ITER;
+            has_R_ = false;
+            if (fixed < 0 || !add_constraint(fixed, TEMPORARILY_FIXED))
+                return QPERROR_INTERNAL_ERROR;
+            if (!factorize_reduced_hessian())
+                fix_free_variables();
+            continue;
+        }
+        take_step(step);
+        if (blocking < 0) {
+            //a full step along p
+            if (is_singular_) {
+                R_[(nZ_ - 1) * n + nZ_ - 1] = std::sqrt(curvature_);
+                is_singular_ = false;
+            }
+            continue;
+        }
+
+        if (++iter_ > max_iter_)
+            return QPERROR_EXCEED_MAX_ITER;
+        bool was_singular = is_singular_;
+        if (!add_constraint(blocking, status))
+            return QPERROR_INTERNAL_ERROR;
+        if (blocking < n)
+            x_[blocking] = working_value(blocking);
+        if (was_singular && !factorize_reduced_hessian())
+            fix_free_variables();
+    }
+}
+
+
+void DenseQPSolver::finish() {
+    int n = nVar_;
+    std::fill(y_.begin(), y_.end(), 0.0);
+    if (status_ == QP_OPTIMAL || status_ == QP_SUFFICIENT_DECREASE)
+        for (int r = nZ_; r < n; r++)
+            if (status_of_[working_[r]] != TEMPORARILY_FIXED)
+                y_[working_[r]] = lambda_[r];
+
+    compute_gradient();
+    objective_ = 0.0;
+    for (int j = 0; j < n; j++)
+        objective_ += 0.5 * x_[j] * (gradient_[j] + g_[j]);
+}
+
+}
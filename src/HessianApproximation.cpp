@@ -0,0 +1,249 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#include <sqphot/HessianApproximation.hpp>
+#include <sqphot/MessageHandling.hpp>
+#include <climits>
+#include <cmath>
+
+namespace SQPhotstart {
+using namespace std;
+
+/** Powell's damping parameter: the BFGS update is damped if s^Ty < 0.2*s^TBs*/
+const double POWELL_DAMPING = 0.2;
+
+/** an SR1 correction is skipped if |v^Ts| < SR1_SKIP_TOL*||s||*||v|| */
+const double SR1_SKIP_TOL = 1.0e-8;
+
+/** a pair is skipped if the step is shorter than this*/
+const double MIN_STEP_NORM_SQ = 1.0e-24;
+
+static double dot(const double* a, const double* b, int n) {
+    double result = 0.0;
+    for (int i = 0; i < n; i++)
+        result += a[i] * b[i];
+    return result;
+}
+
+HessianApproximation::HessianApproximation(int nVar, HessianApproximationType type,
+        int memory_size) :
+    nVar_(nVar),
+    type_(type),
+    memory_size_(memory_size > 0 ? memory_size : 1),
+    num_updates_(0),
+    num_skipped_(0),
+    is_scaled_(false),
+    B_(NULL),
+    sigma_(1.0) {
+    assert(type_ != EXACT_HESSIAN);
+    if (nVar_ > HESSIAN_APPROXIMATION_MAX_NVAR)
+        THROW_EXCEPTION(HESSIAN_APPROXIMATION_TOO_LARGE,
+                        HESSIAN_APPROXIMATION_TOO_LARGE_MSG);
+    if (type_ == DAMPED_BFGS)
+        B_ = new double[nVar_ * nVar_];
+    Bs_ = new double[nVar_];
+    reset();
+}
+
+
+HessianApproximation::~HessianApproximation() {
+    delete[] B_;
+    B_ = NULL;
+    delete[] Bs_;
+    Bs_ = NULL;
+}
+
+
+int HessianApproximation::nnz(int nVar) {
+    long long count = (long long) nVar * (nVar + 1) / 2;
+    if (nVar > HESSIAN_APPROXIMATION_MAX_NVAR || count > INT_MAX)
+        THROW_EXCEPTION(HESSIAN_APPROXIMATION_TOO_LARGE,
+                        HESSIAN_APPROXIMATION_TOO_LARGE_MSG);
+    return (int) count;
+}
+
+
+void HessianApproximation::reset() {
+    num_updates_ = 0;
+    num_skipped_ = 0;
+    is_scaled_ = false;
+    sigma_ = 1.0;
+    s_.clear();
+    y_.clear();
+    v_.clear();
+    d_.clear();
+    if (B_ != NULL) {
+        for (int i = 0; i < nVar_ * nVar_; i++)
+            B_[i] = 0.0;
+        for (int i = 0; i < nVar_; i++)
+            B_[i * nVar_ + i] = 1.0;
+    }
+}
+
+
+void HessianApproximation::set_structure(shared_ptr<SpTripletMat> hessian) const {
+    assert(hessian->EntryNum() == nnz(nVar_));
+    int k = 0;
+    for (int i = 0; i < nVar_; i++) {
+        for (int j = 0; j <= i; j++) {
+            hessian->RowIndex()[k] = i + 1;
+            hessian->ColIndex()[k] = j + 1;
+            k++;
+        }
+    }
+}
+
+
+void HessianApproximation::get_values(shared_ptr<SpTripletMat> hessian) const {
+    double* values = hessian->MatVal();
+    int k = 0;
+    if (type_ == DAMPED_BFGS) {
+        for (int i = 0; i < nVar_; i++)
+            for (int j = 0; j <= i; j++)
+                values[k++] = B_[i * nVar_ + j];
+    } else {
+        for (int i = 0; i < nVar_; i++) {
+            for (int j = 0; j < i; j++)
+                values[k++] = 0.0;
+            values[k++] = sigma_;
+        }
+        for (int l = 0; l < (int) v_.size(); l++) {
+            const double* v = v_[l]->values();
+            double scaling = 1.0 / d_[l];
+            k = 0;
+            for (int i = 0; i < nVar_; i++) {
+                double vi = v[i] * scaling;
+                for (int j = 0; j <= i; j++)
+                    values[k++] += vi * v[j];
+            }
+        }
+    }
+}
+
+
+bool HessianApproximation::update(shared_ptr<const Vector> s,
+                                  shared_ptr<const Vector> y) {
+    bool updated;
+    if (dot(s->values(), s->values(), nVar_) < MIN_STEP_NORM_SQ)
+        updated = false;
+    else if (type_ == DAMPED_BFGS)
+        updated = update_damped_bfgs(s->values(), y->values());
+    else
+        updated = update_limited_memory_sr1(s->values(), y->values());
+
+    if (updated)
+        num_updates_++;
+    else
+        num_skipped_++;
+    return updated;
+}
+
+
+/**
+ * @brief The damped BFGS update (Nocedal and Wright, Procedure 18.2)
+ *
+ *      r = theta*y + (1-theta)*B*s,
+ *      B = B - B s s^T B/(s^TBs) + r r^T/(s^Tr),
+ *
+ * where theta = 1 if s^Ty >= 0.2*s^TBs, and 0.8*s^TBs/(s^TBs-s^Ty) otherwise.
+ * Before the first update, B_0 = I is scaled to y^Ty/s^Ty*I if s^Ty > 0.
+ */
+bool HessianApproximation::update_damped_bfgs(const double* s, const double* y) {
+    double sy = dot(s, y, nVar_);
+    if (!is_scaled_ && sy > 0) {
+        double scaling = dot(y, y, nVar_) / sy;
+        for (int i = 0; i < nVar_; i++)
+            B_[i * nVar_ + i] = scaling;
+        is_scaled_ = true;
+    }
+
+    for (int i = 0; i < nVar_; i++)
+        Bs_[i] = dot(B_ + i * nVar_, s, nVar_);
+    double sBs = dot(s, Bs_, nVar_);
+    if (sBs <= 0)
+        return false;
+
+    double theta = 1.0;
+    if (sy < POWELL_DAMPING * sBs)
+        theta = (1.0 - POWELL_DAMPING) * sBs / (sBs - sy);
+    double sr = theta * sy + (1.0 - theta) * sBs;
+    for (int i = 0; i < nVar_; i++) {
+        double ri = theta * y[i] + (1.0 - theta) * Bs_[i];
+        for (int j = 0; j <= i; j++) {
+            double rj = theta * y[j] + (1.0 - theta) * Bs_[j];
+            double value = B_[i * nVar_ + j] - Bs_[i] * Bs_[j] / sBs + ri * rj / sr;
+            B_[i * nVar_ + j] = value;
+            B_[j * nVar_ + i] = value;
+        }
+    }
+    return true;
+}
+
+
+bool HessianApproximation::update_limited_memory_sr1(const double* s,
+        const double* y) {
+    if ((int) s_.size() == memory_size_) {
+        s_.erase(s_.begin());
+        y_.erase(y_.begin());
+    }
+    s_.push_back(make_shared<Vector>(nVar_, s));
+    y_.push_back(make_shared<Vector>(nVar_, y));
+    return rebuild_limited_memory_sr1();
+}
+
+
+/**
+ * @brief Apply the SR1 update
+ *      B = B + (y-Bs)(y-Bs)^T/((y-Bs)^Ts)
+ * for the stored pairs in order, starting from B_0 = sigma*I with
+ * sigma = y^Ty/s^Ty of the most recent pair with s^Ty > 0. Only the
+ * corrections v_i = y_i-B_i s_i are kept, so B*p costs O(nVar*memory_size).
+ *
+ * @return if the most recent pair produced a correction
+ */
+bool HessianApproximation::rebuild_limited_memory_sr1() {
+    const double* s_last = s_.back()->values();
+    const double* y_last = y_.back()->values();
+    double sy = dot(s_last, y_last, nVar_);
+    if (sy > 0)
+        sigma_ = dot(y_last, y_last, nVar_) / sy;
+
+    v_.clear();
+    d_.clear();
+    bool is_corrected = false;
+    for (int l = 0; l < (int) s_.size(); l++) {
+        const double* s = s_[l]->values();
+        const double* y = y_[l]->values();
+        auto v = make_shared<Vector>(nVar_);
+        times_limited_memory(s, v->values());
+        for (int i = 0; i < nVar_; i++)
+            v->values()[i] = y[i] - v->values()[i];
+        double d = dot(v->values(), s, nVar_);
+        double norm_v = sqrt(dot(v->values(), v->values(), nVar_));
+        double norm_s = sqrt(dot(s, s, nVar_));
+        is_corrected = norm_v > 0 && fabs(d) >= SR1_SKIP_TOL * norm_s * norm_v;
+        if (is_corrected) {
+            v_.push_back(v);
+            d_.push_back(d);
+        }
+    }
+    return is_corrected;
+}
+
+
+void HessianApproximation::times_limited_memory(const double* p,
+        double* result) const {
+    for (int i = 0; i < nVar_; i++)
+        result[i] = sigma_ * p[i];
+    for (int l = 0; l < (int) v_.size(); l++) {
+        const double* v = v_[l]->values();
+        double scaling = dot(v, p, nVar_) / d_[l];
+        for (int i = 0; i < nVar_; i++)
+            result[i] += scaling * v[i];
+    }
+}
+
+}//END_NAMESPACE_SQPHOTSTART
@@ -0,0 +1,170 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#include <sqphot/KKTSolver.hpp>
+#include <sqphot/MessageHandling.hpp>
+#include <IpAlgBuilder.hpp>
+
+namespace SQPhotstart {
+
+using namespace std;
+
+KKTSolver::KKTSolver(LinearSolver linear_solver, int dense_max_size) :
+    linear_solver_(linear_solver),
+    dense_max_size_(dense_max_size),
+    nVar_(0),
+    nConstr_(0),
+    is_dense_(true),
+    is_factorized_(false),
+    is_singular_(false) {
+}
+
+
+void KKTSolver::set_structure(int nVar, int nConstr,
+                              shared_ptr<const SpTripletMat> H,
+                              shared_ptr<const SpTripletMat> A,
+                              const IdentityInfo* I_info) {
+    nVar_ = nVar;
+    nConstr_ = nConstr;
+    irow_.clear();
+    jcol_.clear();
+    //a Hessian stored in full only contributes its lower triangle
+    if (H != nullptr)
+        for (int k = 0; k < H->EntryNum(); k++)
+            if (H->isSymmetric() || H->RowIndex(k) >= H->ColIndex(k))
+                add_entry(H->RowIndex(k), H->ColIndex(k));
+    for (int k = 0; k < A->EntryNum(); k++)
+        add_entry(nVar + A->RowIndex(k), A->ColIndex(k));
+    if (I_info != NULL)
+        for (int b = 0; b < I_info->length; b++)
+            for (int t = 0; t < I_info->size[b]; t++)
+                add_entry(nVar + I_info->irow[b] + t, I_info->jcol[b] + t);
+    for (int i = 1; i <= nVar + nConstr; i++)
+        add_entry(i, i);
+    values_.assign(irow_.size(), 0.0);
+
+    is_factorized_ = false;
+    is_dense_ = linear_solver_ == DENSE_LDL || dimension() <= dense_max_size_;
+    if (is_dense_)
+        K_dense_.resize(dimension() * dimension());
+    else
+        create_sparse_solver();
+}
+
+
+void KKTSolver::set_values(shared_ptr<const SpTripletMat> H,
+                           shared_ptr<const SpTripletMat> A,
+                           const IdentityInfo* I_info, double delta_x,
+                           double delta_c) {
+    int k = 0;
+    if (H != nullptr)
+        for (int e = 0; e < H->EntryNum(); e++)
+            if (H->isSymmetric() || H->RowIndex(e) >= H->ColIndex(e))
+                values_[k++] = H->MatVal(e);
+    for (int e = 0; e < A->EntryNum(); e++)
+        values_[k++] = A->MatVal(e);
+    if (I_info != NULL)
+        for (int b = 0; b < I_info->length; b++)
+            for (int t = 0; t < I_info->size[b]; t++)
+                values_[k++] = I_info->value[b];
+    for (int i = 0; i < nVar_ + nConstr_; i++)
+        values_[k++] = i < nVar_ ? delta_x : -delta_c;
+
+    is_factorized_ = false;
+    if (!is_dense_)
+        K_->SetValues(values_.data());
+}
+
+
+bool KKTSolver::factorize() {
+    if (is_factorized_)
+        return !is_singular_;
+    if (is_dense_) {
+        //the entries at the same position are summed, as by the sparse solvers
+        int n = dimension();
+        fill(K_dense_.begin(), K_dense_.end(), 0.0);
+        for (size_t e = 0; e < values_.size(); e++)
+            K_dense_[(irow_[e] - 1) * n + jcol_[e] - 1] += values_[e];
+        is_singular_ = !ldl_.factorize(n, K_dense_.data());
+        is_factorized_ = true;
+        return !is_singular_;
+    }
+    //the sparse solvers factorize and solve in one call
+    vector<double> zero(dimension(), 0.0);
+    return sparse_solve(zero.data(), 1);
+}
+
+
+bool KKTSolver::solve(double* rhs, int nrhs) {
+    if (!is_dense_)
+        //the sparse solvers factorize K again only if its values have changed
+        return !(is_factorized_ && is_singular_) && sparse_solve(rhs, nrhs);
+    if (!factorize())
+        return false;
+    for (int r = 0; r < nrhs; r++)
+        ldl_.solve(rhs + r * dimension());
+    return true;
+}
+
+
+bool KKTSolver::provides_inertia() const {
+    return is_dense_ || sparse_solver_->ProvidesInertia();
+}
+
+
+int KKTSolver::num_negative() const {
+    return is_dense_ ? ldl_.num_negative() : sparse_solver_->NumberOfNegEVals();
+}
+
+
+void KKTSolver::create_sparse_solver() {
+    if (IsNull(app_)) {
+        app_ = new Ipopt::IpoptApplication(false);
+        app_->Options()->SetStringValue("linear_solver",
+                                        linear_solver_ == MA27 ? "ma27" : "mumps");
+    }
+    //a new solver, since a SymLinearSolver analyses the pattern of the first
+    //matrix it is given only
+    Ipopt::AlgorithmBuilder builder;
+    sparse_solver_ = builder.SymLinearSolverFactory(*app_->Jnlst(), *app_->Options(),
+                     "");
+    if (!sparse_solver_->ReducedInitialize(*app_->Jnlst(), *app_->Options(), ""))
+        THROW_EXCEPTION(KKT_SOLVER_ERROR, KKT_SOLVER_ERROR_MSG);
+    K_space_ = new Ipopt::SymTMatrixSpace(dimension(), (int) irow_.size(),
+                                          irow_.data(), jcol_.data());
+    K_ = K_space_->MakeNewSymTMatrix();
+    vector_space_ = new Ipopt::DenseVectorSpace(dimension());
+}
+
+
+bool KKTSolver::sparse_solve(double* rhs, int nrhs) {
+    int n = dimension();
+    vector<Ipopt::SmartPtr<const Ipopt::Vector> > rhs_vectors(nrhs);
+    vector<Ipopt::SmartPtr<Ipopt::Vector> > solutions(nrhs);
+    for (int r = 0; r < nrhs; r++) {
+        Ipopt::DenseVector* b = vector_space_->MakeNewDenseVector();
+        b->SetValues(rhs + r * n);
+        rhs_vectors[r] = b;
+        solutions[r] = vector_space_->MakeNewDenseVector();
+    }
+    Ipopt::ESymSolverStatus status = sparse_solver_->MultiSolve(*K_, rhs_vectors,
+                                     solutions, false, 0);
+    if (status != Ipopt::SYMSOLVER_SUCCESS &&
+            status != Ipopt::SYMSOLVER_SINGULAR)
+        THROW_EXCEPTION(KKT_SOLVER_ERROR, KKT_SOLVER_ERROR_MSG);
+    is_factorized_ = true;
+    is_singular_ = status == Ipopt::SYMSOLVER_SINGULAR;
+    if (is_singular_)
+        return false;
+    for (int r = 0; r < nrhs; r++) {
+        const double* x = static_cast<const Ipopt::DenseVector*>(
+                              Ipopt::GetRawPtr(solutions[r]))->ExpandedValues();
+        copy(x, x + n, rhs + r * n);
+    }
+    return true;
+}
+
+}
@@ -20,9 +20,12 @@ int Options::setToDefault() {
     iter_max = 1000;
     time_max = 60.0;
     printLevel = 2;
+    trace_file = "";
+    trace_binary = false;
     qpPrintLevel = 0;       //does not print anything
     QPsolverChoice = QORE;
     LPsolverChoice = QORE;
+    formulation = BOX_BOUNDS;
     second_order_correction = false;
     penalty_update = true;
     eta_c = 0.25;
@@ -39,6 +42,8 @@ int Options::setToDefault() {
     opt_dual_fea_tol = 1.0e-4;
     opt_prim_fea_tol = 1.0e-4;
     opt_second_tol = 1.0e-8;
+    multiplier_least_squares = false;
+    multiplier_least_squares_reg = 1.0e-8;
     tol = 1.0e-8;
     penalty_update_tol = 1.0e-8;
     rho = 1;
@@ -47,11 +52,28 @@ int Options::setToDefault() {
     increase_parm = 10;
     rho_max = 1.0e6;
     penalty_iter_max = 200;
+    penalty_parallel_trials = 1;
+    penalty_concurrent_LP = true;
     eps1 = 0.1;
     eps1_change_parm = 0.1;
     eps2 = 1.0e-6;
     EnablePertubation = false;
     lp_maxiter = 100;
+    dense_qp_max_size = 100;
+    dense_qp_min_density = 0.1;
+    qp_warm_start = true;
+    qp_inexact = false;
+    qp_inexact_decrease = 1.0;
+    qp_inexact_tol = 1.0e-2;
+    qp_working_set_stable = 0;
+    qp_working_set_max_size = 300;
+    kkt_linear_solver = MUMPS;
+    kkt_dense_max_size = 100;
+    hessian_approximation = EXACT_HESSIAN;
+    limited_memory_size = 6;
+    hessian_constant = false;
+    hessian_constant_checks = 2;
+    num_threads = 1;
     return 0;
 
 }
@@ -5,6 +5,7 @@
  */
 
 #include <sqphot/QOREInterface.hpp>
+#include <sqphot/QPSnapshot.hpp>
 using namespace std;
 namespace SQPhotstart {
 /**
@@ -18,18 +19,20 @@ QOREInterface::QOREInterface(NLPInfo nlp_info,
                              QPType qptype,
                              shared_ptr<const Options> options,
                              Ipopt::SmartPtr<Ipopt::Journalist> jnlst) :
-    jnlst_(jnlst),
+    solver_(0),
     firstQPsolved_(false),
-    solver_(0) {
-#if NEW_FORMULATION
-    nConstr_QP_ = nlp_info.nCon+nlp_info.nVar;
-    nVar_QP_ = nlp_info.nVar*3+2*nlp_info.nCon;
-#else
-    nConstr_QP_ = nlp_info.nCon;
-    nVar_QP_ = nlp_info.nVar+2*nlp_info.nCon;
-#endif
+    options_(options),
+    jnlst_(jnlst) {
+    formulation_ = options->formulation;
+    nConstr_QP_ = formulation_nConstr_QP(formulation_, nlp_info);
+    nVar_QP_ = formulation_nVar_QP(formulation_, nlp_info);
+    bound_multipliers_offset_ = formulation_bound_multipliers_offset(formulation_,
+                                nlp_info);
     qpiter_[0] = 0;
     allocate_memory(nlp_info, qptype);
+    A_->set_num_threads(options->num_threads);
+    if (H_ != nullptr)
+        H_->set_num_threads(options->num_threads);
     set_solver_options(options);
 }
 
@@ -39,18 +42,23 @@ QOREInterface::QOREInterface(shared_ptr<SpHbMat> H,
                              shared_ptr<Vector> lb,
                              shared_ptr<Vector> ub,
                              shared_ptr<const Options> options):
+    solver_(0),
+    firstQPsolved_(false),
+    nConstr_QP_(A->RowNum()),
+    nVar_QP_(A->ColNum()),
+    bound_multipliers_offset_(0),
+    formulation_(BOX_BOUNDS),
+    options_(options),
     A_(A),
+    A_expanded_(A),
     H_(H),
     g_(g),
     lb_(lb),
-    ub_(ub),
-    nVar_QP_(A->ColNum()),
-    nConstr_QP_(A->RowNum()),
-    firstQPsolved_(false),
-    solver_(0) {
+    ub_(ub) {
     x_qp_= make_shared<Vector>(nVar_QP_+ nConstr_QP_);
     y_qp_= make_shared<Vector>(nVar_QP_+ nConstr_QP_);
     working_set_ = new int[nVar_QP_+ nConstr_QP_]();
+    allocate_workspace();
     qpiter_[0] = 0;
     rv_ = QPNew(&solver_, nVar_QP_, nConstr_QP_, A->EntryNum(),H->EntryNum());
     assert(rv_ == QPSOLVER_OK);
@@ -86,20 +94,21 @@ void QOREInterface::optimizeQP(shared_ptr<Stats> stats) {
     /**-------------------------------------------------------**/
     /**                   Set Data and Optimize QP            **/
     /**-------------------------------------------------------**/
-    rv_ = QPSetData(solver_, nVar_QP_, nConstr_QP_, A_->RowIndex(), A_->ColIndex(),
-                    A_->MatVal(), H_->RowIndex(), H_->ColIndex(), H_->MatVal());
+    //only pass the matrices to QORE if they have been changed since the last solve,
+    //otherwise QPOptimize reuses the current factorization and working set
+    if(!firstQPsolved_||data_change_flags_.Update_A||data_change_flags_.Update_H) {
+        rv_ = QPSetData(solver_, nVar_QP_, nConstr_QP_, A_expanded_->RowIndex(),
+                        A_expanded_->ColIndex(), A_expanded_->MatVal(), H_->RowIndex(), H_->ColIndex(), H_->MatVal());
 
-    assert(rv_ == QPSOLVER_OK);
-    if(firstQPsolved_) {
-        if(matrix_change_flag_)
-        {
+        assert(rv_ == QPSOLVER_OK);
+        if(firstQPsolved_)
             rv_ = QPAdjust(solver_, 1.0);
-        }
-        else {
-            rv_ = QPAdjust(solver_, -1.0);
-        }
     }
-    rv_ = QPOptimize(solver_, lb_->values(), ub_->values(), g_->values(), 0, 0);//
+    rv_ = QPOptimize(solver_, lb_->values(), ub_->values(), g_->values(),
+                     has_warm_start_ ? x_guess_->values() : 0,
+                     has_warm_start_ ? y_guess_->values() : 0);
+    has_warm_start_ = false;
+    reset_flags();
 
 
     if(rv_!=QPSOLVER_OK) {
@@ -141,20 +150,19 @@ void QOREInterface::optimizeLP(shared_ptr<Stats> stats) {
     /**-------------------------------------------------------**/
     /**                   Set Data and Optimize LP            **/
     /**-------------------------------------------------------**/
-    rv_ = QPSetData(solver_, nVar_QP_, nConstr_QP_, A_->RowIndex(), A_->ColIndex(),
-                    A_->MatVal(), NULL, NULL, NULL);
-    assert(rv_ == QPSOLVER_OK);
-    if(firstQPsolved_) {
-        if(matrix_change_flag_)
-        {
+    if(!firstQPsolved_||data_change_flags_.Update_A) {
+        rv_ = QPSetData(solver_, nVar_QP_, nConstr_QP_, A_expanded_->RowIndex(),
+                        A_expanded_->ColIndex(), A_expanded_->MatVal(), NULL, NULL, NULL);
+        assert(rv_ == QPSOLVER_OK);
+        if(firstQPsolved_)
             rv_ = QPAdjust(solver_, 1.0);
-        }
-        else {
-            rv_ = QPAdjust(solver_, -1.0);
-        }
     }
 
-    rv_ = QPOptimize(solver_, lb_->values(), ub_->values(), g_->values(), 0, 0);//
+    rv_ = QPOptimize(solver_, lb_->values(), ub_->values(), g_->values(),
+                     has_warm_start_ ? x_guess_->values() : 0,
+                     has_warm_start_ ? y_guess_->values() : 0);
+    has_warm_start_ = false;
+    reset_flags();
     assert(rv_ == QPSOLVER_OK);
 
     rv_ = QPGetInt(solver_, "status", &status_);
@@ -182,6 +190,23 @@ void QOREInterface::optimizeLP(shared_ptr<Stats> stats) {
 }
 
 
+void QOREInterface::set_warm_start(const ActiveType* W_constr,
+                                   const ActiveType* W_bounds, const double* x,
+                                   const double* y_bounds, const double* y_constr) {
+    std::copy(x, x + nVar_QP_, x_guess_->values());
+    A_expanded_->times(x_guess_, Ax_work_);
+    std::copy(Ax_work_->values(), Ax_work_->values() + nConstr_QP_,
+              x_guess_->values() + nVar_QP_);
+
+    //QORE takes the working set from the nonzero entries of y0
+    for (int i = 0; i < nVar_QP_; i++)
+        y_guess_->setValueAt(i, W_bounds[i] == INACTIVE ? 0.0 : y_bounds[i]);
+    for (int i = 0; i < nConstr_QP_; i++)
+        y_guess_->setValueAt(nVar_QP_ + i, W_constr[i] == INACTIVE ? 0.0 : y_constr[i]);
+    has_warm_start_ = true;
+}
+
+
 /**
  * @brief Allocate memory for the class members
  * @param nlp_index_info  the struct that stores simple nlp dimension info
@@ -190,22 +215,22 @@ void QOREInterface::optimizeLP(shared_ptr<Stats> stats) {
 
 void QOREInterface::allocate_memory(NLPInfo nlp_info, QPType qptype) {
 
-#if NEW_FORMULATION
-    int nnz_g_QP = nlp_info.nnz_jac_g+2*nlp_info.nCon+3*nlp_info.nVar;
-#else
-    int nnz_g_QP = nlp_info.nnz_jac_g + 2 * nlp_info.nCon;
     //number of nonzero variables in jacobian
     //The Jacobian has the structure [J I -I], so it will contains extra 2*number_constr
-    //nonzero elements
-#endif
+    //nonzero elements, and the rows [I 0 0 I -I] of the bounds 3*number_var more
+    int nnz_g_QP = nlp_info.nnz_jac_g + 2 * nlp_info.nCon;
+    if (formulation_ == ELASTIC_BOUNDS)
+        nnz_g_QP += 3 * nlp_info.nVar;
 
     lb_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
     ub_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
     g_ = make_shared<Vector>(nVar_QP_);
-    A_ = make_shared<SpHbMat>(nnz_g_QP, nConstr_QP_, nVar_QP_,true);
+    //the identity blocks of A are kept implicitly, only the Jacobian is stored
+    A_ = make_shared<SpHbMat>(nlp_info.nnz_jac_g, nConstr_QP_, nVar_QP_,true);
     x_qp_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
     y_qp_ = make_shared<Vector>(nConstr_QP_ + nVar_QP_);
     working_set_  =  new int[nConstr_QP_+nVar_QP_];
+    allocate_workspace();
     if (qptype != LP) {
         rv_ = QPNew(&solver_, nVar_QP_, nConstr_QP_, nnz_g_QP,
                     nlp_info.nnz_h_lag);
@@ -227,13 +252,12 @@ bool QOREInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     double compl_violation = 0.0;
     double statioanrity_violation = 0.0;
 
-    shared_ptr<Vector> Ax = make_shared<Vector>(nConstr_QP_);
-    shared_ptr<Vector> stationary_gap = make_shared<Vector>(nVar_QP_);
+    shared_ptr<Vector> stationary_gap = stationary_gap_work_;
 
 
     if(W_c==NULL&&W_b==NULL) {
-        W_c = new ActiveType[nConstr_QP_];
-        W_b = new ActiveType[nVar_QP_];
+        W_c = W_c_work_.data();
+        W_b = W_b_work_.data();
     }
 
     get_working_set(W_c,W_b);
@@ -314,7 +338,7 @@ bool QOREInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     //calculate A'*y+lambda-g-Hx
     A_->transposed_times(y_qp_->values()+nVar_QP_, stationary_gap->values());
 
-    shared_ptr<Vector> Hx = make_shared<Vector>(nVar_QP_);
+    shared_ptr<Vector> Hx = Hx_work_;
     H_->times(x_qp_, Hx);
     stationary_gap->add_vector(y_qp_->values());
     stationary_gap->subtract_vector(g_->values());
@@ -386,11 +410,6 @@ bool QOREInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     qpOptimalStatus_.KKT_error =
         compl_violation + statioanrity_violation + dual_violation + primal_violation;
 
-    if(W_c==NULL&&W_b == NULL) {
-        delete[] W_c;
-        delete[] W_b;
-    }
-
     double tol= 1.0e-5;
 //    if(A!= nullptr)
 //        tol =  (std::max(H->oneNorm(),A->oneNorm())+1)*1.0e-6;
@@ -416,9 +435,8 @@ bool QOREInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
 //@{
 
 double QOREInterface::get_obj_value() {
-    shared_ptr<Vector> Hx = make_shared<Vector>(nVar_QP_);
-    H_->times(x_qp_,Hx); //Hx = H*x_qp
-    return (Hx->times(x_qp_)*0.5+g_->times(x_qp_));
+    H_->times(x_qp_,Hx_work_); //Hx = H*x_qp
+    return (Hx_work_->times(x_qp_)*0.5+g_->times(x_qp_));
 }
 
 
@@ -495,115 +513,47 @@ void QOREInterface::get_working_set(ActiveType* W_constr, ActiveType* W_bounds)
 
 
 
-void QOREInterface::WriteQPDataToFile(Ipopt::EJournalLevel level,
-                                      Ipopt::EJournalCategory category,
-                                      const string filename) {
-
-
-#if DEBUG
-#if PRINT_OUT_QP_WITH_ERROR
-#if PRINT_QP_IN_CPP
-    jnlst_->DeleteAllJournals();
-    Ipopt::SmartPtr<Ipopt::Journal> QPdata_jrnl= jnlst_->AddFileJournal("QPdata",
-            "QORE_cpp_"+filename,Ipopt::J_WARNING);
-    QPdata_jrnl->SetAllPrintLevels(level);
-    QPdata_jrnl->SetPrintLevel(category,level);
-    jnlst_->Printf(level, category, "#include <stdio.h>\n"
-                   "#include <assert.h>\n"
-                   "#include <stdlib.h>\n"
-                   "#include <string.h>\n"
-                   "#include <math.h>\n"
-                   "#include <matrixconversion.h>\n"
-                   "#include <qpsolver.h>\n"
-                   "\n"
-                   "int main(){\n"
-                   "#define NV %i\n#define NC %i\n", nVar_QP_, nConstr_QP_);
-    lb_->write_to_file("lb",jnlst_,level,category,QORE);
-    ub_->write_to_file("ub",jnlst_,level,category,QORE);
-    g_->write_to_file("g",jnlst_,level,category,QORE);
-    A_->write_to_file("A",jnlst_,level,category,QORE);
-    H_->write_to_file("H",jnlst_,level,category,QORE);
-
-    jnlst_->Printf(level,category,"QoreProblem * qp = 0;\n");
-    jnlst_->Printf(level,category,"qp_int rv = QPNew( &qp, NV, NC, %i, %i );\n",
-                   A_->EntryNum(), H_->EntryNum());
-    jnlst_->Printf(level,category,"assert( rv == QPSOLVER_OK );\n");
-    jnlst_->Printf(level,category,"assert( qp!= 0 );\n");
-    jnlst_->Printf(level,category,"QPSetInt(qp, \"prtfreq\", 0); \n");
-    // pass problem data to solver
-    jnlst_->Printf(level, category, "rv = QPSetData( qp, NV, NC, A_jc, A_ir, A_val, H_jc,"
-                   " H_ir, H_val );\n");
-
-    jnlst_->Printf(level,category,"assert( rv == QPSOLVER_OK );\n");
-    // solve first QP
-    jnlst_->Printf(level, category,"rv = QPOptimize( qp, lb, ub, g, 0, 0 );\n");
-
-    jnlst_->Printf(level,category,"qp_int status;\n");
-    jnlst_->Printf(level,category,"QPGetInt(qp, \"status\", &status);\n");
-    jnlst_->Printf(level,category,"if(status!=QPSOLVER_OPTIMAL){\n)");
-    jnlst_->Printf(level,category,"    printf(\"Warning! The QP is not solved to optimality!\");\n");
-    jnlst_->Printf(level,category,"}\n");
-    jnlst_->Printf(level,category,"assert( rv == QPSOLVER_OK );\n");
-    // get and print primal solution
-
-    jnlst_->Printf(level, category, "QPFree(&qp);\n"
-                   "\n return 0; \n"
-                   "}\n");
-
-#else
-#if PRINT_DATA_FOR_QPOASES
-    jnlst_->DeleteAllJournals();
-    Ipopt::SmartPtr<Ipopt::Journal> QPdata_qpOASES_jrnl= jnlst_->AddFileJournal("QPdata",
-            "QPOASES_"+filename,Ipopt::J_WARNING);
-    QPdata_qpOASES_jrnl->SetAllPrintLevels(level);
-    QPdata_qpOASES_jrnl->SetPrintLevel(category,level);
-
-    jnlst_->Printf(level, category, "%d\n", nVar_QP_);
-    jnlst_->Printf(level, category, "%d\n", nConstr_QP_);
-    jnlst_->Printf(level, category, "%d\n", A_->EntryNum());
-    jnlst_->Printf(level, category, "%d\n", H_->EntryNum());
-    lb_->write_to_file("lb",jnlst_,level,category,QORE);
-    ub_->write_to_file("ub",jnlst_,level,category,QORE);
-    g_->write_to_file("g",jnlst_,level,category,QORE);
-
-    shared_ptr<Vector> A_dense = make_shared<Vector>(nVar_QP_*nConstr_QP_);
-    shared_ptr<Vector> H_dense = make_shared<Vector>(nVar_QP_*nVar_QP_);
-
-    A_->get_dense_matrix(A_dense->values());
-    shared_ptr<SpHbMat> A_out = make_shared<SpHbMat>(A_dense->values(),nConstr_QP_,nVar_QP_,true,false);
-    A_out->write_to_file("A",jnlst_,level,category,QPOASES);
-
-    H_->get_dense_matrix(H_dense->values());
-
-    shared_ptr<SpHbMat> H_out = make_shared<SpHbMat>(H_dense->values(),nVar_QP_,nVar_QP_,true,false);
-    H_out->write_to_file("H",jnlst_,level,category,QPOASES);
-#endif
-
-#if PRINT_DATA_FOR_QORE
-    jnlst_->DeleteAllJournals();
-    Ipopt::SmartPtr<Ipopt::Journal> QPdata_qore_jrnl= jnlst_->AddFileJournal("QPdata",
-            "QORE_"+filename,Ipopt::J_WARNING);
-    QPdata_qore_jrnl->SetAllPrintLevels(level);
-    QPdata_qore_jrnl->SetPrintLevel(category,level);
-
-    jnlst_->Printf(level, category, "%d\n", nVar_QP_);
-    jnlst_->Printf(level, category, "%d\n", nConstr_QP_);
-    jnlst_->Printf(level, category, "%d\n", A_->EntryNum());
-    jnlst_->Printf(level, category, "%d\n", H_->EntryNum());
-    lb_->write_to_file("lb",jnlst_,level,category,QORE);
-    ub_->write_to_file("ub",jnlst_,level,category,QORE);
-    g_->write_to_file("g",jnlst_,level,category,QORE);
-    A_->write_to_file("A",jnlst_,level,category,QORE);
-    H_->write_to_file("H",jnlst_,level,category,QORE);
-
-#endif
-#endif
-#endif
-    jnlst_->DeleteAllJournals();
-#endif
+void QOREInterface::WriteQPSnapshot(const string filename) {
+    //the working set is only defined once QORE has been run on the QP
+    vector<ActiveType> W_bounds(nVar_QP_);
+    vector<ActiveType> W_constr(nConstr_QP_);
+    bool has_working_set = true;
+    try {
+        get_working_set(W_constr.data(), W_bounds.data());
+    }
+    catch (INVALID_WORKING_SET &) {
+        has_working_set = false;
+    }
+
+    //lb_ and ub_ hold the bounds on the variables followed by those on Ax
+    QPSnapshot::write(filename, H_ != nullptr ? QP : LP, QORE, get_status(), options_,
+                      H_, A_expanded_, g_->values(), lb_->values(), ub_->values(),
+                      lb_->values() + nVar_QP_, ub_->values() + nVar_QP_,
+                      has_working_set ? W_bounds.data() : NULL,
+                      has_working_set ? W_constr.data() : NULL);
+}
+
+void QOREInterface::allocate_workspace() {
+    Ax_work_ = make_shared<Vector>(nConstr_QP_);
+    Hx_work_ = make_shared<Vector>(nVar_QP_);
+    stationary_gap_work_ = make_shared<Vector>(nVar_QP_);
+    W_c_work_.resize(nConstr_QP_);
+    W_b_work_.resize(nVar_QP_);
+    x_guess_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
+    y_guess_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
+}
+
 
+void QOREInterface::reset_flags() {
+    data_change_flags_.Update_A = false;
+    data_change_flags_.Update_delta = false;
+    data_change_flags_.Update_H = false;
+    data_change_flags_.Update_penalty = false;
+    data_change_flags_.Update_g = false;
+    data_change_flags_.Update_bounds = false;
 }
 
+
 void QOREInterface::handle_error(QPType qptype, shared_ptr<Stats> stats) {
     switch(status_) {
     case QPSOLVER_OPTIMAL:
@@ -641,19 +591,37 @@ void QOREInterface::set_solver_options(shared_ptr<const Options> options) {
 
 
 void QOREInterface::set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info) {
-    if(!A_->isinitialized())
-        A_->setStructure(rhs, I_info);
+    if(!A_->isinitialized()) {
+        A_->set_identity_blocks(I_info);
+        A_->setStructure(rhs);
+    }
     else {
-        matrix_change_flag_ = true;
-        A_->setMatVal(rhs, I_info);
+        data_change_flags_.Update_A = true;
+        A_->setMatVal(rhs);
+    }
+    //QORE takes the whole matrix explicitly; only the Jacobian values are copied
+    //after the first call
+    A_expanded_ = A_->expanded();
+}
+
+
+void QOREInterface::set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+                          const std::vector<int>& entries) {
+    if (!A_->isinitialized()) {
+        set_A(rhs, I_info);
+        return;
     }
+    data_change_flags_.Update_A = true;
+    A_->setMatVal(rhs, entries);
+    //QPSetData still copies the whole expanded matrix
+    A_expanded_ = A_->expanded();
 }
 
 void QOREInterface::set_H(shared_ptr<const SpTripletMat> rhs) {
     if(!H_->isinitialized())
         H_->setStructure(rhs);
     else {
-        matrix_change_flag_=true;
+        data_change_flags_.Update_H = true;
         H_->setMatVal(rhs);
     }
 }
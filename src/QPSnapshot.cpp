@@ -0,0 +1,390 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+#include <sqphot/QPSnapshot.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SQPhotstart {
+using namespace std;
+
+static_assert(sizeof(int) == sizeof(int32_t),
+              "the snapshot stores the SpHbMat indices as int32_t");
+static_assert(sizeof(ActiveType) == sizeof(int32_t),
+              "the snapshot stores the working set as int32_t");
+static_assert(sizeof(QPSnapshot::Header) % 8 == 0,
+              "the payload has to start 8-byte aligned");
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'Q', 'P', 'H', 'Q', 'P', 'S', 'N'};
+const int32_t SNAPSHOT_VERSION = 1;
+const int32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+/** @brief continue the FNV-1a hash of a byte sequence*/
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~(size_t) 7;
+}
+
+/**
+ * @brief the offsets of the sections, each aligned to 8 bytes, in the order they
+ * are written
+ */
+static QPSnapshot::Layout compute_layout(const QPSnapshot::Header &header) {
+    size_t nVar = header.nVar;
+    size_t nConstr = header.nConstr;
+    size_t A_lines = header.A_is_compressed_row ? nConstr : nVar;
+    size_t nnz_H = header.has_H ? header.nnz_H : 0;
+    size_t H_lines = header.has_H ? nVar + 1 : 0;
+
+    QPSnapshot::Layout layout;
+    size_t offset = sizeof(QPSnapshot::Header);
+    layout.A_pointer = offset;
+    offset = align8(offset + (A_lines + 1) * sizeof(int32_t));
+    layout.A_index = offset;
+    offset = align8(offset + header.nnz_A * sizeof(int32_t));
+    layout.A_values = offset;
+    offset += header.nnz_A * sizeof(double);
+    layout.H_pointer = offset;
+    offset = align8(offset + H_lines * sizeof(int32_t));
+    layout.H_index = offset;
+    offset = align8(offset + nnz_H * sizeof(int32_t));
+    layout.H_values = offset;
+    offset += nnz_H * sizeof(double);
+    layout.g = offset;
+    offset += nVar * sizeof(double);
+    layout.lb = offset;
+    offset += nVar * sizeof(double);
+    layout.ub = offset;
+    offset += nVar * sizeof(double);
+    layout.lbA = offset;
+    offset += nConstr * sizeof(double);
+    layout.ubA = offset;
+    offset += nConstr * sizeof(double);
+    layout.working_set = offset;
+    if (header.has_working_set)
+        offset = align8(offset + (nVar + nConstr) * sizeof(int32_t));
+    layout.file_size = offset;
+    return layout;
+}
+
+
+/**
+ * @brief Streams the sections of a snapshot to a file with write(2), straight
+ * from the caller's buffers, and hashes them on the way.
+ *
+ * The file is removed if anything goes wrong, so that a truncated snapshot is
+ * never left behind.
+ */
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const string &filename) :
+        filename_(filename),
+        offset_(0),
+        checksum_(FNV_OFFSET_BASIS) {
+        fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+            fail("cannot be created");
+    }
+
+    ~SnapshotWriter() {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    /** @brief write a section of the payload at the current offset*/
+    void append(const void* data, size_t length) {
+        if (length == 0)
+            return;
+        checksum_ = fnv1a(checksum_, data, length);
+        write_at(data, length, offset_);
+        offset_ += length;
+    }
+
+    /** @brief pad the payload with zeros up to the next multiple of 8 bytes*/
+    void pad() {
+        static const char zeros[8] = {0};
+        append(zeros, align8(offset_) - offset_);
+    }
+
+    /** @brief write the header, once the payload has been written*/
+    void finish(QPSnapshot::Header &header) {
+        header.checksum = checksum_;
+        write_at(&header, sizeof(header), 0);
+        if (close(fd_) != 0) {
+            fd_ = -1;
+            fail("cannot be closed");
+        }
+        fd_ = -1;
+    }
+
+    inline size_t offset() const {
+        return offset_;
+    }
+
+    inline void set_offset(size_t offset) {
+        offset_ = offset;
+    }
+
+private:
+    void write_at(const void* data, size_t length, size_t offset) {
+        const char* bytes = static_cast<const char*>(data);
+        while (length > 0) {
+            ssize_t written = pwrite(fd_, bytes, length, (off_t) offset);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                fail("cannot be written");
+            }
+            bytes += written;
+            offset += written;
+            length -= written;
+        }
+    }
+
+    void fail(const string &reason) {
+        string message = string(INVALID_QP_SNAPSHOT_MSG) + filename_ + " " + reason +
+                         ": " + strerror(errno);
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+            unlink(filename_.c_str());
+        }
+        THROW_EXCEPTION(INVALID_QP_SNAPSHOT, message);
+    }
+
+    string filename_;
+    int fd_;
+    size_t offset_;
+    uint64_t checksum_;
+};
+
+
+void QPSnapshot::write(const string &filename, QPType qptype, Solver solver,
+                       Exitflag status, shared_ptr<const Options> options,
+                       shared_ptr<const SpHbMat> H, shared_ptr<const SpHbMat> A,
+                       const double* g, const double* lb, const double* ub,
+                       const double* lbA, const double* ubA,
+                       const ActiveType* W_bounds, const ActiveType* W_constr) {
+    //the identity blocks of A have to be expanded, see SpHbMat::expanded
+    assert(A->IdentityEntryNum() == 0);
+    bool has_H = H != nullptr && qptype != LP;
+    Options default_options;
+    const Options* opt = options != nullptr ? options.get() : &default_options;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.qptype = qptype;
+    header.solver = solver;
+    header.status = status;
+    header.nVar = A->ColNum();
+    header.nConstr = A->RowNum();
+    header.nnz_A = A->EntryNum();
+    header.nnz_H = has_H ? H->EntryNum() : 0;
+    header.A_is_compressed_row = A->isCompressedRow();
+    header.H_is_compressed_row = has_H ? H->isCompressedRow() : 0;
+    header.has_H = has_H;
+    header.has_working_set = W_bounds != NULL && W_constr != NULL;
+    header.qp_maxiter = opt->qp_maxiter;
+    header.lp_maxiter = opt->lp_maxiter;
+    header.qpPrintLevel = opt->qpPrintLevel;
+    Layout layout = compute_layout(header);
+    header.payload_size = layout.file_size - sizeof(Header);
+
+    //in compressed row format, RowIndex() holds the pointers to the lines and
+    //ColIndex() their column indices, and the other way around otherwise
+    SnapshotWriter writer(filename);
+    writer.set_offset(sizeof(Header));
+    int nVar = header.nVar;
+    int nConstr = header.nConstr;
+    if (A->isCompressedRow()) {
+        writer.append(A->RowIndex(), (nConstr + 1) * sizeof(int));
+        writer.pad();
+        writer.append(A->ColIndex(), A->EntryNum() * sizeof(int));
+    } else {
+        writer.append(A->ColIndex(), (nVar + 1) * sizeof(int));
+        writer.pad();
+        writer.append(A->RowIndex(), A->EntryNum() * sizeof(int));
+    }
+    writer.pad();
+    writer.append(A->MatVal(), A->EntryNum() * sizeof(double));
+    if (has_H) {
+        const int* pointer = H->isCompressedRow() ? H->RowIndex() : H->ColIndex();
+        const int* index = H->isCompressedRow() ? H->ColIndex() : H->RowIndex();
+        writer.append(pointer, (nVar + 1) * sizeof(int));
+        writer.pad();
+        writer.append(index, H->EntryNum() * sizeof(int));
+        writer.pad();
+        writer.append(H->MatVal(), H->EntryNum() * sizeof(double));
+    }
+    writer.append(g, nVar * sizeof(double));
+    writer.append(lb, nVar * sizeof(double));
+    writer.append(ub, nVar * sizeof(double));
+    writer.append(lbA, nConstr * sizeof(double));
+    writer.append(ubA, nConstr * sizeof(double));
+    if (header.has_working_set) {
+        writer.append(W_bounds, nVar * sizeof(ActiveType));
+        writer.append(W_constr, nConstr * sizeof(ActiveType));
+        writer.pad();
+    }
+    assert(writer.offset() == layout.file_size);
+    writer.finish(header);
+}
+
+
+QPSnapshot::QPSnapshot(const string &filename) :
+    data_(NULL),
+    size_(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        THROW_EXCEPTION(INVALID_QP_SNAPSHOT, string(INVALID_QP_SNAPSHOT_MSG) +
+                        filename + " cannot be opened: " + strerror(errno));
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(Header)) {
+        close(fd);
+        THROW_EXCEPTION(INVALID_QP_SNAPSHOT, string(INVALID_QP_SNAPSHOT_MSG) +
+                        filename + " is too short");
+    }
+    size_ = file_stat.st_size;
+    void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        THROW_EXCEPTION(INVALID_QP_SNAPSHOT, string(INVALID_QP_SNAPSHOT_MSG) +
+                        filename + " cannot be mapped: " + strerror(errno));
+    data_ = static_cast<const char*>(data);
+
+    try {
+        validate(filename);
+    }
+    catch (...) {
+        munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+
+QPSnapshot::~QPSnapshot() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+
+/**
+ * @brief check that the pointers of n_lines compressed lines are nondecreasing
+ * from 0 to nnz, and that the indices lie in [0, n_other)
+ */
+static bool is_valid_compressed(const int* pointer, int n_lines, const int* index,
+                                int nnz, int n_other) {
+    if (pointer[0] != 0 || pointer[n_lines] != nnz)
+        return false;
+    for (int i = 0; i < n_lines; i++)
+        if (pointer[i] > pointer[i + 1])
+            return false;
+    for (int k = 0; k < nnz; k++)
+        if (index[k] < 0 || index[k] >= n_other)
+            return false;
+    return true;
+}
+
+
+void QPSnapshot::validate(const string &filename) {
+    memcpy(&header_, data_, sizeof(Header));
+    string error;
+    if (memcmp(header_.magic, SNAPSHOT_MAGIC, sizeof(header_.magic)) != 0)
+        error = " is not a QP snapshot";
+    else if (header_.version != SNAPSHOT_VERSION)
+        error = " has an unsupported version";
+    else if (header_.byte_order != SNAPSHOT_BYTE_ORDER)
+        error = " was written with a different byte order";
+    else if (header_.nVar < 0 || header_.nConstr < 0 || header_.nnz_A < 0 ||
+             header_.nnz_H < 0)
+        error = " has invalid dimensions";
+    else {
+        layout_ = compute_layout(header_);
+        if (layout_.file_size != size_ ||
+                header_.payload_size != size_ - sizeof(Header))
+            error = " is truncated";
+        else if (fnv1a(FNV_OFFSET_BASIS, data_ + sizeof(Header),
+                       size_ - sizeof(Header)) != header_.checksum)
+            error = " is corrupted (checksum mismatch)";
+        else if (!is_valid_compressed(A_pointer(), A_isCompressedRow() ?
+                                      nConstr() : nVar(), A_index(), nnz_A(),
+                                      A_isCompressedRow() ? nVar() : nConstr()) ||
+                 (header_.has_H && !is_valid_compressed(H_pointer(), nVar(),
+                         H_index(), nnz_H(), nVar())))
+            error = " has an invalid matrix structure";
+    }
+    if (!error.empty())
+        THROW_EXCEPTION(INVALID_QP_SNAPSHOT, string(INVALID_QP_SNAPSHOT_MSG) +
+                        filename + error);
+}
+
+
+shared_ptr<SpHbMat> QPSnapshot::to_SpHbMat(int RowNum, int ColNum, int nnz,
+        bool stored_as_compressed_row, const int* pointer, const int* index,
+        const double* values, bool isCompressedRow) {
+    int n_lines = stored_as_compressed_row ? RowNum : ColNum;
+    auto triplet = make_shared<SpTripletMat>(nnz, RowNum, ColNum, false);
+    for (int line = 0; line < n_lines; line++) {
+        for (int k = pointer[line]; k < pointer[line + 1]; k++) {
+            int row = stored_as_compressed_row ? line : index[k];
+            int col = stored_as_compressed_row ? index[k] : line;
+            triplet->setRowIndex(k, row + 1);
+            triplet->setColIndex(k, col + 1);
+            triplet->setMatValAt(k, values[k]);
+        }
+    }
+    auto result = make_shared<SpHbMat>(nnz, RowNum, ColNum, isCompressedRow);
+    result->setStructure(triplet);
+    result->setMatVal(triplet);
+    return result;
+}
+
+
+shared_ptr<SpHbMat> QPSnapshot::get_A(bool isCompressedRow) const {
+    return to_SpHbMat(nConstr(), nVar(), nnz_A(), A_isCompressedRow(), A_pointer(),
+                      A_index(), A_values(), isCompressedRow);
+}
+
+
+shared_ptr<SpHbMat> QPSnapshot::get_H(bool isCompressedRow) const {
+    if (!header_.has_H) {
+        //an empty Hessian, for the interfaces which need one for an LP as well
+        vector<int> pointer(nVar() + 1, 0);
+        return to_SpHbMat(nVar(), nVar(), 0, H_isCompressedRow(), pointer.data(),
+                          NULL, NULL, isCompressedRow);
+    }
+    return to_SpHbMat(nVar(), nVar(), nnz_H(), H_isCompressedRow(), H_pointer(),
+                      H_index(), H_values(), isCompressedRow);
+}
+
+
+shared_ptr<Options> QPSnapshot::get_options() const {
+    auto options = make_shared<Options>();
+    options->QPsolverChoice = solver();
+    options->qp_maxiter = header_.qp_maxiter;
+    options->lp_maxiter = header_.lp_maxiter;
+    options->qpPrintLevel = header_.qpPrintLevel;
+    return options;
+}
+
+}//END_NAMESPACE_SQPHOTSTART
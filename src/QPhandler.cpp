@@ -15,45 +15,47 @@ QPhandler::QPhandler(NLPInfo nlp_info, QPType qptype, Ipopt::SmartPtr<Ipopt::Jou
     nlp_info_(nlp_info),
     jnlst_(jnlst),
     QPsolverChoice_(options->QPsolverChoice) {
-#if NEW_FORMULATION
-    nConstr_QP_ = nlp_info.nCon+nlp_info.nVar;
-    nVar_QP_ = nlp_info.nVar*3+2*nlp_info.nCon;
-    I_info_A_.length = 5;
-    I_info_A_.irow = new int[5];
-    I_info_A_.jcol = new int[5];
-    I_info_A_.size = new int[5];
-    I_info_A_.value = new double[5];
-    I_info_A_.irow[0] = I_info_A_.irow[1] = 1;
-    I_info_A_.irow[2] = I_info_A_.irow[3] = I_info_A_.irow[4] = nlp_info.nCon+1;
-    I_info_A_.jcol[0] = nlp_info.nVar+1;
-    I_info_A_.jcol[1] = nlp_info_.nVar+nlp_info.nCon+1;
-    I_info_A_.jcol[2] = 1;
-    I_info_A_.jcol[3] = nlp_info_.nVar+nlp_info.nCon*2+1;
-    I_info_A_.jcol[4] = nlp_info_.nVar*2+nlp_info.nCon*2+1;
-    I_info_A_.size[0] = I_info_A_.size[1] = nlp_info.nCon;
-    I_info_A_.size[2] = I_info_A_.size[3] = I_info_A_.size[4] = nlp_info.nVar;
-    I_info_A_.value[0] = I_info_A_.value[2] = I_info_A_.value[3] = 1.0;
-    I_info_A_.value[1] = I_info_A_.value[4] = -1.0;
-
-#else
-    nConstr_QP_ = nlp_info.nCon;
-    nVar_QP_ = nlp_info.nVar+2*nlp_info.nCon;
-    I_info_A_.length = 2;
-    I_info_A_.irow = new int[2];
-    I_info_A_.jcol = new int[2];
-    I_info_A_.size = new int[2];
-    I_info_A_.value = new double[2];
-    I_info_A_.irow[0] = I_info_A_.irow[1] = 1;
-    I_info_A_.jcol[0] = nlp_info.nVar+1;
-    I_info_A_.jcol[1] = nlp_info_.nVar+nlp_info.nCon+1;
-    I_info_A_.size[0] = I_info_A_.size[1] = nlp_info.nCon;
-    I_info_A_.value[0] = 1.0;
-    I_info_A_.value[1] = -1.0;
-#endif
+    formulation_ = options->formulation;
+    //the interfaces of GUROBI and CPLEX only build the QP of BOX_BOUNDS
+    if (formulation_ == ELASTIC_BOUNDS &&
+            (QPsolverChoice_ == GUROBI || QPsolverChoice_ == CPLEX))
+        THROW_EXCEPTION(INVALID_FORMULATION, INVALID_FORMULATION_MSG);
+    nConstr_QP_ = formulation_nConstr_QP(formulation_, nlp_info);
+    nVar_QP_ = formulation_nVar_QP(formulation_, nlp_info);
+    if (formulation_ == ELASTIC_BOUNDS)
+        set_identity_blocks<ELASTIC_BOUNDS>();
+    else
+        set_identity_blocks<BOX_BOUNDS>();
 
     W_b_ = new ActiveType[nVar_QP_];
     W_c_ = new ActiveType[nConstr_QP_];
+    lb_work_ = new double[nVar_QP_ + nConstr_QP_];
+    ub_work_ = new double[nVar_QP_ + nConstr_QP_];
+    has_linear_A_entries_ = false;
+    is_linear_A_set_ = false;
+    is_H_constant_ = false;
+    is_constant_H_set_ = false;
+    bound_multipliers_offset_ = formulation_bound_multipliers_offset(formulation_,
+                                nlp_info);
+
+    same_working_set_count_ = 0;
+    working_set_stable_ = options->qp_working_set_stable;
+    is_working_set_solution_ = false;
+    if (qptype == QP && working_set_stable_ > 0) {
+        working_set_solver_ = make_shared<WorkingSetSolver>(nVar_QP_, nConstr_QP_,
+                              options->qp_working_set_max_size,
+                              options->kkt_linear_solver,
+                              options->kkt_dense_max_size);
+        W_b_last_.resize(nVar_QP_);
+        W_c_last_.resize(nConstr_QP_);
+    }
 
+    //small subproblems are solved faster on dense matrices than with the setup of
+    //the sparse solvers
+    if (QPsolverChoice_ == AUTO_SOLVER)
+        QPsolverChoice_ = nVar_QP_ <= options->dense_qp_max_size &&
+                          nlp_info.nnz_jac_g >= options->dense_qp_min_density *
+                          nlp_info.nCon * nlp_info.nVar ? DENSE : QORE;
 
     switch (QPsolverChoice_) {
     case QPOASES:
@@ -63,6 +65,10 @@ QPhandler::QPhandler(NLPInfo nlp_info, QPType qptype, Ipopt::SmartPtr<Ipopt::Jou
     case QORE:
         solverInterface_ = make_shared<QOREInterface>(nlp_info, qptype, options, jnlst);
         break;
+    case DENSE:
+        solverInterface_ = make_shared<DenseQPInterface>(nlp_info, qptype, options,
+                           jnlst);
+        break;
     case GUROBI:
 #ifdef USE_GUROBI
         isolverInterface_ = make_shared<GurobiInterface>(nlp_info, qptype, options, jnlst);
@@ -73,6 +79,10 @@ QPhandler::QPhandler(NLPInfo nlp_info, QPType qptype, Ipopt::SmartPtr<Ipopt::Jou
         solverInterface_ = make_shared<CplexInterface>(nlp_info, qptype, options, jnlst);
 #endif
         break;
+    //AUTO_SOLVER is resolved above
+    case AUTO_SOLVER:
+    default:
+        THROW_EXCEPTION(INVALID_QP_SOLVER, INVALID_QP_SOLVER_MSG);
     }
 
 #if DEBUG
@@ -98,6 +108,10 @@ QPhandler::~QPhandler() {
     W_b_ = NULL;
     delete[] W_c_;
     W_c_ = NULL;
+    delete[] lb_work_;
+    lb_work_ = NULL;
+    delete[] ub_work_;
+    ub_work_ = NULL;
     delete[] I_info_A_.irow;
     I_info_A_.irow = NULL;
     delete[] I_info_A_.jcol;
@@ -118,6 +132,35 @@ QPhandler::~QPhandler() {
 }
 
 
+void QPhandler::swap_state(QPhandler &other) {
+    assert(QPsolverChoice_ == other.QPsolverChoice_ &&
+           nVar_QP_ == other.nVar_QP_ && nConstr_QP_ == other.nConstr_QP_);
+    std::swap(solverInterface_, other.solverInterface_);
+    std::swap(W_c_, other.W_c_);
+    std::swap(W_b_, other.W_b_);
+    W_c_last_.swap(other.W_c_last_);
+    W_b_last_.swap(other.W_b_last_);
+    std::swap(same_working_set_count_, other.same_working_set_count_);
+    std::swap(working_set_solver_, other.working_set_solver_);
+    std::swap(is_working_set_solution_, other.is_working_set_solution_);
+    std::swap(hessian_, other.hessian_);
+    std::swap(jacobian_, other.jacobian_);
+    std::swap(is_linear_A_set_, other.is_linear_A_set_);
+    std::swap(is_constant_H_set_, other.is_constant_H_set_);
+    std::swap(qpOptimalStatus_, other.qpOptimalStatus_);
+#if DEBUG
+#if COMPARE_QP_SOLVER
+    std::swap(qpOASESInterface_, other.qpOASESInterface_);
+    std::swap(QOREInterface_, other.QOREInterface_);
+    std::swap(W_c_qpOASES_, other.W_c_qpOASES_);
+    std::swap(W_b_qpOASES_, other.W_b_qpOASES_);
+    std::swap(W_c_qore_, other.W_c_qore_);
+    std::swap(W_b_qore_, other.W_b_qore_);
+#endif
+#endif
+}
+
+
 /**
  * Get the optimal solution from the QPhandler_interface
  *
@@ -126,6 +169,8 @@ QPhandler::~QPhandler() {
  *                  of the QP subproblem
  */
 double* QPhandler::get_optimal_solution() {
+    if (is_working_set_solution_)
+        return working_set_solver_->x();
     return solverInterface_->get_optimal_solution();
 }
 
@@ -139,11 +184,15 @@ double* QPhandler::get_optimal_solution() {
  * multipliers of the QP subproblem
  */
 double*  QPhandler::get_multipliers_bounds() {
+    if (is_working_set_solution_)
+        return working_set_solver_->y() + bound_multipliers_offset_;
     return solverInterface_->get_multipliers_bounds();
 }
 
 
 double* QPhandler::get_multipliers_constr() {
+    if (is_working_set_solution_)
+        return working_set_solver_->y() + nVar_QP_;
     return solverInterface_->get_multipliers_constr();
 }
 
@@ -176,87 +225,92 @@ void QPhandler::set_bounds(double delta, shared_ptr<const Vector> x_l,
 #endif
 #endif
 
+    if (formulation_ == ELASTIC_BOUNDS)
+        set_QP_bounds<ELASTIC_BOUNDS>(delta, x_l, x_u, x_k, c_l, c_u, c_k, false);
+    else
+        set_QP_bounds<BOX_BOUNDS>(delta, x_l, x_u, x_k, c_l, c_u, c_k, false);
+}
+
+
+template <Formulation F>
+void QPhandler::set_identity_blocks() {
+    int length = FormulationPolicy<F>::num_identity_blocks();
+    I_info_A_.irow = new int[length];
+    I_info_A_.jcol = new int[length];
+    I_info_A_.size = new int[length];
+    I_info_A_.value = new double[length];
+    FormulationPolicy<F>::identity_blocks(nlp_info_, I_info_A_);
+}
+
+
+template <Formulation F>
+void QPhandler::set_QP_bounds(double delta, shared_ptr<const Vector> x_l,
+                              shared_ptr<const Vector> x_u,
+                              shared_ptr<const Vector> x_k,
+                              shared_ptr<const Vector> c_l,
+                              shared_ptr<const Vector> c_u,
+                              shared_ptr<const Vector> c_k, bool is_update) {
+    typedef FormulationPolicy<F> Policy;
+    int nVar = nlp_info_.nVar;
+    int nCon = nlp_info_.nCon;
     /*-------------------------------------------------------------*/
     /* Set lbA, ubA as well as lb and ub as qpOASES differentiates */
     /*the bound constraints from the linear constraints            */
     /*-------------------------------------------------------------*/
-    if(QPsolverChoice_!=QORE) {
-#if not NEW_FORMULATION
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lbA(i, c_l->values(i) - c_k->values(i));//must
-            // place before set_ubA
-            solverInterface_->set_ubA(i, c_u->values(i) - c_k->values(i));
-        }
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i, std::max(
-                                         x_l->values(i) - x_k->values(i), -delta));
-            solverInterface_->set_ub(i, std::min(
-                                         x_u->values(i) - x_k->values(i), delta));
-        }
-        /**
-         * only set the upper bound for the last half to be infinity(those are slack variables).
-         * The lower bounds are initialized as 0
-         */
-        for (int i = 0; i < nlp_info_.nCon * 2; i++)
-            solverInterface_->set_ub(nlp_info_.nVar + i, INF);
-#else
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lbA(i, c_l->values(i) - c_k->values(i));//must
-            // place before set_ubA
-            solverInterface_->set_ubA(i, c_u->values(i) - c_k->values(i));
-        }
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lbA(nlp_info_.nCon+i, x_l->values(i) - x_k->values(i));//must
-            // place before set_ubA
-            solverInterface_->set_ubA(nlp_info_.nCon+i, x_u->values(i) - x_k->values(i));
-        }
-
-        for(int i = 0; i< nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i,-delta);
-            solverInterface_->set_ub(i,delta);
+    if (QPsolverChoice_ != QORE) {
+        if (is_update && (QPsolverChoice_ == GUROBI || QPsolverChoice_ == CPLEX))
+            solverInterface_->reset_constraints();
+        shift_bounds(c_l->values(), c_u->values(), c_k->values(), nCon);
+        solverInterface_->set_lbA(0, nCon, lb_work_);
+        solverInterface_->set_ubA(0, nCon, ub_work_);
+        if (Policy::penalizes_bounds) {
+            shift_bounds(x_l->values(), x_u->values(), x_k->values(), nVar);
+            solverInterface_->set_lbA(nCon, nVar, lb_work_);
+            solverInterface_->set_ubA(nCon, nVar, ub_work_);
         }
-        for (int i = nlp_info_.nVar; i < nVar_QP_; i++)
-            solverInterface_->set_ub(i, INF);
-#endif
     }
     /*-------------------------------------------------------------*/
     /* Only set lb and ub, where lb = [lbx;lbA]; and ub=[ubx; ubA] */
     /*-------------------------------------------------------------*/
     else {
-#if not NEW_FORMULATION
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i, std::max(
-                                         x_l->values(i) - x_k->values(i), -delta));
-            solverInterface_->set_ub(i, std::min(
-                                         x_u->values(i) - x_k->values(i), delta));
-
+        shift_bounds(c_l->values(), c_u->values(), c_k->values(), nCon);
+        solverInterface_->set_lb(nVar_QP_, nCon, lb_work_);
+        solverInterface_->set_ub(nVar_QP_, nCon, ub_work_);
+        if (Policy::penalizes_bounds) {
+            shift_bounds(x_l->values(), x_u->values(), x_k->values(), nVar);
+            solverInterface_->set_lb(nVar_QP_ + nCon, nVar, lb_work_);
+            solverInterface_->set_ub(nVar_QP_ + nCon, nVar, ub_work_);
         }
+    }
 
-        for (int i = 0; i < nlp_info_.nCon * 2; i++)
-            solverInterface_->set_ub(nlp_info_.nVar + i, INF);
-#endif
-
+    Policy::step_bounds(nVar, delta, x_l->values(), x_u->values(), x_k->values(),
+                        lb_work_, ub_work_);
+    /**
+     * only set the upper bound for the last half to be infinity(those are slack variables).
+     * The lower bounds are initialized as 0
+     */
+    int length = nVar;
+    if (!is_update) {
+        for (int i = nVar; i < nVar_QP_; i++)
+            ub_work_[i] = INF;
+        length = nVar_QP_;
+    }
+    solverInterface_->set_lb(0, nVar, lb_work_);
+    solverInterface_->set_ub(0, length, ub_work_);
+}
 
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lb(nVar_QP_+i, c_l->values(i)- c_k->values(i));
-            solverInterface_->set_ub(nVar_QP_+i, c_u->values(i)- c_k->values(i));
-        }
 
-#if NEW_FORMULATION
-        for(int i = 0; i< nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i,-delta);
-            solverInterface_->set_ub(i,delta);
-            solverInterface_->set_lb(nVar_QP_+nlp_info_.nCon+i, x_l->values(i)
-                                     - x_k->values(i));
-            solverInterface_->set_ub(nVar_QP_+nlp_info_.nCon+i, x_u->values(i)
-                                     - x_k->values(i));
-        }
-        for (int i = nlp_info_.nVar; i < nVar_QP_; i++)
-            solverInterface_->set_ub(i, INF);
-        //DEBUG
-//        solverInterface_->getLb()->print("lb");
-//        solverInterface_->getUb()->print("ub");
-#endif
+/**
+ * @brief Compute the shifted bounds lb_work_ = l-k, ub_work_ = u-k in a single
+ * pass over the first length entries of the workspace.
+ */
+void QPhandler::shift_bounds(const double* l, const double* u, const double* k,
+                             int length) {
+    double* lb = lb_work_;
+    double* ub = ub_work_;
+    for (int i = 0; i < length; i++) {
+        lb[i] = l[i] - k[i];
+        ub[i] = u[i] - k[i];
     }
 }
 
@@ -308,6 +362,10 @@ void QPhandler::set_g(shared_ptr<const Vector> grad, double rho) {
  * readers.
  */
 void QPhandler::set_H(shared_ptr<const SpTripletMat> hessian) {
+    hessian_ = hessian;
+    if (is_constant_H_set_)
+        return;
+    is_constant_H_set_ = is_H_constant_;
 #if DEBUG
 #if COMPARE_QP_SOLVER
     qpOASESInterface_->set_H_values(hessian);
@@ -324,13 +382,19 @@ void QPhandler::set_H(shared_ptr<const SpTripletMat> hessian) {
  * @param jacobian  the Matrix object for Jacobian from c(x)
  */
 void QPhandler::set_A(shared_ptr<const SpTripletMat> jacobian) {
+    jacobian_ = jacobian;
 #if DEBUG
 #if COMPARE_QP_SOLVER
     qpOASESInterface_->set_A_values(jacobian, I_info_A_);
     QOREInterface_->set_A_values(jacobian, I_info_A_);
 #endif
 #endif
-    solverInterface_->set_A(jacobian, I_info_A_);
+    if (is_linear_A_set_)
+        solverInterface_->set_A(jacobian, I_info_A_, A_nonlinear_entries_);
+    else {
+        solverInterface_->set_A(jacobian, I_info_A_);
+        is_linear_A_set_ = has_linear_A_entries_;
+    }
 }
 
 
@@ -350,72 +414,10 @@ void QPhandler::update_bounds(double delta, shared_ptr<const Vector> x_l,
     set_bounds_debug(delta, x_l, x_u, x_k, c_l, c_u, c_k);
 #endif
 #endif
-#if not NEW_FORMULATION
-    if(QPsolverChoice_!=QORE) {
-        if(QPsolverChoice_==GUROBI||QPsolverChoice_==CPLEX)
-            solverInterface_->reset_constraints();
-
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lbA(i, c_l->values(i) - c_k->values(i));
-        }
-
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i, std::max(
-                                         x_l->values(i) - x_k->values(i), -delta));
-            solverInterface_->set_ub(i, std::min(
-                                         x_u->values(i) - x_k->values(i), delta));
-        }
-    }
-    else {
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i, std::max(
-                                         x_l->values(i) - x_k->values(i), -delta));
-            solverInterface_->set_ub(i, std::min(
-                                         x_u->values(i) - x_k->values(i), delta));
-
-        }
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lb(nlp_info_.nVar +2*nlp_info_.nCon+i, c_l->values(i)
-                                     - c_k->values(i));
-            solverInterface_->set_ub(nlp_info_.nVar +2*nlp_info_.nCon+i, c_u->values(i)
-                                     - c_k->values(i));
-        }
-    }
-#else
-    if(QPsolverChoice_==QORE) {
-        for(int i = 0; i< nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i,-delta);
-            solverInterface_->set_ub(i,delta);
-        }
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lb(nVar_QP_+i, c_l->values(i)- c_k->values(i));
-            solverInterface_->set_ub(nVar_QP_+i, c_u->values(i)- c_k->values(i));
-        }
-
-        for(int i = 0; i< nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(nVar_QP_+nlp_info_.nCon+i, x_l->values(i)
-                                     - x_k->values(i));
-            solverInterface_->set_ub(nVar_QP_+nlp_info_.nCon+i, x_u->values(i)
-                                     - x_k->values(i));
-        }
-    }
-    else {
-        for(int i = 0; i< nlp_info_.nVar; i++) {
-            solverInterface_->set_lb(i,-delta);
-            solverInterface_->set_ub(i,delta);
-        }
-
-        for (int i = 0; i < nlp_info_.nCon; i++) {
-            solverInterface_->set_lbA(i, c_l->values(i) - c_k->values(i));
-            solverInterface_->set_ubA(i, c_u->values(i) - c_k->values(i));
-        }
-        for (int i = 0; i < nlp_info_.nVar; i++) {
-            solverInterface_->set_lbA(nlp_info_.nCon+i, x_l->values(i) - x_k->values(i));
-            solverInterface_->set_ubA(nlp_info_.nCon+i, x_u->values(i) - x_k->values(i));
-        }
-
-    }
-#endif
+    if (formulation_ == ELASTIC_BOUNDS)
+        set_QP_bounds<ELASTIC_BOUNDS>(delta, x_l, x_u, x_k, c_l, c_u, c_k, true);
+    else
+        set_QP_bounds<BOX_BOUNDS>(delta, x_l, x_u, x_k, c_l, c_u, c_k, true);
 }
 
 
@@ -469,6 +471,19 @@ void QPhandler::update_grad(shared_ptr<const Vector> grad) {
  */
 void QPhandler::solveQP(shared_ptr<SQPhotstart::Stats> stats,
                         shared_ptr<Options> options) {
+    PhaseTimer timer(stats.get(), PHASE_QP_SOLVE);
+    is_working_set_solution_ = false;
+    if (working_set_solver_ != nullptr &&
+            same_working_set_count_ >= working_set_stable_) {
+        if (solve_on_working_set()) {
+            if (stats != nullptr)
+                stats->qp_working_set_addone();
+            same_working_set_count_++;
+            return;
+        }
+        //wait for the working set to settle again before the next try
+        same_working_set_count_ = 0;
+    }
 //   solverInterface_->getA()->print_full("A");
 //   solverInterface_->getH()->print_full("H");
 //   solverInterface_->getLb()->print("Lb");
@@ -491,22 +506,104 @@ void QPhandler::solveQP(shared_ptr<SQPhotstart::Stats> stats,
     solverInterface_->optimizeQP(stats);
 
 
-    //manually check if the optimality condition is satisfied
+    //manually check if the optimality condition is satisfied, which a QP stopped
+    //at its objective target is not expected to be
     bool isOptimal= test_optimality(solverInterface_, QPsolverChoice_, W_b_, W_c_);
-    if(!isOptimal) {
+    if(!isOptimal && !is_inexact()) {
         THROW_EXCEPTION(QP_NOT_OPTIMAL,QP_NOT_OPTIMAL_MSG);
     }
+    if (working_set_solver_ != nullptr)
+        count_working_set();
 }
 
 
-double QPhandler::get_objective() {
+bool QPhandler::solve_on_working_set() {
+    if (hessian_ == nullptr || jacobian_ == nullptr)
+        return false;
+    const double* lb = solverInterface_->getLb()->values();
+    const double* ub = solverInterface_->getUb()->values();
+    //QORE has the bounds on Ax after those on x
+    const double* lbA = QPsolverChoice_ == QORE ? lb + nVar_QP_ :
+                        solverInterface_->getLbA()->values();
+    const double* ubA = QPsolverChoice_ == QORE ? ub + nVar_QP_ :
+                        solverInterface_->getUbA()->values();
+    if (!working_set_solver_->solve(hessian_, jacobian_, I_info_A_,
+                                    solverInterface_->getG()->values(), lb, ub, lbA,
+                                    ubA, W_c_, W_b_))
+        return false;
+    is_working_set_solution_ = true;
+    qpOptimalStatus_ = working_set_solver_->optimality_status();
+    //the objective target was meant for this QP only
+    solverInterface_->set_objective_target(-INF);
+    return true;
+}
+
+
+void QPhandler::count_working_set() {
+    //a QP stopped early does not have the working set of its solution
+    if (is_inexact()) {
+        same_working_set_count_ = 0;
+        return;
+    }
+    if (same_working_set_count_ > 0 &&
+            std::equal(W_b_, W_b_ + nVar_QP_, W_b_last_.begin()) &&
+            std::equal(W_c_, W_c_ + nConstr_QP_, W_c_last_.begin()))
+        same_working_set_count_++;
+    else {
+        same_working_set_count_ = 1;
+        std::copy(W_b_, W_b_ + nVar_QP_, W_b_last_.begin());
+        std::copy(W_c_, W_c_ + nConstr_QP_, W_c_last_.begin());
+    }
+}
 
+
+void QPhandler::set_objective_target(double target) {
+    solverInterface_->set_objective_target(target);
+}
+
+
+bool QPhandler::is_inexact() {
+    if (is_working_set_solution_)
+        return false;
+    return solverInterface_->get_status() == QP_SUFFICIENT_DECREASE;
+}
+
+
+void QPhandler::set_A_nonlinear_entries(const std::vector<int>& entries) {
+    A_nonlinear_entries_ = entries;
+    has_linear_A_entries_ = (int) entries.size() < nlp_info_.nnz_jac_g;
+    //the values of the linear entries may differ from those the solver has, if
+    //the NLP was reset
+    is_linear_A_set_ = false;
+}
+
+
+void QPhandler::set_H_constant(bool is_constant) {
+    is_H_constant_ = is_constant;
+    is_constant_H_set_ = false;
+}
+
+
+void QPhandler::warm_start_next_QP() {
+    //W_b_ and W_c_ hold the working set of the last QP, from test_optimality
+    solverInterface_->set_warm_start(W_c_, W_b_, get_optimal_solution(),
+                                     get_multipliers_bounds(),
+                                     get_multipliers_constr());
+}
+
+
+double QPhandler::get_objective() {
+    if (is_working_set_solution_)
+        return working_set_solver_->objective();
     return solverInterface_->get_obj_value();
 }
 
 
 void QPhandler::update_H(shared_ptr<const SpTripletMat> Hessian) {
-
+    hessian_ = Hessian;
+    if (is_constant_H_set_)
+        return;
+    is_constant_H_set_ = is_H_constant_;
 #if DEBUG
 #if COMPARE_QP_SOLVER
     QOREInterface_->set_H_values(Hessian);
@@ -518,6 +615,7 @@ void QPhandler::update_H(shared_ptr<const SpTripletMat> Hessian) {
 
 
 void QPhandler::update_A(shared_ptr<const SpTripletMat> Jacobian) {
+    jacobian_ = Jacobian;
 
 #if DEBUG
 #if COMPARE_QP_SOLVER
@@ -525,8 +623,12 @@ void QPhandler::update_A(shared_ptr<const SpTripletMat> Jacobian) {
     qpOASESInterface_->set_A_values(Jacobian, I_info_A_);
 #endif
 #endif
-    solverInterface_->set_A(Jacobian, I_info_A_);
-
+    if (is_linear_A_set_)
+        solverInterface_->set_A(Jacobian, I_info_A_, A_nonlinear_entries_);
+    else {
+        solverInterface_->set_A(Jacobian, I_info_A_);
+        is_linear_A_set_ = has_linear_A_entries_;
+    }
 }
 
 
@@ -549,30 +651,27 @@ void QPhandler::update_delta(double delta, shared_ptr<const Vector> x_l,
 #endif
 #endif
 
-#if NEW_FORMULATION
-    for(int i = 0; i< nlp_info_.nVar; i++) {
-        solverInterface_->set_lb(i,-delta);
-        solverInterface_->set_ub(i,delta);
-    }
-#else
-
-    for (int i = 0; i < nlp_info_.nVar; i++) {
-        solverInterface_->set_lb(i, std::max(
-                                     x_l->values(i) - x_k->values(i), -delta));
-        solverInterface_->set_ub(i, std::min(
-                                     x_u->values(i) - x_k->values(i), delta));
-    }
-
-#endif
+    if (formulation_ == ELASTIC_BOUNDS)
+        FormulationPolicy<ELASTIC_BOUNDS>::step_bounds(nlp_info_.nVar, delta,
+                x_l->values(), x_u->values(), x_k->values(), lb_work_, ub_work_);
+    else
+        FormulationPolicy<BOX_BOUNDS>::step_bounds(nlp_info_.nVar, delta,
+                x_l->values(), x_u->values(), x_k->values(), lb_work_, ub_work_);
+    solverInterface_->set_lb(0, nlp_info_.nVar, lb_work_);
+    solverInterface_->set_ub(0, nlp_info_.nVar, ub_work_);
 }
 
 void QPhandler::WriteQPData(const string filename ) {
-
-    solverInterface_->WriteQPDataToFile(Ipopt::J_LAST_LEVEL, Ipopt::J_USER1,filename);
-
+#if DEBUG
+#if PRINT_OUT_QP_WITH_ERROR
+    solverInterface_->WriteQPSnapshot(filename);
+#endif
+#endif
 }
 
 Exitflag QPhandler::get_status() {
+    if (is_working_set_solution_)
+        return QP_OPTIMAL;
     return (solverInterface_->get_status());
 }
 
@@ -590,7 +689,7 @@ bool QPhandler::test_optimality(
 
 
 double QPhandler::get_infea_measure_model() {
-    return oneNorm(solverInterface_->get_optimal_solution()+nlp_info_.nVar,nVar_QP_-nlp_info_.nVar);
+    return oneNorm(get_optimal_solution()+nlp_info_.nVar,nVar_QP_-nlp_info_.nVar);
 }
 
 const OptimalityStatus &QPhandler::get_QpOptimalStatus() const {
@@ -725,7 +824,7 @@ bool QPhandler::testQPsolverDifference() {
         printf("difference is %10e\n",diff_norm);
         qpOASESsol->print("qpOASESsol");
         QOREsol->print("QOREsol");
-        QOREInterface_->WriteQPDataToFile(jnlst_,J_ALL,J_DBG);
+        QOREInterface_->WriteQPSnapshot("QORE_compare.qpsnap");
     }
     assert(diff_norm<1.0e-8);
     return true;
@@ -10,12 +10,22 @@
 namespace SQPhotstart {
 
 /** Default constructor*/
-SQPTNLP::SQPTNLP(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
+SQPTNLP::SQPTNLP(Ipopt::SmartPtr<Ipopt::TNLP> nlp, shared_ptr<Stats> stats) :
+    stats_(stats),
+    f_cached_(0.0),
+    has_x_last_(false),
+    is_f_cached_(false),
+    is_c_cached_(false),
+    are_constraints_linear_(false),
+    is_linear_program_(false) {
     nlp_ = nlp;
     Ipopt::TNLP::IndexStyleEnum index_style;
     nlp_->get_nlp_info(nlp_info_.nVar, nlp_info_.nCon, nlp_info_.nnz_jac_g,
                        nlp_info_.nnz_h_lag, index_style);
     assert(index_style == Ipopt::TNLP::FORTRAN_STYLE);
+    x_last_ = make_shared<Vector>(nlp_info_.nVar);
+    c_cached_ = make_shared<Vector>(nlp_info_.nCon);
+    classify_linearity();
 }
 
 
@@ -50,7 +60,17 @@ SQPTNLP::Get_starting_point(shared_ptr<Vector> x_0, shared_ptr<Vector> lambda_0)
  *@brief Evaluate the objective value
  */
 bool SQPTNLP::Eval_f(shared_ptr<const Vector> x, double& obj_value) {
-    nlp_->eval_f(nlp_info_.nVar, x->values(), true, obj_value);
+    PhaseTimer timer(stats_.get(), PHASE_NLP_EVAL);
+    bool new_x = update_x(x);
+    if (stats_ != nullptr)
+        stats_->f_eval_addone(is_f_cached_);
+    if (!is_f_cached_) {
+        if (!new_x && stats_ != nullptr)
+            stats_->new_x_reused_addone();
+        nlp_->eval_f(nlp_info_.nVar, x->values(), new_x, f_cached_);
+        is_f_cached_ = true;
+    }
+    obj_value = f_cached_;
     return true;
 }
 
@@ -60,8 +80,18 @@ bool SQPTNLP::Eval_f(shared_ptr<const Vector> x, double& obj_value) {
  */
 bool SQPTNLP::Eval_constraints(shared_ptr<const Vector> x,
                                shared_ptr<Vector> constraints) {
-    nlp_->eval_g(nlp_info_.nVar, x->values(), true, nlp_info_.nCon,
-                 constraints->values());
+    PhaseTimer timer(stats_.get(), PHASE_NLP_EVAL);
+    bool new_x = update_x(x);
+    if (stats_ != nullptr)
+        stats_->c_eval_addone(is_c_cached_);
+    if (!is_c_cached_) {
+        if (!new_x && stats_ != nullptr)
+            stats_->new_x_reused_addone();
+        nlp_->eval_g(nlp_info_.nVar, x->values(), new_x, nlp_info_.nCon,
+                     c_cached_->values());
+        is_c_cached_ = true;
+    }
+    constraints->copy_vector(c_cached_->values());
     return true;
 }
 
@@ -69,7 +99,14 @@ bool SQPTNLP::Eval_constraints(shared_ptr<const Vector> x,
  *@brief Evaluate gradient at point x
  */
 bool SQPTNLP::Eval_gradient(shared_ptr<const Vector> x, shared_ptr<Vector> gradient) {
-    nlp_->eval_grad_f(nlp_info_.nVar, x->values(), true, gradient->values());
+    PhaseTimer timer(stats_.get(), PHASE_NLP_EVAL);
+    bool new_x = update_x(x);
+    if (stats_ != nullptr) {
+        stats_->grad_eval_addone();
+        if (!new_x)
+            stats_->new_x_reused_addone();
+    }
+    nlp_->eval_grad_f(nlp_info_.nVar, x->values(), new_x, gradient->values());
     return true;
 }
 
@@ -83,16 +120,45 @@ bool SQPTNLP::Get_Strucutre_Jacobian(shared_ptr<const Vector> x,
     nlp_->eval_jac_g(nlp_info_.nVar, x->values(), true, nlp_info_.nCon,
                      nlp_info_.nnz_jac_g,
                      Jacobian->RowIndex(), Jacobian->ColIndex(), NULL);
+    jac_rows_.assign(Jacobian->RowIndex(), Jacobian->RowIndex() + nlp_info_.nnz_jac_g);
+    classify_linearity();
     return true;
 }
 
+
+void SQPTNLP::classify_linearity() {
+    std::vector<Ipopt::TNLP::LinearityType> types(nlp_info_.nCon);
+    bool has_linearity = nlp_info_.nCon > 0 &&
+                         nlp_->get_constraints_linearity(nlp_info_.nCon, types.data());
+    nonlinear_jac_entries_.clear();
+    for (int i = 0; i < (int) jac_rows_.size(); i++)
+        if (!has_linearity || types[jac_rows_[i] - 1] != Ipopt::TNLP::LINEAR)
+            nonlinear_jac_entries_.push_back(i);
+
+    are_constraints_linear_ = nlp_info_.nCon == 0 || has_linearity;
+    for (int i = 0; i < nlp_info_.nCon && are_constraints_linear_; i++)
+        are_constraints_linear_ = types[i] == Ipopt::TNLP::LINEAR;
+    types.resize(nlp_info_.nVar);
+    is_linear_program_ = are_constraints_linear_ && nlp_info_.nVar > 0 &&
+                         nlp_->get_variables_linearity(nlp_info_.nVar, types.data());
+    for (int i = 0; i < nlp_info_.nVar && is_linear_program_; i++)
+        is_linear_program_ = types[i] == Ipopt::TNLP::LINEAR;
+}
+
 /**
  *@brief Evaluate Jacobian at point x
  */
 
 bool SQPTNLP::Eval_Jacobian(shared_ptr<const Vector> x,
                             shared_ptr<SpTripletMat> Jacobian) {
-    nlp_->eval_jac_g(nlp_info_.nVar, x->values(), true, nlp_info_.nCon,
+    PhaseTimer timer(stats_.get(), PHASE_NLP_EVAL);
+    bool new_x = update_x(x);
+    if (stats_ != nullptr) {
+        stats_->jac_eval_addone();
+        if (!new_x)
+            stats_->new_x_reused_addone();
+    }
+    nlp_->eval_jac_g(nlp_info_.nVar, x->values(), new_x, nlp_info_.nCon,
                      nlp_info_.nnz_jac_g,
                      NULL, NULL, Jacobian->MatVal());
     return true;
@@ -121,16 +187,114 @@ bool SQPTNLP::Get_Structure_Hessian(shared_ptr<const Vector> x,
 bool
 SQPTNLP::Eval_Hessian(shared_ptr<const Vector> x, shared_ptr<const Vector> lambda,
                       shared_ptr<SpTripletMat> Hessian) {
+    PhaseTimer timer(stats_.get(), PHASE_NLP_EVAL);
+    bool new_x = update_x(x);
+    if (stats_ != nullptr) {
+        stats_->hess_eval_addone();
+        if (!new_x)
+            stats_->new_x_reused_addone();
+    }
     auto lambda_tmp = make_shared<Vector>(lambda->Dim());
     lambda_tmp->copy_vector(lambda->values());
     lambda_tmp->scale(-1.0);
-    nlp_->eval_h(nlp_info_.nVar, x->values(), true, 1, nlp_info_.nCon,
+    nlp_->eval_h(nlp_info_.nVar, x->values(), new_x, 1, nlp_info_.nCon,
                  lambda_tmp->values(), true,
                  nlp_info_.nnz_h_lag, NULL, NULL, Hessian->MatVal());
 
     return true;
 }
 
+/**
+ * @brief forget the last evaluated point, so that the next evaluation will be
+ * passed to the NLP with new_x = true
+ */
+void SQPTNLP::reset_cache() {
+    has_x_last_ = false;
+    is_f_cached_ = false;
+    is_c_cached_ = false;
+}
+
+
+/**
+ * @brief replace the NLP to be read by another one with the same dimensions
+ * and the same sparsity structure of the Jacobian and the Hessian.
+ * @return false if nlp does not use FORTRAN_STYLE indices, or if its dimensions
+ * or its sparsity structure do not match the current ones
+ */
+bool SQPTNLP::reset_nlp(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
+    NLPInfo nlp_info;
+    Ipopt::TNLP::IndexStyleEnum index_style;
+    nlp->get_nlp_info(nlp_info.nVar, nlp_info.nCon, nlp_info.nnz_jac_g,
+                      nlp_info.nnz_h_lag, index_style);
+    if (index_style != Ipopt::TNLP::FORTRAN_STYLE)
+        return false;
+    if (nlp_info.nVar != nlp_info_.nVar || nlp_info.nCon != nlp_info_.nCon ||
+            nlp_info.nnz_jac_g != nlp_info_.nnz_jac_g ||
+            nlp_info.nnz_h_lag != nlp_info_.nnz_h_lag)
+        return false;
+    if (!has_same_structure(nlp))
+        return false;
+
+    nlp_ = nlp;
+    reset_cache();
+    //the structure is the same, but the new NLP may declare other constraints
+    //linear
+    classify_linearity();
+    return true;
+}
+
+
+/**
+ * @brief compare the index arrays of the Jacobian and the Hessian of nlp with
+ * those of the current NLP, entry by entry, since the QP matrices are built on
+ * the latter. Both NLPs have the same dimensions.
+ */
+bool SQPTNLP::has_same_structure(Ipopt::SmartPtr<Ipopt::TNLP> nlp) {
+    int nnz = std::max(nlp_info_.nnz_jac_g, nlp_info_.nnz_h_lag);
+    std::vector<int> irow(nnz), jcol(nnz), irow_new(nnz), jcol_new(nnz);
+
+    if (!nlp_->eval_jac_g(nlp_info_.nVar, NULL, false, nlp_info_.nCon,
+                          nlp_info_.nnz_jac_g, irow.data(), jcol.data(), NULL) ||
+            !nlp->eval_jac_g(nlp_info_.nVar, NULL, false, nlp_info_.nCon,
+                             nlp_info_.nnz_jac_g, irow_new.data(), jcol_new.data(),
+                             NULL))
+        return false;
+    if (!std::equal(irow.begin(), irow.begin() + nlp_info_.nnz_jac_g,
+                    irow_new.begin()) ||
+            !std::equal(jcol.begin(), jcol.begin() + nlp_info_.nnz_jac_g,
+                        jcol_new.begin()))
+        return false;
+
+    if (!nlp_->eval_h(nlp_info_.nVar, NULL, false, 1.0, nlp_info_.nCon, NULL,
+                      false, nlp_info_.nnz_h_lag, irow.data(), jcol.data(), NULL) ||
+            !nlp->eval_h(nlp_info_.nVar, NULL, false, 1.0, nlp_info_.nCon, NULL,
+                         false, nlp_info_.nnz_h_lag, irow_new.data(),
+                         jcol_new.data(), NULL))
+        return false;
+    return std::equal(irow.begin(), irow.begin() + nlp_info_.nnz_h_lag,
+                      irow_new.begin()) &&
+           std::equal(jcol.begin(), jcol.begin() + nlp_info_.nnz_h_lag,
+                      jcol_new.begin());
+}
+
+
+/**
+ * @brief check if x differs from the last point passed to the NLP. If so, the
+ * point is recorded and the cached values are invalidated.
+ * @return the new_x flag to be passed to the NLP
+ */
+bool SQPTNLP::update_x(shared_ptr<const Vector> x) {
+    if (has_x_last_ && std::equal(x->values(), x->values() + nlp_info_.nVar,
+                                  x_last_->values()))
+        return false;
+
+    x_last_->copy_vector(x->values());
+    has_x_last_ = true;
+    is_f_cached_ = false;
+    is_c_cached_ = false;
+    return true;
+}
+
 /**
  * @brief This function shifts the initial starting point to be feasible to the bound constraints
  * @param x initial starting point
@@ -15,7 +15,8 @@ SpHbMat::SpHbMat(int RowNum, int ColNum, bool isCompressedRow) :
     isInitialised_(false),
     RowNum_(RowNum),
     ColNum_(ColNum),
-    isCompressedRow_(isCompressedRow) {
+    isCompressedRow_(isCompressedRow),
+    expanded_is_current_(false) {
     if(isCompressedRow_) {
         RowIndex_ = new int[RowNum + 1]();
     } else
@@ -40,7 +41,8 @@ SpHbMat::SpHbMat(int nnz, int RowNum, int ColNum, bool isCompressedRow) :
     RowNum_(RowNum),
     ColNum_(ColNum),
     isInitialised_(false),
-    isCompressedRow_(isCompressedRow) {
+    isCompressedRow_(isCompressedRow),
+    expanded_is_current_(false) {
 
     if(isCompressedRow) {
         ColIndex_ = new int[nnz]();
@@ -65,7 +67,8 @@ SpHbMat::SpHbMat(const double* data, int RowNum, int ColNum, bool row_oriented,
     EntryNum_(0),
     RowNum_(RowNum),
     ColNum_(ColNum),
-    isCompressedRow_(isCompressedRow)
+    isCompressedRow_(isCompressedRow),
+    expanded_is_current_(false)
 {
 
     int* RowIndex_tmp = NULL;
@@ -201,70 +204,30 @@ void SpHbMat::setStructure(
     assert(isInitialised_ == false);
 
     int counter = 0; // the counter for recording the index location
-    std::vector<std::tuple<int, int, double, int>> sorted_index_info;
+    std::vector<int> row(EntryNum_);
+    std::vector<int> col(EntryNum_);
+    std::vector<double> val(EntryNum_);
     for (int i = 0; i < rhs->EntryNum(); i++) {
-        sorted_index_info.push_back(std::make_tuple(
-                                        rhs->RowIndex(i),
-                                        rhs->ColIndex(i),
-                                        rhs->MatVal(i),
-                                        counter));
+        row[counter] = rhs->RowIndex(i) - 1;
+        col[counter] = rhs->ColIndex(i) - 1;
+        val[counter] = rhs->MatVal(i);
         counter++;
     }
 
-    // adding identity matrices info to the tuple array.
+    // adding identity matrices info to the entry arrays.
     for(int i = 0; i<I_info.length; i++) {
         for (int j = 0; j < I_info.size[i]; j++) {
-            sorted_index_info.push_back(std::make_tuple(
-                                            I_info.irow[i] + j,
-                                            I_info.jcol[i] + j,
-                                            I_info.value[i],
-                                            counter));
+            row[counter] = I_info.irow[i] + j - 1;
+            col[counter] = I_info.jcol[i] + j - 1;
+            val[counter] = I_info.value[i];
             counter++;
         }
-
     }
 
     assert(counter==EntryNum_);
 
-    //  for(int i = 0; i <sorted_index_info.size(); i++) {
-    //      printf("%i ", std::get<0>(sorted_index_info[i]));
-    //      printf("%i ", std::get<1>(sorted_index_info[i]));
-    //      printf("%5.2e ", std::get<2>(sorted_index_info[i]));
-    //      printf("%i \n", std::get<3>(sorted_index_info[i]));
-
-    //  }
-
-
-    if(isCompressedRow_) {
-        std::sort(sorted_index_info.begin(), sorted_index_info.end(),
-                  tuple_sort_rule_compressed_row);
-        for (int i = 0; i < EntryNum_; i++) {
-            ColIndex_[i] = std::get<1>(sorted_index_info[i]) - 1;
-            MatVal_[i] = std::get<2>(sorted_index_info[i]);
-            order_[std::get<3>(sorted_index_info[i])]= i;
-
-            for (int j = std::get<0>(sorted_index_info[i]); j < RowNum_; j++) {
-                RowIndex_[j]++;
-            }
-        }
-        RowIndex_[RowNum_] = EntryNum_;
-
-    } else {
-        std::sort(sorted_index_info.begin(), sorted_index_info.end(),
-                  tuple_sort_rule_compressed_column);
-        for (int i = 0; i < EntryNum_; i++) {
-            MatVal_[i] = std::get<2>(sorted_index_info[i]);
-            RowIndex_[i] = std::get<0>(sorted_index_info[i]) - 1;
-            order_[std::get<3>(sorted_index_info[i])] =i;
-
-            for (int j = std::get<1>(sorted_index_info[i]); j < ColNum_; j++) {
-                ColIndex_[j]++;
-            }
-        }
-        ColIndex_[ColNum_] = EntryNum_;
-    }
+    build_compressed_structure(row.data(), col.data(), val.data());
     isInitialised_ = true;
-    sorted_index_info.clear();
 }
 
 
@@ -287,30 +250,19 @@ void SpHbMat::setStructure(std::shared_ptr<const SpTripletMat> rhs) {
     isSymmetric_ = rhs->isSymmetric();
 
     assert(isInitialised_ == false);
-    std::vector<std::tuple<int, int, double, int>> sorted_index_info;
 
-    //if it is symmetric, it will calculate the
-    // number of entry and allocate_memory the memory
-    // of RowIndex and MatVal by going through
-    // all of its entries one by one
-    for (int i = 0; i < rhs->EntryNum(); i++) {
-        sorted_index_info.emplace_back(rhs->RowIndex(i),
-                                       rhs->ColIndex(i),
-                                       rhs->MatVal(i),
-                                       sorted_index_info.size());
-
-        if (isSymmetric_&& rhs->RowIndex(i) != rhs->ColIndex(i)) {
-            sorted_index_info.emplace_back(
-                rhs->ColIndex(i),
-                rhs->RowIndex(i),
-                rhs->MatVal(i),
-                sorted_index_info.size());
+    //if it is symmetric, the off-diagonal entries are stored twice, so count the
+    //number of entries first before allocating the memory
+    int nnz = rhs->EntryNum();
+    if (isSymmetric_) {
+        for (int i = 0; i < rhs->EntryNum(); i++) {
+            if (rhs->RowIndex(i) != rhs->ColIndex(i))
+                nnz++;
         }
     }
 
-
     if(EntryNum_ <0) {//no memory allocated so far
-        EntryNum_ = sorted_index_info.size();
+        EntryNum_ = nnz;
         MatVal_ = new double[EntryNum_]();
         order_ = new int[EntryNum_]();
 
@@ -320,43 +272,179 @@ void SpHbMat::setStructure(std::shared_ptr<const SpTripletMat> rhs) {
             RowIndex_ = new int[EntryNum_]();
         }
     }
+    assert(nnz == EntryNum_);
 
-    if (isCompressedRow_) {
-        std::sort(sorted_index_info.begin(), sorted_index_info.end(),
-                  tuple_sort_rule_compressed_row);
-        //copy the order information back
-        for (int i = 0; i < EntryNum_; i++) {
-            ColIndex_[i] = std::get<1>(sorted_index_info[i]) - 1;
-            MatVal_[i] = std::get<2>(sorted_index_info[i]);
-            order_[std::get<3>(sorted_index_info[i])]= i;
-            for (int j = std::get<0>(sorted_index_info[i]); j < RowNum_; j++) {
-                RowIndex_[j]++;
-            }
-        }
-        RowIndex_[RowNum_] = EntryNum_;
-    } else {
-        std::sort(sorted_index_info.begin(), sorted_index_info.end(),
-                  tuple_sort_rule_compressed_column);
-        //copy the order information back
-
-        for (int i = 0; i < EntryNum_; i++) {
-            RowIndex_[i] = std::get<0>(sorted_index_info[i]) - 1;
-            MatVal_[i] = std::get<2>(sorted_index_info[i]);
-            order_[std::get<3>(sorted_index_info[i])] = i;
+    std::vector<int> row(EntryNum_);
+    std::vector<int> col(EntryNum_);
+    std::vector<double> val(EntryNum_);
+    int counter = 0;
+    for (int i = 0; i < rhs->EntryNum(); i++) {
+        row[counter] = rhs->RowIndex(i) - 1;
+        col[counter] = rhs->ColIndex(i) - 1;
+        val[counter] = rhs->MatVal(i);
+        counter++;
 
-            for (int j = std::get<1>(sorted_index_info[i]); j < ColNum_; j++) {
-                ColIndex_[j]++;
-            }
+        if (isSymmetric_&& rhs->RowIndex(i) != rhs->ColIndex(i)) {
+            row[counter] = rhs->ColIndex(i) - 1;
+            col[counter] = rhs->RowIndex(i) - 1;
+            val[counter] = rhs->MatVal(i);
+            counter++;
         }
-        ColIndex_[ColNum_] = EntryNum_;
     }
+
+    build_compressed_structure(row.data(), col.data(), val.data());
     isInitialised_ = true;
-    sorted_index_info.clear();
+}
+
+
+/**
+ * @brief fill the Harwell-Boeing index arrays, the values and order_ from
+ * EntryNum_ entries given in (0-based) triplet form.
+ *
+ * The entries are bucketed by a two-pass counting sort: first by the minor
+ * index (column for compressed row, row for compressed column), then stably by
+ * the major index. This gives the same ordering as sorting with
+ * tuple_sort_rule_compressed_row/column in O(EntryNum_ + RowNum_ + ColNum_).
+ * order_[k] records the position of the k-th input entry, as used by setMatVal.
+ */
+void SpHbMat::build_compressed_structure(const int* row, const int* col,
+        const double* val) {
+    const int* major = isCompressedRow_ ? row : col;
+    const int* minor = isCompressedRow_ ? col : row;
+    int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+    int* index = isCompressedRow_ ? ColIndex_ : RowIndex_;
+    int major_num = isCompressedRow_ ? RowNum_ : ColNum_;
+    int minor_num = isCompressedRow_ ? ColNum_ : RowNum_;
+
+    //first pass: order the entries by their minor index
+    std::vector<int> minor_start(minor_num + 1, 0);
+    for (int k = 0; k < EntryNum_; k++)
+        minor_start[minor[k] + 1]++;
+    for (int i = 0; i < minor_num; i++)
+        minor_start[i + 1] += minor_start[i];
+    std::vector<int> by_minor(EntryNum_);
+    for (int k = 0; k < EntryNum_; k++)
+        by_minor[minor_start[minor[k]]++] = k;
+
+    //second pass: stable bucketing by the major index
+    for (int i = 0; i < major_num + 1; i++)
+        pointer[i] = 0;
+    for (int k = 0; k < EntryNum_; k++)
+        pointer[major[k] + 1]++;
+    for (int i = 0; i < major_num; i++)
+        pointer[i + 1] += pointer[i];
+
+    std::vector<int> next(pointer, pointer + major_num);
+    for (int t = 0; t < EntryNum_; t++) {
+        int k = by_minor[t];
+        int pos = next[major[k]]++;
+        index[pos] = minor[k];
+        MatVal_[pos] = val[k];
+        order_[k] = pos;
+    }
+    assert(pointer[major_num] == EntryNum_);
+    if (num_threads_ > 1)
+        build_transpose_structure();
 }
 
 //@}
 
 
+void SpHbMat::set_identity_blocks(IdentityInfo I_info) {
+    assert(isInitialised_ == false);
+    I_irow_.resize(I_info.length);
+    I_jcol_.resize(I_info.length);
+    I_size_.resize(I_info.length);
+    I_value_.resize(I_info.length);
+    for (int b = 0; b < I_info.length; b++) {
+        I_irow_[b] = I_info.irow[b] - 1;
+        I_jcol_[b] = I_info.jcol[b] - 1;
+        I_size_[b] = I_info.size[b];
+        I_value_[b] = I_info.value[b];
+    }
+}
+
+
+/**
+ * @brief Each major line (row for compressed row, column for compressed column) of
+ * the expanded matrix is the merge of the stored entries of that line, which are
+ * sorted by their minor index already, with the at most one entry every identity
+ * block has in it. Stored entries come first on ties, as in setStructure(rhs,
+ * I_info), and so does the order_ of the expanded matrix.
+ */
+std::shared_ptr<SpHbMat> SpHbMat::expanded() {
+    assert(isInitialised_);
+    if (expanded_ != nullptr) {
+        if (!expanded_is_current_) {
+            double* values = expanded_->MatVal_;
+            for (int k = 0; k < EntryNum_; k++)
+                values[expanded_position_[k]] = MatVal_[k];
+            expanded_is_current_ = true;
+        }
+        return expanded_;
+    }
+
+    int nBlocks = (int) I_size_.size();
+    expanded_ = std::make_shared<SpHbMat>(EntryNum_ + IdentityEntryNum(), RowNum_,
+                                          ColNum_, isCompressedRow_);
+    expanded_position_.resize(EntryNum_);
+
+    const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+    const int* index = isCompressedRow_ ? ColIndex_ : RowIndex_;
+    int* pointer_e = isCompressedRow_ ? expanded_->RowIndex_ : expanded_->ColIndex_;
+    int* index_e = isCompressedRow_ ? expanded_->ColIndex_ : expanded_->RowIndex_;
+    const std::vector<int>& I_major = isCompressedRow_ ? I_irow_ : I_jcol_;
+    const std::vector<int>& I_minor = isCompressedRow_ ? I_jcol_ : I_irow_;
+    int major_num = isCompressedRow_ ? RowNum_ : ColNum_;
+
+    //the input index of the first entry of each block, after the stored ones
+    std::vector<int> I_start(nBlocks);
+    for (int b = 0, start = EntryNum_; b < nBlocks; start += I_size_[b], b++)
+        I_start[b] = start;
+
+    //(minor index, block, offset) of the identity entries in the current line
+    std::vector<std::tuple<int, int, int>> line_I;
+    int pos = 0;
+    for (int i = 0; i < major_num; i++) {
+        pointer_e[i] = pos;
+        line_I.clear();
+        for (int b = 0; b < nBlocks; b++) {
+            int offset = i - I_major[b];
+            if (offset >= 0 && offset < I_size_[b])
+                line_I.emplace_back(I_minor[b] + offset, b, offset);
+        }
+        std::sort(line_I.begin(), line_I.end());
+
+        int k = pointer[i];
+        auto t = line_I.begin();
+        while (k < pointer[i + 1] || t != line_I.end()) {
+            if (t == line_I.end() || (k < pointer[i + 1] && index[k] <= get<0>(*t))) {
+                index_e[pos] = index[k];
+                expanded_->MatVal_[pos] = MatVal_[k];
+                expanded_position_[k] = pos;
+                k++;
+            } else {
+                int b = get<1>(*t);
+                index_e[pos] = get<0>(*t);
+                expanded_->MatVal_[pos] = I_value_[b];
+                expanded_->order_[I_start[b] + get<2>(*t)] = pos;
+                t++;
+            }
+            pos++;
+        }
+    }
+    pointer_e[major_num] = pos;
+    assert(pos == expanded_->EntryNum_);
+
+    for (int k = 0; k < EntryNum_; k++)
+        expanded_->order_[k] = expanded_position_[order_[k]];
+    expanded_->isSymmetric_ = isSymmetric_;
+    expanded_->isInitialised_ = true;
+    expanded_is_current_ = true;
+    return expanded_;
+}
+
+
 /** @name setMatVal */
 //@{
 /**
@@ -367,16 +455,13 @@ void SpHbMat::setStructure(std::shared_ptr<const SpTripletMat> rhs) {
  */
 void SpHbMat::setMatVal(std::shared_ptr<const SpTripletMat> rhs,
                         IdentityInfo I_info) {
-    //adding identity submatrices  to the matrix
-    int total_I_entries = 0;
-    for(int i=0; i<I_info.length; i++) {
-        total_I_entries += I_info.size[i];
-    }
-
-    //assign each matrix entry to the corresponding position after permutation
-    for (int i = 0; i < EntryNum_ - total_I_entries; i++) {
+    //the identity entries never change, so only the entries of rhs are assigned to
+    //the corresponding position after permutation
+    for (int i = 0; i < rhs->EntryNum(); i++) {
         MatVal_[order(i)] = rhs->MatVal(i);
     }
+    expanded_is_current_ = false;
+    update_transpose_values();
 }
 
 
@@ -390,6 +475,25 @@ void SpHbMat::setMatVal(std::shared_ptr<const SpTripletMat> rhs) {
             j++;
         }
     }
+    expanded_is_current_ = false;
+    update_transpose_values();
+}
+
+
+void SpHbMat::setMatVal(std::shared_ptr<const SpTripletMat> rhs,
+                        const std::vector<int>& entries) {
+    assert(!isSymmetric_);
+    bool has_transpose = !transpose_values_.empty();
+    double* expanded_values = expanded_ != nullptr && expanded_is_current_ ?
+                              expanded_->MatVal_ : NULL;
+    for (int i : entries) {
+        int k = order_[i];
+        MatVal_[k] = rhs->MatVal(i);
+        if (has_transpose)
+            transpose_values_[transpose_slot_[k]] = MatVal_[k];
+        if (expanded_values != NULL)
+            expanded_values[expanded_position_[k]] = MatVal_[k];
+    }
 }
 
 //@}
@@ -424,6 +528,11 @@ void SpHbMat::copy(std::shared_ptr<const SpHbMat> rhs) {
     for (int i = 0; i < ColNum_ + 1; i++) {
         ColIndex_[i] = rhs->ColIndex(i);
     }
+    I_irow_ = rhs->I_irow_;
+    I_jcol_ = rhs->I_jcol_;
+    I_size_ = rhs->I_size_;
+    I_value_ = rhs->I_value_;
+    expanded_is_current_ = false;
 }
 
 void SpHbMat::set_zero() {
@@ -492,7 +601,8 @@ shared_ptr<SpTripletMat> SpHbMat::convert_to_triplet() const {
         }
     }
     else {
-        result = make_shared<SpTripletMat>(EntryNum_, RowNum_, ColNum_, false, true);
+        result = make_shared<SpTripletMat>(EntryNum_ + IdentityEntryNum(), RowNum_,
+                                           ColNum_, false, true);
         for (int i = 0; i < EntryNum_; i++) {
             if(isCompressedRow_) {
                 while(RowIndex_[j] == i)
@@ -509,82 +619,19 @@ shared_ptr<SpTripletMat> SpHbMat::convert_to_triplet() const {
 
             result->setMatValAt(i,MatVal_[i]);
         }
-    }
-    return result;
-}
-
-void SpHbMat::write_to_file(const char* name,
-                            Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
-                            Ipopt::EJournalLevel level,
-                            Ipopt::EJournalCategory category,
-                            Solver solver) {
-#if DEBUG
-#if PRINT_QP_IN_CPP
-    const char* var_type_int;
-    const char* var_type_double;
-    var_type_int = (solver == QPOASES) ? "sparse_int_t" : "qp_int";
-    var_type_double = (solver == QPOASES) ? "real_t" : "double";
-    jnlst->Printf(level, category, "%s %s_jc[] = \n{", var_type_int, name);
-    int i;
-    for (i = 0; i < ColNum_ + 1; i++) {
-        if (i % 10 == 0 && i > 1)
-            jnlst->Printf(level, category, "\n");
-        if (i == ColNum_)
-            jnlst->Printf(level, category, "%d};\n\n", ColIndex_[i]);
-        else
-            jnlst->Printf(level, category, "%d, ", ColIndex_[i]);
-    }
-    jnlst->Printf(level, category, "%s %s_ir[] = \n{", var_type_int, name);
-    for (i = 0; i < EntryNum_; i++) {
-        if (i % 10 == 0 && i > 1)
-            jnlst->Printf(level, category, "\n");
-        if (i == EntryNum_ - 1)
-            jnlst->Printf(level, category, "%d};\n\n", RowIndex_[i]);
-        else
-            jnlst->Printf(level, category, "%d, ", RowIndex_[i]);
-    }
-    jnlst->Printf(level, category, "%s %s_val[] = \n{", var_type_double, name);
-    for (i = 0; i < EntryNum_; i++) {
-        if (i % 10 == 0 && i > 1)
-            jnlst->Printf(level, category, "\n");
-        if (i == EntryNum_ - 1)
-            jnlst->Printf(level, category, "%23.16e};\n\n", MatVal_[i]);
-        else
-            jnlst->Printf(level, category, "%23.16e, ", MatVal_[i]);
-    }
-#else
-    int i;
-    if(solver == QORE) {
-        for (i = 0; i < RowNum_ + 1; i++) {
-            jnlst->Printf(level, category, "%d\n", RowIndex_[i]);
-        }
-        for (i = 0; i < EntryNum_; i++) {
-            jnlst->Printf(level, category, "%d\n", ColIndex_[i]);
-        }
-        for (i = 0; i < EntryNum_; i++) {
-            jnlst->Printf(level, category, "%23.16e\n", MatVal_[i]);
-        }
-    }
-    else if(solver ==QPOASES) {
-        for (i = 0; i < EntryNum_; i++) {
-            jnlst->Printf(level, category, "%d\n", RowIndex_[i]);
-        }
-        for (i = 0; i < ColNum_ + 1; i++) {
-            jnlst->Printf(level, category, "%d\n", ColIndex_[i]);
-        }
-        for (i = 0; i < EntryNum_; i++) {
-            jnlst->Printf(level, category, "%23.16e\n", MatVal_[i]);
+        int k = EntryNum_;
+        for (int b = 0; b < (int) I_size_.size(); b++) {
+            for (int j = 0; j < I_size_[b]; j++) {
+                result->setRowIndex(k, I_irow_[b] + j + 1);
+                result->setColIndex(k, I_jcol_[b] + j + 1);
+                result->setMatValAt(k, I_value_[b]);
+                k++;
+            }
         }
     }
-#endif
-#endif
+    return result;
 }
 
-
-
-
-
-
 void SpHbMat::get_dense_matrix(double* dense_matrix,bool row_oriented) const {
 
     int row;
@@ -653,90 +700,125 @@ void SpHbMat::get_dense_matrix(double* dense_matrix,bool row_oriented) const {
         }
 
     }
+    add_identity_to_dense(dense_matrix, row_oriented);
 }
 
 
-void SpHbMat::transposed_times(shared_ptr<const Vector> p,
-                               shared_ptr<Vector> result) const {
-
-    result->set_zeros();
-
-    if(isCompressedRow_) {
-        int row;
-        for(int i = 1; i <RowNum_+1; i++) {
-            if(RowIndex_[i]>0) {
-                row = i-1;
-                break;
-            }
-        }
-        for(int i = 0; i<EntryNum_; i++) {
-            while(i==RowIndex_[row+1]) {
-                row++;
-            }
-            result->addNumberAt(ColIndex_[i], MatVal_[i]*p->values(row));
-        }
-    }
-    else {
-        int col;
-        //find the col corresponding to the first nonzero entry
-        for(int i = 1; i<ColNum_+1; i++) {
-            if(ColIndex_[i]>0) {
-                col = i-1;
-                break;
-            }
-        }
-        for(int i = 0; i<EntryNum_; i++) {
-            //go to the next col
-            while(i == ColIndex_[col+1]) {
-                col++;
-            }
-            result->addNumberAt(col, MatVal_[i]*p->values(RowIndex_[i]));
+void SpHbMat::add_identity_to_dense(double* dense_matrix, bool row_oriented) const {
+    for (int b = 0; b < (int) I_size_.size(); b++) {
+        for (int j = 0; j < I_size_[b]; j++) {
+            int row = I_irow_[b] + j;
+            int col = I_jcol_[b] + j;
+            if (row_oriented)
+                dense_matrix[ColNum_ * row + col] += I_value_[b];
+            else
+                dense_matrix[RowNum_ * col + row] += I_value_[b];
         }
     }
 }
 
+
+void SpHbMat::transposed_times(shared_ptr<const Vector> p,
+                               shared_ptr<Vector> result) const {
+    times_impl(p->values(), result->values(), true);
+}
+
 void SpHbMat::times(std::shared_ptr<const Vector> p,
                     std::shared_ptr<Vector> result) const {
+    times_impl(p->values(), result->values(), false);
+}
 
-    result->set_zeros();
 
-    if(isCompressedRow_) {
-        int row;
-        //find the row corresponding to the first nonzero entry
-        for(int i = 1; i <RowNum_+1; i++) {
-            if(RowIndex_[i]>0) {
-                row = i-1;
-                break;
-            }
-        }
-        for(int i = 0; i<EntryNum_; i++) {
-            //go to the next row
-            while(i==RowIndex_[row+1]) {
-                row++;
-            }
-            result->addNumberAt(row, MatVal_[i]*p->values(ColIndex_[i]));
-        }
-    }
-    else {
-        int col;
-        //find the col corresponding to the first nonzero entry
-        for(int i = 1; i<ColNum_+1; i++) {
-            if(ColIndex_[i]>0) {
-                col = i-1;
-                break;
-            }
-        }
-        for(int i = 0; i<EntryNum_; i++) {
-            //go to the next col
-            while(i == ColIndex_[col+1]) {
-                col++;
-            }
-            result->addNumberAt(RowIndex_[i], MatVal_[i]*p->values(col));
+void SpHbMat::times_impl(const double* p, double* result, bool transposed) const {
+    //M*p for compressed row and M^T*p for compressed column go along the stored
+    //lines, the other two along the lines of the transpose
+    bool along_stored_lines = (isCompressedRow_ != transposed);
+    int num_lines = transposed ? ColNum_ : RowNum_;
+    int num_threads = num_threads_for(EntryNum_, num_threads_);
+
+    if (along_stored_lines || !transpose_pointer_.empty()) {
+        const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+        const int* index = isCompressedRow_ ? ColIndex_ : RowIndex_;
+        const double* values = MatVal_;
+        if (!along_stored_lines) {
+            pointer = transpose_pointer_.data();
+            index = transpose_index_.data();
+            values = transpose_values_.data();
+        }
+        auto gather = [&](int t) {
+            //the lines are split such that every thread gets about the same number
+            //of entries
+            int first = std::lower_bound(pointer, pointer + num_lines + 1,
+                                         chunk_begin(EntryNum_, t, num_threads)) - pointer;
+            int last = (t == num_threads - 1) ? num_lines :
+                       std::lower_bound(pointer, pointer + num_lines + 1,
+                                        chunk_begin(EntryNum_, t + 1, num_threads)) - pointer;
+            for (int i = first; i < last; i++) {
+                double sum = 0.0;
+                for (int k = pointer[i]; k < pointer[i + 1]; k++)
+                    sum += values[k] * p[index[k]];
+                result[i] = sum;
+            }
+        };
+        if (num_threads > 1)
+            parallel_for(num_threads, gather);
+        else
+            gather(0);
+    } else {
+        const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+        const int* index = isCompressedRow_ ? ColIndex_ : RowIndex_;
+        int num_stored_lines = isCompressedRow_ ? RowNum_ : ColNum_;
+        for (int i = 0; i < num_lines; i++)
+            result[i] = 0.0;
+        for (int i = 0; i < num_stored_lines; i++)
+            for (int k = pointer[i]; k < pointer[i + 1]; k++)
+                result[index[k]] += MatVal_[k] * p[i];
+    }
+    add_identity_times(p, result, transposed);
+}
+
+
+void SpHbMat::set_num_threads(int num_threads) {
+    num_threads_ = num_threads > 0 ? num_threads : 1;
+    if (num_threads_ > 1 && isInitialised_ && transpose_pointer_.empty())
+        build_transpose_structure();
+}
+
+
+void SpHbMat::build_transpose_structure() {
+    const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+    const int* index = isCompressedRow_ ? ColIndex_ : RowIndex_;
+    int num_lines = isCompressedRow_ ? RowNum_ : ColNum_;
+    int num_transposed_lines = isCompressedRow_ ? ColNum_ : RowNum_;
+
+    transpose_pointer_.assign(num_transposed_lines + 1, 0);
+    transpose_index_.resize(EntryNum_);
+    transpose_position_.resize(EntryNum_);
+    transpose_slot_.resize(EntryNum_);
+    transpose_values_.resize(EntryNum_);
+    for (int k = 0; k < EntryNum_; k++)
+        transpose_pointer_[index[k] + 1]++;
+    for (int i = 0; i < num_transposed_lines; i++)
+        transpose_pointer_[i + 1] += transpose_pointer_[i];
+    std::vector<int> next(transpose_pointer_.begin(), transpose_pointer_.end() - 1);
+    for (int i = 0; i < num_lines; i++) {
+        for (int k = pointer[i]; k < pointer[i + 1]; k++) {
+            int pos = next[index[k]]++;
+            transpose_index_[pos] = i;
+            transpose_position_[pos] = k;
+            transpose_slot_[k] = pos;
+            transpose_values_[pos] = MatVal_[k];
         }
     }
 }
 
 
+void SpHbMat::update_transpose_values() {
+    for (int k = 0; k < (int) transpose_values_.size(); k++)
+        transpose_values_[k] = MatVal_[transpose_position_[k]];
+}
+
+
 //@{
 void
 SpHbMat::print_full(const char* name, Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
@@ -774,6 +856,7 @@ SpHbMat::print_full(const char* name, Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
             dense_matrix[ColNum_ * RowIndex_[i]+col] = MatVal_[i];
         }
     }
+    add_identity_to_dense(dense_matrix, true);
 
     if(!IsNull(jnlst)) {
         if (name != nullptr) {
@@ -844,64 +927,47 @@ void SpHbMat::print(const char* name, Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
     for (int i = 0; i < EntryNum_; i++)
         std::cout << order(i) << " ";
     std::cout << " " << std::endl;
+
+    for (int b = 0; b < (int) I_size_.size(); b++)
+        std::cout << "Identity: " << I_value_[b] << "*I(" << I_size_[b] << ") at ("
+                  << I_irow_[b] << ", " << I_jcol_[b] << ")" << std::endl;
 }
 
 
 /** @name norms */
 //@{
 const double SpHbMat::oneNorm()const {
-    //TODO: test on it!
-    std::shared_ptr<Vector> colSums = std::make_shared<Vector>(ColNum_);
-    if(isCompressedRow_) {
-        for (int i = 0; i < EntryNum_; i++) {
-            colSums->addNumberAt(ColIndex(i), abs(MatVal_[i]));
-        }
-    }
-    else {
-        int col = 0;
-        for(int i = 1; i<ColNum_+1; i++) {
-            if(ColIndex_[i]>0) {
-                col = i-1;
-                break;
-            }
-        }
-        for (int i = 0; i < EntryNum_; i++) {
-            while(ColIndex_[col+1])
-                col++;
-            colSums->addNumberAt(col, abs(MatVal_[i]));
-        }
-    }
-
-    double oneNorm = colSums->getInfNorm();//same as calculating the MAX of an array
+    std::vector<double> colSums(ColNum_, 0.0);
+    const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+    int major_num = isCompressedRow_ ? RowNum_ : ColNum_;
+    for (int i = 0; i < major_num; i++)
+        for (int k = pointer[i]; k < pointer[i + 1]; k++)
+            colSums[isCompressedRow_ ? ColIndex_[k] : i] += fabs(MatVal_[k]);
+    for (int b = 0; b < (int) I_size_.size(); b++)
+        for (int j = 0; j < I_size_[b]; j++)
+            colSums[I_jcol_[b] + j] += fabs(I_value_[b]);
+
+    double oneNorm = 0.0;
+    for (double colSum : colSums)
+        oneNorm = std::max(oneNorm, colSum);
     return oneNorm;
-
 }
 
 const double SpHbMat::infNorm()const {
-    //TODO: test on it!
-    std::shared_ptr<Vector> rowSums = std::make_shared<Vector>(RowNum_);
-    if(isCompressedRow_) {
-        for (int i = 0; i < EntryNum_; i++) {
-            rowSums->addNumberAt(RowIndex(i), abs(MatVal_[i]));
-        }
-    }
-    else {
-        int row = 0;
-        for(int i = 1; i<RowNum_+1; i++) {
-            if(RowIndex_[i]>0) {
-                row = i-1;
-                break;
-            }
-        }
-        for (int i = 0; i < EntryNum_; i++) {
-            while(RowIndex_[row+1])
-                row++;
-            rowSums->addNumberAt(row, abs(MatVal_[i]));
-        }
-    }
-
-    double InfNorm = rowSums->getInfNorm();//same as calculating the MAX of an array
-    return InfNorm;
+    std::vector<double> rowSums(RowNum_, 0.0);
+    const int* pointer = isCompressedRow_ ? RowIndex_ : ColIndex_;
+    int major_num = isCompressedRow_ ? RowNum_ : ColNum_;
+    for (int i = 0; i < major_num; i++)
+        for (int k = pointer[i]; k < pointer[i + 1]; k++)
+            rowSums[isCompressedRow_ ? i : RowIndex_[k]] += fabs(MatVal_[k]);
+    for (int b = 0; b < (int) I_size_.size(); b++)
+        for (int j = 0; j < I_size_[b]; j++)
+            rowSums[I_irow_[b] + j] += fabs(I_value_[b]);
+
+    double infNorm = 0.0;
+    for (double rowSum : rowSums)
+        infNorm = std::max(infNorm, rowSum);
+    return infNorm;
 }
 //@}
 }//END_OF_NAMESPACE
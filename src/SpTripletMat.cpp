@@ -238,7 +238,10 @@ void SpTripletMat::times(std::shared_ptr<const Vector> p,
                          std::shared_ptr<Vector> result) const {
 
     assert(ColNum_ == p->Dim());
-    if (isSymmetric_) {
+    int num_threads = num_threads_for(EntryNum_, num_threads_);
+    if (num_threads > 1) {
+        parallel_times(p->values(), result->values(), RowNum_, false, num_threads);
+    } else if (isSymmetric_) {
         result->set_zeros();
         for (int i = 0; i < EntryNum_; i++) {
             result->addNumberAt(RowIndex_[i] - 1, MatVal_[i] * p->values()
@@ -311,8 +314,11 @@ void SpTripletMat::copy(std::shared_ptr<const SpTripletMat> rhs, bool deep_copy)
 void SpTripletMat::transposed_times(std::shared_ptr<const Vector> p,
                                     std::shared_ptr<Vector> result) const {
 
+    int num_threads = num_threads_for(EntryNum_, num_threads_);
     if (isSymmetric_) {
         times(p, result);
+    } else if (num_threads > 1) {
+        parallel_times(p->values(), result->values(), ColNum_, true, num_threads);
     } else {
         result->set_zeros(); //set all entries to be 0
         for (int i = 0; i < EntryNum_; i++) {
@@ -323,6 +329,34 @@ void SpTripletMat::transposed_times(std::shared_ptr<const Vector> p,
 }
 
 
+void SpTripletMat::parallel_times(const double* p, double* result, int result_dim,
+                                  bool transposed, int num_threads) const {
+    std::vector<double> partial((num_threads - 1) * result_dim, 0.0);
+    parallel_for(num_threads, [&](int t) {
+        double* acc = (t == 0) ? result : partial.data() + (t - 1) * result_dim;
+        if (t == 0)
+            for (int i = 0; i < result_dim; i++)
+                acc[i] = 0.0;
+        int end = chunk_begin(EntryNum_, t + 1, num_threads);
+        for (int k = chunk_begin(EntryNum_, t, num_threads); k < end; k++) {
+            int row = (transposed ? ColIndex_[k] : RowIndex_[k]) - 1;
+            int col = (transposed ? RowIndex_[k] : ColIndex_[k]) - 1;
+            acc[row] += MatVal_[k] * p[col];
+            if (isSymmetric_ && row != col)
+                acc[col] += MatVal_[k] * p[row];
+        }
+    });
+
+    //sum up the partial results, split over the entries of result
+    parallel_for(num_threads, [&](int t) {
+        int end = chunk_begin(result_dim, t + 1, num_threads);
+        for (int i = chunk_begin(result_dim, t, num_threads); i < end; i++)
+            for (int s = 0; s < num_threads - 1; s++)
+                result[i] += partial[s * result_dim + i];
+    });
+}
+
+
 void SpTripletMat::get_dense_matrix(double* dense_matrix,bool row_oriented) const {
     if(row_oriented) {
         for(int i = 0; i<EntryNum_; i++) {
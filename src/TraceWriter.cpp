@@ -0,0 +1,111 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#include <sqphot/TraceWriter.hpp>
+#include <sqphot/Stats.hpp>
+#include <sqphot/MessageHandling.hpp>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace SQPhotstart {
+
+using namespace std;
+
+const uint32_t TraceWriter::version;
+
+
+TraceWriter::TraceWriter(const string &filename, bool binary, int capacity) :
+    file_(NULL),
+    binary_(binary),
+    dropped_(0),
+    head_(0),
+    tail_(0),
+    stop_(false) {
+    size_t size = 1;
+    while (size < (size_t) max(capacity, 1))
+        size *= 2;
+    buffer_.resize(size);
+    mask_ = size - 1;
+
+    file_ = fopen(filename.c_str(), binary ? "wb" : "w");
+    if (file_ == NULL) {
+        THROW_EXCEPTION(INVALID_TRACE_FILE, string(INVALID_TRACE_FILE_MSG) + filename +
+                        " cannot be opened: " + strerror(errno));
+    }
+    if (binary_) {
+        uint32_t header[4] = {version, (uint32_t) sizeof(IterationRecord),
+                              (uint32_t) N_TIMED_PHASES, 0
+                             };
+        fwrite(magic(), 1, 8, file_);
+        fwrite(header, sizeof(uint32_t), 4, file_);
+    }
+    writer_ = std::thread(&TraceWriter::run, this);
+}
+
+
+TraceWriter::~TraceWriter() {
+    stop_.store(true, memory_order_release);
+    writer_.join();
+    fclose(file_);
+}
+
+
+void TraceWriter::run() {
+    while (!stop_.load(memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    //the records pushed before the destructor was called
+    drain();
+}
+
+
+void TraceWriter::drain() {
+    size_t tail = tail_.load(memory_order_relaxed);
+    size_t head = head_.load(memory_order_acquire);
+    if (tail == head)
+        return;
+    for (; tail != head; tail++) {
+        const IterationRecord &record = buffer_[tail & mask_];
+        if (binary_)
+            fwrite(&record, sizeof(IterationRecord), 1, file_);
+        else
+            write_json(record);
+        //the slot can be reused once it is written
+        tail_.store(tail + 1, memory_order_release);
+    }
+    fflush(file_);
+}
+
+
+/** write "name":value, with null for the values that JSON cannot represent*/
+static void write_json_number(FILE* file, const char* name, double value) {
+    if (std::isfinite(value))
+        fprintf(file, "\"%s\":%.17g,", name, value);
+    else
+        fprintf(file, "\"%s\":null,", name);
+}
+
+
+void TraceWriter::write_json(const IterationRecord &record) {
+    fprintf(file_, "{\"iter\":%d,", record.iter);
+    write_json_number(file_, "f", record.f);
+    write_json_number(file_, "infea_measure", record.infea_measure);
+    write_json_number(file_, "rho", record.rho);
+    write_json_number(file_, "delta", record.delta);
+    write_json_number(file_, "norm_p", record.norm_p);
+    write_json_number(file_, "qp_kkt_error", record.qp_kkt_error);
+    fprintf(file_, "\"qp_iter\":%d,\"accepted\":%s,\"phase_time\":{", record.qp_iter,
+            record.accepted ? "true" : "false");
+    for (int i = 0; i < N_TIMED_PHASES; i++)
+        fprintf(file_, "%s\"%s\":%.9g", i > 0 ? "," : "",
+                Stats::phase_name((TimedPhase) i), record.phase_time[i]);
+    fprintf(file_, "}}\n");
+}
+
+}//SQPHOTSTART
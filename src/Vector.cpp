@@ -189,33 +189,6 @@ void Vector::set_zeros() {
     }
 }
 
-void Vector::write_to_file(const char* name,
-                           Ipopt::SmartPtr<Ipopt::Journalist> jnlst,
-                           Ipopt::EJournalLevel level,
-                           Ipopt::EJournalCategory category,
-                           Solver qpsolver) {
-#if DEBUG
-#if PRINT_QP_IN_CPP
-    const char * var_type;
-    var_type = (qpsolver==QPOASES)?"real_t":"double const";
-
-    jnlst->Printf(level, category, "%s %s[%i] = {", var_type,name,Dim());
-    for (int i = 0; i < Dim(); i++) {
-        if (i % 10 == 0 && i > 1)
-            jnlst->Printf(level, category, "\n");
-        if (i == Dim() - 1)
-            jnlst->Printf(level, category, "%23.16e};\n\n", values_[i]);
-        else
-            jnlst->Printf(level, category, "%23.16e, ", values_[i]);
-    }
-#else
-    //print in file
-    for (int i = 0; i < Dim(); i++) {
-        jnlst->Printf(level, category, "%23.16e\n", values_[i]);
-    }
-#endif
-#endif
-}
 //
 //Vector Vector::operator+(const Vector& rhs) {
 //    assert(this->size_==rhs.size_);
@@ -0,0 +1,262 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+#include <sqphot/WorkingSetSolver.hpp>
+#include <sqphot/Utils.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace SQPhotstart {
+
+using namespace std;
+
+WorkingSetSolver::WorkingSetSolver(int nVar, int nConstr, int max_size,
+                                   LinearSolver linear_solver, int dense_max_size) :
+    nVar_(nVar),
+    nConstr_(nConstr),
+    max_size_(max_size),
+    objective_(0.0),
+    kkt_(linear_solver, dense_max_size),
+    index_(nVar + nConstr),
+    has_structure_(false),
+    W_constr_(nConstr),
+    W_bounds_(nVar),
+    H_source_(NULL),
+    J_source_(NULL),
+    x_(nVar),
+    y_(nVar + nConstr),
+    Hx_(nVar),
+    Ax_(nConstr),
+    ATy_(nVar) {
+}
+
+
+void WorkingSetSolver::H_times(const SpTripletMat &H, const double* v,
+                               double* result) const {
+    fill(result, result + nVar_, 0.0);
+    for (int k = 0; k < H.EntryNum(); k++) {
+        int i = H.RowIndex(k) - 1;
+        int j = H.ColIndex(k) - 1;
+        result[i] += H.MatVal(k) * v[j];
+        if (H.isSymmetric() && i != j)
+            result[j] += H.MatVal(k) * v[i];
+    }
+}
+
+
+void WorkingSetSolver::A_times(const SpTripletMat &J, const IdentityInfo &I_info,
+                               const double* v, double* result,
+                               bool transposed) const {
+    fill(result, result + (transposed ? nVar_ : nConstr_), 0.0);
+    for (int k = 0; k < J.EntryNum(); k++) {
+        int i = J.RowIndex(k) - 1;
+        int j = J.ColIndex(k) - 1;
+        if (transposed)
+            result[j] += J.MatVal(k) * v[i];
+        else
+            result[i] += J.MatVal(k) * v[j];
+    }
+    for (int b = 0; b < I_info.length; b++)
+        for (int t = 0; t < I_info.size[b]; t++) {
+            int i = I_info.irow[b] - 1 + t;
+            int j = I_info.jcol[b] - 1 + t;
+            if (transposed)
+                result[j] += I_info.value[b] * v[i];
+            else
+                result[i] += I_info.value[b] * v[j];
+        }
+}
+
+
+void WorkingSetSolver::set_structure(shared_ptr<const SpTripletMat> H,
+                                     shared_ptr<const SpTripletMat> J,
+                                     const IdentityInfo &I_info, int nFree,
+                                     int nWorking) {
+    H_entries_.clear();
+    J_entries_.clear();
+    I_blocks_.clear();
+    if (H != nullptr)
+        for (int k = 0; k < H->EntryNum(); k++)
+            if (index_[H->RowIndex(k) - 1] >= 0 && index_[H->ColIndex(k) - 1] >= 0)
+                H_entries_.push_back(k);
+    for (int k = 0; k < J->EntryNum(); k++)
+        if (index_[nVar_ + J->RowIndex(k) - 1] >= 0 && index_[J->ColIndex(k) - 1] >= 0)
+            J_entries_.push_back(k);
+    int nnz_A = (int) J_entries_.size();
+    for (int b = 0; b < I_info.length; b++)
+        for (int t = 0; t < I_info.size[b]; t++)
+            if (index_[nVar_ + I_info.irow[b] - 1 + t] >= 0 &&
+                    index_[I_info.jcol[b] - 1 + t] >= 0) {
+                //an entry of an identity block is kept as its row of A
+                J_entries_.push_back(I_info.irow[b] - 1 + t);
+                I_blocks_.push_back(b);
+                nnz_A++;
+            }
+
+    //the rows of the reduced system are numbered from 1, as in SpTripletMat
+    H_FF_ = make_shared<SpTripletMat>((int) H_entries_.size(), nFree, nFree,
+                                      H == nullptr || H->isSymmetric());
+    for (size_t e = 0; e < H_entries_.size(); e++) {
+        H_FF_->setRowIndex(e, index_[H->RowIndex(H_entries_[e]) - 1] + 1);
+        H_FF_->setColIndex(e, index_[H->ColIndex(H_entries_[e]) - 1] + 1);
+    }
+    A_WF_ = make_shared<SpTripletMat>(nnz_A, nWorking, nFree);
+    int nnz_J = nnz_A - (int) I_blocks_.size();
+    for (int e = 0; e < nnz_A; e++) {
+        int row, col;
+        if (e < nnz_J) {
+            row = J->RowIndex(J_entries_[e]) - 1;
+            col = J->ColIndex(J_entries_[e]) - 1;
+        }
+        else {
+            int b = I_blocks_[e - nnz_J];
+            row = J_entries_[e];
+            col = I_info.jcol[b] - I_info.irow[b] + row;
+        }
+        A_WF_->setRowIndex(e, index_[nVar_ + row] - nFree + 1);
+        A_WF_->setColIndex(e, index_[col] + 1);
+    }
+    kkt_.set_structure(nFree, nWorking, H_FF_, A_WF_);
+
+    has_structure_ = true;
+    H_source_ = H.get();
+    J_source_ = J.get();
+}
+
+
+void WorkingSetSolver::set_values(shared_ptr<const SpTripletMat> H,
+                                  shared_ptr<const SpTripletMat> J,
+                                  const IdentityInfo &I_info) {
+    for (size_t e = 0; e < H_entries_.size(); e++)
+        H_FF_->setMatValAt(e, H->MatVal(H_entries_[e]));
+    int nnz_J = (int) (J_entries_.size() - I_blocks_.size());
+    for (int e = 0; e < (int) J_entries_.size(); e++)
+        A_WF_->setMatValAt(e, e < nnz_J ? J->MatVal(J_entries_[e]) :
+                           I_info.value[I_blocks_[e - nnz_J]]);
+    kkt_.set_values(H_FF_, A_WF_);
+}
+
+
+bool WorkingSetSolver::solve(shared_ptr<const SpTripletMat> H,
+                             shared_ptr<const SpTripletMat> J,
+                             const IdentityInfo &I_info, const double* g,
+                             const double* lb, const double* ub, const double* lbA,
+                             const double* ubA, const ActiveType* W_constr,
+                             const ActiveType* W_bounds, double tol) {
+    /**-------------------------------------------------------**/
+    /**   number the free variables and working constraints   **/
+    /**-------------------------------------------------------**/
+    int nFree = 0;
+    for (int j = 0; j < nVar_; j++) {
+        if (W_bounds[j] == INACTIVE) {
+            index_[j] = nFree++;
+            x_[j] = 0.0;
+        }
+        else {
+            index_[j] = -1;
+            x_[j] = W_bounds[j] == ACTIVE_ABOVE ? ub[j] : lb[j];
+            if (fabs(x_[j]) >= INF)
+                return false;
+        }
+    }
+    int n = nFree;
+    for (int i = 0; i < nConstr_; i++) {
+        if (W_constr[i] == INACTIVE)
+            index_[nVar_ + i] = -1;
+        else {
+            index_[nVar_ + i] = n++;
+            if (fabs(W_constr[i] == ACTIVE_ABOVE ? ubA[i] : lbA[i]) >= INF)
+                return false;
+        }
+    }
+    if (n > max_size_)
+        return false;
+    int nWorking = n - nFree;
+
+    /**-------------------------------------------------------**/
+    /**      the reduced KKT system, with x_ = [0; x_X]       **/
+    /**-------------------------------------------------------**/
+    //its pattern is that of the previous solve if the working set is the same
+    if (!has_structure_ || H.get() != H_source_ || J.get() != J_source_ ||
+            !equal(W_bounds, W_bounds + nVar_, W_bounds_.begin()) ||
+            !equal(W_constr, W_constr + nConstr_, W_constr_.begin())) {
+        copy(W_bounds, W_bounds + nVar_, W_bounds_.begin());
+        copy(W_constr, W_constr + nConstr_, W_constr_.begin());
+        set_structure(H, J, I_info, nFree, nWorking);
+    }
+    set_values(H, J, I_info);
+
+    rhs_.resize(n);
+    if (H != nullptr)
+        H_times(*H, x_.data(), Hx_.data());
+    else
+        fill(Hx_.begin(), Hx_.end(), 0.0);
+    A_times(*J, I_info, x_.data(), Ax_.data(), false);
+    for (int j = 0; j < nVar_; j++)
+        if (index_[j] >= 0)
+            rhs_[index_[j]] = -g[j] - Hx_[j];
+    for (int i = 0; i < nConstr_; i++)
+        if (index_[nVar_ + i] >= 0)
+            rhs_[index_[nVar_ + i]] =
+                (W_constr[i] == ACTIVE_ABOVE ? ubA[i] : lbA[i]) - Ax_[i];
+
+    //the reduced Hessian has to be positive definite for a minimizer, so that K
+    //has nWorking negative eigenvalues and no zero one
+    if (!kkt_.factorize() || !kkt_.provides_inertia() ||
+            kkt_.num_negative() != nWorking)
+        return false;
+    kkt_.solve(rhs_.data());
+
+    for (int j = 0; j < nVar_; j++)
+        if (index_[j] >= 0)
+            x_[j] = rhs_[index_[j]];
+    for (int i = 0; i < nConstr_; i++)
+        y_[nVar_ + i] = index_[nVar_ + i] >= 0 ? -rhs_[index_[nVar_ + i]] : 0.0;
+
+    /**-------------------------------------------------------**/
+    /**  the multipliers of the bounds and the KKT conditions **/
+    /**-------------------------------------------------------**/
+    if (H != nullptr)
+        H_times(*H, x_.data(), Hx_.data());
+    A_times(*J, I_info, x_.data(), Ax_.data(), false);
+    A_times(*J, I_info, y_.data() + nVar_, ATy_.data(), true);
+    double primal_violation = 0.0;
+    double dual_violation = 0.0;
+    double stationarity_violation = 0.0;
+    objective_ = 0.0;
+    for (int j = 0; j < nVar_; j++) {
+        double gap = g[j] + Hx_[j] - ATy_[j];
+        if (index_[j] >= 0) {
+            y_[j] = 0.0;
+            stationarity_violation += fabs(gap);
+        }
+        else
+            y_[j] = gap;
+        objective_ += x_[j] * (0.5 * Hx_[j] + g[j]);
+    }
+    for (int k = 0; k < nVar_ + nConstr_; k++) {
+        bool is_bound = k < nVar_;
+        double value = is_bound ? x_[k] : Ax_[k - nVar_];
+        double lower = is_bound ? lb[k] : lbA[k - nVar_];
+        double upper = is_bound ? ub[k] : ubA[k - nVar_];
+        primal_violation += max(0.0, lower - value) - min(0.0, upper - value);
+        ActiveType W = is_bound ? W_bounds[k] : W_constr[k - nVar_];
+        if (W == ACTIVE_BELOW)
+            dual_violation -= min(0.0, y_[k]);
+        else if (W == ACTIVE_ABOVE)
+            dual_violation += max(0.0, y_[k]);
+    }
+
+    optimality_status_.primal_violation = primal_violation;
+    optimality_status_.dual_violation = dual_violation;
+    optimality_status_.compl_violation = 0.0;
+    optimality_status_.stationarity_violation = stationarity_violation;
+    optimality_status_.KKT_error =
+        primal_violation + dual_violation + stationarity_violation;
+    return optimality_status_.KKT_error <= tol;
+}
+
+}
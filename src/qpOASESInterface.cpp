@@ -5,6 +5,7 @@
  * Date:    2019-07
  */
 #include <sqphot/qpOASESInterface.hpp>
+#include <sqphot/QPSnapshot.hpp>
 
 
 
@@ -39,14 +40,15 @@ qpOASESInterface::qpOASESInterface(NLPInfo nlp_info, QPType qptype,
     options_(options)
 {
 
-#if NEW_FORMULATION
-    nConstr_QP_ = nlp_info.nCon+nlp_info.nVar;
-    nVar_QP_ = nlp_info.nVar*3+2*nlp_info.nCon;
-#else
-    nConstr_QP_ = nlp_info.nCon;
-    nVar_QP_ = nlp_info.nVar+2*nlp_info.nCon;
-#endif
+    Formulation formulation = options->formulation;
+    nConstr_QP_ = formulation_nConstr_QP(formulation, nlp_info);
+    nVar_QP_ = formulation_nVar_QP(formulation, nlp_info);
+    bound_multipliers_offset_ = formulation_bound_multipliers_offset(formulation,
+                                nlp_info);
     allocate_memory(nlp_info, qptype);
+    A_->set_num_threads(options->num_threads);
+    if (H_ != nullptr)
+        H_->set_num_threads(options->num_threads);
 }
 
 
@@ -59,16 +61,18 @@ qpOASESInterface::qpOASESInterface(shared_ptr<SpHbMat> H,
                                    shared_ptr<Vector> lbA,
                                    shared_ptr<Vector> ubA,
                                    shared_ptr<Options> options):
-    nVar_QP_(A->ColNum()),
     nConstr_QP_(A->RowNum()),
-    H_(H),
-    A_(A),
+    nVar_QP_(A->ColNum()),
+    bound_multipliers_offset_(0),
+    options_(options),
     g_(g),
-    lb_(lb),
-    ub_(ub),
     lbA_(lbA),
+    lb_(lb),
     ubA_(ubA),
-    options_(options)
+    ub_(ub),
+    H_(H),
+    A_(A),
+    A_expanded_(A)
 {
 
 
@@ -88,9 +92,7 @@ qpOASESInterface::qpOASESInterface(shared_ptr<SpHbMat> H,
                  A_->RowIndex(),
                  A_->ColIndex(),
                  A_->MatVal());
-
-
-
+    allocate_workspace();
 }
 
 /**Default destructor*/
@@ -105,17 +107,13 @@ qpOASESInterface::~qpOASESInterface() = default;
  */
 void qpOASESInterface::allocate_memory(NLPInfo nlp_info, QPType qptype) {
 
-#if NEW_FORMULATION
-    int nnz_g_QP = nlp_info.nnz_jac_g+2*nlp_info.nCon+3*nlp_info.nVar;
-#else
-    int nnz_g_QP = nlp_info.nnz_jac_g + 2 * nlp_info.nCon;
-#endif
     lbA_ = make_shared<Vector>(nConstr_QP_);
     ubA_ = make_shared<Vector>(nConstr_QP_);
     lb_ = make_shared<Vector>(nVar_QP_);
     ub_ = make_shared<Vector>(nVar_QP_);
     g_ = make_shared<Vector>(nVar_QP_);
-    A_ = make_shared<SpHbMat>(nnz_g_QP, nConstr_QP_, nVar_QP_,false);
+    //the identity blocks of A are kept implicitly, only the Jacobian is stored
+    A_ = make_shared<SpHbMat>(nlp_info.nnz_jac_g, nConstr_QP_, nVar_QP_,false);
     x_qp_ = make_shared<Vector>(nVar_QP_);
     y_qp_ = make_shared<Vector>(nConstr_QP_+nVar_QP_);
 
@@ -125,6 +123,19 @@ void qpOASESInterface::allocate_memory(NLPInfo nlp_info, QPType qptype) {
 
     solver_ = std::make_shared<qpOASES::SQProblem>((qpOASES::int_t) nVar_QP_,
               (qpOASES::int_t) nConstr_QP_);
+    allocate_workspace();
+}
+
+
+void qpOASESInterface::allocate_workspace() {
+    Ax_work_ = make_shared<Vector>(nConstr_QP_);
+    Hx_work_ = make_shared<Vector>(nVar_QP_);
+    stationary_gap_work_ = make_shared<Vector>(nVar_QP_);
+    W_solver_work_.resize(nVar_QP_ + nConstr_QP_);
+    W_c_work_.resize(nConstr_QP_);
+    W_b_work_.resize(nVar_QP_);
+    x_guess_ = make_shared<Vector>(nVar_QP_);
+    y_guess_ = make_shared<Vector>(nVar_QP_ + nConstr_QP_);
 }
 
 /**
@@ -174,41 +185,58 @@ qpOASESInterface::optimizeQP(shared_ptr<Stats> stats) {
 //                  ub_->print("ub");
         //@}
         get_Matrix_change_status();
+        //a working set given by set_warm_start replaces the one of the last solve
+        const qpOASES::Bounds* guessed_bounds = has_warm_start_ ? &guessed_bounds_ : 0;
+        const qpOASES::Constraints* guessed_constraints =
+            has_warm_start_ ? &guessed_constraints_ : 0;
         if (new_QP_matrix_status_ == UNDEFINED) {
             assert(old_QP_matrix_status_ != UNDEFINED);
             if (old_QP_matrix_status_ == FIXED)
                 solver_->hotstart(g_->values(), lb_->values(), ub_->values(),
                                   lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             else {
                 solver_->hotstart(H_qpOASES_.get(), g_->values(), A_qpOASES_.get(),
                                   lb_->values(), ub_->values(), lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
         }
         else {
             if (new_QP_matrix_status_ == FIXED && old_QP_matrix_status_ == FIXED) {
                 solver_->hotstart(g_->values(), lb_->values(), ub_->values(),
                                   lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
             else if (new_QP_matrix_status_ == VARIED &&
                      old_QP_matrix_status_ == VARIED) {
                 solver_->hotstart(H_qpOASES_.get(), g_->values(), A_qpOASES_.get(),
                                   lb_->values(), ub_->values(), lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
             else if (new_QP_matrix_status_ != old_QP_matrix_status_) {
-                qpOASES::Bounds tmp_bounds;
-                solver_->getBounds(tmp_bounds);
-                solver_->init(H_qpOASES_.get(), g_->values(), A_qpOASES_.get(),
-                              lb_->values(),
-                              ub_->values(), lbA_->values(), ubA_->values(), nWSR,0,         x_qp_->values(),y_qp_->values(),&tmp_bounds);
+                if (has_warm_start_)
+                    solver_->init(H_qpOASES_.get(), g_->values(), A_qpOASES_.get(),
+                                  lb_->values(), ub_->values(), lbA_->values(),
+                                  ubA_->values(), nWSR, 0, x_guess_->values(),
+                                  y_guess_->values(), guessed_bounds,
+                                  guessed_constraints);
+                else {
+                    qpOASES::Bounds tmp_bounds;
+                    solver_->getBounds(tmp_bounds);
+                    solver_->init(H_qpOASES_.get(), g_->values(), A_qpOASES_.get(),
+                                  lb_->values(),
+                                  ub_->values(), lbA_->values(), ubA_->values(), nWSR,0,         x_qp_->values(),y_qp_->values(),&tmp_bounds);
+                }
                 new_QP_matrix_status_ = old_QP_matrix_status_ = UNDEFINED;
 
             }
         }
     }
+    has_warm_start_ = false;
 
     reset_flags();
 
@@ -239,15 +267,20 @@ void qpOASESInterface::optimizeLP(shared_ptr<Stats> stats) {
     }
     else {
         get_Matrix_change_status();
+        const qpOASES::Bounds* guessed_bounds = has_warm_start_ ? &guessed_bounds_ : 0;
+        const qpOASES::Constraints* guessed_constraints =
+            has_warm_start_ ? &guessed_constraints_ : 0;
         if (new_QP_matrix_status_ == UNDEFINED) {
             if (old_QP_matrix_status_ == FIXED)
                 solver_->hotstart(g_->values(), lb_->values(), ub_->values(),
                                   lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             else {
                 solver_->hotstart(0, g_->values(), A_qpOASES_.get(),
                                   lb_->values(), ub_->values(), lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
         }
 
@@ -255,17 +288,22 @@ void qpOASESInterface::optimizeLP(shared_ptr<Stats> stats) {
             if (new_QP_matrix_status_ == FIXED && old_QP_matrix_status_ == FIXED) {
                 solver_->hotstart(g_->values(), lb_->values(), ub_->values(),
                                   lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
             else if (new_QP_matrix_status_ == VARIED &&
                      old_QP_matrix_status_ == VARIED) {
                 solver_->hotstart(0, g_->values(), A_qpOASES_.get(),
                                   lb_->values(), ub_->values(), lbA_->values(),
-                                  ubA_->values(), nWSR);
+                                  ubA_->values(), nWSR, 0, guessed_bounds,
+                                  guessed_constraints);
             }
             else if (new_QP_matrix_status_ != old_QP_matrix_status_) {
                 solver_->init(0, g_->values(), A_qpOASES_.get(), lb_->values(),
-                              ub_->values(), lbA_->values(), ubA_->values(), nWSR);
+                              ub_->values(), lbA_->values(), ubA_->values(), nWSR,
+                              0, has_warm_start_ ? x_guess_->values() : 0,
+                              has_warm_start_ ? y_guess_->values() : 0,
+                              guessed_bounds, guessed_constraints);
                 new_QP_matrix_status_ = old_QP_matrix_status_ = UNDEFINED;
             }
         }
@@ -275,6 +313,7 @@ void qpOASESInterface::optimizeLP(shared_ptr<Stats> stats) {
             handle_error(LP, stats);
         }
     }
+    has_warm_start_ = false;
     //get primal and dual solutions
     if(stats!=nullptr)
         stats->qp_iter_addValue((int) nWSR);
@@ -284,16 +323,34 @@ void qpOASESInterface::optimizeLP(shared_ptr<Stats> stats) {
 }
 
 
+void qpOASESInterface::set_warm_start(const ActiveType* W_constr,
+                                      const ActiveType* W_bounds, const double* x,
+                                      const double* y_bounds, const double* y_constr) {
+    x_guess_->copy_vector(x);
+    std::copy(y_bounds, y_bounds + nVar_QP_, y_guess_->values());
+    std::copy(y_constr, y_constr + nConstr_QP_, y_guess_->values() + nVar_QP_);
+
+    //qpOASES keeps the equality constraints at their lower bounds
+    guessed_bounds_.init(nVar_QP_);
+    for (int i = 0; i < nVar_QP_; i++)
+        guessed_bounds_.setupBound(i, W_bounds[i] == INACTIVE ? qpOASES::ST_INACTIVE :
+                                   W_bounds[i] == ACTIVE_ABOVE ? qpOASES::ST_UPPER :
+                                   qpOASES::ST_LOWER);
+    guessed_constraints_.init(nConstr_QP_);
+    for (int i = 0; i < nConstr_QP_; i++)
+        guessed_constraints_.setupConstraint(i, W_constr[i] == INACTIVE ?
+                                             qpOASES::ST_INACTIVE :
+                                             W_constr[i] == ACTIVE_ABOVE ?
+                                             qpOASES::ST_UPPER : qpOASES::ST_LOWER);
+    has_warm_start_ = true;
+}
+
+
 /**
  * @brief get the pointer to the multipliers to the bounds constraints.
  */
 double* qpOASESInterface::get_multipliers_bounds() {
-#if NEW_FORMULATION
-    return y_qp_->values()+3*nConstr_QP_;//equals to nVar_QP+nConstr_nlp
-#else
-    return y_qp_->values();
-#endif
-
+    return y_qp_->values() + bound_multipliers_offset_;
 }
 
 
@@ -428,17 +485,35 @@ void qpOASESInterface::set_A(shared_ptr<const SQPhotstart::SpTripletMat> rhs, Id
         data_change_flags_.Update_A = true;
     }
     if(!A_->isinitialized()) {
-        A_->setStructure(rhs, I_info);
+        A_->set_identity_blocks(I_info);
+        A_->setStructure(rhs);
+        A_expanded_ = A_->expanded();
         A_qpOASES_ = std::make_shared<qpOASES::SparseMatrix>(nConstr_QP_,
                      nVar_QP_,
-                     A_->RowIndex(),
-                     A_->ColIndex(),
-                     A_->MatVal());
+                     A_expanded_->RowIndex(),
+                     A_expanded_->ColIndex(),
+                     A_expanded_->MatVal());
     }
     else {
-        A_->setMatVal(rhs, I_info);
-        A_qpOASES_->setVal(A_->MatVal());
+        A_->setMatVal(rhs);
+        A_qpOASES_->setVal(A_->expanded()->MatVal());
+    }
+}
+
+
+void qpOASESInterface::set_A(shared_ptr<const SpTripletMat> rhs, IdentityInfo I_info,
+                             const std::vector<int>& entries) {
+    if (!A_->isinitialized()) {
+        set_A(rhs, I_info);
+        return;
+    }
+    if (firstQPsolved_ && !data_change_flags_.Update_A) {
+        data_change_flags_.Update_A = true;
     }
+    A_->setMatVal(rhs, entries);
+    //A_qpOASES_ refers to the values of the expanded matrix, which are updated in
+    //place, or refreshed here if a full update left them out of date
+    A_->expanded();
 }
 
 
@@ -476,6 +551,34 @@ void qpOASESInterface::set_ubA(shared_ptr<const Vector> rhs) {
 }
 
 
+void qpOASESInterface::set_lb(int location, int length, const double* values) {
+    if (firstQPsolved_ && !data_change_flags_.Update_bounds)
+        data_change_flags_.Update_bounds = true;
+    std::copy(values, values + length, lb_->values() + location);
+}
+
+
+void qpOASESInterface::set_ub(int location, int length, const double* values) {
+    if (firstQPsolved_ && !data_change_flags_.Update_bounds)
+        data_change_flags_.Update_bounds = true;
+    std::copy(values, values + length, ub_->values() + location);
+}
+
+
+void qpOASESInterface::set_lbA(int location, int length, const double* values) {
+    if (firstQPsolved_ && !data_change_flags_.Update_bounds)
+        data_change_flags_.Update_bounds = true;
+    std::copy(values, values + length, lbA_->values() + location);
+}
+
+
+void qpOASESInterface::set_ubA(int location, int length, const double* values) {
+    if (firstQPsolved_ && !data_change_flags_.Update_bounds)
+        data_change_flags_.Update_bounds = true;
+    std::copy(values, values + length, ubA_->values() + location);
+}
+
+
 void qpOASESInterface::set_g(shared_ptr<const Vector> rhs) {
 
     if (firstQPsolved_ && !data_change_flags_.Update_g)
@@ -503,12 +606,12 @@ bool qpOASESInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     double dual_violation = 0.0;
     double compl_violation = 0.0;
     double statioanrity_violation = 0.0;
-    shared_ptr<Vector> Ax = make_shared<Vector>(nConstr_QP_);
+    shared_ptr<Vector> Ax = Ax_work_;
 
 
     if(W_c==NULL&& W_b==NULL) {
-        W_c = new ActiveType[nConstr_QP_];
-        W_b = new ActiveType[nVar_QP_];
+        W_c = W_c_work_.data();
+        W_b = W_b_work_.data();
     }
     get_working_set(W_c,W_b);
 
@@ -584,7 +687,7 @@ bool qpOASESInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     //calculate A'*y+lambda-(g+Hx)
 
 
-    shared_ptr<Vector> stationary_gap = make_shared<Vector>(nVar_QP_);
+    shared_ptr<Vector> stationary_gap = stationary_gap_work_;
 //    A_->print("A");
 //    H_->print("H");
 //    x_qp_->print("x_qp");
@@ -595,7 +698,9 @@ bool qpOASESInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
     if (A_ != nullptr) {
         A_->transposed_times(y_qp_->values()+nVar_QP_, stationary_gap->values());
     }
-    shared_ptr<Vector> Hx = make_shared<Vector>(nVar_QP_);
+    else
+        stationary_gap->set_zeros();
+    shared_ptr<Vector> Hx = Hx_work_;
     H_->times(x_qp_, Hx);
 
     stationary_gap->add_vector(y_qp_->values());
@@ -665,11 +770,6 @@ bool qpOASESInterface::test_optimality(ActiveType* W_c, ActiveType* W_b) {
         compl_violation + statioanrity_violation + dual_violation + primal_violation;
 
 
-    if(W_c==NULL&&W_b==NULL) {
-        delete [] W_c;
-        delete [] W_b;
-    }
-
     if(qpOptimalStatus_.KKT_error>1.0e-6) {
 //        printf("comp_violation %10e\n", compl_violation);
 //        printf("stat_violation %10e\n", statioanrity_violation);
@@ -788,29 +888,23 @@ void qpOASESInterface::set_solver_options() {
 }
 
 
-void qpOASESInterface::WriteQPDataToFile(Ipopt::EJournalLevel level,
-        Ipopt::EJournalCategory category,
-        const string filename) {
-#if DEBUG
-#if PRINT_OUT_QP_WITH_ERROR
-    jnlst_->DeleteAllJournals();
-    Ipopt::SmartPtr<Ipopt::Journal> QPdata_jrnl= jnlst_->AddFileJournal("QPdata",
-            "qpOASES"+filename,Ipopt::J_WARNING);
-    QPdata_jrnl->SetAllPrintLevels(level);
-    QPdata_jrnl->SetPrintLevel(category,level);
-
-    lb_->write_to_file("lb",jnlst_,level,category,QPOASES);
-    lbA_->write_to_file("lbA",jnlst_,level,category,QPOASES);
-    ub_->write_to_file("ub",jnlst_,level,category,QPOASES);
-    ubA_->write_to_file("ubA",jnlst_,level,category,QPOASES);
-
-    g_->write_to_file("g",jnlst_,level,category,QPOASES);
-    A_->write_to_file("A",jnlst_,level,category,QPOASES);
-    H_->write_to_file("H",jnlst_,level,category,QPOASES);
-    jnlst_->DeleteAllJournals();
-#endif
-#endif
+void qpOASESInterface::WriteQPSnapshot(const string filename) {
+    //the working set is only defined once qpOASES has been run on the QP
+    vector<ActiveType> W_bounds(nVar_QP_);
+    vector<ActiveType> W_constr(nConstr_QP_);
+    bool has_working_set = true;
+    try {
+        get_working_set(W_constr.data(), W_bounds.data());
+    }
+    catch (INVALID_WORKING_SET &) {
+        has_working_set = false;
+    }
 
+    QPSnapshot::write(filename, H_ != nullptr ? QP : LP, QPOASES, get_status(),
+                      options_, H_, A_expanded_, g_->values(), lb_->values(),
+                      ub_->values(), lbA_->values(), ubA_->values(),
+                      has_working_set ? W_bounds.data() : NULL,
+                      has_working_set ? W_constr.data() : NULL);
 }
 
 
@@ -834,8 +928,8 @@ void qpOASESInterface::get_Matrix_change_status() {
 
 void qpOASESInterface::get_working_set(SQPhotstart::ActiveType* W_constr,
                                        SQPhotstart::ActiveType* W_bounds) {
-    int* tmp_W_c = new int[nConstr_QP_];
-    int* tmp_W_b = new int[nVar_QP_];
+    int* tmp_W_b = W_solver_work_.data();
+    int* tmp_W_c = W_solver_work_.data() + nVar_QP_;
 
 
     assert(nConstr_QP_==solver_->getNC());
@@ -866,7 +960,7 @@ void qpOASESInterface::get_working_set(SQPhotstart::ActiveType* W_constr,
             THROW_EXCEPTION(INVALID_WORKING_SET,INVALID_WORKING_SET_MSG);
         }
     }
-    auto Ax = make_shared<Vector>(nConstr_QP_);
+    shared_ptr<Vector> Ax = Ax_work_;
     A_->times(x_qp_, Ax); //tmp_vec_nCon=A*x
     for (int i = 0; i < nConstr_QP_; i++) {
         switch((int)tmp_W_c[i]) {
@@ -890,8 +984,6 @@ void qpOASESInterface::get_working_set(SQPhotstart::ActiveType* W_constr,
             THROW_EXCEPTION(INVALID_WORKING_SET,INVALID_WORKING_SET_MSG);
         }
     }
-    delete[] tmp_W_b;
-    delete[] tmp_W_c;
 }
 
 void qpOASESInterface::reset_constraints() {
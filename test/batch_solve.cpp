@@ -0,0 +1,377 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Solves a list of .nl problems concurrently and writes one results table, in
+ * place of running simple_test once per problem from a shell script.
+ *
+ * usage: batch_solve <problem list> [-j jobs] [-t time limit] [-o results file]
+ *                    [-w work directory]
+ *
+ *  problem list    one problem per line, e.g. test/CUTE_examples/Plist.cute_all_nopres;
+ *                  relative names are looked up next to the list, and ".nl" is
+ *                  appended if needed. Empty lines and lines starting with # are
+ *                  skipped.
+ *  -j              the number of problems solved at the same time (default: the
+ *                  number of hardware threads)
+ *  -t              the time limit of each problem in seconds (default: 3600). It
+ *                  is passed to the Algorithm as time_max, and a problem still
+ *                  running after 1.1*limit+5 seconds is killed.
+ *  -o              the results table (default: batch_result_table)
+ *  -w              each problem runs in <work directory>/<name>, where its console
+ *                  output (stdout.log), its log files and the snapshots of its
+ *                  failed QPs are written (default: batch_logs)
+ *
+ * ASL, which reads and evaluates the .nl files, keeps global state and is not
+ * reentrant, so the problems cannot share one address space. Every problem is
+ * solved in a process forked from the driver (which costs no exec or dynamic
+ * loading), and the driver keeps -j of them busy, handing out the largest .nl
+ * files first so that no long problem is left to run alone at the end. A crash
+ * or a runaway problem only takes its own process down.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <sqphot/Algorithm.hpp>
+#include <AmplTNLP.hpp>
+
+using namespace Ipopt;
+using namespace SQPhotstart;
+
+typedef std::chrono::steady_clock Clock;
+
+
+/** a problem of the list, and its line in the results table once solved*/
+struct Instance {
+    std::string name;
+    std::string path;
+    off_t size;
+    std::string row;
+    double time;
+};
+
+
+/** a problem being solved by a child process*/
+struct Running {
+    int index;
+    pid_t pid;
+    int fd;               /**< the read end of the pipe the row is sent through*/
+    Clock::time_point start;
+    bool is_killed;
+};
+
+
+inline bool exist(const std::string &name) {
+    struct stat buffer;
+    return (stat(name.c_str(), &buffer) == 0);
+}
+
+
+std::string table_header() {
+    char header[512];
+    snprintf(header, sizeof(header), "%10s   %10s    %10s    %10s    %10s    %10s    "
+             "%23s    %23s    %23s    %23s    %23s    %23s    %10s\n", "name", "nVar",
+             "nConstr", "iter", "QP_iter", "exitflag", "objective", "||p||",
+             "primal_violation", "dual_violation", "stationarity_violation",
+             "compl_violation", "time");
+    return header;
+}
+
+
+/**
+ * @brief the row of the results table for a problem, without the time column,
+ * in the format of simple_test
+ */
+std::string table_row(const std::string &name, Algorithm &alg) {
+    OptimalityStatus opt_status = alg.get_opt_status();
+    shared_ptr<Stats> stats = alg.get_stats();
+    char row[512];
+    snprintf(row, sizeof(row), "%10s   %10d    %10d    %10d    %10d    %10d    "
+             "%23.16e    %23.16e    %23.16e    %23.16e    %23.16e    %23.16e",
+             name.c_str(), alg.get_num_var(), alg.get_num_constr(), stats->iter,
+             stats->qp_iter, alg.get_exit_flag(), alg.get_final_objective(),
+             alg.get_norm_p(), opt_status.primal_violation, opt_status.dual_violation,
+             opt_status.stationarity_violation, opt_status.compl_violation);
+    return row;
+}
+
+
+/** @brief the row of a problem which did not return any result*/
+std::string failed_row(const std::string &name, Exitflag exitflag) {
+    char row[512];
+    snprintf(row, sizeof(row), "%10s   %10s    %10s    %10s    %10s    %10d    "
+             "%23s    %23s    %23s    %23s    %23s    %23s", name.c_str(), "-", "-",
+             "-", "-", exitflag, "nan", "nan", "nan", "nan", "nan", "nan");
+    return row;
+}
+
+
+/**
+ * @brief read the problem list, and resolve the names to the .nl files
+ */
+bool read_problem_list(const std::string &list_name, std::vector<Instance> &instances) {
+    FILE* list = fopen(list_name.c_str(), "r");
+    if (list == NULL) {
+        perror(list_name.c_str());
+        return false;
+    }
+    std::size_t found = list_name.find_last_of("/\\");
+    std::string directory = found == std::string::npos ? "." :
+                            list_name.substr(0, found);
+
+    char buffer[4096];
+    bool is_valid = true;
+    while (fgets(buffer, sizeof(buffer), list) != NULL) {
+        std::string line(buffer);
+        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::string path = line[0] == '/' ? line : directory + "/" + line;
+        if (!exist(path) && exist(path + ".nl"))
+            path += ".nl";
+        char resolved[PATH_MAX];
+        struct stat file_stat;
+        if (realpath(path.c_str(), resolved) == NULL ||
+                stat(resolved, &file_stat) != 0) {
+            printf("cannot find the problem %s\n", line.c_str());
+            is_valid = false;
+            continue;
+        }
+
+        Instance instance;
+        instance.path = resolved;
+        std::size_t begin = line.find_last_of("/\\");
+        instance.name = begin == std::string::npos ? line : line.substr(begin + 1);
+        if (instance.name.size() > 3 &&
+                instance.name.compare(instance.name.size() - 3, 3, ".nl") == 0)
+            instance.name.erase(instance.name.size() - 3);
+        instance.size = file_stat.st_size;
+        instance.time = 0.0;
+        instances.push_back(instance);
+    }
+    fclose(list);
+    return is_valid;
+}
+
+
+/**
+ * @brief solve a problem in the child process, and send its row through fd
+ */
+void solve_in_child(const Instance &instance, const std::string &work_directory,
+                    double time_limit, int fd) {
+    std::string directory = work_directory + "/" + instance.name;
+    mkdir(directory.c_str(), 0755);
+    if (chdir(directory.c_str()) != 0)
+        _exit(2);
+    int log = open("stdout.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+    }
+
+    std::string row;
+    try {
+        Algorithm alg;
+        alg.get_options()->time_max = time_limit;
+        char program[] = "batch_solve";
+        std::vector<char> path(instance.path.begin(), instance.path.end());
+        path.push_back('\0');
+        char* args_array[] = {program, path.data(), NULL};
+        char** args = args_array;
+        SmartPtr<TNLP> ampl_tnlp = new AmplTNLP(ConstPtr(alg.getJnlst()),
+                                                alg.getRoptions2(), args);
+        alg.initialization(ampl_tnlp, instance.name);
+        alg.Optimize();
+        row = table_row(instance.name, alg);
+    }
+    catch (...) {
+        row = failed_row(instance.name, UNKNOWN);
+    }
+    fflush(stdout);
+
+    const char* data = row.c_str();
+    size_t length = row.size();
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0)
+            _exit(1);
+        data += written;
+        length -= written;
+    }
+    _exit(0);
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("usage: %s <problem list> [-j jobs] [-t time limit] "
+               "[-o results file] [-w work directory]\n", argv[0]);
+        return 1;
+    }
+    std::string list_name = argv[1];
+    int jobs = std::max(1, (int) std::thread::hardware_concurrency());
+    double time_limit = 3600;
+    std::string result_name = "batch_result_table";
+    std::string work_directory = "batch_logs";
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-j") == 0)
+            jobs = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "-t") == 0)
+            time_limit = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-o") == 0)
+            result_name = argv[i + 1];
+        else if (strcmp(argv[i], "-w") == 0)
+            work_directory = argv[i + 1];
+        else {
+            printf("unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<Instance> instances;
+    if (!read_problem_list(list_name, instances))
+        return 1;
+    mkdir(work_directory.c_str(), 0755);
+    char resolved[PATH_MAX];
+    if (realpath(work_directory.c_str(), resolved) == NULL) {
+        perror(work_directory.c_str());
+        return 1;
+    }
+    work_directory = resolved;
+    //a child's pipe breaking must not take the driver down
+    signal(SIGPIPE, SIG_IGN);
+
+    //the largest problems first, so that they do not delay the end of the batch
+    std::vector<int> order(instances.size());
+    for (int i = 0; i < (int) order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return instances[a].size > instances[b].size;
+    });
+    std::chrono::duration<double> kill_after(1.1 * time_limit + 5.0);
+
+    printf("Solving %d problems with %d jobs\n", (int) instances.size(), jobs);
+    fflush(stdout);
+    Clock::time_point batch_start = Clock::now();
+    std::vector<Running> running;
+    std::vector<std::string> buffers(instances.size());
+    int next = 0;
+    int num_done = 0;
+    while (next < (int) order.size() || !running.empty()) {
+        while ((int) running.size() < jobs && next < (int) order.size()) {
+            int index = order[next++];
+            int pipe_fds[2];
+            if (pipe(pipe_fds) != 0) {
+                perror("pipe");
+                return 1;
+            }
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (pid == 0) {
+                close(pipe_fds[0]);
+                for (const Running &other : running)
+                    close(other.fd);
+                solve_in_child(instances[index], work_directory, time_limit,
+                               pipe_fds[1]);
+            }
+            close(pipe_fds[1]);
+            running.push_back({index, pid, pipe_fds[0], Clock::now(), false});
+        }
+
+        //wait for output, a child to finish, or the next deadline
+        Clock::time_point now = Clock::now();
+        double timeout = kill_after.count();
+        std::vector<pollfd> fds(running.size());
+        for (int r = 0; r < (int) running.size(); r++) {
+            fds[r].fd = running[r].fd;
+            fds[r].events = POLLIN;
+            std::chrono::duration<double> elapsed = now - running[r].start;
+            if (!running[r].is_killed)
+                timeout = std::min(timeout, kill_after.count() - elapsed.count());
+        }
+        poll(fds.data(), fds.size(), (int) (std::max(0.0, timeout) * 1000) + 1);
+
+        now = Clock::now();
+        for (int r = (int) running.size() - 1; r >= 0; r--) {
+            Running &job = running[r];
+            Instance &instance = instances[job.index];
+            bool is_finished = false;
+            if (fds[r].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[512];
+                ssize_t length = read(job.fd, buffer, sizeof(buffer));
+                if (length > 0)
+                    buffers[job.index].append(buffer, length);
+                else if (length == 0 || errno != EINTR)
+                    is_finished = true;
+            }
+            if (!is_finished) {
+                if (!job.is_killed && now - job.start > kill_after) {
+                    kill(job.pid, SIGKILL);
+                    job.is_killed = true;
+                }
+                continue;
+            }
+
+            close(job.fd);
+            int status = 0;
+            waitpid(job.pid, &status, 0);
+            instance.time = std::chrono::duration<double>(now - job.start).count();
+            if (job.is_killed)
+                instance.row = failed_row(instance.name, EXCEED_TIME_LIMITS);
+            else if (buffers[job.index].empty())
+                //the child crashed before sending its row
+                instance.row = failed_row(instance.name, UNKNOWN);
+            else
+                instance.row = buffers[job.index];
+            num_done++;
+            printf("[%*d/%d] %-12s %8.2fs%s\n", (int) std::to_string(
+                       instances.size()).size(), num_done, (int) instances.size(),
+                   instance.name.c_str(), instance.time,
+                   job.is_killed ? "  killed after the time limit" :
+                   WIFSIGNALED(status) ? "  crashed" : "");
+            fflush(stdout);
+            running.erase(running.begin() + r);
+        }
+    }
+    std::chrono::duration<double> batch_time = Clock::now() - batch_start;
+
+    //the rows are written in the order of the list
+    FILE* result = fopen(result_name.c_str(), "w");
+    if (result == NULL) {
+        perror(result_name.c_str());
+        return 1;
+    }
+    fprintf(result, "%s", table_header().c_str());
+    for (const Instance &instance : instances)
+        fprintf(result, "%s    %10.2f\n", instance.row.c_str(), instance.time);
+    fclose(result);
+    printf("Solved %d problems in %.2fs, results written to %s\n",
+           (int) instances.size(), batch_time.count(), result_name.c_str());
+    return 0;
+}
@@ -0,0 +1,207 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Benchmark of the QP solver backends on a sequence of small QPs with the
+ * structure of the SL1QP subproblems,
+ *
+ *      minimize    1/2 p^T H p + g^T p + rho e^T (u + v)
+ *      subject to  c_l <= J p + u - v <= c_u,
+ *                  -delta <= p <= delta,  u, v >= 0,
+ *
+ * where J and H are random and dense, and g, c_l and c_u change slightly from one
+ * QP to the next, as they do between SQP iterations. Each backend (the dense
+ * solver, qpOASES and QORE) solves every QP of the sequence with a new interface
+ * (cold) and with a single interface reused along the sequence (hot), and the
+ * number of solves per second is reported.
+ *
+ * usage: benchmark_DenseQP [nVar] [nCon] [number_of_QPs]
+ */
+#include <sqphot/DenseQPInterface.hpp>
+#include <sqphot/qpOASESInterface.hpp>
+#include <sqphot/QOREInterface.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SQPhotstart;
+
+
+shared_ptr<SpHbMat> to_SpHbMat(const vector<double> &dense, int rowNum, int colNum,
+                               bool isCompressedRow) {
+    auto triplet = make_shared<SpTripletMat>(dense.data(), rowNum, colNum, true);
+    auto result = make_shared<SpHbMat>(rowNum, colNum, isCompressedRow);
+    result->setStructure(triplet);
+    result->setMatVal(triplet);
+    return result;
+}
+
+
+/** the data of the QPs of the sequence, in the layouts of both qpOASES and QORE*/
+struct QPSequence {
+    int nVar;
+    int nConstr;
+    shared_ptr<SpHbMat> H_csc, H_csr, A_csc, A_csr;
+    vector<vector<double> > g, lbA, ubA;
+    vector<double> lb, ub;
+
+    /** the vectors handed to the interfaces, loaded with one QP at a time*/
+    shared_ptr<Vector> g_qp, lb_qp, ub_qp, lbA_qp, ubA_qp, lb_qore, ub_qore;
+
+    QPSequence(int nx, int nCon, int length) :
+        nVar(nx + 2 * nCon),
+        nConstr(nCon),
+        g(length),
+        lbA(length),
+        ubA(length),
+        lb(nVar),
+        ub(nVar) {
+        std::mt19937 random(2019);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+        vector<double> B(nx * nx), H(nVar * nVar, 0.0), A(nCon * nVar, 0.0);
+        for (double &b : B)
+            b = uniform(random);
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < nx; j++) {
+                for (int k = 0; k < nx; k++)
+                    H[i * nVar + j] += B[k * nx + i] * B[k * nx + j];
+                H[i * nVar + j] += i == j ? 0.1 : 0.0;
+            }
+        for (int i = 0; i < nCon; i++) {
+            for (int j = 0; j < nx; j++)
+                A[i * nVar + j] = uniform(random) > 0 ? 5 * uniform(random) : 0.0;
+            A[i * nVar + nx + i] = 1.0;
+            A[i * nVar + nx + nCon + i] = -1.0;
+        }
+        H_csc = to_SpHbMat(H, nVar, nVar, false);
+        H_csr = to_SpHbMat(H, nVar, nVar, true);
+        A_csc = to_SpHbMat(A, nCon, nVar, false);
+        A_csr = to_SpHbMat(A, nCon, nVar, true);
+
+        for (int j = 0; j < nVar; j++) {
+            lb[j] = j < nx ? -1.0 : 0.0;
+            ub[j] = j < nx ? 1.0 : INF;
+        }
+        vector<double> g0(nVar), c0(nCon);
+        for (int j = 0; j < nVar; j++)
+            g0[j] = j < nx ? 10 * uniform(random) : 100.0;
+        for (int i = 0; i < nCon; i++)
+            c0[i] = 5 * uniform(random);
+        for (int k = 0; k < length; k++) {
+            g[k] = g0;
+            lbA[k] = ubA[k] = c0;
+            for (int j = 0; j < nx; j++)
+                g[k][j] += 0.1 * uniform(random);
+            for (int i = 0; i < nCon; i++) {
+                lbA[k][i] += 0.1 * uniform(random);
+                ubA[k][i] = i % 2 == 0 ? lbA[k][i] : INF;
+            }
+        }
+
+        g_qp = make_shared<Vector>(nVar);
+        lb_qp = make_shared<Vector>(nVar, lb.data());
+        ub_qp = make_shared<Vector>(nVar, ub.data());
+        lbA_qp = make_shared<Vector>(nCon);
+        ubA_qp = make_shared<Vector>(nCon);
+        lb_qore = make_shared<Vector>(nVar + nCon);
+        ub_qore = make_shared<Vector>(nVar + nCon);
+        std::copy(lb.begin(), lb.end(), lb_qore->values());
+        std::copy(ub.begin(), ub.end(), ub_qore->values());
+    }
+
+    void load(int k) {
+        g_qp->copy_vector(g[k].data());
+        lbA_qp->copy_vector(lbA[k].data());
+        ubA_qp->copy_vector(ubA[k].data());
+        std::copy(lbA[k].begin(), lbA[k].end(), lb_qore->values() + nVar);
+        std::copy(ubA[k].begin(), ubA[k].end(), ub_qore->values() + nVar);
+    }
+
+    shared_ptr<QPSolverInterface> make_interface(Solver solver,
+            shared_ptr<Options> options) {
+        switch (solver) {
+        case QPOASES:
+            return make_shared<qpOASESInterface>(H_csc, A_csc, g_qp, lb_qp, ub_qp,
+                                                 lbA_qp, ubA_qp, options);
+        case QORE:
+            return make_shared<QOREInterface>(H_csr, A_csr, g_qp, lb_qore, ub_qore,
+                                              options);
+        default:
+            return make_shared<DenseQPInterface>(H_csr, A_csr, g_qp, lb_qp, ub_qp,
+                                                 lbA_qp, ubA_qp, options);
+        }
+    }
+};
+
+
+struct ThroughputSummary {
+    double total = 0;
+    int optimal = 0;
+    shared_ptr<Stats> stats = make_shared<Stats>();
+
+    void print(const char* name, const char* mode, int n) const {
+        fprintf(stderr, "%-8s %-5s %14.1f %14.3f %10.2f %8d/%d\n", name, mode,
+                n / total, total * 1e3 / n, (double) stats->qp_iter / n, optimal, n);
+    }
+};
+
+
+/**
+ * @brief solve the sequence with a new interface for every QP (hot == false) or
+ * with a single interface
+ */
+ThroughputSummary run(QPSequence &sequence, Solver solver, bool hot, int n,
+                      shared_ptr<Options> options) {
+    ThroughputSummary summary;
+    shared_ptr<QPSolverInterface> interface;
+    vector<ActiveType> W_bounds(sequence.nVar), W_constr(sequence.nConstr);
+    for (int k = 0; k < n; k++) {
+        sequence.load(k);
+        auto start = std::chrono::steady_clock::now();
+        bool is_solved = true;
+        try {
+            if (!hot || k == 0)
+                interface = sequence.make_interface(solver, options);
+            interface->optimizeQP(summary.stats);
+        }
+        catch (...) {
+            is_solved = false;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        summary.total += elapsed.count();
+        if (is_solved && interface->test_optimality(W_constr.data(), W_bounds.data()))
+            summary.optimal++;
+    }
+    return summary;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    int nx = argc > 1 ? atoi(argv[1]) : 20;
+    int nCon = argc > 2 ? atoi(argv[2]) : 10;
+    int n = argc > 3 ? atoi(argv[3]) : 1000;
+
+    QPSequence sequence(nx, nCon, n);
+    auto options = make_shared<Options>();
+
+    fprintf(stderr, "\n=========================================================\n");
+    fprintf(stderr, "    Benchmark for the QP solvers, %d QPs with %d variables\n"
+            "    and %d constraints\n", n, sequence.nVar, sequence.nConstr);
+    fprintf(stderr, "=========================================================\n");
+    fprintf(stderr, "%-8s %-5s %14s %14s %10s %10s\n", "", "", "solves/s",
+            "mean (ms)", "qp_iter", "optimal");
+    const Solver solvers[3] = {DENSE, QPOASES, QORE};
+    const char* names[3] = {"dense", "qpOASES", "QORE"};
+    for (int s = 0; s < 3; s++) {
+        run(sequence, solvers[s], false, n, options).print(names[s], "cold", n);
+        run(sequence, solvers[s], true, n, options).print(names[s], "hot", n);
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-11
+ */
+
+/**
+ * Benchmark of KKTSolver against QORE on a sequence of equality-constrained QPs
+ *
+ *      minimize    1/2 x^T H x + g^T x
+ *      subject to  A x = b,
+ *
+ * with H and A random and sparse, and g and b changing slightly from one QP to the
+ * next. The solution of each QP is that of the KKT system [H A^T; A 0], which
+ * KKTSolver solves with each of its linear solvers, both factorizing K again for
+ * every QP (factor) and reusing its factorization (solve). QORE solves the same
+ * QPs with a single interface, hot-started along the sequence. The number of
+ * solves per second and the largest difference with the solutions of QORE are
+ * reported.
+ *
+ * usage: benchmark_KKTSolver [nVar] [nCon] [number_of_QPs]
+ */
+#include <sqphot/KKTSolver.hpp>
+#include <sqphot/QOREInterface.hpp>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SQPhotstart;
+
+
+/** the data of the QPs of the sequence, as triplets and in the layout of QORE*/
+struct QPSequence {
+    int nVar;
+    int nConstr;
+    shared_ptr<SpTripletMat> H, A;
+    shared_ptr<SpHbMat> H_csr, A_csr;
+    vector<vector<double> > g, b;
+
+    /** the vectors handed to QORE, loaded with one QP at a time*/
+    shared_ptr<Vector> g_qp, lb_qore, ub_qore;
+
+    QPSequence(int nVar, int nCon, int length) :
+        nVar(nVar),
+        nConstr(nCon),
+        g(length),
+        b(length) {
+        std::mt19937 random(2019);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+        //H is diagonally dominant and A has a nonzero diagonal, with about five
+        //other entries in each row
+        double density = std::min(1.0, 5.0 / nVar);
+        vector<double> H_dense(nVar * nVar, 0.0), A_dense(nCon * nVar, 0.0);
+        for (int i = 0; i < nVar; i++)
+            for (int j = 0; j < i; j++)
+                if ((uniform(random) + 1) / 2 < density) {
+                    double h = uniform(random);
+                    H_dense[i * nVar + j] = H_dense[j * nVar + i] = h;
+                    H_dense[i * nVar + i] += fabs(h);
+                    H_dense[j * nVar + j] += fabs(h);
+                }
+        for (int i = 0; i < nVar; i++)
+            H_dense[i * nVar + i] += 1.0;
+        for (int i = 0; i < nCon; i++) {
+            for (int j = 0; j < nVar; j++)
+                if ((uniform(random) + 1) / 2 < density)
+                    A_dense[i * nVar + j] = uniform(random);
+            A_dense[i * nVar + i % nVar] = 5.0;
+        }
+        H = make_shared<SpTripletMat>(H_dense.data(), nVar, nVar, true);
+        A = make_shared<SpTripletMat>(A_dense.data(), nCon, nVar, true);
+        H_csr = make_shared<SpHbMat>(nVar, nVar, true);
+        H_csr->setStructure(H);
+        H_csr->setMatVal(H);
+        A_csr = make_shared<SpHbMat>(nCon, nVar, true);
+        A_csr->setStructure(A);
+        A_csr->setMatVal(A);
+
+        vector<double> g0(nVar), b0(nCon);
+        for (int j = 0; j < nVar; j++)
+            g0[j] = 10 * uniform(random);
+        for (int i = 0; i < nCon; i++)
+            b0[i] = 5 * uniform(random);
+        for (int k = 0; k < length; k++) {
+            g[k] = g0;
+            b[k] = b0;
+            for (int j = 0; j < nVar; j++)
+                g[k][j] += 0.1 * uniform(random);
+            for (int i = 0; i < nCon; i++)
+                b[k][i] += 0.1 * uniform(random);
+        }
+
+        g_qp = make_shared<Vector>(nVar);
+        lb_qore = make_shared<Vector>(nVar + nCon);
+        ub_qore = make_shared<Vector>(nVar + nCon);
+        for (int j = 0; j < nVar; j++) {
+            lb_qore->values()[j] = -INF;
+            ub_qore->values()[j] = INF;
+        }
+    }
+
+    void load(int k) {
+        g_qp->copy_vector(g[k].data());
+        std::copy(b[k].begin(), b[k].end(), lb_qore->values() + nVar);
+        std::copy(b[k].begin(), b[k].end(), ub_qore->values() + nVar);
+    }
+
+    /** @brief the right-hand side [-g; b] of the KKT system of QP k*/
+    void kkt_rhs(int k, double* rhs) const {
+        for (int j = 0; j < nVar; j++)
+            rhs[j] = -g[k][j];
+        std::copy(b[k].begin(), b[k].end(), rhs + nVar);
+    }
+};
+
+
+struct Summary {
+    double total = 0;
+    int solved = 0;
+    double max_diff = 0;   /**< the largest |x - x_QORE| over the sequence*/
+
+    void print(const char* name, const char* mode, int n) const {
+        if (solved == 0) {
+            fprintf(stderr, "%-8s %-6s %14s\n", name, mode, "not available");
+            return;
+        }
+        fprintf(stderr, "%-8s %-6s %14.1f %14.3f %12.2e %8d/%d\n", name, mode,
+                n / total, total * 1e3 / n, max_diff, solved, n);
+    }
+};
+
+
+/** @brief solve the sequence with QORE, and keep its solutions*/
+Summary run_qore(QPSequence &sequence, int n, shared_ptr<Options> options,
+                 vector<vector<double> > &x_qore) {
+    Summary summary;
+    auto stats = make_shared<Stats>();
+    shared_ptr<QOREInterface> interface;
+    x_qore.assign(n, vector<double>(sequence.nVar, NAN));
+    for (int k = 0; k < n; k++) {
+        sequence.load(k);
+        auto start = std::chrono::steady_clock::now();
+        try {
+            if (k == 0)
+                interface = make_shared<QOREInterface>(sequence.H_csr, sequence.A_csr,
+                                                       sequence.g_qp, sequence.lb_qore,
+                                                       sequence.ub_qore, options);
+            interface->optimizeQP(stats);
+        }
+        catch (...) {
+            continue;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        summary.total += elapsed.count();
+        if (interface->get_status() == QP_OPTIMAL) {
+            summary.solved++;
+            std::copy(interface->get_optimal_solution(),
+                      interface->get_optimal_solution() + sequence.nVar,
+                      x_qore[k].begin());
+        }
+    }
+    return summary;
+}
+
+
+/**
+ * @brief solve the sequence with KKTSolver, factorizing K for each QP if refactor
+ * is true and once otherwise
+ */
+Summary run_kkt(const QPSequence &sequence, LinearSolver linear_solver,
+                bool refactor, int n, const vector<vector<double> > &x_qore) {
+    Summary summary;
+    vector<double> rhs(sequence.nVar + sequence.nConstr);
+    try {
+        KKTSolver solver(linear_solver, 0);
+        solver.set_structure(sequence.nVar, sequence.nConstr, sequence.H, sequence.A);
+        solver.set_values(sequence.H, sequence.A);
+        for (int k = 0; k < n; k++) {
+            sequence.kkt_rhs(k, rhs.data());
+            auto start = std::chrono::steady_clock::now();
+            if (refactor)
+                solver.set_values(sequence.H, sequence.A);
+            bool is_solved = solver.solve(rhs.data());
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            summary.total += elapsed.count();
+            if (!is_solved)
+                continue;
+            summary.solved++;
+            for (int j = 0; j < sequence.nVar; j++)
+                if (!std::isnan(x_qore[k][j]))
+                    summary.max_diff = std::max(summary.max_diff,
+                                                fabs(rhs[j] - x_qore[k][j]));
+        }
+    }
+    catch (...) {
+        summary.solved = 0;
+    }
+    return summary;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    int nVar = argc > 1 ? atoi(argv[1]) : 500;
+    int nCon = argc > 2 ? atoi(argv[2]) : 200;
+    int n = argc > 3 ? atoi(argv[3]) : 100;
+
+    QPSequence sequence(nVar, nCon, n);
+    auto options = make_shared<Options>();
+
+    fprintf(stderr, "\n=========================================================\n");
+    fprintf(stderr, "    Benchmark for KKTSolver, %d QPs with %d variables\n"
+            "    and %d equality constraints\n", n, sequence.nVar, sequence.nConstr);
+    fprintf(stderr, "=========================================================\n");
+    fprintf(stderr, "%-8s %-6s %14s %14s %12s %10s\n", "", "", "solves/s",
+            "mean (ms)", "max |dx|", "solved");
+    vector<vector<double> > x_qore;
+    run_qore(sequence, n, options, x_qore).print("QORE", "hot", n);
+    const LinearSolver solvers[3] = {DENSE_LDL, MA27, MUMPS};
+    const char* names[3] = {"dense", "MA27", "MUMPS"};
+    for (int s = 0; s < 3; s++) {
+        run_kkt(sequence, solvers[s], true, n, x_qore).print(names[s], "factor", n);
+        run_kkt(sequence, solvers[s], false, n, x_qore).print(names[s], "solve", n);
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Benchmark for Algorithm::ReOptimize on a sequence of parametric NLPs.
+ *
+ * Each instance is the problem hs071 whose constraint bounds are perturbed by a
+ * parameter t,
+ *
+ *      minimize    x1*x4*(x1+x2+x3) + x3
+ *      subject to  x1*x2*x3*x4 >= 25 + t
+ *                  x1^2+x2^2+x3^2+x4^2 = 40 + t
+ *                  1 <= x1,x2,x3,x4 <= 5
+ *
+ * The sequence is solved once from scratch for every instance (cold) and once by
+ * calling ReOptimize on a single Algorithm object (hot), and the per-solve latency
+ * of both is reported.
+ *
+ * usage: benchmark_ReOptimize [number_of_instances] > /dev/null
+ * (the summary is written to stderr)
+ */
+#include <sqphot/Algorithm.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SQPhotstart;
+using namespace Ipopt;
+
+
+class ParametricHS071 : public TNLP {
+public:
+    explicit ParametricHS071(double t) : t_(t) {}
+
+    bool get_nlp_info(Index& n, Index& m, Index& nnz_jac_g, Index& nnz_h_lag,
+                      IndexStyleEnum& index_style) override {
+        n = 4;
+        m = 2;
+        nnz_jac_g = 8;
+        nnz_h_lag = 10;
+        index_style = FORTRAN_STYLE;
+        return true;
+    }
+
+    bool get_bounds_info(Index n, Number* x_l, Number* x_u, Index m, Number* g_l,
+                         Number* g_u) override {
+        for (Index i = 0; i < n; i++) {
+            x_l[i] = 1.0;
+            x_u[i] = 5.0;
+        }
+        g_l[0] = 25.0 + t_;
+        g_u[0] = 2.0e19;
+        g_l[1] = g_u[1] = 40.0 + t_;
+        return true;
+    }
+
+    bool get_starting_point(Index n, bool init_x, Number* x, bool init_z,
+                            Number* z_L, Number* z_U, Index m, bool init_lambda,
+                            Number* lambda) override {
+        x[0] = 1.0;
+        x[1] = 5.0;
+        x[2] = 5.0;
+        x[3] = 1.0;
+        if (init_lambda)
+            for (Index i = 0; i < m; i++)
+                lambda[i] = 0.0;
+        return true;
+    }
+
+    bool eval_f(Index n, const Number* x, bool new_x, Number& obj_value) override {
+        obj_value = x[0] * x[3] * (x[0] + x[1] + x[2]) + x[2];
+        return true;
+    }
+
+    bool eval_grad_f(Index n, const Number* x, bool new_x, Number* grad_f) override {
+        grad_f[0] = x[0] * x[3] + x[3] * (x[0] + x[1] + x[2]);
+        grad_f[1] = x[0] * x[3];
+        grad_f[2] = x[0] * x[3] + 1;
+        grad_f[3] = x[0] * (x[0] + x[1] + x[2]);
+        return true;
+    }
+
+    bool eval_g(Index n, const Number* x, bool new_x, Index m, Number* g) override {
+        g[0] = x[0] * x[1] * x[2] * x[3];
+        g[1] = x[0] * x[0] + x[1] * x[1] + x[2] * x[2] + x[3] * x[3];
+        return true;
+    }
+
+    bool eval_jac_g(Index n, const Number* x, bool new_x, Index m, Index nele_jac,
+                    Index* iRow, Index* jCol, Number* values) override {
+        if (values == NULL) {
+            for (Index k = 0; k < 8; k++) {
+                iRow[k] = k / 4 + 1;
+                jCol[k] = k % 4 + 1;
+            }
+        } else {
+            values[0] = x[1] * x[2] * x[3];
+            values[1] = x[0] * x[2] * x[3];
+            values[2] = x[0] * x[1] * x[3];
+            values[3] = x[0] * x[1] * x[2];
+            for (Index i = 0; i < 4; i++)
+                values[4 + i] = 2 * x[i];
+        }
+        return true;
+    }
+
+    bool eval_h(Index n, const Number* x, bool new_x, Number obj_factor, Index m,
+                const Number* lambda, bool new_lambda, Index nele_hess, Index* iRow,
+                Index* jCol, Number* values) override {
+        if (values == NULL) {
+            //the lower triangle
+            Index idx = 0;
+            for (Index row = 0; row < 4; row++) {
+                for (Index col = 0; col <= row; col++) {
+                    iRow[idx] = row + 1;
+                    jCol[idx] = col + 1;
+                    idx++;
+                }
+            }
+        } else {
+            values[0] = obj_factor * (2 * x[3]);
+            values[1] = obj_factor * (x[3]);
+            values[2] = 0.;
+            values[3] = obj_factor * (x[3]);
+            values[4] = 0.;
+            values[5] = 0.;
+            values[6] = obj_factor * (2 * x[0] + x[1] + x[2]);
+            values[7] = obj_factor * (x[0]);
+            values[8] = obj_factor * (x[0]);
+            values[9] = 0.;
+
+            values[1] += lambda[0] * (x[2] * x[3]);
+            values[3] += lambda[0] * (x[1] * x[3]);
+            values[4] += lambda[0] * (x[0] * x[3]);
+            values[6] += lambda[0] * (x[1] * x[2]);
+            values[7] += lambda[0] * (x[0] * x[2]);
+            values[8] += lambda[0] * (x[0] * x[1]);
+
+            values[0] += lambda[1] * 2;
+            values[2] += lambda[1] * 2;
+            values[5] += lambda[1] * 2;
+            values[9] += lambda[1] * 2;
+        }
+        return true;
+    }
+
+    void finalize_solution(SolverReturn status, Index n, const Number* x,
+                           const Number* z_L, const Number* z_U, Index m,
+                           const Number* g, const Number* lambda, Number obj_value,
+                           const IpoptData* ip_data,
+                           IpoptCalculatedQuantities* ip_cq) override {}
+
+private:
+    double t_;
+};
+
+
+struct LatencySummary {
+    double total = 0;
+    double max = 0;
+    int iter = 0;
+    int qp_iter = 0;
+    int optimal = 0;
+
+    void add(double elapsed, shared_ptr<const Stats> stats, Exitflag exitflag) {
+        total += elapsed;
+        max = std::max(max, elapsed);
+        iter += stats->iter;
+        qp_iter += stats->qp_iter;
+        if (exitflag == OPTIMAL)
+            optimal++;
+    }
+
+    void print(const char* name, int n) const {
+        fprintf(stderr, "%-6s %14.3f %14.3f %10.2f %10.2f %8d/%d\n", name,
+                total * 1e3 / n, max * 1e3, (double) iter / n, (double) qp_iter / n,
+                optimal, n);
+    }
+};
+
+
+int main(int argc, char* argv[]) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 1000;
+    LatencySummary cold, hot;
+
+    //the parameter goes through [0, 5) in n steps
+    auto parameter = [n](int k) {
+        return 5.0 * k / n;
+    };
+
+    for (int k = 0; k < n; k++) {
+        SmartPtr<TNLP> nlp = new ParametricHS071(parameter(k));
+        auto start = std::chrono::steady_clock::now();
+        Algorithm alg;
+        alg.initialization(nlp, "reopt_cold");
+        alg.Optimize();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        cold.add(elapsed.count(), alg.get_stats(), alg.get_exit_flag());
+    }
+
+    Algorithm alg;
+    for (int k = 0; k < n; k++) {
+        SmartPtr<TNLP> nlp = new ParametricHS071(parameter(k));
+        auto start = std::chrono::steady_clock::now();
+        if (k == 0) {
+            alg.initialization(nlp, "reopt_hot");
+            alg.Optimize();
+        } else
+            alg.ReOptimize(nlp);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        hot.add(elapsed.count(), alg.get_stats(), alg.get_exit_flag());
+    }
+
+    fprintf(stderr, "\n=========================================================\n");
+    fprintf(stderr, "    Benchmark for Algorithm::ReOptimize, %d instances\n", n);
+    fprintf(stderr, "=========================================================\n");
+    fprintf(stderr, "%-6s %14s %14s %10s %10s %10s\n", "", "mean (ms)", "max (ms)",
+            "iter", "qp_iter", "optimal");
+    cold.print("cold", n);
+    hot.print("hot", n);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Timing benchmark for the symbolic step SpHbMat::setStructure, on randomly
+ * generated triplet matrices with a fixed number of nonzeros per row, mimicking
+ * the Jacobian [J I -I] of the l1-elastic QP.
+ *
+ * usage: benchmark_SpHbMat [n] [nnz_per_row] [repeat]
+ */
+#include <sqphot/SpHbMat.hpp>
+#include "../unitTest/unit_test_utils.hpp"
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SQPhotstart;
+
+
+double time_set_structure(shared_ptr<const SpTripletMat> triplet,
+                          IdentityInfo I_info, int nnz, int colNum,
+                          bool isCompressedRow, int repeat) {
+    double elapsed = 0;
+    for (int r = 0; r < repeat; r++) {
+        auto m = make_shared<SpHbMat>(nnz, triplet->RowNum(), colNum,
+                                      isCompressedRow);
+        auto start = std::chrono::steady_clock::now();
+        m->setStructure(triplet, I_info);
+        m->setMatVal(triplet, I_info);
+        auto end = std::chrono::steady_clock::now();
+        elapsed += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return elapsed / repeat;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 200000;
+    int nnz_per_row = argc > 2 ? atoi(argv[2]) : 5;
+    int repeat = argc > 3 ? atoi(argv[3]) : 5;
+
+    std::mt19937 g(2019);
+    std::uniform_int_distribution<int> random_col(1, n);
+    std::uniform_real_distribution<double> random_val(-10.0, 10.0);
+
+    printf("\n=========================================================\n");
+    printf("    Benchmark for SpHbMat::setStructure\n");
+    printf("=========================================================\n");
+    printf("%10s %10s %12s %12s %14s\n", "rows", "nnz", "CSR (ms)", "CSC (ms)",
+           "ns/nnz (CSC)");
+
+    for (int rowNum = n / 100 > 0 ? n / 100 : 1; rowNum <= n; rowNum *= 10) {
+        int colNum = rowNum;
+        int nnz_J = rowNum * nnz_per_row;
+        auto triplet = make_shared<SpTripletMat>(nnz_J, rowNum, colNum, false, true);
+        for (int k = 0; k < nnz_J; k++) {
+            triplet->setRowIndex(k, k / nnz_per_row + 1);
+            triplet->setColIndex(k, random_col(g) % colNum + 1);
+            triplet->setMatValAt(k, random_val(g));
+        }
+
+        //the elastic variables [J I -I]
+        auto I_info = make_elastic_identity(rowNum, colNum);
+
+        int nnz = nnz_J + 2 * rowNum;
+        double t_csr = time_set_structure(triplet, *I_info, nnz, colNum + 2 * rowNum,
+                                          true, repeat);
+        double t_csc = time_set_structure(triplet, *I_info, nnz, colNum + 2 * rowNum,
+                                          false, repeat);
+        printf("%10d %10d %12.3f %12.3f %14.2f\n", rowNum, nnz, t_csr, t_csc,
+               t_csc * 1e6 / nnz);
+
+        if (rowNum == n)
+            break;
+        if (rowNum * 10 > n)
+            rowNum = n / 10;
+    }
+
+    return 0;
+}
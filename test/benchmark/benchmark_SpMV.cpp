@@ -0,0 +1,118 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Timing benchmark for the threaded sparse matrix-vector products of SpTripletMat
+ * and SpHbMat, on a randomly generated Jacobian with a fixed number of nonzeros
+ * per row, the size of the larger CUTE problems. Each product is timed with 1, 2,
+ * 4, ... threads, up to max_threads.
+ *
+ * usage: benchmark_SpMV [n] [nnz_per_row] [max_threads] [repeat]
+ */
+#include <sqphot/SpHbMat.hpp>
+#include <sqphot/Vector.hpp>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SQPhotstart;
+
+
+/** the average time of repeat calls of product, in milliseconds*/
+template<typename Product>
+double time_product(const Product &product, int repeat) {
+    product();  //warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+        product();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / repeat;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int nnz_per_row = argc > 2 ? atoi(argv[2]) : 5;
+    int max_threads = argc > 3 ? atoi(argv[3]) :
+                      std::max(1, (int) std::thread::hardware_concurrency());
+    int repeat = argc > 4 ? atoi(argv[4]) : 20;
+
+    std::mt19937 g(2019);
+    std::uniform_int_distribution<int> random_col(1, n);
+    std::uniform_real_distribution<double> random_val(-10.0, 10.0);
+
+    int rowNum = n;
+    int colNum = n;
+    int nnz = rowNum * nnz_per_row;
+    auto triplet = make_shared<SpTripletMat>(nnz, rowNum, colNum, false, true);
+    for (int k = 0; k < nnz; k++) {
+        triplet->setRowIndex(k, k / nnz_per_row + 1);
+        triplet->setColIndex(k, random_col(g));
+        triplet->setMatValAt(k, random_val(g));
+    }
+    auto csr = make_shared<SpHbMat>(nnz, rowNum, colNum, true);
+    csr->setStructure(triplet);
+    csr->setMatVal(triplet);
+    auto csc = make_shared<SpHbMat>(nnz, rowNum, colNum, false);
+    csc->setStructure(triplet);
+    csc->setMatVal(triplet);
+
+    auto x = make_shared<Vector>(colNum);
+    auto y = make_shared<Vector>(rowNum);
+    for (int i = 0; i < colNum; i++)
+        x->setValueAt(i, random_val(g));
+    for (int i = 0; i < rowNum; i++)
+        y->setValueAt(i, random_val(g));
+    auto Jx = make_shared<Vector>(rowNum);
+    auto JTy = make_shared<Vector>(colNum);
+
+    printf("\n=========================================================\n");
+    printf("    Benchmark for the threaded sparse matrix-vector products\n");
+    printf("    rows = cols = %d, nnz = %d\n", n, nnz);
+    printf("=========================================================\n");
+    printf("%8s %15s %15s %15s %15s %15s %15s\n", "threads", "Trip J*x", "Trip J'*y",
+           "CSR J*x", "CSR J'*y", "CSC J*x", "CSC J'*y");
+
+    double serial[6];
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        triplet->set_num_threads(num_threads);
+        csr->set_num_threads(num_threads);
+        csc->set_num_threads(num_threads);
+        double t[6];
+        t[0] = time_product([&]() {
+            triplet->times(x, Jx);
+        }, repeat);
+        t[1] = time_product([&]() {
+            triplet->transposed_times(y, JTy);
+        }, repeat);
+        t[2] = time_product([&]() {
+            csr->times(x, Jx);
+        }, repeat);
+        t[3] = time_product([&]() {
+            csr->transposed_times(y, JTy);
+        }, repeat);
+        t[4] = time_product([&]() {
+            csc->times(x, Jx);
+        }, repeat);
+        t[5] = time_product([&]() {
+            csc->transposed_times(y, JTy);
+        }, repeat);
+
+        printf("%8d", num_threads);
+        for (int i = 0; i < 6; i++) {
+            if (num_threads == 1)
+                serial[i] = t[i];
+            printf(" %7.2fms %3.1fx", t[i], serial[i] / t[i]);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+/* Copyright (C) 2019
+ * All Rights Reserved.
+ *
+ * Authors: Xinyi Luo
+ * Date:2019-10
+ */
+
+/**
+ * Replays a QP written to a QPSnapshot (by QPhandler::WriteQPData when a QP
+ * solver fails) with any of the QP solver backends, and compares the results
+ * with the status and working set recorded in the snapshot.
+ *
+ * usage: replay_QPsnapshot <snapshot> [qore|qpoases|dense|all]
+ *        replay_QPsnapshot --convert <text log> <snapshot>
+ *
+ * The second form converts a QP written by the former text writer (see
+ * test/unsolved_QP_data) to a snapshot.
+ */
+extern "C" {
+#include <qpsolver.h>
+}
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sqphot/QPSnapshot.hpp>
+#include <sqphot/QOREInterface.hpp>
+#include <sqphot/qpOASESInterface.hpp>
+#include <sqphot/DenseQPInterface.hpp>
+#include <sqphot/MessageHandling.hpp>
+
+using namespace SQPhotstart;
+
+
+const char* exitflag_name(Exitflag exitflag) {
+    switch (exitflag) {
+    case QP_OPTIMAL:
+        return "OPTIMAL";
+    case QPERROR_EXCEED_MAX_ITER:
+        return "EXCEED_ITER_LIMIT";
+    case QPERROR_INFEASIBLE:
+        return "INFEASIBLE";
+    case QPERROR_UNBOUNDED:
+        return "UNBOUNDED";
+    case QPERROR_NOTINITIALISED:
+        return "NOTINITIALISED";
+    case QPERROR_PREPARINGAUXILIARYQP:
+        return "PREPARINGAUXILIARYQP";
+    case QPERROR_AUXILIARYQPSOLVED:
+        return "AUXILIARYQP_SOLVED";
+    case QPERROR_PERFORMINGHOMOTOPY:
+        return "PERFORMING_HOMOTOPY";
+    case QPERROR_HOMOTOPYQPSOLVED:
+        return "HOMOTOPYQPSOLVED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+
+const char* solver_name(Solver solver) {
+    switch (solver) {
+    case QPOASES:
+        return "qpOASES";
+    case QORE:
+        return "QORE";
+    case GUROBI:
+        return "Gurobi";
+    case CPLEX:
+        return "Cplex";
+    case DENSE:
+        return "dense";
+    default:
+        return "undefined";
+    }
+}
+
+
+/**
+ * @brief solve the QP of the snapshot with the interface, and print the results
+ * next to those recorded in the snapshot
+ */
+void replay(const QPSnapshot &snapshot, QPSolverInterface &interface,
+            const char* name) {
+    int nVar = snapshot.nVar();
+    int nConstr = snapshot.nConstr();
+    auto stats = make_shared<Stats>();
+    try {
+        if (snapshot.qptype() == LP)
+            interface.optimizeLP(stats);
+        else
+            interface.optimizeQP(stats);
+    }
+    catch (...) {
+        //the exit flag is reported below
+    }
+
+    std::vector<ActiveType> W_bounds(nVar);
+    std::vector<ActiveType> W_constr(nConstr);
+    int working_set_changes = -1;
+    bool is_optimal = false;
+    try {
+        is_optimal = interface.test_optimality(W_constr.data(), W_bounds.data());
+        if (snapshot.has_working_set()) {
+            working_set_changes = 0;
+            for (int i = 0; i < nVar; i++)
+                working_set_changes += W_bounds[i] != snapshot.W_bounds()[i];
+            for (int i = 0; i < nConstr; i++)
+                working_set_changes += W_constr[i] != snapshot.W_constr()[i];
+        }
+    }
+    catch (INVALID_WORKING_SET &) {
+    }
+
+    printf("%30s    %23s\n", "Solver", name);
+    printf("%30s    %23s\n", "Exitflag", exitflag_name(interface.get_status()));
+    printf("%30s    %23d\n", "Iteration", stats->qp_iter);
+    printf("%30s    %23.16e\n", "Objective", interface.get_obj_value());
+    printf("%30s    %23.16e\n", "KKT Error",
+           interface.get_optimality_status().KKT_error);
+    printf("%30s    %23s\n", "KKT conditions", is_optimal ? "satisfied" : "violated");
+    if (working_set_changes >= 0)
+        printf("%30s    %23d\n", "Working set changes", working_set_changes);
+    printf(SINGLE_DIVIDER);
+}
+
+
+void replay_qore(const QPSnapshot &snapshot) {
+    int nVar = snapshot.nVar();
+    int nConstr = snapshot.nConstr();
+    //QORE takes the bounds on the variables and on Ax in a single vector
+    auto lb = make_shared<Vector>(nVar + nConstr);
+    auto ub = make_shared<Vector>(nVar + nConstr);
+    lb->copy_vector(snapshot.lb());
+    ub->copy_vector(snapshot.ub());
+    memcpy(lb->values() + nVar, snapshot.lbA(), nConstr * sizeof(double));
+    memcpy(ub->values() + nVar, snapshot.ubA(), nConstr * sizeof(double));
+    auto g = make_shared<Vector>(nVar, snapshot.g());
+
+    QOREInterface interface(snapshot.get_H(true), snapshot.get_A(true), g, lb, ub,
+                            snapshot.get_options());
+    replay(snapshot, interface, "QORE");
+}
+
+
+void replay_qpoases(const QPSnapshot &snapshot) {
+    auto g = make_shared<Vector>(snapshot.nVar(), snapshot.g());
+    auto lb = make_shared<Vector>(snapshot.nVar(), snapshot.lb());
+    auto ub = make_shared<Vector>(snapshot.nVar(), snapshot.ub());
+    auto lbA = make_shared<Vector>(snapshot.nConstr(), snapshot.lbA());
+    auto ubA = make_shared<Vector>(snapshot.nConstr(), snapshot.ubA());
+
+    qpOASESInterface interface(snapshot.get_H(false), snapshot.get_A(false), g, lb,
+                               ub, lbA, ubA, snapshot.get_options());
+    replay(snapshot, interface, "qpOASES");
+}
+
+
+void replay_dense(const QPSnapshot &snapshot) {
+    auto g = make_shared<Vector>(snapshot.nVar(), snapshot.g());
+    auto lb = make_shared<Vector>(snapshot.nVar(), snapshot.lb());
+    auto ub = make_shared<Vector>(snapshot.nVar(), snapshot.ub());
+    auto lbA = make_shared<Vector>(snapshot.nConstr(), snapshot.lbA());
+    auto ubA = make_shared<Vector>(snapshot.nConstr(), snapshot.ubA());
+
+    DenseQPInterface interface(snapshot.get_H(true), snapshot.get_A(true), g, lb, ub,
+                               lbA, ubA, snapshot.get_options());
+    replay(snapshot, interface, "dense");
+}
+
+
+/**
+ * @brief read the next number of a text log, one number per line
+ */
+template<typename T>
+bool read_numbers(FILE* file, const char* format, T* values, int length) {
+    for (int i = 0; i < length; i++)
+        if (fscanf(file, format, &values[i]) != 1)
+            return false;
+    return true;
+}
+
+
+/**
+ * @brief convert a QP written by the text writer for QORE: nVar, nConstr, nnz of
+ * A and H, then lb, ub (on the variables followed by Ax), g, and A and H in
+ * compressed row format
+ */
+int convert_text_log(const char* log_name, const char* snapshot_name) {
+    FILE* file = fopen(log_name, "r");
+    if (file == NULL) {
+        perror(log_name);
+        return 1;
+    }
+    int dims[4];
+    if (!read_numbers(file, "%d", dims, 4)) {
+        printf("%s is not a QP log\n", log_name);
+        fclose(file);
+        return 1;
+    }
+    int nVar = dims[0], nConstr = dims[1], nnz_A = dims[2], nnz_H = dims[3];
+    std::vector<double> lb(nVar + nConstr), ub(nVar + nConstr), g(nVar);
+    auto A = make_shared<SpHbMat>(nnz_A, nConstr, nVar, true);
+    auto H = make_shared<SpHbMat>(nnz_H, nVar, nVar, true);
+    bool is_complete = read_numbers(file, "%lf", lb.data(), nVar + nConstr) &&
+                       read_numbers(file, "%lf", ub.data(), nVar + nConstr) &&
+                       read_numbers(file, "%lf", g.data(), nVar) &&
+                       read_numbers(file, "%d", A->RowIndex(), nConstr + 1) &&
+                       read_numbers(file, "%d", A->ColIndex(), nnz_A) &&
+                       read_numbers(file, "%lf", A->MatVal(), nnz_A) &&
+                       read_numbers(file, "%d", H->RowIndex(), nVar + 1) &&
+                       read_numbers(file, "%d", H->ColIndex(), nnz_H) &&
+                       read_numbers(file, "%lf", H->MatVal(), nnz_H);
+    fclose(file);
+    if (!is_complete) {
+        printf("%s is truncated\n", log_name);
+        return 1;
+    }
+
+    //the text logs record neither the working set nor the options
+    QPSnapshot::write(snapshot_name, QP, QORE, UNKNOWN, nullptr, H, A, g.data(),
+                      lb.data(), ub.data(), lb.data() + nVar, ub.data() + nVar);
+    printf("%s converted to %s\n", log_name, snapshot_name);
+    return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0)
+        return convert_text_log(argv[2], argv[3]);
+    if (argc < 2) {
+        printf("usage: %s <snapshot> [qore|qpoases|dense|all]\n"
+               "       %s --convert <text log> <snapshot>\n", argv[0], argv[0]);
+        return 1;
+    }
+    std::string backend = argc > 2 ? argv[2] : "all";
+    if (backend != "qore" && backend != "qpoases" && backend != "dense" &&
+            backend != "all") {
+        printf("unknown QP solver %s\n", backend.c_str());
+        return 1;
+    }
+
+    try {
+        QPSnapshot snapshot(argv[1]);
+
+        std::string name(argv[1]);
+        std::size_t found = name.find_last_of("/\\");
+        printf(DOUBLE_LONG_DIVIDER);
+        printf("                         Replaying %s %s\n",
+               snapshot.qptype() == LP ? "LP" : "QP", name.substr(found + 1).c_str());
+        printf(DOUBLE_LONG_DIVIDER);
+        printf("%30s    %23d\n", "Variables", snapshot.nVar());
+        printf("%30s    %23d\n", "Constraints", snapshot.nConstr());
+        printf("%30s    %23d\n", "Nonzeros in A", snapshot.nnz_A());
+        printf("%30s    %23d\n", "Nonzeros in H", snapshot.nnz_H());
+        printf("%30s    %23s\n", "Recorded solver", solver_name(snapshot.solver()));
+        printf("%30s    %23s\n", "Recorded exitflag", exitflag_name(snapshot.status()));
+        printf(SINGLE_DIVIDER);
+
+        if (backend == "qore" || backend == "all")
+            replay_qore(snapshot);
+        if (backend == "qpoases" || backend == "all")
+            replay_qpoases(snapshot);
+        if (backend == "dense" || backend == "all")
+            replay_dense(snapshot);
+    }
+    catch (INVALID_QP_SNAPSHOT &e) {
+        printf("%s\n", e.Message().c_str());
+        return 1;
+    }
+    return 0;
+}
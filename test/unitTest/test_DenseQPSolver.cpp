@@ -0,0 +1,344 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/DenseQPSolver.hpp>
+#include <sqphot/Utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+const double KKT_TOL = 1.0e-6;
+
+double random_double(double lower, double upper) {
+    return lower + (upper - lower) * rand() / RAND_MAX;
+}
+
+
+/** @brief a random QP whose constraints are satisfied by a random point*/
+struct RandomQP {
+    int nVar;
+    int nConstr;
+    vector<double> H, A, g, lb, ub, lbA, ubA;
+
+    /**
+     * @param curvature 1 for a positive definite Hessian, 0 for an LP, -1 for an
+     * indefinite Hessian
+     * @param penalty if A and H have the structure of the SL1QP subproblems,
+     * [J I -I] and [B 0; 0 0], with the slacks bounded below by 0
+     */
+    RandomQP(int nx, int nConstr, int curvature, bool penalty = false) :
+        nVar(penalty ? nx + 2 * nConstr : nx),
+        nConstr(nConstr),
+        H(nVar * nVar, 0.0),
+        A(nConstr * nVar, 0.0),
+        g(nVar),
+        lb(nVar),
+        ub(nVar),
+        lbA(nConstr),
+        ubA(nConstr) {
+        vector<double> B(nx * nx);
+        for (int i = 0; i < nx * nx; i++)
+            B[i] = random_double(-1, 1);
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < nx; j++) {
+                double value = 0.0;
+                if (curvature > 0) {
+                    for (int k = 0; k < nx; k++)
+                        value += B[k * nx + i] * B[k * nx + j];
+                    value += i == j ? 0.1 : 0.0;
+                }
+                else if (curvature < 0)
+                    value = (B[i * nx + j] + B[j * nx + i]) / 2;
+                H[i * nVar + j] = value;
+            }
+
+        vector<double> x(nVar);
+        for (int j = 0; j < nVar; j++) {
+            g[j] = random_double(-10, 10);
+            x[j] = random_double(-1, 1);
+            lb[j] = rand() % 4 == 0 && curvature > 0 ? -INF : x[j] - random_double(0, 2);
+            ub[j] = rand() % 4 == 0 && curvature > 0 ? INF : x[j] + random_double(0, 2);
+        }
+        for (int i = 0; i < nConstr; i++)
+            for (int j = 0; j < nx; j++)
+                A[i * nVar + j] = rand() % 2 ? random_double(-5, 5) : 0.0;
+
+        if (penalty) {
+            for (int i = 0; i < nConstr; i++) {
+                A[i * nVar + nx + i] = 1.0;
+                A[i * nVar + nx + nConstr + i] = -1.0;
+            }
+            for (int j = nx; j < nVar; j++) {
+                g[j] = random_double(1, 10);
+                x[j] = 0.0;
+                lb[j] = 0.0;
+                ub[j] = INF;
+            }
+            for (int j = 0; j < nx; j++) {
+                lb[j] = -1.0;
+                ub[j] = 1.0;
+            }
+        }
+
+        for (int i = 0; i < nConstr; i++) {
+            double Ax = 0.0;
+            for (int j = 0; j < nVar; j++)
+                Ax += A[i * nVar + j] * x[j];
+            if (penalty)
+                //infeasible for the variables alone, but not with the slacks
+                Ax += random_double(-20, 20);
+            int type = rand() % 4;
+            lbA[i] = type == 1 ? -INF : Ax - (type == 0 ? 0.0 : random_double(0, 1));
+            ubA[i] = type == 2 ? INF : type == 0 ? lbA[i] : Ax + random_double(0, 1);
+        }
+    }
+
+    Exitflag solve(DenseQPSolver &solver, int max_iter = 1000,
+                   double objective_target = -INF) const {
+        return solver.solve(H.data(), A.data(), g.data(), lb.data(), ub.data(),
+                            lbA.data(), ubA.data(), max_iter, objective_target);
+    }
+
+    /** @brief the largest violation of the bounds and constraints at x*/
+    double infeasibility(const double* x) const {
+        double violation = 0.0;
+        for (int j = 0; j < nVar; j++)
+            violation = max(violation, max(lb[j] - x[j], x[j] - ub[j]));
+        for (int i = 0; i < nConstr; i++) {
+            double Ax = 0.0;
+            for (int j = 0; j < nVar; j++)
+                Ax += A[i * nVar + j] * x[j];
+            violation = max(violation, max(lbA[i] - Ax, Ax - ubA[i]));
+        }
+        return violation;
+    }
+
+    /**
+     * @brief check the first-order optimality conditions of the solution, and that
+     * the working set agrees with the multipliers
+     */
+    bool is_KKT_point(const DenseQPSolver &solver, bool is_LP = false) const {
+        const double* x = solver.x();
+        const double* y = solver.y();
+        vector<ActiveType> W_bounds(nVar), W_constr(nConstr);
+        solver.get_working_set(W_constr.data(), W_bounds.data());
+
+        double error = 0.0;
+        vector<double> stationarity(nVar);
+        for (int j = 0; j < nVar; j++) {
+            stationarity[j] = g[j] - y[j];
+            if (!is_LP)
+                for (int k = 0; k < nVar; k++)
+                    stationarity[j] += H[j * nVar + k] * x[k];
+        }
+        for (int i = 0; i < nConstr; i++) {
+            double Ax = 0.0;
+            for (int j = 0; j < nVar; j++) {
+                Ax += A[i * nVar + j] * x[j];
+                stationarity[j] -= A[i * nVar + j] * y[nVar + i];
+            }
+            error = max(error, max(lbA[i] - Ax, Ax - ubA[i]));
+            error = max(error, complementarity(Ax, lbA[i], ubA[i], y[nVar + i],
+                                               W_constr[i]));
+        }
+        for (int j = 0; j < nVar; j++) {
+            error = max(error, fabs(stationarity[j]));
+            error = max(error, max(lb[j] - x[j], x[j] - ub[j]));
+            error = max(error, complementarity(x[j], lb[j], ub[j], y[j], W_bounds[j]));
+        }
+        if (error > KKT_TOL)
+            printf("    KKT error %e\n", error);
+        return error <= KKT_TOL;
+    }
+
+    /** @brief the violation of the sign and complementarity of a multiplier*/
+    static double complementarity(double value, double lower, double upper,
+                                  double y, ActiveType type) {
+        double scale = max(1.0, fabs(y));
+        double violation = 0.0;
+        if (y > 0.0)
+            violation = (value - lower) * y;
+        else if (y < 0.0)
+            violation = (value - upper) * y;
+        if ((type == ACTIVE_BELOW || type == ACTIVE_BOTH_SIDE) &&
+                fabs(value - lower) > KKT_TOL * max(1.0, fabs(lower)))
+            violation = INF;
+        if (type == ACTIVE_ABOVE && fabs(value - upper) > KKT_TOL * max(1.0, fabs(upper)))
+            violation = INF;
+        if (type == INACTIVE && fabs(y) > KKT_TOL * scale)
+            violation = max(violation, fabs(y));
+        return violation;
+    }
+};
+
+
+void PRINT_RESULT(bool passed, const char* name) {
+    printf("---------------------------------------------------------\n");
+    printf("    %s test %s\n", name, passed ? "passed!" : "FAILED!");
+    printf("---------------------------------------------------------\n");
+}
+
+
+/** @brief solve random QPs or LPs, then resolve them with perturbed data*/
+bool TEST_RANDOM(int nVar, int nConstr, int curvature, bool penalty,
+                 const char* name) {
+    bool passed = true;
+    for (int trial = 0; trial < 20; trial++) {
+        RandomQP qp(nVar, nConstr, curvature, penalty);
+        DenseQPSolver solver(qp.nVar, qp.nConstr);
+        Exitflag status = curvature == 0 ?
+                          solver.solve(NULL, qp.A.data(), qp.g.data(), qp.lb.data(),
+                                       qp.ub.data(), qp.lbA.data(), qp.ubA.data(), 1000) :
+                          qp.solve(solver);
+        if (status != QP_OPTIMAL || !qp.is_KKT_point(solver, curvature == 0)) {
+            printf("    trial %d: cold start returns %d\n", trial, status);
+            passed = false;
+            continue;
+        }
+
+        //warm start from the working set of the previous solve
+        for (int j = 0; j < qp.nVar; j++)
+            qp.g[j] += random_double(-0.1, 0.1);
+        for (int i = 0; i < qp.nConstr; i++)
+            if (qp.lbA[i] > -INF && qp.ubA[i] < INF && qp.lbA[i] != qp.ubA[i])
+                qp.ubA[i] += random_double(0, 0.1);
+        status = curvature == 0 ?
+                 solver.solve(NULL, qp.A.data(), qp.g.data(), qp.lb.data(),
+                              qp.ub.data(), qp.lbA.data(), qp.ubA.data(), 1000) :
+                 qp.solve(solver);
+        if (status != QP_OPTIMAL || !qp.is_KKT_point(solver, curvature == 0)) {
+            printf("    trial %d: warm start returns %d\n", trial, status);
+            passed = false;
+        }
+    }
+    PRINT_RESULT(passed, name);
+    return passed;
+}
+
+
+/**
+ * @brief solve random QPs, then solve them again with a new solver handed the
+ * working set and solution of the first one, which should need no iteration
+ */
+bool TEST_WORKING_SET_GUESS(int nVar, int nConstr, bool penalty, const char* name) {
+    bool passed = true;
+    for (int trial = 0; trial < 20; trial++) {
+        RandomQP qp(nVar, nConstr, 1, penalty);
+        DenseQPSolver solver(qp.nVar, qp.nConstr);
+        if (qp.solve(solver) != QP_OPTIMAL)
+            continue;
+        vector<ActiveType> W_bounds(qp.nVar), W_constr(qp.nConstr);
+        solver.get_working_set(W_constr.data(), W_bounds.data());
+
+        DenseQPSolver guessed(qp.nVar, qp.nConstr);
+        guessed.set_working_set(W_constr.data(), W_bounds.data(), solver.x());
+        Exitflag status = qp.solve(guessed);
+        if (status != QP_OPTIMAL || !qp.is_KKT_point(guessed) ||
+                guessed.iterations() > 0) {
+            printf("    trial %d: returns %d after %d iterations, %d for the cold "
+                   "start\n", trial, status, guessed.iterations(), solver.iterations());
+            passed = false;
+        }
+    }
+    PRINT_RESULT(passed, name);
+    return passed;
+}
+
+
+/**
+ * @brief solve with an objective target above the optimal objective, check that
+ * the solver stops at a feasible point which reaches it, no later than the full
+ * solve, and that the next solve finishes the QP from there
+ */
+bool TEST_OBJECTIVE_TARGET(int nVar, int nConstr, bool penalty, const char* name) {
+    bool passed = true;
+    for (int trial = 0; trial < 20; trial++) {
+        RandomQP qp(nVar, nConstr, 1, penalty);
+        DenseQPSolver solver(qp.nVar, qp.nConstr);
+        if (qp.solve(solver) != QP_OPTIMAL)
+            continue;
+        double target = solver.objective() + 0.1 * max(1.0, fabs(solver.objective()));
+
+        DenseQPSolver inexact(qp.nVar, qp.nConstr);
+        Exitflag status = qp.solve(inexact, 1000, target);
+        if ((status != QP_SUFFICIENT_DECREASE && status != QP_OPTIMAL) ||
+                inexact.objective() > target + KKT_TOL * max(1.0, fabs(target)) ||
+                qp.infeasibility(inexact.x()) > KKT_TOL ||
+                inexact.iterations() > solver.iterations()) {
+            printf("    trial %d: returns %d after %d iterations, %d for the full "
+                   "solve, objective %e for the target %e\n", trial, status,
+                   inexact.iterations(), solver.iterations(), inexact.objective(),
+                   target);
+            passed = false;
+            continue;
+        }
+        status = qp.solve(inexact);
+        if (status != QP_OPTIMAL || !qp.is_KKT_point(inexact)) {
+            printf("    trial %d: returns %d when the solve is finished\n", trial,
+                   status);
+            passed = false;
+        }
+    }
+    PRINT_RESULT(passed, name);
+    return passed;
+}
+
+
+/** @brief x1 + x2 >= 3 with 0 <= x <= 1*/
+bool TEST_INFEASIBLE() {
+    double H[4] = {1, 0, 0, 1};
+    double A[2] = {1, 1};
+    double g[2] = {0, 0};
+    double lb[2] = {0, 0};
+    double ub[2] = {1, 1};
+    double lbA[1] = {3};
+    double ubA[1] = {INF};
+    DenseQPSolver solver(2, 1);
+    bool passed = solver.solve(H, A, g, lb, ub, lbA, ubA, 100) == QPERROR_INFEASIBLE;
+    PRINT_RESULT(passed, "Infeasible QP");
+    return passed;
+}
+
+
+/** @brief minimize -x1 - x2 subject to x1 - x2 = 0, x unbounded*/
+bool TEST_UNBOUNDED() {
+    double A[2] = {1, -1};
+    double g[2] = {-1, -1};
+    double lb[2] = {-INF, -INF};
+    double ub[2] = {INF, INF};
+    double lbA[1] = {0};
+    double ubA[1] = {0};
+    DenseQPSolver solver(2, 1);
+    bool passed = solver.solve(NULL, A, g, lb, ub, lbA, ubA, 100) == QPERROR_UNBOUNDED;
+    PRINT_RESULT(passed, "Unbounded LP");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int nVar = rand() % 20 + 2;
+    int nConstr = rand() % 20 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing DenseQPSolver on randomly generated data,\n"
+           "   nVar = %d, nConstr = %d.", nVar, nConstr);
+    printf("\n=========================================================\n");
+
+    TEST_RANDOM(nVar, nConstr, 1, false, "Convex QP");
+    TEST_RANDOM(nVar, nConstr, -1, false, "Nonconvex QP");
+    TEST_RANDOM(nVar, nConstr, 0, false, "LP");
+    TEST_RANDOM(nVar, nConstr, 1, true, "Penalty QP");
+    TEST_RANDOM(nVar, nConstr, 0, true, "Penalty LP");
+    TEST_WORKING_SET_GUESS(nVar, nConstr, false, "Working set guess for a QP");
+    TEST_WORKING_SET_GUESS(nVar, nConstr, true, "Working set guess for a penalty QP");
+    TEST_OBJECTIVE_TARGET(nVar, nConstr, false, "Objective target for a QP");
+    TEST_OBJECTIVE_TARGET(nVar, nConstr, true, "Objective target for a penalty QP");
+    TEST_INFEASIBLE();
+    TEST_UNBOUNDED();
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/HessianApproximation.hpp>
+#include <sqphot/Vector.hpp>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <cmath>
+
+using namespace SQPhotstart;
+using namespace std;
+
+/**
+ * @brief get the dense (row-oriented) matrix of the approximation
+ */
+void get_dense_approximation(shared_ptr<HessianApproximation> B, int n,
+                             double* dense) {
+    shared_ptr<SpTripletMat> triplet = make_shared<SpTripletMat>(
+                                           HessianApproximation::nnz(n), n, n, true);
+    B->set_structure(triplet);
+    B->get_values(triplet);
+    for (int i = 0; i < n * n; i++)
+        dense[i] = 0.0;
+    for (int k = 0; k < triplet->EntryNum(); k++) {
+        int row = triplet->RowIndex(k) - 1;
+        int col = triplet->ColIndex(k) - 1;
+        dense[row * n + col] = triplet->MatVal(k);
+        dense[col * n + row] = triplet->MatVal(k);
+    }
+}
+
+
+double max_abs_diff(const double* a, const double* b, int length) {
+    double result = 0.0;
+    for (int i = 0; i < length; i++)
+        result = std::max(result, fabs(a[i] - b[i]));
+    return result;
+}
+
+
+/**
+ * @brief a random symmetric positive definite A = M^TM+I
+ */
+void random_spd_matrix(int n, double* A) {
+    double* M = new double[n * n];
+    for (int i = 0; i < n * n; i++)
+        M[i] = (rand() % 21 - 10) / 10.0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            A[i * n + j] = (i == j) ? 1.0 : 0.0;
+            for (int k = 0; k < n; k++)
+                A[i * n + j] += M[k * n + i] * M[k * n + j];
+        }
+    }
+    delete[] M;
+}
+
+
+/**
+ * @brief a symmetric A with all eigenvalues in [0.9, 1.1], on which no BFGS update
+ * is damped
+ */
+void random_well_conditioned_matrix(int n, double* A) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            A[i * n + j] = (rand() % 21 - 10) / (100.0 * n);
+            A[j * n + i] = A[i * n + j];
+        }
+        A[i * n + i] += 1.0;
+    }
+}
+
+
+void dense_times(int n, const double* A, const double* p, double* result) {
+    for (int i = 0; i < n; i++) {
+        result[i] = 0.0;
+        for (int j = 0; j < n; j++)
+            result[i] += A[i * n + j] * p[j];
+    }
+}
+
+
+bool TEST_SECANT_CONDITION(HessianApproximationType type, int n) {
+    double* A = new double[n * n];
+    double* B_dense = new double[n * n];
+    random_well_conditioned_matrix(n, A);
+    auto B = make_shared<HessianApproximation>(n, type, n);
+    auto s = make_shared<Vector>(n);
+    auto y = make_shared<Vector>(n);
+    auto Bs = make_shared<Vector>(n);
+
+    bool passed = true;
+    for (int iter = 0; iter < 3; iter++) {
+        for (int i = 0; i < n; i++)
+            s->setValueAt(i, (rand() % 21 - 10) / 10.0 + 0.05);
+        dense_times(n, A, s->values(), y->values());
+        B->update(s, y);
+        get_dense_approximation(B, n, B_dense);
+        dense_times(n, B_dense, s->values(), Bs->values());
+        //the most recent pair satisfies the secant equation B*s = y
+        if (max_abs_diff(Bs->values(), y->values(), n) > 1.0e-8 * (1 + y->getInfNorm()))
+            passed = false;
+    }
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    Secant condition for %s test passed!\n",
+               type == DAMPED_BFGS ? "damped BFGS" : "L-SR1");
+    else
+        printf("    Secant condition for %s test FAILED!\n",
+               type == DAMPED_BFGS ? "damped BFGS" : "L-SR1");
+    printf("---------------------------------------------------------\n");
+    delete[] A;
+    delete[] B_dense;
+    return passed;
+}
+
+
+bool TEST_SR1_RECOVERS_QUADRATIC(int n) {
+    double* A = new double[n * n];
+    double* B_dense = new double[n * n];
+    random_spd_matrix(n, A);
+    auto B = make_shared<HessianApproximation>(n, LIMITED_MEMORY_SR1, n);
+    auto s = make_shared<Vector>(n);
+    auto y = make_shared<Vector>(n);
+
+    //SR1 recovers a quadratic after n linearly independent steps
+    for (int iter = 0; iter < n; iter++) {
+        s->set_zeros();
+        s->setValueAt(iter, 1.0);
+        if (iter > 0)
+            s->setValueAt(iter - 1, 0.5);
+        dense_times(n, A, s->values(), y->values());
+        B->update(s, y);
+    }
+    get_dense_approximation(B, n, B_dense);
+    bool passed = max_abs_diff(A, B_dense, n * n) < 1.0e-6;
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    L-SR1 recovering a quadratic test passed!\n");
+    else
+        printf("    L-SR1 recovering a quadratic test FAILED!\n");
+    printf("---------------------------------------------------------\n");
+    delete[] A;
+    delete[] B_dense;
+    return passed;
+}
+
+
+bool TEST_DAMPED_BFGS_NEGATIVE_CURVATURE(int n) {
+    double* B_dense = new double[n * n];
+    auto B = make_shared<HessianApproximation>(n, DAMPED_BFGS, n);
+    auto s = make_shared<Vector>(n);
+    auto y = make_shared<Vector>(n);
+    auto Bp = make_shared<Vector>(n);
+
+    //pairs with s^Ty < 0 are damped, and B stays positive definite
+    bool passed = true;
+    for (int iter = 0; iter < 5; iter++) {
+        for (int i = 0; i < n; i++) {
+            s->setValueAt(i, (rand() % 21 - 10) / 10.0 + 0.05);
+            y->setValueAt(i, -s->values(i) * (rand() % 5 + 1));
+        }
+        if (!B->update(s, y))
+            passed = false;
+        get_dense_approximation(B, n, B_dense);
+        for (int trial = 0; trial < 10; trial++) {
+            auto p = make_shared<Vector>(n);
+            for (int i = 0; i < n; i++)
+                p->setValueAt(i, (rand() % 21 - 10) / 10.0 + 0.01);
+            dense_times(n, B_dense, p->values(), Bp->values());
+            double pBp = 0.0;
+            for (int i = 0; i < n; i++)
+                pBp += p->values(i) * Bp->values(i);
+            if (pBp <= 0)
+                passed = false;
+        }
+    }
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    Damped BFGS with negative curvature test passed!\n");
+    else
+        printf("    Damped BFGS with negative curvature test FAILED!\n");
+    printf("---------------------------------------------------------\n");
+    delete[] B_dense;
+    return passed;
+}
+
+
+/**
+ * @brief nnz is exact up to HESSIAN_APPROXIMATION_MAX_NVAR, and larger problems,
+ * whose count would overflow an int, are rejected
+ */
+bool TEST_SIZE_LIMIT() {
+    int n = HESSIAN_APPROXIMATION_MAX_NVAR;
+    bool passed = HessianApproximation::nnz(n) == n * (n + 1) / 2;
+    const int too_large[2] = {HESSIAN_APPROXIMATION_MAX_NVAR + 1, 70000};
+    for (int i = 0; i < 2; i++) {
+        try {
+            HessianApproximation::nnz(too_large[i]);
+            passed = false;
+        }
+        catch (HESSIAN_APPROXIMATION_TOO_LARGE) {
+        }
+        try {
+            HessianApproximation B(too_large[i], LIMITED_MEMORY_SR1, 6);
+            passed = false;
+        }
+        catch (HESSIAN_APPROXIMATION_TOO_LARGE) {
+        }
+    }
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    Size limit test passed!\n");
+    else
+        printf("    Size limit test FAILED!\n");
+    printf("---------------------------------------------------------\n");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int n = rand() % 10 + 2;
+
+    printf("\n=========================================================\n");
+    printf("    Testing Methods for Quasi-Newton Hessian Approximation\n"
+           "   on randomly generated data, n = %d.", n);
+    printf("\n=========================================================\n");
+
+    TEST_SECANT_CONDITION(DAMPED_BFGS, n);
+
+    TEST_SECANT_CONDITION(LIMITED_MEMORY_SR1, n);
+
+    TEST_SR1_RECOVERS_QUADRATIC(n);
+
+    TEST_DAMPED_BFGS_NEGATIVE_CURVATURE(n);
+
+    TEST_SIZE_LIMIT();
+
+    return 0;
+}
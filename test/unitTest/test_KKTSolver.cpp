@@ -0,0 +1,301 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/KKTSolver.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+const double TOL = 1.0e-6;
+
+double random_double(double lower, double upper) {
+    return lower + (upper - lower) * rand() / RAND_MAX;
+}
+
+
+void PRINT_RESULT(bool passed, const char* name) {
+    printf("---------------------------------------------------------\n");
+    printf("    %s test %s\n", name, passed ? "passed!" : "FAILED!");
+    printf("---------------------------------------------------------\n");
+}
+
+
+/**
+ * @brief a random KKT system with H = C^T C + 0.1 I and A = [J I], both as
+ * triplets for KKTSolver and as the dense K
+ */
+struct RandomKKT {
+    int nx;
+    int nVar;
+    int nConstr;
+    vector<double> H_dense, J_dense;
+    shared_ptr<SpTripletMat> H;
+    shared_ptr<SpTripletMat> J;
+    IdentityInfo I_info;
+    int irow[1], jcol[1], size[1];
+    double value[1];
+
+    RandomKKT(int nx, int nConstr) :
+        nx(nx),
+        nVar(nx + nConstr),
+        nConstr(nConstr),
+        H_dense(nVar * nVar, 0.0),
+        J_dense(nConstr * nx, 0.0) {
+        vector<double> C(nx * nx);
+        for (int i = 0; i < nx * nx; i++)
+            C[i] = rand() % 3 ? 0.0 : random_double(-1, 1);
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < nx; j++) {
+                for (int k = 0; k < nx; k++)
+                    H_dense[i * nVar + j] += C[k * nx + i] * C[k * nx + j];
+                H_dense[i * nVar + j] += i == j ? 0.1 : 0.0;
+            }
+        for (int j = nx; j < nVar; j++)
+            H_dense[j * nVar + j] = 1.0;
+        H = make_shared<SpTripletMat>(H_dense.data(), nVar, nVar, true);
+
+        for (int i = 0; i < nConstr * nx; i++)
+            J_dense[i] = rand() % 2 ? 0.0 : random_double(-5, 5);
+        J = make_shared<SpTripletMat>(J_dense.data(), nConstr, nx, true);
+        I_info.length = 1;
+        I_info.irow = irow;
+        I_info.jcol = jcol;
+        I_info.size = size;
+        I_info.value = value;
+        irow[0] = 1;
+        jcol[0] = nx + 1;
+        size[0] = nConstr;
+        value[0] = random_double(0.5, 2);
+    }
+
+    /** @brief K x, with K regularized by delta_x and delta_c*/
+    vector<double> K_times(const vector<double> &x, double delta_x,
+                           double delta_c) const {
+        int n = nVar + nConstr;
+        vector<double> result(n, 0.0);
+        for (int i = 0; i < nVar; i++) {
+            for (int j = 0; j < nVar; j++)
+                result[i] += H_dense[i * nVar + j] * x[j];
+            result[i] += delta_x * x[i];
+        }
+        for (int i = 0; i < nConstr; i++) {
+            for (int j = 0; j < nx; j++) {
+                result[nVar + i] += J_dense[i * nx + j] * x[j];
+                result[j] += J_dense[i * nx + j] * x[nVar + i];
+            }
+            result[nVar + i] += value[0] * x[nx + i] - delta_c * x[nVar + i];
+            result[nx + i] += value[0] * x[nVar + i];
+        }
+        return result;
+    }
+};
+
+
+/** @brief solve K x = K x_0 for two random x_0 at once, and check the inertia*/
+bool TEST_SOLVE(int nx, int nConstr, double delta_x, double delta_c) {
+    bool passed = true;
+    for (int trial = 0; trial < 10; trial++) {
+        RandomKKT kkt(nx, nConstr);
+        int n = kkt.nVar + kkt.nConstr;
+        KKTSolver solver(DENSE_LDL, 0);
+        solver.set_structure(kkt.nVar, kkt.nConstr, kkt.H, kkt.J, &kkt.I_info);
+        solver.set_values(kkt.H, kkt.J, &kkt.I_info, delta_x, delta_c);
+
+        vector<double> x(2 * n), rhs(2 * n);
+        for (int r = 0; r < 2; r++) {
+            vector<double> x_r(n);
+            for (int i = 0; i < n; i++)
+                x_r[i] = random_double(-1, 1);
+            vector<double> rhs_r = kkt.K_times(x_r, delta_x, delta_c);
+            copy(x_r.begin(), x_r.end(), x.begin() + r * n);
+            copy(rhs_r.begin(), rhs_r.end(), rhs.begin() + r * n);
+        }
+        if (!solver.solve(rhs.data(), 2) || !solver.provides_inertia() ||
+                solver.num_negative() != kkt.nConstr) {
+            printf("    trial %d: wrong inertia\n", trial);
+            passed = false;
+            continue;
+        }
+        for (int i = 0; i < 2 * n; i++)
+            passed = passed && fabs(rhs[i] - x[i]) <= TOL;
+    }
+    PRINT_RESULT(passed, "Solve and inertia");
+    return passed;
+}
+
+
+/** @brief new values with the same pattern are factorized again*/
+bool TEST_SET_VALUES(int nx, int nConstr) {
+    RandomKKT kkt(nx, nConstr);
+    int n = kkt.nVar + kkt.nConstr;
+    KKTSolver solver(DENSE_LDL, 0);
+    solver.set_structure(kkt.nVar, kkt.nConstr, kkt.H, kkt.J, &kkt.I_info);
+    solver.set_values(kkt.H, kkt.J, &kkt.I_info);
+    bool passed = solver.factorize();
+
+    for (int e = 0; e < kkt.J->EntryNum(); e++) {
+        double a = 2 * kkt.J->MatVal(e);
+        kkt.J->setMatValAt(e, a);
+        kkt.J_dense[(kkt.J->RowIndex(e) - 1) * nx + kkt.J->ColIndex(e) - 1] = a;
+    }
+    kkt.value[0] = -kkt.value[0];
+    solver.set_values(kkt.H, kkt.J, &kkt.I_info);
+    vector<double> x(n);
+    for (int i = 0; i < n; i++)
+        x[i] = random_double(-1, 1);
+    vector<double> rhs = kkt.K_times(x, 0.0, 0.0);
+    passed = passed && solver.solve(rhs.data());
+    for (int i = 0; i < n; i++)
+        passed = passed && fabs(rhs[i] - x[i]) <= TOL;
+    PRINT_RESULT(passed, "Set values");
+    return passed;
+}
+
+
+/** @brief a KKT system with dependent rows of A is singular, unless delta_c > 0*/
+bool TEST_SINGULAR(int nx) {
+    vector<double> A_dense(2 * nx);
+    for (int j = 0; j < nx; j++) {
+        A_dense[j] = random_double(-1, 1);
+        A_dense[nx + j] = 2 * A_dense[j];
+    }
+    auto A = make_shared<SpTripletMat>(A_dense.data(), 2, nx, true);
+    auto H = make_shared<SpTripletMat>(nx, nx, nx, true);
+    for (int j = 0; j < nx; j++) {
+        H->setRowIndex(j, j + 1);
+        H->setColIndex(j, j + 1);
+        H->setMatValAt(j, 1.0);
+    }
+    KKTSolver solver(DENSE_LDL, 0);
+    solver.set_structure(nx, 2, H, A);
+    solver.set_values(H, A);
+    bool passed = !solver.factorize();
+    solver.set_values(H, A, NULL, 0.0, 1.0e-4);
+    passed = passed && solver.factorize() && solver.num_negative() == 2;
+    PRINT_RESULT(passed, "Singular");
+    return passed;
+}
+
+
+/**
+ * @brief the systems of TEST_SOLVE and TEST_SET_VALUES with a sparse solver of
+ * Ipopt, which the QP working set uses for the systems larger than
+ * kkt_dense_max_size. MA27 is not in every build of Ipopt, so it may be reported
+ * as not available instead.
+ */
+bool TEST_SPARSE(int nx, int nConstr, LinearSolver linear_solver, const char* name,
+                 bool is_required) {
+    bool passed = true;
+    try {
+        for (int trial = 0; trial < 5 && passed; trial++) {
+            RandomKKT kkt(nx, nConstr);
+            int n = kkt.nVar + kkt.nConstr;
+            KKTSolver solver(linear_solver, 0);
+            solver.set_structure(kkt.nVar, kkt.nConstr, kkt.H, kkt.J, &kkt.I_info);
+            solver.set_values(kkt.H, kkt.J, &kkt.I_info, 1.0e-2, 1.0e-3);
+
+            vector<double> x(2 * n), rhs(2 * n);
+            for (int r = 0; r < 2; r++) {
+                vector<double> x_r(n);
+                for (int i = 0; i < n; i++)
+                    x_r[i] = random_double(-1, 1);
+                vector<double> rhs_r = kkt.K_times(x_r, 1.0e-2, 1.0e-3);
+                copy(x_r.begin(), x_r.end(), x.begin() + r * n);
+                copy(rhs_r.begin(), rhs_r.end(), rhs.begin() + r * n);
+            }
+            passed = solver.solve(rhs.data(), 2);
+            if (passed && solver.provides_inertia() &&
+                    solver.num_negative() != kkt.nConstr) {
+                printf("    trial %d: wrong inertia\n", trial);
+                passed = false;
+            }
+            for (int i = 0; i < 2 * n; i++)
+                passed = passed && fabs(rhs[i] - x[i]) <= TOL;
+
+            //new values with the same pattern
+            kkt.value[0] = -kkt.value[0];
+            solver.set_values(kkt.H, kkt.J, &kkt.I_info);
+            vector<double> x_new(n);
+            for (int i = 0; i < n; i++)
+                x_new[i] = random_double(-1, 1);
+            vector<double> rhs_new = kkt.K_times(x_new, 0.0, 0.0);
+            passed = passed && solver.solve(rhs_new.data());
+            for (int i = 0; i < n; i++)
+                passed = passed && fabs(rhs_new[i] - x_new[i]) <= TOL;
+        }
+    }
+    catch (...) {
+        if (is_required) {
+            PRINT_RESULT(false, name);
+            return false;
+        }
+        printf("    %s is not available in this build of Ipopt\n", name);
+        return true;
+    }
+    PRINT_RESULT(passed, name);
+    return passed;
+}
+
+
+/**
+ * @brief the least-squares multipliers min ||g - J^T lambda||, from K with H = 0
+ * and delta_x = 1, whose residual has to be orthogonal to the rows of J
+ */
+bool TEST_LEAST_SQUARES(int nx, int nConstr) {
+    int m = min(nx, nConstr);
+    vector<double> J_dense(m * nx, 0.0), rhs(nx + m, 0.0);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < nx; j++)
+            J_dense[i * nx + j] = rand() % 2 ? 0.0 : random_double(-5, 5);
+        J_dense[i * nx + i] = 10.0;
+    }
+    for (int j = 0; j < nx; j++)
+        rhs[j] = random_double(-10, 10);
+    vector<double> g(rhs.begin(), rhs.begin() + nx);
+    auto J = make_shared<SpTripletMat>(J_dense.data(), m, nx, true);
+
+    KKTSolver solver(DENSE_LDL, 0);
+    solver.set_structure(nx, m, nullptr, J);
+    solver.set_values(nullptr, J, NULL, 1.0, 0.0);
+    bool passed = solver.solve(rhs.data());
+    //r = g - J^T lambda, and J r = 0
+    vector<double> r(g);
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < nx; j++)
+            r[j] -= J_dense[i * nx + j] * rhs[nx + i];
+    for (int j = 0; j < nx; j++)
+        passed = passed && fabs(r[j] - rhs[j]) <= TOL;
+    for (int i = 0; i < m; i++) {
+        double Jr = 0.0;
+        for (int j = 0; j < nx; j++)
+            Jr += J_dense[i * nx + j] * r[j];
+        passed = passed && fabs(Jr) <= TOL;
+    }
+    PRINT_RESULT(passed, "Least squares");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int nx = rand() % 20 + 2;
+    int nConstr = rand() % 10 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing Methods for KKTSolver with nx = %d, nConstr = %d", nx,
+           nConstr);
+    printf("\n=========================================================\n");
+
+    TEST_SOLVE(nx, nConstr, 0.0, 0.0);
+    TEST_SOLVE(nx, nConstr, 1.0e-2, 1.0e-3);
+    TEST_SET_VALUES(nx, nConstr);
+    TEST_SINGULAR(nx);
+    TEST_LEAST_SQUARES(nx, nConstr);
+    TEST_SPARSE(nx, nConstr, MUMPS, "MUMPS", true);
+    TEST_SPARSE(nx, nConstr, MA27, "MA27", false);
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/QPSnapshot.hpp>
+#include <sqphot/Vector.hpp>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+const char* SNAPSHOT_FILE = "unitTest_QPSnapshot.qpsnap";
+
+/**
+ * @brief a random dense matrix with about half of its entries zero, and
+ * symmetric if rowNum == colNum
+ */
+vector<double> random_dense_matrix(int rowNum, int colNum) {
+    vector<double> dense(rowNum * colNum, 0.0);
+    for (int i = 0; i < rowNum; i++) {
+        for (int j = 0; j < colNum; j++) {
+            if (rowNum == colNum && j < i)
+                dense[i * colNum + j] = dense[j * colNum + i];
+            else if (rand() % 2 == 0)
+                dense[i * colNum + j] = (rand() % 201 - 100) / 10.0;
+        }
+    }
+    return dense;
+}
+
+
+shared_ptr<SpHbMat> to_SpHbMat(const vector<double> &dense, int rowNum, int colNum,
+                               bool isCompressedRow) {
+    auto triplet = make_shared<SpTripletMat>(dense.data(), rowNum, colNum, true);
+    auto result = make_shared<SpHbMat>(rowNum, colNum, isCompressedRow);
+    result->setStructure(triplet);
+    result->setMatVal(triplet);
+    return result;
+}
+
+
+bool TEST_DENSE_EQUAL(shared_ptr<const SpHbMat> m, const vector<double> &dense,
+                      const char* name) {
+    vector<double> m_dense(dense.size(), 0.0);
+    m->get_dense_matrix(m_dense.data());
+    return TEST_EQUAL_DOUBLE_ARRAY(m_dense.data(), dense.data(), dense.size(), name);
+}
+
+
+/**
+ * @brief check that a snapshot is loaded as it was written, for both orientations
+ * of the matrices, with and without a Hessian and a working set
+ */
+bool TEST_SNAPSHOT_ROUND_TRIP(int nVar, int nConstr, QPType qptype,
+                              bool isCompressedRow, bool with_working_set) {
+    vector<double> A_dense = random_dense_matrix(nConstr, nVar);
+    vector<double> H_dense = random_dense_matrix(nVar, nVar);
+    auto A = to_SpHbMat(A_dense, nConstr, nVar, isCompressedRow);
+    auto H = to_SpHbMat(H_dense, nVar, nVar, isCompressedRow);
+
+    vector<double> g(nVar), lb(nVar), ub(nVar), lbA(nConstr), ubA(nConstr);
+    vector<ActiveType> W_bounds(nVar), W_constr(nConstr);
+    const ActiveType types[4] = {ACTIVE_ABOVE, ACTIVE_BELOW, ACTIVE_BOTH_SIDE,
+                                 INACTIVE
+                                };
+    for (int i = 0; i < nVar; i++) {
+        g[i] = (rand() % 201 - 100) / 10.0;
+        lb[i] = -(rand() % 10) - INF * (rand() % 2);
+        ub[i] = rand() % 10;
+        W_bounds[i] = types[rand() % 4];
+    }
+    for (int i = 0; i < nConstr; i++) {
+        lbA[i] = -(rand() % 10);
+        ubA[i] = rand() % 10 + INF * (rand() % 2);
+        W_constr[i] = types[rand() % 4];
+    }
+    auto options = make_shared<Options>();
+    options->qp_maxiter = rand() % 1000 + 1;
+    options->lp_maxiter = rand() % 1000 + 1;
+    options->qpPrintLevel = rand() % 4;
+
+    QPSnapshot::write(SNAPSHOT_FILE, qptype, QPOASES, QPERROR_EXCEED_MAX_ITER,
+                      options, qptype == LP ? nullptr : H, A, g.data(), lb.data(),
+                      ub.data(), lbA.data(), ubA.data(),
+                      with_working_set ? W_bounds.data() : NULL,
+                      with_working_set ? W_constr.data() : NULL);
+
+    bool passed = true;
+    {
+        QPSnapshot snapshot(SNAPSHOT_FILE);
+        passed = snapshot.nVar() == nVar && snapshot.nConstr() == nConstr &&
+                 snapshot.qptype() == qptype && snapshot.solver() == QPOASES &&
+                 snapshot.status() == QPERROR_EXCEED_MAX_ITER &&
+                 snapshot.nnz_A() == A->EntryNum() &&
+                 snapshot.A_isCompressedRow() == isCompressedRow &&
+                 snapshot.nnz_H() == (qptype == LP ? 0 : H->EntryNum()) &&
+                 snapshot.has_working_set() == with_working_set;
+
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.A_values(), A->MatVal(),
+                                         A->EntryNum(), "A_values") && passed;
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.g(), g.data(), nVar, "g") && passed;
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.lb(), lb.data(), nVar, "lb") &&
+                 passed;
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.ub(), ub.data(), nVar, "ub") &&
+                 passed;
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.lbA(), lbA.data(), nConstr, "lbA")
+                 && passed;
+        passed = TEST_EQUAL_DOUBLE_ARRAY(snapshot.ubA(), ubA.data(), nConstr, "ubA")
+                 && passed;
+        if (with_working_set) {
+            for (int i = 0; i < nVar; i++)
+                passed = snapshot.W_bounds()[i] == W_bounds[i] && passed;
+            for (int i = 0; i < nConstr; i++)
+                passed = snapshot.W_constr()[i] == W_constr[i] && passed;
+        }
+
+        auto loaded_options = snapshot.get_options();
+        passed = loaded_options->qp_maxiter == options->qp_maxiter &&
+                 loaded_options->lp_maxiter == options->lp_maxiter &&
+                 loaded_options->qpPrintLevel == options->qpPrintLevel && passed;
+
+        //the matrices are rebuilt in either orientation
+        for (int orientation = 0; orientation < 2; orientation++) {
+            passed = TEST_DENSE_EQUAL(snapshot.get_A(orientation), A_dense, "A") &&
+                     passed;
+            if (qptype == LP)
+                passed = snapshot.get_H(orientation)->EntryNum() == 0 && passed;
+            else
+                passed = TEST_DENSE_EQUAL(snapshot.get_H(orientation), H_dense, "H")
+                         && passed;
+        }
+    }
+    remove(SNAPSHOT_FILE);
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    Snapshot round trip test for %s %s%s passed!\n",
+               qptype == LP ? "LP" : "QP", isCompressedRow ? "CSR" : "CSC",
+               with_working_set ? " with working set" : "");
+    else
+        printf("    Snapshot round trip test for %s %s%s FAILED!\n",
+               qptype == LP ? "LP" : "QP", isCompressedRow ? "CSR" : "CSC",
+               with_working_set ? " with working set" : "");
+    printf("---------------------------------------------------------\n");
+    return passed;
+}
+
+
+/** @brief a snapshot is rejected if it is truncated or any byte changed*/
+bool TEST_CORRUPTED_SNAPSHOT(int nVar, int nConstr) {
+    vector<double> A_dense = random_dense_matrix(nConstr, nVar);
+    vector<double> H_dense = random_dense_matrix(nVar, nVar);
+    auto A = to_SpHbMat(A_dense, nConstr, nVar, false);
+    auto H = to_SpHbMat(H_dense, nVar, nVar, false);
+    vector<double> x(nVar + nConstr, 1.0);
+
+    QPSnapshot::write(SNAPSHOT_FILE, QP, QORE, QPERROR_INFEASIBLE, nullptr, H, A,
+                      x.data(), x.data(), x.data(), x.data(), x.data());
+    FILE* file = fopen(SNAPSHOT_FILE, "rb");
+    vector<char> bytes;
+    int c;
+    while ((c = fgetc(file)) != EOF)
+        bytes.push_back((char) c);
+    fclose(file);
+
+    bool passed = true;
+    //flip one byte of the header, and one of the payload, then cut the file short
+    size_t positions[3] = {0, bytes.size() - 1, 0};
+    for (int trial = 0; trial < 3; trial++) {
+        vector<char> corrupted = bytes;
+        if (trial < 2)
+            corrupted[positions[trial]] ^= 0x10;
+        else
+            corrupted.resize(bytes.size() - 8);
+        file = fopen(SNAPSHOT_FILE, "wb");
+        fwrite(corrupted.data(), 1, corrupted.size(), file);
+        fclose(file);
+        bool is_rejected = false;
+        try {
+            QPSnapshot snapshot(SNAPSHOT_FILE);
+        }
+        catch (INVALID_QP_SNAPSHOT &) {
+            is_rejected = true;
+        }
+        passed = is_rejected && passed;
+    }
+    remove(SNAPSHOT_FILE);
+
+    printf("---------------------------------------------------------\n");
+    if (passed)
+        printf("    Corrupted snapshot test passed!\n");
+    else
+        printf("    Corrupted snapshot test FAILED!\n");
+    printf("---------------------------------------------------------\n");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int nVar = rand() % 10 + 2;
+    int nConstr = rand() % 10 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing Methods for QPSnapshot on randomly generated data,\n"
+           "   nVar = %d, nConstr = %d.", nVar, nConstr);
+    printf("\n=========================================================\n");
+
+    for (int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        TEST_SNAPSHOT_ROUND_TRIP(nVar, nConstr, QP, isCompressedRow, true);
+        TEST_SNAPSHOT_ROUND_TRIP(nVar, nConstr, LP, isCompressedRow, false);
+    }
+
+    TEST_CORRUPTED_SNAPSHOT(nVar, nConstr);
+
+    return 0;
+}
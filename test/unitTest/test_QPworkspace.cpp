@@ -0,0 +1,195 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/DenseQPInterface.hpp>
+#include <sqphot/qpOASESInterface.hpp>
+#include <sqphot/QOREInterface.hpp>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <new>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+/**
+ * Allocation-counting hook: while is_counting is set, every call of the global
+ * operator new (which new[], make_shared and the containers go through) is counted.
+ */
+//@{
+static bool is_counting = false;
+static long allocation_count = 0;
+
+void* operator new(std::size_t size) {
+    if (is_counting)
+        allocation_count++;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void start_counting() {
+    allocation_count = 0;
+    is_counting = true;
+}
+
+long stop_counting() {
+    is_counting = false;
+    return allocation_count;
+}
+//@}
+
+
+double random_double(double lower, double upper) {
+    return lower + (upper - lower) * rand() / RAND_MAX;
+}
+
+
+shared_ptr<SpHbMat> to_SpHbMat(const vector<double> &dense, int rowNum, int colNum,
+                               bool isCompressedRow) {
+    auto triplet = make_shared<SpTripletMat>(dense.data(), rowNum, colNum, true);
+    auto result = make_shared<SpHbMat>(rowNum, colNum, isCompressedRow);
+    result->setStructure(triplet);
+    result->setMatVal(triplet);
+    return result;
+}
+
+
+/**
+ * @brief a random QP with the structure of the SL1QP subproblems, A = [J I -I],
+ * with the bounds laid out for qpOASES and the dense solver, and for QORE
+ */
+struct PenaltyQP {
+    int nVar;
+    int nConstr;
+    shared_ptr<SpHbMat> H_csc, H_csr, A_csc, A_csr;
+    shared_ptr<Vector> g, lb, ub, lbA, ubA, lb_qore, ub_qore;
+
+    PenaltyQP(int nx, int nCon) :
+        nVar(nx + 2 * nCon),
+        nConstr(nCon) {
+        vector<double> B(nx * nx), H(nVar * nVar, 0.0), A(nCon * nVar, 0.0);
+        for (double &b : B)
+            b = random_double(-1, 1);
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < nx; j++) {
+                for (int k = 0; k < nx; k++)
+                    H[i * nVar + j] += B[k * nx + i] * B[k * nx + j];
+                H[i * nVar + j] += i == j ? 0.1 : 0.0;
+            }
+        for (int i = 0; i < nCon; i++) {
+            for (int j = 0; j < nx; j++)
+                A[i * nVar + j] = rand() % 2 ? random_double(-5, 5) : 0.0;
+            A[i * nVar + nx + i] = 1.0;
+            A[i * nVar + nx + nCon + i] = -1.0;
+        }
+        H_csc = to_SpHbMat(H, nVar, nVar, false);
+        H_csr = to_SpHbMat(H, nVar, nVar, true);
+        A_csc = to_SpHbMat(A, nCon, nVar, false);
+        A_csr = to_SpHbMat(A, nCon, nVar, true);
+
+        g = make_shared<Vector>(nVar);
+        lb = make_shared<Vector>(nVar);
+        ub = make_shared<Vector>(nVar);
+        lbA = make_shared<Vector>(nCon);
+        ubA = make_shared<Vector>(nCon);
+        lb_qore = make_shared<Vector>(nVar + nCon);
+        ub_qore = make_shared<Vector>(nVar + nCon);
+        for (int j = 0; j < nVar; j++) {
+            g->setValueAt(j, j < nx ? random_double(-10, 10) : 100.0);
+            lb->setValueAt(j, j < nx ? -1.0 : 0.0);
+            ub->setValueAt(j, j < nx ? 1.0 : INF);
+        }
+        for (int i = 0; i < nCon; i++) {
+            lbA->setValueAt(i, random_double(-5, 5));
+            ubA->setValueAt(i, i % 2 == 0 ? lbA->values(i) : INF);
+        }
+        std::copy(lb->values(), lb->values() + nVar, lb_qore->values());
+        std::copy(ub->values(), ub->values() + nVar, ub_qore->values());
+        std::copy(lbA->values(), lbA->values() + nCon, lb_qore->values() + nVar);
+        std::copy(ubA->values(), ubA->values() + nCon, ub_qore->values() + nVar);
+    }
+};
+
+
+void PRINT_RESULT(bool passed, const char* name) {
+    printf("---------------------------------------------------------\n");
+    printf("    %s test %s\n", name, passed ? "passed!" : "FAILED!");
+    printf("---------------------------------------------------------\n");
+}
+
+
+/**
+ * @brief solve a sequence of QPs whose gradient changes, as between SQP
+ * iterations, and count the allocations of the calls made after each solve; the
+ * solve itself is counted too if count_solve is set
+ */
+bool TEST_NO_ALLOCATION(QPSolverInterface &interface, int nVar, int nConstr,
+                        bool count_solve, const char* name) {
+    bool passed = true;
+    auto stats = make_shared<Stats>();
+    vector<ActiveType> W_bounds(nVar), W_constr(nConstr);
+    vector<double> y_bounds(nVar), y_constr(nConstr);
+    for (int k = 0; k < 10; k++) {
+        for (int j = 0; j < nVar - 2 * nConstr; j++)
+            interface.set_g(j, interface.getG()->values(j) + random_double(-0.1, 0.1));
+        //the first solve may size the data structures of the solver
+        if (count_solve && k > 0)
+            start_counting();
+        try {
+            interface.optimizeQP(stats);
+        }
+        catch (...) {
+            stop_counting();
+            printf("    QP %d is not solved\n", k);
+            passed = false;
+            continue;
+        }
+        start_counting();
+        interface.test_optimality(W_constr.data(), W_bounds.data());
+        interface.test_optimality();
+        interface.get_working_set(W_constr.data(), W_bounds.data());
+        interface.get_obj_value();
+        interface.set_warm_start(W_constr.data(), W_bounds.data(),
+                                 interface.get_optimal_solution(),
+                                 interface.get_multipliers_bounds(),
+                                 interface.get_multipliers_constr());
+        long count = stop_counting();
+        if (count > 0) {
+            printf("    %ld allocations after QP %d\n", count, k);
+            passed = false;
+        }
+    }
+    PRINT_RESULT(passed, name);
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int nx = rand() % 20 + 2;
+    int nConstr = rand() % 20 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing the workspace of the QP solver interfaces,\n"
+           "   nVar = %d, nConstr = %d.", nx, nConstr);
+    printf("\n=========================================================\n");
+
+    PenaltyQP qp(nx, nConstr);
+    DenseQPInterface dense(qp.H_csr, qp.A_csr, qp.g, qp.lb, qp.ub, qp.lbA, qp.ubA);
+    TEST_NO_ALLOCATION(dense, qp.nVar, qp.nConstr, true, "DenseQPInterface");
+
+    auto options = make_shared<Options>();
+    options->qpPrintLevel = 0;
+    qpOASESInterface qpoases(qp.H_csc, qp.A_csc, qp.g, qp.lb, qp.ub, qp.lbA, qp.ubA,
+                             options);
+    TEST_NO_ALLOCATION(qpoases, qp.nVar, qp.nConstr, false, "qpOASESInterface");
+
+    QOREInterface qore(qp.H_csr, qp.A_csr, qp.g, qp.lb_qore, qp.ub_qore, options);
+    TEST_NO_ALLOCATION(qore, qp.nVar, qp.nConstr, false, "QOREInterface");
+
+    return 0;
+}
@@ -377,6 +377,7 @@ bool TEST_TRIPLET_HB_MATIRX_CONVERSION(int rowNum, int colNum, const double* den
         m_triplet_csr_out->print("m_triplet_csr_out");
         printf("---------------------------------------------------------\n");
     }
+    return true;
 }
 
 
@@ -387,15 +388,463 @@ bool TEST_MATRIX_ALLOCATION_FROM_PERMUTATIONS() {
 
 
 
+/** the seed of the shuffles of shuffled_triplet, fixed so that a failure can be
+ * reproduced with the same order of the entries*/
+const unsigned SHUFFLE_SEED = 2019;
+
+
+/**
+ * @brief build a (non-symmetric) triplet matrix from a row-oriented dense matrix,
+ * with the entries stored in a shuffled order so that the permutation order_
+ * recorded by setStructure is exercised.
+ */
+shared_ptr<SpTripletMat> shuffled_triplet(int rowNum, int colNum,
+        const double* dense_matrix_in, std::mt19937& g) {
+    std::vector<int> nonzeros;
+    for(int i = 0; i < rowNum * colNum; i++)
+        if(dense_matrix_in[i] != 0)
+            nonzeros.push_back(i);
+    std::shuffle(nonzeros.begin(), nonzeros.end(), g);
+
+    auto triplet = make_shared<SpTripletMat>(nonzeros.size(), rowNum, colNum,
+                   false, true);
+    for(size_t k = 0; k < nonzeros.size(); k++) {
+        triplet->setRowIndex(k, nonzeros[k] / colNum + 1);
+        triplet->setColIndex(k, nonzeros[k] % colNum + 1);
+        triplet->setMatValAt(k, dense_matrix_in[nonzeros[k]]);
+    }
+    return triplet;
+}
+
+
+/**
+ * @brief compare the structure built by setStructure with the one built
+ * directly from the dense matrix, and check that order_ maps every triplet entry
+ * to its Harwell-Boeing position.
+ */
+bool TEST_HB_STRUCTURE_EQUAL(shared_ptr<const SpHbMat> m, shared_ptr<const SpHbMat>
+                             m_ref, shared_ptr<const SpTripletMat> triplet,
+                             bool isCompressedRow, const char* name) {
+
+    if(m->EntryNum() != m_ref->EntryNum()) {
+        printf("number of entries for %s is %d, expected %d\n", name,
+               m->EntryNum(), m_ref->EntryNum());
+        return false;
+    }
+
+    bool passed;
+    if(isCompressedRow)
+        passed = TEST_EQUAL_INT_ARRAY(m->RowIndex(), m_ref->RowIndex(),
+                                      m->RowNum() + 1, name) &&
+                 TEST_EQUAL_INT_ARRAY(m->ColIndex(), m_ref->ColIndex(),
+                                      m->EntryNum(), name);
+    else
+        passed = TEST_EQUAL_INT_ARRAY(m->ColIndex(), m_ref->ColIndex(),
+                                      m->ColNum() + 1, name) &&
+                 TEST_EQUAL_INT_ARRAY(m->RowIndex(), m_ref->RowIndex(),
+                                      m->EntryNum(), name);
+    passed = passed && TEST_EQUAL_DOUBLE_ARRAY(m->MatVal(), m_ref->MatVal(),
+             m->EntryNum(), name);
+
+    //every triplet entry has to be found at the position given by order_
+    for(int k = 0; k < triplet->EntryNum() && passed; k++) {
+        int pos = m->order(k);
+        int major = isCompressedRow ? triplet->RowIndex(k) : triplet->ColIndex(k);
+        int minor = isCompressedRow ? triplet->ColIndex(k) : triplet->RowIndex(k);
+        const int* pointer = isCompressedRow ? m->RowIndex() : m->ColIndex();
+        const int* index = isCompressedRow ? m->ColIndex() : m->RowIndex();
+        if(pos < pointer[major - 1] || pos >= pointer[major] ||
+                index[pos] != minor - 1) {
+            printf("order for %s is wrong at entry %d\n", name, k);
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+
 bool TEST_SET_STRUCTURE(int rowNum, int colNum, const double* dense_matrix_in) {
 
+    std::mt19937 g(SHUFFLE_SEED);
+    bool passed = true;
+
+    /**-------------------------------------------------------**/
+    /**             Without Identity Submatrix                **/
+    /**-------------------------------------------------------**/
+    auto m_triplet_in = shuffled_triplet(rowNum, colNum, dense_matrix_in, g);
+
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        auto m_ref = make_shared<SpHbMat>(dense_matrix_in, rowNum, colNum, true,
+                                          isCompressedRow);
+        auto m = make_shared<SpHbMat>(rowNum, colNum, isCompressedRow);
+        m->setStructure(m_triplet_in);
+        passed = TEST_HB_STRUCTURE_EQUAL(m, m_ref, m_triplet_in, isCompressedRow,
+                                         isCompressedRow ? "csr" : "csc") && passed;
+    }
+
+    /**-------------------------------------------------------**/
+    /**             With Identity Submatrix [J I -I]          **/
+    /**-------------------------------------------------------**/
+    int colNum_I = colNum + 2 * rowNum;
+    auto dense_matrix_I = new double[rowNum * colNum_I]();
+    for(int i = 0; i < rowNum; i++) {
+        for(int j = 0; j < colNum; j++)
+            dense_matrix_I[i * colNum_I + j] = dense_matrix_in[i * colNum + j];
+        dense_matrix_I[i * colNum_I + colNum + i] = 1.0;
+        dense_matrix_I[i * colNum_I + colNum + rowNum + i] = -1.0;
+    }
+
+    auto I_info = make_elastic_identity(rowNum, colNum);
+
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        auto m_ref = make_shared<SpHbMat>(dense_matrix_I, rowNum, colNum_I, true,
+                                          isCompressedRow);
+        auto m = make_shared<SpHbMat>(m_triplet_in->EntryNum() + 2 * rowNum, rowNum,
+                                      colNum_I, isCompressedRow);
+        m->setStructure(m_triplet_in, *I_info);
+        passed = TEST_HB_STRUCTURE_EQUAL(m, m_ref, m_triplet_in, isCompressedRow,
+                                         isCompressedRow ? "csr_I" : "csc_I") && passed;
+    }
+
+    /**-------------------------------------------------------**/
+    /**             Symmetric matrix A^T A                    **/
+    /**-------------------------------------------------------**/
+    auto dense_matrix_sym = new double[colNum * colNum]();
+    for(int i = 0; i < colNum; i++)
+        for(int j = 0; j < colNum; j++)
+            for(int k = 0; k < rowNum; k++)
+                dense_matrix_sym[i * colNum + j] += dense_matrix_in[k * colNum + i] *
+                                                    dense_matrix_in[k * colNum + j];
+
+    auto m_triplet_sym = make_shared<SpTripletMat>(dense_matrix_sym, colNum, colNum,
+                         true);
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        auto m_ref = make_shared<SpHbMat>(dense_matrix_sym, colNum, colNum, true,
+                                          isCompressedRow);
+        auto m = make_shared<SpHbMat>(colNum, colNum, isCompressedRow);
+        m->setStructure(m_triplet_sym);
+        m->setMatVal(m_triplet_sym);
+        passed = TEST_EQUAL_INT_ARRAY(isCompressedRow ? m->RowIndex() : m->ColIndex(),
+                                      isCompressedRow ? m_ref->RowIndex() : m_ref->ColIndex(),
+                                      colNum + 1, "sym") &&
+                 m->EntryNum() == m_ref->EntryNum() &&
+                 TEST_EQUAL_DOUBLE_ARRAY(m->MatVal(), m_ref->MatVal(), m->EntryNum(),
+                                         "sym") && passed;
+    }
+
+    if(passed) {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing setStructure and the permutation order\n"
+               "    passed!       \n");
+        printf("---------------------------------------------------------\n");
+    } else {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing setStructure and the permutation order\n"
+               "    FAILED!       \n");
+        printf("---------------------------------------------------------\n");
+    }
+
+    delete[] dense_matrix_I;
+    delete[] dense_matrix_sym;
+    return passed;
+}
+
+bool TEST_SET_MATRIX_VALUE(int rowNum, int colNum, const double* dense_matrix_in) {
+
+    std::mt19937 g(SHUFFLE_SEED);
+    bool passed = true;
+
+    auto m_triplet_in = shuffled_triplet(rowNum, colNum, dense_matrix_in, g);
+
+    //new values on the same sparsity pattern
+    auto dense_matrix_new = new double[rowNum * colNum]();
+    for(int i = 0; i < rowNum * colNum; i++)
+        dense_matrix_new[i] = 2.0 * dense_matrix_in[i] + 1.0 * (dense_matrix_in[i] != 0);
+    for(int k = 0; k < m_triplet_in->EntryNum(); k++)
+        m_triplet_in->setMatValAt(k, 2.0 * m_triplet_in->MatVal(k) + 1.0);
+
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        auto m_ref = make_shared<SpHbMat>(dense_matrix_new, rowNum, colNum, true,
+                                          isCompressedRow);
+        auto m = make_shared<SpHbMat>(rowNum, colNum, isCompressedRow);
+        m->setStructure(m_triplet_in);
+        m->setMatVal(m_triplet_in);
+        passed = TEST_EQUAL_DOUBLE_ARRAY(m->MatVal(), m_ref->MatVal(), m->EntryNum(),
+                                         "setMatVal") && passed;
+    }
+
+    if(passed) {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing setMatVal passed!       \n");
+        printf("---------------------------------------------------------\n");
+    } else {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing setMatVal FAILED!       \n");
+        printf("---------------------------------------------------------\n");
+    }
+
+    delete[] dense_matrix_new;
+    return passed;
+}
+
+
+/**
+ * @brief compare the matrix [J I -I] with implicit identity blocks against the one
+ * with explicit identity entries, before and after the values of J change.
+ */
+bool TEST_IMPLICIT_IDENTITY_BLOCKS(int rowNum, int colNum,
+                                   const double* dense_matrix_in) {
+
+    std::mt19937 g(SHUFFLE_SEED);
+    bool passed = true;
+
+    auto m_triplet_in = shuffled_triplet(rowNum, colNum, dense_matrix_in, g);
+    int colNum_I = colNum + 2 * rowNum;
+
+    auto I_info = make_elastic_identity(rowNum, colNum);
+
+    auto p = make_shared<Vector>(colNum_I);
+    auto q = make_shared<Vector>(rowNum);
+    for(int i = 0; i < colNum_I; i++)
+        p->setValueAt(i, rand() % 10 - 5);
+    for(int i = 0; i < rowNum; i++)
+        q->setValueAt(i, rand() % 10 - 5);
+
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        const char* name = isCompressedRow ? "csr_implicit" : "csc_implicit";
+        auto m_ref = make_shared<SpHbMat>(m_triplet_in->EntryNum() + 2 * rowNum,
+                                          rowNum, colNum_I, isCompressedRow);
+        m_ref->setStructure(m_triplet_in, *I_info);
+        auto m = make_shared<SpHbMat>(m_triplet_in->EntryNum(), rowNum, colNum_I,
+                                      isCompressedRow);
+        m->set_identity_blocks(*I_info);
+        m->setStructure(m_triplet_in);
+
+        //only the entries of J are stored
+        passed = m->EntryNum() == m_triplet_in->EntryNum() &&
+                 m->IdentityEntryNum() == 2 * rowNum && passed;
+
+        for(int iter = 0; iter < 2; iter++) {
+            if(iter == 1) {
+                //new values on the same sparsity pattern
+                for(int k = 0; k < m_triplet_in->EntryNum(); k++)
+                    m_triplet_in->setMatValAt(k, 2.0 * m_triplet_in->MatVal(k) + 1.0);
+                m_ref->setMatVal(m_triplet_in, *I_info);
+                m->setMatVal(m_triplet_in);
+            }
+            auto m_expanded = m->expanded();
+            passed = TEST_HB_STRUCTURE_EQUAL(m_expanded, m_ref, m_triplet_in,
+                                             isCompressedRow, name) && passed;
+
+            auto result = make_shared<Vector>(rowNum);
+            auto result_ref = make_shared<Vector>(rowNum);
+            m->times(p, result);
+            m_ref->times(p, result_ref);
+            passed = TEST_EQUAL_DOUBLE_ARRAY(result->values(), result_ref->values(),
+                                             rowNum, name) && passed;
+
+            auto result_trans = make_shared<Vector>(colNum_I);
+            auto result_trans_ref = make_shared<Vector>(colNum_I);
+            m->transposed_times(q, result_trans);
+            m_ref->transposed_times(q, result_trans_ref);
+            passed = TEST_EQUAL_DOUBLE_ARRAY(result_trans->values(),
+                                             result_trans_ref->values(), colNum_I,
+                                             name) && passed;
+
+            auto dense = new double[rowNum * colNum_I]();
+            auto dense_ref = new double[rowNum * colNum_I]();
+            m->get_dense_matrix(dense);
+            m_ref->get_dense_matrix(dense_ref);
+            passed = TEST_EQUAL_DOUBLE_ARRAY(dense, dense_ref, rowNum * colNum_I,
+                                             name) && passed;
+            delete[] dense;
+            delete[] dense_ref;
+
+            passed = m->oneNorm() == m_ref->oneNorm() &&
+                     m->infNorm() == m_ref->infNorm() && passed;
+        }
+    }
+
+    if(passed) {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing implicit identity blocks passed!       \n");
+        printf("---------------------------------------------------------\n");
+    } else {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing implicit identity blocks FAILED!       \n");
+        printf("---------------------------------------------------------\n");
+    }
+
+    return passed;
+}
 
 
+/**
+ * @brief compare the threaded times and transposed_times of [J I -I] against the
+ * serial ones, for J large enough to be split. The entries are small integers, so
+ * both have to agree exactly.
+ */
+bool TEST_PARALLEL_MATRIX_VECTOR_MULTIPLICATION() {
+    int rowNum = 2000;
+    int colNum = 3000;
+    int colNum_I = colNum + 2 * rowNum;
+    int EntryNum = 30 * rowNum;
+    auto triplet = make_shared<SpTripletMat>(EntryNum, rowNum, colNum, false, true);
+    for(int k = 0; k < EntryNum; k++) {
+        triplet->setRowIndex(k, rand() % rowNum + 1);
+        triplet->setColIndex(k, rand() % colNum + 1);
+        triplet->setMatValAt(k, rand() % 11 - 5);
+    }
+
+    auto I_info = make_elastic_identity(rowNum, colNum);
+
+    auto p = make_shared<Vector>(colNum_I);
+    auto q = make_shared<Vector>(rowNum);
+    for(int i = 0; i < colNum_I; i++)
+        p->setValueAt(i, rand() % 11 - 5);
+    for(int i = 0; i < rowNum; i++)
+        q->setValueAt(i, rand() % 11 - 5);
+
+    bool passed = true;
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        auto m = make_shared<SpHbMat>(EntryNum, rowNum, colNum_I, isCompressedRow);
+        m->set_identity_blocks(*I_info);
+        m->setStructure(triplet);
+        m->setMatVal(triplet);
+        //the threads are set before the structure, so the cached transpose has to
+        //follow setMatVal
+        auto m_parallel = make_shared<SpHbMat>(EntryNum, rowNum, colNum_I,
+                                               isCompressedRow);
+        m_parallel->set_num_threads(4);
+        m_parallel->set_identity_blocks(*I_info);
+        m_parallel->setStructure(triplet);
+        m_parallel->setMatVal(triplet);
+
+        auto result_serial = make_shared<Vector>(rowNum);
+        auto result_parallel = make_shared<Vector>(rowNum);
+        auto result_trans_serial = make_shared<Vector>(colNum_I);
+        auto result_trans_parallel = make_shared<Vector>(colNum_I);
+        m->times(p, result_serial);
+        m->transposed_times(q, result_trans_serial);
+        m_parallel->times(p, result_parallel);
+        m_parallel->transposed_times(q, result_trans_parallel);
+
+        passed = TEST_EQUAL_DOUBLE_ARRAY(result_serial->values(),
+                                         result_parallel->values(), rowNum,
+                                         "times") &&
+                 TEST_EQUAL_DOUBLE_ARRAY(result_trans_serial->values(),
+                                         result_trans_parallel->values(), colNum_I,
+                                         "transposed_times") && passed;
+    }
 
+    if(passed) {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing parallel matrix-vector multiplication passed!\n");
+        printf("---------------------------------------------------------\n");
+    } else {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing parallel matrix-vector multiplication FAILED!\n");
+        printf("---------------------------------------------------------\n");
+    }
 
+    return passed;
 }
 
-bool TEST_SET_MATRIX_VALUE() {
+
+
+/**
+ * @brief compare [J I -I] whose values are updated entry by entry, for a random
+ * subset of the entries of J, against the one updated by a full setMatVal; the
+ * cached transpose and expanded matrix have to follow both updates.
+ */
+bool TEST_SET_PARTIAL_MATRIX_VALUE() {
+    int rowNum = 500;
+    int colNum = 700;
+    int colNum_I = colNum + 2 * rowNum;
+    int EntryNum = 10 * rowNum;
+    auto triplet = make_shared<SpTripletMat>(EntryNum, rowNum, colNum, false, true);
+    for(int k = 0; k < EntryNum; k++) {
+        triplet->setRowIndex(k, rand() % rowNum + 1);
+        triplet->setColIndex(k, rand() % colNum + 1);
+        triplet->setMatValAt(k, rand() % 11 - 5);
+    }
+
+    auto I_info = make_elastic_identity(rowNum, colNum);
+
+    auto p = make_shared<Vector>(colNum_I);
+    auto q = make_shared<Vector>(rowNum);
+    for(int i = 0; i < colNum_I; i++)
+        p->setValueAt(i, rand() % 11 - 5);
+    for(int i = 0; i < rowNum; i++)
+        q->setValueAt(i, rand() % 11 - 5);
+
+    bool passed = true;
+    for(int isCompressedRow = 0; isCompressedRow < 2; isCompressedRow++) {
+        const char* name = isCompressedRow ? "csr_partial" : "csc_partial";
+        shared_ptr<SpHbMat> m[2];
+        for(int j = 0; j < 2; j++) {
+            //with more than one thread the transpose is cached
+            m[j] = make_shared<SpHbMat>(EntryNum, rowNum, colNum_I, isCompressedRow);
+            m[j]->set_num_threads(4);
+            m[j]->set_identity_blocks(*I_info);
+            m[j]->setStructure(triplet);
+            m[j]->setMatVal(triplet);
+        }
+        auto m_full = m[0];
+        auto m_partial = m[1];
+        m_partial->expanded();
+
+        for(int iter = 0; iter < 2; iter++) {
+            if(iter == 1) {
+                //a full update leaves the expanded matrix out of date, which the
+                //partial update after it must not depend on
+                m_partial->setMatVal(triplet);
+            }
+            std::vector<int> entries;
+            for(int k = 0; k < EntryNum; k++)
+                if(rand() % 4 == 0) {
+                    entries.push_back(k);
+                    triplet->setMatValAt(k, rand() % 11 - 5);
+                }
+            m_full->setMatVal(triplet);
+            m_partial->setMatVal(triplet, entries);
+
+            passed = TEST_EQUAL_DOUBLE_ARRAY(m_partial->MatVal(), m_full->MatVal(),
+                                             EntryNum, name) && passed;
+            auto expanded = m_partial->expanded();
+            auto expanded_ref = m_full->expanded();
+            passed = TEST_EQUAL_DOUBLE_ARRAY(expanded->MatVal(),
+                                             expanded_ref->MatVal(),
+                                             expanded->EntryNum(), name) && passed;
+
+            auto result = make_shared<Vector>(rowNum);
+            auto result_ref = make_shared<Vector>(rowNum);
+            m_partial->times(p, result);
+            m_full->times(p, result_ref);
+            passed = TEST_EQUAL_DOUBLE_ARRAY(result->values(), result_ref->values(),
+                                             rowNum, name) && passed;
+
+            auto result_trans = make_shared<Vector>(colNum_I);
+            auto result_trans_ref = make_shared<Vector>(colNum_I);
+            m_partial->transposed_times(q, result_trans);
+            m_full->transposed_times(q, result_trans_ref);
+            passed = TEST_EQUAL_DOUBLE_ARRAY(result_trans->values(),
+                                             result_trans_ref->values(), colNum_I,
+                                             name) && passed;
+        }
+    }
+
+    if(passed) {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing partial matrix value update passed!\n");
+        printf("---------------------------------------------------------\n");
+    } else {
+        printf("---------------------------------------------------------\n");
+        printf("   Testing partial matrix value update FAILED!\n");
+        printf("---------------------------------------------------------\n");
+    }
+
+    return passed;
 }
 
 
@@ -471,6 +920,20 @@ int main(int argc, char* argv[]) {
 
     TEST_TRIPLET_HB_MATIRX_CONVERSION(rowNum, colNum, dense_matrix_in);
 
+    /**-------------------------------------------------------**/
+    /**            Set Structure and Matrix Value             **/
+    /**-------------------------------------------------------**/
+
+    TEST_SET_STRUCTURE(rowNum, colNum, dense_matrix_in);
+
+    TEST_SET_MATRIX_VALUE(rowNum, colNum, dense_matrix_in);
+
+    TEST_IMPLICIT_IDENTITY_BLOCKS(rowNum, colNum, dense_matrix_in);
+
+    TEST_PARALLEL_MATRIX_VECTOR_MULTIPLICATION();
+
+    TEST_SET_PARTIAL_MATRIX_VALUE();
+
 
     delete[] dense_matrix_in;
     isNonzero.clear();
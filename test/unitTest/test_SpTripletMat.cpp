@@ -183,6 +183,55 @@ bool TEST_TRIPLET_HB_MATIRX_CONVERSION() {
 }
 
 
+/**
+ * @brief compare the threaded times and transposed_times on a random matrix large
+ * enough to be split against the serial ones. The entries are small integers, so
+ * both have to agree exactly whatever the order of the summation.
+ */
+bool TEST_PARALLEL_MATRIX_VECTOR_MULTIPLICATION(bool isSymmetric) {
+    int dim = 3000;
+    int EntryNum = 20 * dim;
+    auto m = make_shared<SpTripletMat>(EntryNum, dim, dim, isSymmetric);
+    for(int k = 0; k < EntryNum; k++) {
+        int row = rand() % dim + 1;
+        int col = rand() % dim + 1;
+        if(isSymmetric && col > row)
+            std::swap(row, col);
+        m->setRowIndex(k, row);
+        m->setColIndex(k, col);
+        m->setMatValAt(k, rand() % 11 - 5);
+    }
+    auto p = make_shared<Vector>(dim);
+    for(int i = 0; i < dim; i++)
+        p->setValueAt(i, rand() % 11 - 5);
+
+    auto result_serial = make_shared<Vector>(dim);
+    auto result_parallel = make_shared<Vector>(dim);
+    auto result_trans_serial = make_shared<Vector>(dim);
+    auto result_trans_parallel = make_shared<Vector>(dim);
+    m->times(p, result_serial);
+    m->transposed_times(p, result_trans_serial);
+    m->set_num_threads(4);
+    m->times(p, result_parallel);
+    m->transposed_times(p, result_trans_parallel);
+
+    bool passed = TEST_EQUAL_DOUBLE_ARRAY(result_serial->values(),
+                                          result_parallel->values(), dim, "times") &&
+                  TEST_EQUAL_DOUBLE_ARRAY(result_trans_serial->values(),
+                                          result_trans_parallel->values(), dim,
+                                          "transposed_times");
+    printf("---------------------------------------------------------\n");
+    if(passed)
+        printf("    Parallel %s matrix-vector multiplication test passed!\n",
+               isSymmetric ? "symmetric" : "general");
+    else
+        printf("    Parallel %s matrix-vector multiplication test FAILED!\n",
+               isSymmetric ? "symmetric" : "general");
+    printf("---------------------------------------------------------\n");
+    return passed;
+}
+
+
 int main(int argc, char* argv[]) {
 
 
@@ -316,6 +365,14 @@ int main(int argc, char* argv[]) {
 
     TEST_TRANSPOSED_MATRIX_VECTOR_MULTIPLICATION(dim, dim, dense_matrix_in, vector_sym_mult);
 
+    /**-------------------------------------------------------**/
+    /**      Parallel Matrix-vector Multiplication            **/
+    /**-------------------------------------------------------**/
+
+    TEST_PARALLEL_MATRIX_VECTOR_MULTIPLICATION(false);
+
+    TEST_PARALLEL_MATRIX_VECTOR_MULTIPLICATION(true);
+
 
 
     delete[] dense_matrix_in;
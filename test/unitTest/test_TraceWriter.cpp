@@ -0,0 +1,172 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/TraceWriter.hpp>
+#include <chrono>
+#include <cstring>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+const char* TRACE_FILE = "unitTest_TraceWriter.trace";
+
+
+void PRINT_RESULT(bool passed, const char* name) {
+    printf("---------------------------------------------------------\n");
+    printf("    %s test %s\n", name, passed ? "passed!" : "FAILED!");
+    printf("---------------------------------------------------------\n");
+}
+
+
+IterationRecord random_record(int iter) {
+    IterationRecord record;
+    memset(&record, 0, sizeof(IterationRecord));
+    record.iter = iter;
+    record.qp_iter = rand() % 20;
+    record.accepted = rand() % 2;
+    record.f = (rand() % 2001 - 1000) / 7.0;
+    record.infea_measure = rand() % 1000 / 3.0;
+    record.rho = rand() % 1000 + 1;
+    record.delta = rand() % 1000 / 11.0;
+    record.norm_p = rand() % 1000 / 13.0;
+    record.qp_kkt_error = rand() % 1000 * 1.0e-9;
+    for (int i = 0; i < N_TIMED_PHASES; i++)
+        record.phase_time[i] = rand() % 1000 * 1.0e-6;
+    return record;
+}
+
+
+/**
+ * @brief push records to a trace whose buffer holds all of them, and check that
+ * the trace read back from the file has the same records
+ */
+bool TEST_ROUND_TRIP(int n, bool binary) {
+    bool passed = true;
+    vector<IterationRecord> records;
+    for (int k = 0; k < n; k++)
+        records.push_back(random_record(k + 1));
+    {
+        TraceWriter trace(TRACE_FILE, binary, n);
+        for (int k = 0; k < n; k++)
+            trace.push(records[k]);
+        passed = passed && trace.dropped() == 0;
+    }
+
+    FILE* file = fopen(TRACE_FILE, binary ? "rb" : "r");
+    if (file == NULL) {
+        PRINT_RESULT(false, binary ? "Binary round trip" : "JSON lines round trip");
+        return false;
+    }
+    if (binary) {
+        char magic[8];
+        uint32_t header[4];
+        passed = passed && fread(magic, 1, 8, file) == 8 &&
+                 memcmp(magic, TraceWriter::magic(), 8) == 0;
+        passed = passed && fread(header, sizeof(uint32_t), 4, file) == 4 &&
+                 header[0] == TraceWriter::version &&
+                 header[1] == sizeof(IterationRecord) && header[2] == N_TIMED_PHASES;
+        IterationRecord record;
+        int count = 0;
+        while (fread(&record, sizeof(IterationRecord), 1, file) == 1) {
+            passed = passed && count < n &&
+                     memcmp(&record, &records[count], sizeof(IterationRecord)) == 0;
+            count++;
+        }
+        passed = passed && count == n;
+    }
+    else {
+        char line[4096];
+        int count = 0;
+        while (fgets(line, sizeof(line), file) != NULL) {
+            int iter, qp_iter;
+            double f, infea_measure, rho, delta, norm_p;
+            passed = passed && count < n &&
+                     sscanf(line, "{\"iter\":%d,\"f\":%lf,\"infea_measure\":%lf,"
+                            "\"rho\":%lf,\"delta\":%lf,\"norm_p\":%lf,", &iter, &f,
+                            &infea_measure, &rho, &delta, &norm_p) == 6;
+            if (!passed)
+                break;
+            const IterationRecord &expected = records[count];
+            passed = iter == expected.iter && f == expected.f &&
+                     infea_measure == expected.infea_measure &&
+                     rho == expected.rho && delta == expected.delta &&
+                     norm_p == expected.norm_p;
+            const char* field = strstr(line, "\"qp_iter\":");
+            passed = passed && field != NULL && sscanf(field, "\"qp_iter\":%d",
+                     &qp_iter) == 1 && qp_iter == expected.qp_iter;
+            passed = passed && strstr(line, expected.accepted ? "\"accepted\":true" :
+                                      "\"accepted\":false") != NULL;
+            passed = passed && line[strlen(line) - 1] == '\n' &&
+                     strstr(line, "}}\n") != NULL;
+            count++;
+        }
+        passed = passed && count == n;
+    }
+    fclose(file);
+    remove(TRACE_FILE);
+
+    PRINT_RESULT(passed, binary ? "Binary round trip" : "JSON lines round trip");
+    return passed;
+}
+
+
+/**
+ * @brief push records much faster than they can be written to a small buffer,
+ * and check that every record is either written, in order, or counted as dropped
+ */
+bool TEST_FULL_BUFFER(int n) {
+    bool passed = true;
+    size_t dropped;
+    std::chrono::duration<double> elapsed;
+    {
+        TraceWriter trace(TRACE_FILE, true, 4);
+        IterationRecord record = random_record(0);
+        auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < n; k++) {
+            record.iter = k + 1;
+            trace.push(record);
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+        dropped = trace.dropped();
+    }
+    printf("    %d records pushed in %.1f ns each, %zu dropped\n", n,
+           elapsed.count() * 1e9 / n, dropped);
+
+    FILE* file = fopen(TRACE_FILE, "rb");
+    if (file == NULL) {
+        PRINT_RESULT(false, "Full buffer");
+        return false;
+    }
+    fseek(file, 8 + 4 * sizeof(uint32_t), SEEK_SET);
+    IterationRecord record;
+    int count = 0;
+    int last_iter = 0;
+    while (fread(&record, sizeof(IterationRecord), 1, file) == 1) {
+        passed = passed && record.iter > last_iter;
+        last_iter = record.iter;
+        count++;
+    }
+    fclose(file);
+    remove(TRACE_FILE);
+    passed = passed && count + dropped == (size_t) n;
+
+    PRINT_RESULT(passed, "Full buffer");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int n = rand() % 1000 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing Methods for TraceWriter on %d random records", n);
+    printf("\n=========================================================\n");
+
+    TEST_ROUND_TRIP(n, false);
+    TEST_ROUND_TRIP(n, true);
+    TEST_FULL_BUFFER(100000);
+
+    return 0;
+}
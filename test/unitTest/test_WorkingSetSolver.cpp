@@ -0,0 +1,265 @@
+#include <unit_test_utils.hpp>
+#include <sqphot/DenseLDL.hpp>
+#include <sqphot/DenseQPSolver.hpp>
+#include <sqphot/WorkingSetSolver.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <vector>
+
+using namespace SQPhotstart;
+using namespace std;
+
+const double TOL = 1.0e-6;
+
+double random_double(double lower, double upper) {
+    return lower + (upper - lower) * rand() / RAND_MAX;
+}
+
+
+void PRINT_RESULT(bool passed, const char* name) {
+    printf("---------------------------------------------------------\n");
+    printf("    %s test %s\n", name, passed ? "passed!" : "FAILED!");
+    printf("---------------------------------------------------------\n");
+}
+
+
+/**
+ * @brief factorize Q diag(d) Q^T, with Q a product of random Householder
+ * reflections and d of random signs, and check the inertia and a solve
+ */
+bool TEST_LDL_INERTIA(int n) {
+    bool passed = true;
+    for (int trial = 0; trial < 20; trial++) {
+        vector<double> K(n * n, 0.0), v(n);
+        int num_positive = 0;
+        for (int i = 0; i < n; i++) {
+            double d = random_double(0.1, 10) * (rand() % 2 ? 1 : -1);
+            K[i * n + i] = d;
+            num_positive += d > 0;
+        }
+        for (int r = 0; r < 3; r++) {
+            //K = (I - 2vv^T) K (I - 2vv^T) with ||v|| = 1
+            double norm = 0.0;
+            for (int i = 0; i < n; i++) {
+                v[i] = random_double(-1, 1);
+                norm += v[i] * v[i];
+            }
+            for (int i = 0; i < n; i++)
+                v[i] /= sqrt(norm);
+            vector<double> Kv(n, 0.0);
+            double vKv = 0.0;
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++)
+                    Kv[i] += K[i * n + j] * v[j];
+                vKv += v[i] * Kv[i];
+            }
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j < n; j++)
+                    K[i * n + j] += -2 * v[i] * Kv[j] - 2 * Kv[i] * v[j] +
+                                    4 * vKv * v[i] * v[j];
+        }
+
+        DenseLDL ldl;
+        vector<double> x(n), rhs(n, 0.0);
+        for (int j = 0; j < n; j++)
+            x[j] = random_double(-1, 1);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                rhs[i] += K[i * n + j] * x[j];
+        if (!ldl.factorize(n, K.data()) || ldl.num_positive() != num_positive ||
+                ldl.num_negative() != n - num_positive) {
+            printf("    trial %d: wrong inertia\n", trial);
+            passed = false;
+            continue;
+        }
+        ldl.solve(rhs.data());
+        for (int j = 0; j < n; j++)
+            passed = passed && fabs(rhs[j] - x[j]) <= TOL;
+    }
+    PRINT_RESULT(passed, "DenseLDL inertia and solve");
+    return passed;
+}
+
+
+/** @brief a KKT matrix with dependent rows of A is singular*/
+bool TEST_LDL_SINGULAR(int n) {
+    int m = 2;
+    int N = n + m;
+    vector<double> K(N * N, 0.0);
+    for (int i = 0; i < n; i++)
+        K[i * N + i] = 1.0;
+    for (int j = 0; j < n; j++) {
+        double a = random_double(-1, 1);
+        K[n * N + j] = K[j * N + n] = a;
+        K[(n + 1) * N + j] = K[j * N + n + 1] = 2 * a;
+    }
+    DenseLDL ldl;
+    bool passed = !ldl.factorize(N, K.data());
+    PRINT_RESULT(passed, "DenseLDL singular");
+    return passed;
+}
+
+
+/**
+ * @brief a random SL1QP subproblem, with A = [J I -I] and H = [B 0; 0 0], both
+ * as triplets for WorkingSetSolver and dense for DenseQPSolver
+ */
+struct RandomSL1QP {
+    int nx;
+    int nVar;
+    int nConstr;
+    vector<double> H, A, g, lb, ub, lbA, ubA;
+    shared_ptr<SpTripletMat> B;
+    shared_ptr<SpTripletMat> J;
+    IdentityInfo I_info;
+    int irow[2], jcol[2], size[2];
+    double value[2];
+
+    RandomSL1QP(int nx, int nConstr) :
+        nx(nx),
+        nVar(nx + 2 * nConstr),
+        nConstr(nConstr),
+        H(nVar * nVar, 0.0),
+        A(nConstr * nVar, 0.0),
+        g(nVar),
+        lb(nVar),
+        ub(nVar),
+        lbA(nConstr),
+        ubA(nConstr) {
+        vector<double> C(nx * nx), B_dense(nx * nx, 0.0);
+        for (int i = 0; i < nx * nx; i++)
+            C[i] = random_double(-1, 1);
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < nx; j++) {
+                for (int k = 0; k < nx; k++)
+                    B_dense[i * nx + j] += C[k * nx + i] * C[k * nx + j];
+                B_dense[i * nx + j] += i == j ? 0.1 : 0.0;
+                H[i * nVar + j] = B_dense[i * nx + j];
+            }
+        B = make_shared<SpTripletMat>(B_dense.data(), nx, nx, true);
+
+        vector<double> J_dense(nConstr * nx, 0.0);
+        for (int i = 0; i < nConstr; i++)
+            for (int j = 0; j < nx; j++)
+                if (rand() % 2)
+                    A[i * nVar + j] = J_dense[i * nx + j] = random_double(-5, 5);
+        J = make_shared<SpTripletMat>(J_dense.data(), nConstr, nx, true);
+        for (int i = 0; i < nConstr; i++) {
+            A[i * nVar + nx + i] = 1.0;
+            A[i * nVar + nx + nConstr + i] = -1.0;
+        }
+        I_info.length = 2;
+        I_info.irow = irow;
+        I_info.jcol = jcol;
+        I_info.size = size;
+        I_info.value = value;
+        irow[0] = irow[1] = 1;
+        jcol[0] = nx + 1;
+        jcol[1] = nx + nConstr + 1;
+        size[0] = size[1] = nConstr;
+        value[0] = 1.0;
+        value[1] = -1.0;
+
+        for (int j = 0; j < nVar; j++) {
+            g[j] = j < nx ? random_double(-10, 10) : random_double(1, 10);
+            lb[j] = j < nx ? -1.0 : 0.0;
+            ub[j] = j < nx ? 1.0 : INF;
+        }
+        for (int i = 0; i < nConstr; i++) {
+            int type = rand() % 3;
+            double center = random_double(-5, 5);
+            lbA[i] = type == 1 ? -INF : center - (type == 0 ? 0.0 : random_double(0, 1));
+            ubA[i] = type == 2 ? INF : type == 0 ? lbA[i] : center + random_double(0, 1);
+        }
+    }
+
+    Exitflag solve(DenseQPSolver &solver) const {
+        return solver.solve(H.data(), A.data(), g.data(), lb.data(), ub.data(),
+                            lbA.data(), ubA.data(), 1000);
+    }
+
+    bool solve(WorkingSetSolver &solver, const ActiveType* W_constr,
+               const ActiveType* W_bounds) const {
+        return solver.solve(B, J, I_info, g.data(), lb.data(), ub.data(),
+                            lbA.data(), ubA.data(), W_constr, W_bounds);
+    }
+};
+
+
+/**
+ * @brief solve the QP on the working set of DenseQPSolver, which has to give the
+ * same solution, then check that a wrong working set is either rejected or gives
+ * a solution of the QP
+ */
+bool TEST_WORKING_SET(int nx, int nConstr) {
+    bool passed = true;
+    int solved = 0;
+    for (int trial = 0; trial < 20; trial++) {
+        RandomSL1QP qp(nx, nConstr);
+        DenseQPSolver dense(qp.nVar, qp.nConstr);
+        if (qp.solve(dense) != QP_OPTIMAL)
+            continue;
+        vector<ActiveType> W_bounds(qp.nVar), W_constr(qp.nConstr);
+        dense.get_working_set(W_constr.data(), W_bounds.data());
+
+        WorkingSetSolver solver(qp.nVar, qp.nConstr, qp.nVar + qp.nConstr);
+        if (!qp.solve(solver, W_constr.data(), W_bounds.data())) {
+            printf("    trial %d: the optimal working set is rejected\n", trial);
+            passed = false;
+            continue;
+        }
+        solved++;
+        double scale = max(1.0, fabs(dense.objective()));
+        passed = passed && fabs(solver.objective() - dense.objective()) <= TOL * scale;
+        for (int j = 0; j < nx; j++)
+            passed = passed && fabs(solver.x()[j] - dense.x()[j]) <= TOL;
+        for (int k = 0; k < qp.nVar + qp.nConstr; k++)
+            passed = passed && fabs(solver.y()[k] - dense.y()[k]) <= TOL *
+                     max(1.0, fabs(dense.y()[k]));
+
+        //fix a variable of the step which is not at a bound
+        for (int j = 0; j < nx; j++)
+            if (W_bounds[j] == INACTIVE) {
+                W_bounds[j] = ACTIVE_BELOW;
+                break;
+            }
+        if (qp.solve(solver, W_constr.data(), W_bounds.data()))
+            passed = passed && fabs(solver.objective() - dense.objective()) <=
+                     TOL * scale;
+    }
+    printf("    %d of 20 QPs solved\n", solved);
+    PRINT_RESULT(passed, "Working set");
+    return passed;
+}
+
+
+/** @brief a system larger than max_size is not solved*/
+bool TEST_MAX_SIZE(int nx, int nConstr) {
+    RandomSL1QP qp(nx, nConstr);
+    vector<ActiveType> W_bounds(qp.nVar, INACTIVE), W_constr(qp.nConstr, INACTIVE);
+    WorkingSetSolver solver(qp.nVar, qp.nConstr, qp.nVar - 1);
+    bool passed = !qp.solve(solver, W_constr.data(), W_bounds.data());
+    PRINT_RESULT(passed, "Maximum size");
+    return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+    int nx = rand() % 20 + 2;
+    int nConstr = rand() % 10 + 1;
+
+    printf("\n=========================================================\n");
+    printf("    Testing Methods for DenseLDL and WorkingSetSolver with nx = %d, "
+           "nConstr = %d", nx, nConstr);
+    printf("\n=========================================================\n");
+
+    TEST_LDL_INERTIA(nx + nConstr);
+    TEST_LDL_SINGULAR(nx);
+    TEST_WORKING_SET(nx, nConstr);
+    TEST_MAX_SIZE(nx, nConstr);
+
+    return 0;
+}
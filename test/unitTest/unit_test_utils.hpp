@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <memory>
+#include <sqphot/Types.hpp>
 
 template <typename T>
 bool TEST_EQUAL(T a, T b) {
@@ -26,3 +28,32 @@ bool TEST_EQUAL_DOUBLE_ARRAY(const double* a, const double* b, int length, const
     }
     return true;
 }
+
+
+/**
+ * @brief the identity blocks of the elastic matrix [J I -I], for J with rowNum rows
+ * and colNum columns. Its arrays are deleted with the last copy of the pointer.
+ */
+inline std::shared_ptr<SQPhotstart::IdentityInfo> make_elastic_identity(int rowNum,
+        int colNum) {
+    std::shared_ptr<SQPhotstart::IdentityInfo> I_info(new SQPhotstart::IdentityInfo,
+    [](SQPhotstart::IdentityInfo* I) {
+        delete[] I->irow;
+        delete[] I->jcol;
+        delete[] I->size;
+        delete[] I->value;
+        delete I;
+    });
+    I_info->length = 2;
+    I_info->irow = new int[2];
+    I_info->jcol = new int[2];
+    I_info->size = new int[2];
+    I_info->value = new double[2];
+    I_info->irow[0] = I_info->irow[1] = 1;
+    I_info->jcol[0] = colNum + 1;
+    I_info->jcol[1] = colNum + rowNum + 1;
+    I_info->size[0] = I_info->size[1] = rowNum;
+    I_info->value[0] = 1.0;
+    I_info->value[1] = -1.0;
+    return I_info;
+}